@@ -25,6 +25,7 @@
 #include <util/cs_Utils.h>
 
 #include <structs/buffer/cs_EncryptionBuffer.h>
+#include <structs/cs_PacketView.h>
 #include <processing/cs_EncryptionHandler.h>
 
 /** General BLE name service
@@ -277,6 +278,14 @@ public:
 	 */
 	virtual uint16_t getValueLength() = 0;
 
+	/** Return the number of bytes the value can hold
+	 *  For normal types (arithmetic and strings) this is the length of the
+	 *  value.
+	 */
+	virtual uint16_t getValueMaxLength() {
+		return getValueLength();
+	}
+
 	/** Helper function which is called when a characteristic is written over
 	 *  BLE.
 	 *  @len the number of bytes that were written
@@ -445,6 +454,9 @@ public:
 	//! Format of callback on write (from user)
 	typedef function<void(const EncryptionAccessLevel, const T&)> callback_on_write_t;
 
+	//! Format of callback on write, with a view on the payload in the value
+	typedef function<void(const EncryptionAccessLevel, const PacketView&)> callback_on_write_view_t;
+
 protected:
 	/** The generic type is physically located in this field in this class (by value, not just by reference)
 	 *  In the case of aes encryption, this is the unencrypted value
@@ -454,6 +466,9 @@ protected:
 	//! The callback to call on a write coming from the softdevice (and originating from the user)
 	callback_on_write_t        _callbackOnWrite;
 
+	//! The callback to call on a write, instead of _callbackOnWrite, with a view on the payload
+	callback_on_write_view_t   _callbackOnWriteView;
+
 public:
 	CharacteristicGeneric() {};
 
@@ -474,6 +489,16 @@ public:
 		_callbackOnWrite = closure;
 	}
 
+	/** Register an on write callback which gets a view on the written payload.
+	 *
+	 *  Like with onWrite(), the payload is decrypted into the value, as far as it fits in getValueMaxLength() bytes.
+	 *  The view points at the payload there, including the zero padding of the last block, so that the callback
+	 *  doesn't have to parse the value again. The reply can be written to the value once the payload has been handled.
+	 */
+	void onWriteView(const callback_on_write_view_t& closure) {
+		_callbackOnWriteView = closure;
+	}
+
 	/** CharacteristicGeneric() returns value object
 	 *  In the case of aes encryption, this is the unencrypted value
 	 * @return value object
@@ -515,6 +540,11 @@ protected:
 
 		setGattValueLength(len);
 
+		if (_callbackOnWriteView) {
+			writtenView(len);
+			return;
+		}
+
 		EncryptionAccessLevel accessLevel = NOT_SET;
 		// when using encryption, the packet needs to be decrypted
 		if (_status.aesEncrypted && _minAccessLevel < ENCRYPTION_DISABLED) {
@@ -554,6 +584,46 @@ protected:
 		_callbackOnWrite(accessLevel, getValue());
 	}
 
+	/** Like written(), but calls the callback with a view on the value.
+	 */
+	void writtenView(uint16_t len) {
+		EncryptionAccessLevel accessLevel = NOT_SET;
+		PacketView view;
+		if (_status.aesEncrypted && _minAccessLevel < ENCRYPTION_DISABLED) {
+			// only the part of the payload that fits in the value is decrypted, the view checks the length of the
+			// stream header against what was decrypted.
+			uint16_t decryptionBufferLength = EncryptionHandler::calculateDecryptionBufferLength(getGattValueLength());
+			if (decryptionBufferLength > getValueMaxLength()) {
+				decryptionBufferLength = getValueMaxLength();
+			}
+			setValueLength(decryptionBufferLength);
+
+			bool success = EncryptionHandler::getInstance().decrypt(
+				getGattValuePtr(),
+				getGattValueLength(),
+				getValuePtr(),
+				getValueLength(),
+				accessLevel
+			);
+
+			// disconnect on failure or if the user is not authenticated
+			if (!success || !EncryptionHandler::getInstance().allowAccess(_minAccessLevel , accessLevel)) {
+				LOGi("insufficient access")
+				EncryptionHandler::getInstance().closeConnectionAuthenticationFailure();
+				return;
+			}
+		}
+		else {
+			accessLevel = ENCRYPTION_DISABLED;
+			setValueLength(len);
+		}
+		view.assign(getValuePtr(), getValueLength());
+
+		LOGd("%s: onWrite()", _name);
+
+		_callbackOnWriteView(accessLevel, view);
+	}
+
 
 	/** @inherit */
 	virtual bool configurePresentationFormat(ble_gatts_char_pf_t& presentation_format) {
@@ -745,13 +815,17 @@ private:
 	 */
 	uint16_t _valueLength;
 
+	/** number of bytes that were allocated for the value
+	 */
+	uint16_t _maxValueLength;
+
 	uint16_t _gattValueLength;
 
 	uint16_t _notificationPendingOffset;
 
 public:
 
-	Characteristic<buffer_ptr_t>() : _maxGattValueLength(0), _valueLength(0), _gattValueLength(0),
+	Characteristic<buffer_ptr_t>() : _maxGattValueLength(0), _valueLength(0), _maxValueLength(0), _gattValueLength(0),
 		_notificationPendingOffset(0) {
 		setSharedEncryptionBuffer(true);
 	}
@@ -785,6 +859,18 @@ public:
 		return _valueLength;
 	}
 
+	/** Set the number of bytes that were allocated for the value
+	 * @length maximum length in bytes
+	 */
+	void setMaxValueLength(uint16_t length) {
+		_maxValueLength = length;
+	}
+
+	/** @inherit */
+	uint16_t getValueMaxLength() {
+		return _maxValueLength;
+	}
+
 	/** Set the maximum length of the buffer
 	 * @length maximum length in bytes
 	 *
@@ -20,6 +20,7 @@
 
 #if BUILD_MESHING == 1
 #include <protocol/cs_MeshMessageTypes.h>
+#include <processing/cs_LoadEventDetector.h>
 #endif
 
 //#define BUILD_MESHING 1
@@ -353,6 +354,9 @@ private:
 	//! Event type of next mesh message. 0 for the regular interval msg.
 	uint16_t _meshNextEventType;
 
+	//! Last load event, to be sent over the mesh.
+	load_event_t _loadEvent;
+
 	struct __attribute__((packed)) advertised_ids_t {
 		uint8_t   size;
 		int8_t    head; // Index of last crownstone ID that was advertised
@@ -95,6 +95,11 @@ typedef struct  {
 	//! Analog input pin to read the voltage.
 	uint8_t pinAinVoltage;
 
+	//! Gain of the medium and low gain current pins, relative to the high gain pin. 0 when the pin is not available or
+	//! not calibrated, the current range is then not changed automatically.
+	float currentGainMed;
+	float currentGainLow;
+
 	//! Analog input pin to read 'zero' line for current and voltage measurement (optional).
 	uint8_t pinAinZeroRef;
 
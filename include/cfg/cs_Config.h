@@ -137,13 +137,14 @@
 
 
 #define POWER_SAMPLE_BURST_NUM_SAMPLES           75 // Number of voltage and current samples per burst
+#define POWER_SAMPLE_STREAM_INTERVAL_MS          40 // Minimal time between two compressed waveform chunks, when streaming. Buffers in between are skipped.
 
 #define CS_ADC_SAMPLE_INTERVAL_US                200
 //#define CS_ADC_SAMPLE_INTERVAL_US                400
 
 #define CS_ADC_MAX_PINS                          2
-#define CS_ADC_NUM_BUFFERS                       2 // ADC code is currently written for (max) 2
-#define CS_ADC_BUF_SIZE                          (2*20000/CS_ADC_SAMPLE_INTERVAL_US)
+#define CS_ADC_NUM_BUFFERS                       4 // At most 2 are queued in the SAADC, the others give time to process
+#define CS_ADC_BUF_SIZE                          (2*((POWER_SAMPLING_MAX_PERIOD_US + CS_ADC_SAMPLE_INTERVAL_US - 1)/CS_ADC_SAMPLE_INTERVAL_US)) // Holds the longest accepted period.
 //#define CS_ADC_BUF_SIZE                          (2*30000/CS_ADC_SAMPLE_INTERVAL_US)
 
 #define STORAGE_REQUEST_BUFFER_SIZE              5
@@ -173,14 +174,54 @@
 //#define CURRENT_ZERO_EXP_AVG_DISCOUNT            1000 // No averaging
 #define POWER_EXP_AVG_DISCOUNT                   200 // Is divided by 1000, so 200 is a discount of 0.2. // 99% of the average is influenced by the last 21 values
 //#define POWER_EXP_AVG_DISCOUNT                   1000 // No averaging
-#define POWER_SAMPLING_RMS_WINDOW_SIZE           9 // Windows size used for filtering the power and current rms. Currently can only be 7, 9, or 25!
-
-#define POWER_SAMPLING_CURVE_HALF_WINDOW_SIZE    5 // Half window size used for filtering the current curve. Can't just be any value!
-//#define POWER_SAMPLING_CURVE_HALF_WINDOW_SIZE    16 // Half window size used for filtering the current curve. Can't just be any value!
+#define POWER_SAMPLING_RMS_WINDOW_SIZE           9 // Windows size used for filtering the power and current rms.
+
+#define POWER_SAMPLING_CURVE_HALF_WINDOW_SIZE    5 // Half window size used for filtering the current curve. Can be any value with the sliding median filter.
+//#define POWER_SAMPLING_CURVE_HALF_WINDOW_SIZE    16 // Half window size used for filtering the current curve. Can be any value with the sliding median filter.
+#define POWER_SAMPLING_CURVE_SLIDING_MEDIAN      1 // Use the sliding median filter (1) or the block sort median (0) for the current curve.
+
+#define POWER_SAMPLING_HARMONIC_ANALYSIS         1 // Calculate power factor, phase shift and current harmonics every AC period (1), or not (0).
+#define POWER_SAMPLING_HARMONICS_COUNT           3 // Number of odd current harmonics to analyse: 3 means the 3rd, 5th and 7th.
+
+#define POWER_SAMPLING_PERIOD_TRACKING           1 // Integrate over the measured mains period (1), or over the nominal period (0).
+#define POWER_SAMPLING_NOMINAL_PERIOD_US         20000 // Period of the mains (50 Hz), used until the period is measured.
+#define POWER_SAMPLING_MIN_PERIOD_US             15385 // Shortest accepted period: 65 Hz.
+#define POWER_SAMPLING_MAX_PERIOD_US             22222 // Longest accepted period: 45 Hz.
+#define POWER_SAMPLING_PERIOD_LOCK_COUNT         4 // Number of accepted period measurements before the measured period is used.
+#define POWER_SAMPLING_ZERO_CROSSING_HYSTERESIS  50 // Voltage has to go this much (adc value) below zero before the next upward zero crossing is detected.
+#define POWER_SAMPLING_ENERGY_MAX_GAP_MS         2000 // Longest time without samples that is still bridged in the energy, longer gaps are not metered.
+#define POWER_SAMPLING_AUTO_RANGE                0 // Automatically change the range and gain of the current channel (1), or only on debug commands (0). Off until a board config has calibrated currentGainMed and currentGainLow.
+#define POWER_SAMPLING_RANGE_DOWN_PERCENT        90 // Switch to a less sensitive range when a current sample reaches this percentage of the ADC limits.
+#define POWER_SAMPLING_RANGE_UP_PERCENT          45 // Switch to a more sensitive range when the current samples would stay within this percentage of its limits ..
+#define POWER_SAMPLING_RANGE_UP_BUFFERS          25 // .. for this many buffers in a row.
+#define LOAD_EVENT_DETECTION                     1 // Detect appliances being switched on and off from steps in the filtered Irms (1), or not (0).
+#define LOAD_EVENT_MIN_STEP_MILLI_AMP            50 // A step of the filtered Irms has to be at least this large ..
+#define LOAD_EVENT_MIN_STEP_PERCENT              2 // .. and at least this percentage of the Irms before the step.
+#define LOAD_EVENT_DEBOUNCE_PERIODS              20 // The Irms has to stay at the new level for this many periods.
+#define POWER_SAMPLING_SCHEDULER                 1 // Only fully process a period now and then while the Irms is steady (1), or every period (0).
+#define POWER_SAMPLING_MONITOR_INTERVAL_MS       200 // While the Irms is steady, fully process a period every this many ms.
+#define POWER_SAMPLING_BURST_MS                  3000 // After a step of the Irms, fully process every period for this many ms.
+#define POWER_SAMPLING_BURST_STEP_MILLI_AMP      50 // A step of the Irms has to be at least this large ..
+#define POWER_SAMPLING_BURST_STEP_PERCENT        5 // .. or this percentage of the Irms, to start a burst.
+#define POWER_SAMPLING_BURST_GUARD_PERCENT       50 // Fully process every period when the Irms is above this percentage of the current threshold.
 
 #define CURRENT_USAGE_THRESHOLD                  (16000) // Power usage threshold in mA at which the switch should be turned off.
 #define CURRENT_USAGE_THRESHOLD_PWM              (1000)  // Power usage threshold in mA at which the PWM should be turned off.
 
+// The soft fuse heats up with the square of the current above the threshold, and trips when it's too hot (I²t).
+#define SOFT_FUSE_TRIP_MULTIPLE_PERCENT          200  // Trip curves are given as the time to trip at this percentage of the threshold current:
+#define SOFT_FUSE_TRIP_MS_RESISTIVE              500  // .. for resistive loads,
+#define SOFT_FUSE_TRIP_MS_MOTOR                  4000 // .. for inductive loads, which draw several times their current while starting,
+#define SOFT_FUSE_TRIP_MS_ELECTRONIC             1000 // .. for loads with a distorted current, like LED drivers, which have an inrush peak,
+#define SOFT_FUSE_TRIP_MS_PWM                    400  // .. for the dimmer, whatever the load.
+#define SOFT_FUSE_SHORT_PERCENT                  300  // Trip right away when the current is above this percentage of the threshold ..
+#define SOFT_FUSE_SHORT_PERCENT_MOTOR            1000 // .. or this percentage for inductive loads, ..
+#define SOFT_FUSE_SHORT_PERIODS                  2    // .. for this many periods in a row.
+#define SOFT_FUSE_MAX_PERIODS_PWM                21   // The dimmer also trips when the current is above its threshold for this many periods in a row.
+#define SOFT_FUSE_CLASS_LATCH_PERIODS            5    // The load class is kept once the fuse has been heated for this many periods, until it cooled down.
+#define SOFT_FUSE_MOTOR_PHASE_DECI_DEGREES       250  // Loads with the current more than this phase behind the voltage are inductive.
+#define SOFT_FUSE_ELECTRONIC_THD                 500  // Loads with a current THD above this (times 1000) are electronic.
+
 #define PWM_PERIOD                               10000L // Interval in us: 1/10000e-6 = 100 Hz
 
 #define KEEP_ALIVE_INTERVAL                      (2 * 60) // 2 minutes, in seconds
@@ -225,4 +266,9 @@
 #define MESH_STATE_TIMEOUT                       (3*MESH_STATE_REFRESH_PERIOD) // ms until state of a crownstone is considered to be timed out.
 #define LAST_SEEN_COUNT_PER_STATE_CHAN           3 // Number of last seen timestamps to store per state channel.
 
+#define AES_BATCH_BLOCKS                         4 // Number of CTR blocks that are encrypted with one call to the AES backend.
+#define KEYSTREAM_CACHE_ENTRIES                  3 // Number of packets of which the CTR keystream is computed in advance, while idle.
+#define KEYSTREAM_CACHE_BLOCKS                   4 // Keystream blocks per packet: enough for a payload of 60 bytes, longer payloads are partly encrypted on the fly.
+#define CCM_TAG_LENGTH                           4 // Length of the truncated tag of CCM packets, like the MIC of the BLE link layer.
+
 #define SWITCH_ON_AT_SETUP_BOOT_DELAY            3600  // Seconds until the switch turns on when in setup mode (Crownstone built-in only)
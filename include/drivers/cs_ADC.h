@@ -8,9 +8,11 @@
 
 #include <ble/cs_Nordic.h>
 #include <cfg/cs_Config.h>
+#include <drivers/cs_AdcBufferQueue.h>
 #include <structs/buffer/cs_CircularBuffer.h>
 #include <structs/buffer/cs_StackBuffer.h>
 #include <structs/buffer/cs_DifferentialBuffer.h>
+#include <structs/buffer/cs_SpscQueue.h>
 
 //! Numeric reference to a pin
 typedef uint8_t cs_adc_pin_id_t;
@@ -18,15 +20,9 @@ typedef uint8_t cs_adc_pin_id_t;
 //! Numeric reference to a channel
 typedef uint8_t cs_adc_channel_id_t;
 
-//! Numeric reference to a buffer
-typedef uint8_t cs_adc_buffer_id_t;
-
 //! Pin count (number)
 typedef uint8_t cs_adc_pin_count_t;
 
-//! Buffer count (number)
-typedef uint8_t cs_adc_buffer_count_t;
-
 //! Buffer size (number)
 typedef uint16_t cs_adc_buffer_size_t;
 
@@ -57,8 +53,9 @@ struct adc_done_cb_data_t {
 	//! Buffer size as argument for ADC callback 
 	cs_adc_buffer_size_t bufSize;
 	//! Buffer index as argument for ADC callback
-	//! TODO: remove this field
 	cs_adc_buffer_id_t bufNum;
+	//! RTC count when the buffer was handed out, to measure the processing latency.
+	uint32_t handedOutTicks;
 };
 
 enum adc_gain_t {
@@ -121,7 +118,7 @@ struct adc_config_t {
  * The buffers to be used internally. To have these buffers in the form of macros means that we can check at compile
  * time if they are small enough with respect to the nRF52 memory limitations.
  *
- *   - CS_ADC_NUM_BUFFERS              The number of ADC buffers to use. 
+ *   - CS_ADC_NUM_BUFFERS              The number of ADC buffers to use, at least 2.
  *   - CS_ADC_BUF_SIZE                 The size of the buffer (first time used in init()).
  *
  * The pins:
@@ -134,17 +131,25 @@ struct adc_config_t {
  * corresponding implementation file. This function uses the singleton feature to call update on an event from the 
  * ADC peripheral, in particular, NRF_DRV_SAADC_EVT_DONE, with a buffer as argument.
  *
- * 2. The update() routine puts an internal C function, adc_done, with _doneCallback as argument in the event queue
- * of the scheduler. This calls the callback function set previously in setDoneCallback() by a particular caller, 
- * e.g. the cs_PowerSampling. In this particular case it ends up in PowerSampling::powerSampleAdcDone that after 
- * processing the data calls releaseBuffer(bufNum).
+ * 2. The update() routine pushes a copy of _doneCallbackData in the done queue, a lock-free SpscQueue, and puts an
+ * internal C function, adc_done, in the event queue of the scheduler, unless it is there already. This pops the done
+ * queue, and calls the callback function set previously in setDoneCallback() by a particular caller, e.g. the
+ * cs_PowerSampling. In this particular case it ends up in PowerSampling::powerSampleAdcDone that after processing the
+ * data calls releaseBuffer(bufNum). The time between handing out a buffer and calling the callback is kept up (see
+ * getMaxDoneLatencyMs).
  *
- * 3. The releaseBuffer function clears the _doneCallbackData structure and queues a new buffer. Note that all 
+ * 3. The releaseBuffer function hands the buffer back to the ADC, and queues it to be filled again. Note that all
  * processing has taken place by now.
- 
- * Note. In the ADC it is assumed that the member object is not updated (_doneCallbackData.bufName == bufNum) in the
- * mean while. In other words, it should not be possible to get a second interrupt before releaseBuffer has been 
- * called. Scheduling a new ADC task is only done at the end of the releaseBuffer function.
+ *
+ * The ownership of the buffers is kept in an AdcBufferQueue. Only one buffer at a time is handed to the callback, and
+ * _doneCallbackData is not touched until that buffer is released. Buffers that are filled in the mean while wait in
+ * the queue, and are handed out in order by releaseBuffer. Only when all buffers are in use, the oldest waiting buffer
+ * is overwritten (see getOverrunCount).
+ *
+ * So the done queue holds at most the one buffer that is handed out: it only decouples the interrupt from the app
+ * scheduler. The backlog of the main thread is in the buffer queue: the filled buffers that wait (see
+ * getMaxFilledCount), the buffers that are overwritten (see getOverrunCount), and the time a handed out buffer waits
+ * for the app scheduler (see getMaxDoneLatencyMs).
  */
 class ADC {
 
@@ -177,6 +182,28 @@ public:
 	 */
 	bool releaseBuffer(nrf_saadc_value_t* buf);
 
+	/** Get the number of filled buffers that were overwritten before they could be processed.
+	 */
+	uint32_t getOverrunCount() const {
+		return _bufferQueue.getOverrunCount();
+	}
+
+	/** Get the number of times a buffer was released that wasn't handed out, or was released already.
+	 */
+	uint32_t getReleaseErrorCount() const {
+		return _bufferQueue.getErrorCount();
+	}
+
+	/** Get the highest number of filled buffers that waited for the previous buffer to be released.
+	 */
+	cs_adc_buffer_count_t getMaxFilledCount() const {
+		return _bufferQueue.getMaxFilled();
+	}
+
+	/** Get the longest time between handing out a buffer, and calling the done callback with it.
+	 */
+	uint32_t getMaxDoneLatencyMs() const;
+
 	/** Set the callback which is called when a buffer is filled.
 	 *
 	 * @param[in] callback             Function to be called when a buffer is filled with samples.
@@ -206,6 +233,14 @@ public:
 	 */
 	cs_adc_error_t changeChannel(cs_adc_channel_id_t channel, adc_channel_config_t& config);
 
+	/** Whether a changed channel config still has to be applied.
+	 *
+	 * Buffers that are handed out while this is true, were sampled with the old config.
+	 */
+	bool isConfigChangePending() {
+		return _changeConfig;
+	}
+
 
 	/** Update this object with a buffer with values from the ADC conversion.
 	 *
@@ -224,6 +259,10 @@ public:
 	 */
 	void _handleAdcLimitInterrupt(nrf_saadc_limit_t type);
 
+	/** Call the done callback for each buffer in the done queue, from the app scheduler.
+	 */
+	void _handleDoneQueue();
+
 protected:
 
 
@@ -250,12 +289,22 @@ private:
 	//! Array of pointers to buffers.
 	nrf_saadc_value_t* _bufferPointers[CS_ADC_NUM_BUFFERS];
 
-	//! Number of buffers that are queued to be populated by adc.
-	cs_adc_buffer_count_t _numBuffersQueued;
+	//! State of each buffer.
+	AdcBufferQueue _bufferQueue;
 
 	//! Arguments to the callback function
 	adc_done_cb_data_t _doneCallbackData;
 
+	//! Buffer that is handed out, waiting for the done callback. Pushed from the interrupt, or from releaseBuffer()
+	//! within a critical region, popped from the app scheduler. Only one buffer is handed out at a time.
+	SpscQueue<adc_done_cb_data_t, 1> _doneQueue;
+
+	//! Whether adc_done is in the event queue of the scheduler.
+	bool _doneEventPending;
+
+	//! Longest time between handing out a buffer and calling the done callback.
+	uint32_t _maxDoneLatencyTicks;
+
 	//! The zero crossing callback.
 	adc_zero_crossing_cb_t _zeroCrossingCallback;
 
@@ -281,7 +330,19 @@ private:
 	nrf_saadc_input_t getAdcPin(cs_adc_pin_id_t pinNum);
 
 	//! Function that puts a buffer in queue to be populated with adc values.
-	void addBufferToSampleQueue(nrf_saadc_value_t* buf);
+	void addBufferToSampleQueue(cs_adc_buffer_id_t bufNum);
+
+	//! Queue buffers until the SAADC has enough, optionally overwriting buffers that are waiting to be processed.
+	void fillSampleQueue(bool overwrite);
+
+	//! Hand the next filled buffer to the done callback, if it is not busy.
+	void startProcessing();
+
+	//! Put adc_done in the event queue of the scheduler, unless it is there already.
+	void scheduleDoneEvent();
+
+	//! Function that returns the index of a buffer, or CS_ADC_BUFFER_NONE.
+	cs_adc_buffer_id_t getBufferIndex(nrf_saadc_value_t* buf);
 
 	//! Function to apply a new config. Should be called when no buffers are are queued, nor being processed.
 	void applyConfig();
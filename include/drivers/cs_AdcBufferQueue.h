@@ -0,0 +1,142 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "cfg/cs_Config.h"
+
+//! Numeric reference to a buffer
+typedef uint8_t cs_adc_buffer_id_t;
+
+//! Buffer count (number)
+typedef uint8_t cs_adc_buffer_count_t;
+
+//! Returned when there is no buffer.
+#define CS_ADC_BUFFER_NONE 0xFF
+
+//! The SAADC driver holds at most 2 buffers: the one being filled, and the next one.
+#define CS_ADC_MAX_QUEUED_BUFFERS 2
+
+#if CS_ADC_NUM_BUFFERS < 2 || CS_ADC_NUM_BUFFERS >= CS_ADC_BUFFER_NONE
+#error "Invalid CS_ADC_NUM_BUFFERS"
+#endif
+
+enum adc_buffer_state_t {
+	ADC_BUFFER_FREE,       // Owned by the ADC, not in use.
+	ADC_BUFFER_QUEUED,     // Handed to the SAADC, being filled or next to be filled.
+	ADC_BUFFER_FILLED,     // Filled, waiting to be processed.
+	ADC_BUFFER_PROCESSING, // Handed to the user, owned by the user until released.
+};
+
+/** Keeps track of the state and ownership of the ADC buffers.
+ *
+ * There are CS_ADC_NUM_BUFFERS buffers, of which at most 2 are queued in the SAADC. Filled buffers are handed to the
+ * user one at a time, in the order they were filled, and the user hands them back with release(). As long as there
+ * are free buffers, the SAADC is kept supplied, so a processing spike only delays the processing. When there are no
+ * free buffers left, the oldest filled buffer is overwritten, which counts as an overrun.
+ *
+ * This class has no hardware dependencies, the ADC driver calls it from the interrupt and from releaseBuffer(), within
+ * a critical region.
+ */
+class AdcBufferQueue {
+public:
+	AdcBufferQueue();
+
+	/** Mark all buffers as free, and reset the counters.
+	 */
+	void init();
+
+	/** Get the next buffer to hand to the SAADC, and mark it as queued.
+	 *
+	 * @param[in] overwrite            Whether to overwrite the oldest filled buffer when no buffer is free.
+	 * @return                         Buffer, or CS_ADC_BUFFER_NONE when the SAADC is full or no buffer is available.
+	 */
+	cs_adc_buffer_id_t nextToQueue(bool overwrite);
+
+	/** Mark a queued buffer as filled, to be called when the SAADC is done with it.
+	 *
+	 * @return                         False when the buffer was not the first queued buffer.
+	 */
+	bool onFilled(cs_adc_buffer_id_t id);
+
+	/** Get the oldest filled buffer to process, unless a buffer is being processed already.
+	 *
+	 * @return                         Buffer that is now owned by the user, or CS_ADC_BUFFER_NONE.
+	 */
+	cs_adc_buffer_id_t startProcessing();
+
+	/** Release a buffer that was being processed.
+	 *
+	 * @return                         False when the buffer was not being processed (for example when it was released already).
+	 */
+	bool release(cs_adc_buffer_id_t id);
+
+	/** Free the filled buffers without processing them, for example because they were sampled with an old config.
+	 *
+	 * The dropped buffers count as overruns, so that the gap shows up the same way.
+	 *
+	 * @return                         Number of buffers that were dropped.
+	 */
+	cs_adc_buffer_count_t dropFilled();
+
+	adc_buffer_state_t getState(cs_adc_buffer_id_t id) const {
+		return _states[id];
+	}
+
+	//! Number of buffers that are queued in the SAADC.
+	cs_adc_buffer_count_t numQueued() const {
+		return _numQueued;
+	}
+
+	//! Number of filled buffers that are waiting to be processed.
+	cs_adc_buffer_count_t numFilled() const {
+		return _numFilled;
+	}
+
+	//! Highest number of filled buffers that waited to be processed at once.
+	cs_adc_buffer_count_t getMaxFilled() const {
+		return _maxFilled;
+	}
+
+	//! Whether a buffer is owned by the user.
+	bool isProcessing() const {
+		return _processing != CS_ADC_BUFFER_NONE;
+	}
+
+	//! Number of filled buffers that were overwritten or dropped before they were processed.
+	uint32_t getOverrunCount() const {
+		return _overrunCount;
+	}
+
+	//! Number of calls to release() or onFilled() with a buffer in the wrong state.
+	uint32_t getErrorCount() const {
+		return _errorCount;
+	}
+
+private:
+	adc_buffer_state_t _states[CS_ADC_NUM_BUFFERS];
+
+	//! Queued buffers, in the order they will be filled.
+	cs_adc_buffer_id_t _queued[CS_ADC_MAX_QUEUED_BUFFERS];
+	cs_adc_buffer_count_t _numQueued;
+
+	//! Filled buffers, in the order they were filled, starting at _filledStart.
+	cs_adc_buffer_id_t _filled[CS_ADC_NUM_BUFFERS];
+	cs_adc_buffer_count_t _filledStart;
+	cs_adc_buffer_count_t _numFilled;
+	cs_adc_buffer_count_t _maxFilled;
+
+	//! Buffer that is being processed.
+	cs_adc_buffer_id_t _processing;
+
+	uint32_t _overrunCount;
+	uint32_t _errorCount;
+
+	//! Remove and return the oldest filled buffer.
+	cs_adc_buffer_id_t popFilled();
+};
@@ -65,6 +65,9 @@ enum GeneralEventType {
 	EVT_PWM_POWERED,
 	EVT_PWM_ALLOWED, // Sent when pwm allowed flag is set. Payload is boolean.
 	EVT_SWITCH_LOCKED, // Sent when switch locked flag is set. Payload is boolean.
+	EVT_POWER_QUALITY, // Sent every AC period when the harmonic analysis is enabled. Payload is power_quality_t.
+	EVT_CONT_POWER_SAMPLER_ENABLED, // Sent when streaming of the power samples is enabled or disabled. Payload is boolean.
+	EVT_LOAD_SWITCHED, // Sent when the attached load is switched on or off. Payload is load_event_t.
 	EVT_ALL = 0xFFFF
 };
 
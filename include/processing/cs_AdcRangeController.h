@@ -0,0 +1,103 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "processing/cs_PowerCalculation.h"
+
+//! Maximum number of levels: every ADC range on 3 pins.
+#define ADC_RANGE_MAX_LEVELS 24
+
+/**
+ * A setting of the current channel: the pin (high, medium or low gain) and the range of the ADC.
+ */
+struct adc_range_level_t {
+	uint8_t pin;
+	uint16_t rangeMilliVolt;
+	//! Gain of the pin, relative to the high gain pin.
+	float gain;
+};
+
+/** Picks the range of the current channel, so that small loads are measured at a fine resolution, and large loads
+ * don't clip.
+ *
+ * The levels are ordered from most to least sensitive. Every buffer, the peak of the current samples is compared to
+ * the limits of the ADC:
+ * - When a sample reaches POWER_SAMPLING_RANGE_DOWN_PERCENT of the limits, the next less sensitive level is taken
+ *   right away, as the buffer may have clipped.
+ * - When the samples would stay within POWER_SAMPLING_RANGE_UP_PERCENT of the limits of the next more sensitive level,
+ *   for POWER_SAMPLING_RANGE_UP_BUFFERS buffers in a row, that level is taken.
+ *
+ * The gap between the two thresholds is the hysteresis, so that a load doesn't make the range go back and forth.
+ * Samples are compared as they are, not relative to the zero line, as the ADC clips on the raw value.
+ */
+class AdcRangeController {
+public:
+	AdcRangeController();
+
+	/** Remove all levels.
+	 *
+	 * @param[in] adcMin               Lowest value of the ADC.
+	 * @param[in] adcMax               Highest value of the ADC.
+	 */
+	void init(int32_t adcMin, int32_t adcMax);
+
+	/** Add the ranges of a pin, that are less sensitive than the levels added before.
+	 *
+	 * @param[in] pin                  The pin.
+	 * @param[in] gain                 Gain of the pin, relative to the high gain pin. 0 when the pin is not available.
+	 * @param[in] maxRangeMilliVolt    Largest range to use on this pin.
+	 */
+	void addPin(uint8_t pin, float gain, uint16_t maxRangeMilliVolt);
+
+	/** Set the current level.
+	 *
+	 * @return                         False when there is no level with the given pin and range.
+	 */
+	bool setLevel(uint8_t pin, uint16_t rangeMilliVolt);
+
+	/** Check the current samples of a buffer, that was sampled at the current level.
+	 *
+	 * @return                         True when the level changed.
+	 */
+	bool update(const power_t& power);
+
+	uint8_t getLevel() const {
+		return _level;
+	}
+
+	uint8_t getNumLevels() const {
+		return _numLevels;
+	}
+
+	const adc_range_level_t& getLevelConfig() const {
+		return _levels[_level];
+	}
+
+	/** Factor to convert an ADC value of one level to another level.
+	 */
+	float getScale(uint8_t fromLevel, uint8_t toLevel) const;
+
+private:
+	adc_range_level_t _levels[ADC_RANGE_MAX_LEVELS];
+	uint8_t _numLevels;
+	uint8_t _level;
+
+	int32_t _adcMin;
+	int32_t _adcMax;
+
+	//! Number of buffers in a row that would fit the more sensitive level.
+	uint16_t _fitCount;
+
+	//! ADC value per mV at the input of the high gain pin.
+	float sensitivity(uint8_t level) const {
+		return _levels[level].gain / _levels[level].rangeMilliVolt;
+	}
+
+	bool withinPercent(int32_t minSample, int32_t maxSample, float scale, uint8_t percent) const;
+};
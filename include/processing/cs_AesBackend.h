@@ -0,0 +1,49 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define AES_BLOCK_LENGTH 16
+#define AES_KEY_LENGTH   16
+
+/** AES-128 block encryption.
+ *
+ * The packet encryption only needs the forward cipher: ECB encrypts a single block, and CTR encrypts the counter
+ * blocks, for both encryption and decryption. On the device this is done by the SoftDevice (SoftdeviceAes), on the
+ * host by SoftwareAes, so that PacketCipher can be tested and benchmarked there.
+ */
+class AesBackend {
+public:
+	virtual ~AesBackend() {}
+
+	/** Set the key for the following blocks.
+	 *
+	 * @param[in] key                  AES_KEY_LENGTH bytes.
+	 */
+	virtual void setKey(const uint8_t* key) = 0;
+
+	/** Encrypt a block with the key.
+	 *
+	 * @param[in]  cleartext           AES_BLOCK_LENGTH bytes.
+	 * @param[out] ciphertext          AES_BLOCK_LENGTH bytes, may be the same as the cleartext.
+	 */
+	virtual void encryptBlock(const uint8_t* cleartext, uint8_t* ciphertext) = 0;
+
+	/** Encrypt consecutive blocks with the key.
+	 *
+	 * Backends that can have several blocks in flight, or that have a fixed cost per call, should override this.
+	 *
+	 * @param[in]  cleartext           blockCount * AES_BLOCK_LENGTH bytes.
+	 * @param[out] ciphertext          blockCount * AES_BLOCK_LENGTH bytes, may be the same as the cleartext.
+	 */
+	virtual void encryptBlocks(const uint8_t* cleartext, uint8_t* ciphertext, uint16_t blockCount) {
+		for (uint16_t i = 0; i < blockCount; ++i) {
+			encryptBlock(cleartext + i * AES_BLOCK_LENGTH, ciphertext + i * AES_BLOCK_LENGTH);
+		}
+	}
+};
@@ -0,0 +1,267 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <limits>
+
+//! Smallest type for an index in a block.
+template <bool small>
+struct BlockMedianIndex {
+	typedef uint16_t type;
+};
+
+template <>
+struct BlockMedianIndex<true> {
+	typedef uint8_t type;
+};
+
+/** Running median filter with a window of 2*halfWindowSize+1 samples, by sorting blocks of samples.
+ *
+ * This is the sort median algorithm of third/SortMedian.cc (J. Suomela, "Median filtering is equivalent to sorting",
+ * 2014), with all storage in the object, so that it can be statically allocated. The input is split in blocks of a
+ * window size, and each block is sorted once, into a linked list. Going from one block to the next, the samples of the
+ * previous block are removed from its list, and the samples of the next block added to its list, while keeping track
+ * of the median of the two lists.
+ *
+ * It has the same interface as SlidingMedianFilter: the input is read from the interleaved ADC buffer, and padded at
+ * both ends with the first and last sample.
+ *
+ * By default, the samples are stored as int16, like they come from the ADC, and the links as uint8 when the window is
+ * small enough. For a window of at least mergeSortMinWindowSize, a block of int16 samples is sorted by merging runs of
+ * keys that hold the sample in the upper and the index in the lower 16 bits, so that equal samples are ordered by index
+ * without a second compare. For smaller windows, std::sort is faster.
+ *
+ * @param halfWindowSize           Number of samples on each side of the output sample.
+ * @param blockCount               Number of blocks: the filter can filter up to blockCount*windowSize - 2*halfWindowSize
+ *                                 samples at once.
+ * @param T                        Type of the samples in the padded input.
+ */
+template <uint16_t halfWindowSize, uint16_t blockCount, class T = int16_t>
+class BlockMedianFilter {
+public:
+	static const uint16_t windowSize = 2 * halfWindowSize + 1;
+	static const uint16_t inputSize = windowSize * blockCount;
+
+	//! Maximum number of samples that can be filtered at once.
+	static const uint16_t maxCount = inputSize - 2 * halfWindowSize;
+
+	//! Smallest window for which blocks of int16 samples are merge sorted.
+	static const uint16_t mergeSortMinWindowSize = 16;
+
+	/** Filter a curve.
+	 *
+	 * @param[in]  input               Pointer to the first sample.
+	 * @param[in]  stride              Distance between two consecutive samples (the number of interleaved channels).
+	 * @param[in]  count               Number of samples to filter, at most maxCount.
+	 * @param[out] output              Array of at least count elements, to write the filtered samples to.
+	 */
+	template <typename U>
+	void filter(const int16_t* input, uint16_t stride, uint16_t count, U* output) {
+		if (count == 0 || count > maxCount) {
+			return;
+		}
+		// Pad the input with the first and last sample, also up to the end of the last block.
+		uint16_t j = 0;
+		for (; j < halfWindowSize; ++j) {
+			_input[j] = input[0];
+		}
+		for (uint16_t i = 0; i < count; ++i) {
+			_input[j++] = input[i * stride];
+		}
+		for (; j < inputSize; ++j) {
+			_input[j] = input[(count - 1) * stride];
+		}
+
+		initBlock(_parts[1], 0);
+		output[0] = peek(_parts[1]);
+		for (uint16_t block = 1; block < blockCount; ++block) {
+			part_t& prev = _parts[block % 2];
+			part_t& next = _parts[(block + 1) % 2];
+			initBlock(next, block);
+			unwind(next);
+			for (uint16_t i = 0; i < windowSize; ++i) {
+				uint16_t outIndex = (block - 1) * windowSize + i + 1;
+				remove(prev, i);
+				add(next, i);
+				balance(prev, next);
+				if (outIndex < count) {
+					T a = peek(prev);
+					T b = peek(next);
+					output[outIndex] = a < b ? a : b;
+				}
+			}
+		}
+	}
+
+private:
+	//! Index of the tail of the linked lists.
+	static const uint16_t tail = windowSize;
+
+	//! Index in a block, or the tail.
+	typedef typename BlockMedianIndex<(windowSize < 255)>::type index_t;
+
+	struct link_t {
+		index_t prev;
+		index_t next;
+	};
+
+	/** The samples of a block, as a sorted linked list.
+	 */
+	struct part_t {
+		//! Pointer to the first sample of the block in the input.
+		const T* data;
+		//! Index of the median sample, or tail.
+		index_t med;
+		//! Number of samples before the median.
+		index_t small;
+		link_t link[windowSize + 1];
+	};
+
+	//! Compares indices of a block by their sample, and their index when the samples are equal.
+	struct order_t {
+		const T* data;
+		bool operator()(uint16_t a, uint16_t b) const {
+			return data[a] < data[b] || (data[a] == data[b] && a < b);
+		}
+	};
+
+	//! The padded input.
+	T _input[inputSize];
+
+	//! The previous and the next block.
+	part_t _parts[2];
+
+	//! Get the indices of a block, sorted by sample.
+	template <class U>
+	static void sortBlock(const U* data, uint16_t* sorted) {
+		for (uint16_t i = 0; i < windowSize; ++i) {
+			sorted[i] = i;
+		}
+		order_t order = {data};
+		std::sort(sorted, sorted + windowSize, order);
+	}
+
+	/** Get the indices of a block of int16 samples, sorted by sample.
+	 *
+	 * Bottom up merge sort of the keys, starting with runs of 4 made by insertion sort.
+	 */
+	static void sortBlock(const int16_t* data, uint16_t* sorted) {
+		if (windowSize < mergeSortMinWindowSize) {
+			sortBlock<int16_t>(data, sorted);
+			return;
+		}
+		int32_t keys[2][windowSize];
+		for (uint16_t i = 0; i < windowSize; ++i) {
+			int32_t key = (int32_t)data[i] * 65536 + i;
+			uint16_t j = i;
+			for (; j % 4 != 0 && keys[0][j - 1] > key; --j) {
+				keys[0][j] = keys[0][j - 1];
+			}
+			keys[0][j] = key;
+		}
+		uint8_t from = 0;
+		for (uint16_t width = 4; width < windowSize; width *= 2) {
+			const int32_t* in = keys[from];
+			int32_t* out = keys[1 - from];
+			for (uint16_t start = 0; start < windowSize; start += 2 * width) {
+				uint16_t mid = start + width < windowSize ? start + width : windowSize;
+				uint16_t end = start + 2 * width < windowSize ? start + 2 * width : windowSize;
+				uint16_t a = start;
+				uint16_t b = mid;
+				for (uint16_t k = start; k < end; ++k) {
+					bool takeA = b == end || (a < mid && in[a] < in[b]);
+					out[k] = takeA ? in[a++] : in[b++];
+				}
+			}
+			from = 1 - from;
+		}
+		for (uint16_t i = 0; i < windowSize; ++i) {
+			sorted[i] = keys[from][i] & 0xFFFF;
+		}
+	}
+
+	//! Sort the block, and link it in sorted order.
+	void initBlock(part_t& part, uint16_t block) {
+		part.data = _input + block * windowSize;
+		uint16_t sorted[windowSize];
+		sortBlock(part.data, sorted);
+
+		index_t a = tail;
+		for (uint16_t i = 0; i < windowSize; ++i) {
+			index_t b = sorted[i];
+			part.link[a].next = b;
+			part.link[b].prev = a;
+			a = b;
+		}
+		part.link[a].next = tail;
+		part.link[tail].prev = a;
+		part.med = sorted[halfWindowSize];
+		part.small = halfWindowSize;
+	}
+
+	//! Remove all samples from the list, while keeping the links to put them back in reverse order.
+	void unwind(part_t& part) {
+		for (uint16_t j = 0; j < windowSize; ++j) {
+			index_t i = windowSize - 1 - j;
+			link_t l = part.link[i];
+			part.link[l.prev].next = l.next;
+			part.link[l.next].prev = l.prev;
+		}
+		part.med = tail;
+		part.small = 0;
+	}
+
+	inline bool belowMed(const part_t& part, uint16_t i) const {
+		return part.med == tail || part.data[i] < part.data[part.med]
+				|| (part.data[i] == part.data[part.med] && i < part.med);
+	}
+
+	inline void remove(part_t& part, uint16_t i) {
+		link_t l = part.link[i];
+		part.link[l.prev].next = l.next;
+		part.link[l.next].prev = l.prev;
+		if (belowMed(part, i)) {
+			--part.small;
+		}
+		else {
+			if (i == part.med) {
+				part.med = l.next;
+			}
+			if (part.small > 0) {
+				part.med = part.link[part.med].prev;
+				--part.small;
+			}
+		}
+	}
+
+	inline void add(part_t& part, uint16_t i) {
+		link_t l = part.link[i];
+		part.link[l.prev].next = i;
+		part.link[l.next].prev = i;
+		if (belowMed(part, i)) {
+			part.med = part.link[part.med].prev;
+		}
+	}
+
+	inline T peek(const part_t& part) const {
+		return part.med == tail ? std::numeric_limits<T>::max() : part.data[part.med];
+	}
+
+	//! Advance the median of one of the parts, so that there are halfWindowSize samples below the median.
+	inline void balance(part_t& prev, part_t& next) {
+		if (prev.small + next.small >= halfWindowSize) {
+			return;
+		}
+		bool advancePrev = next.med == tail || (prev.med != tail && peek(prev) <= peek(next));
+		part_t& part = advancePrev ? prev : next;
+		part.med = part.link[part.med].next;
+		++part.small;
+	}
+};
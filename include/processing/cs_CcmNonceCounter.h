@@ -0,0 +1,113 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "processing/cs_PacketCipher.h"
+
+//! Direction in the nonce of a CCM packet.
+enum ccm_direction_t {
+	CCM_DIRECTION_TO_CROWNSTONE = 0,   //! Written to a characteristic.
+	CCM_DIRECTION_FROM_CROWNSTONE = 1, //! Read from a characteristic, or notified.
+};
+
+//! Largest packet counter, the counter is PACKET_NONCE_LENGTH bytes.
+#define CCM_MAX_PACKET_COUNTER ((1UL << (8 * PACKET_NONCE_LENGTH)) - 1)
+
+/** Packet counters of the CCM packets of a session, one per direction.
+ *
+ * A CCM nonce should never be used twice with the same key. Instead of a random packet nonce, a CCM packet starts
+ * with a counter (little endian) that is incremented for every packet that is sent. The nonce is the counter, the
+ * direction, the user level and the session nonce (see the encryption section of docs/PROTOCOL.md), so the nonces are
+ * unique per session and direction, and a packet can't be reflected back to the sender.
+ *
+ * A received packet is only accepted when its counter is higher than that of the last accepted packet, so that packets
+ * can't be replayed. The counter of a packet is only accepted once its tag is checked.
+ */
+class CcmNonceCounter {
+public:
+	CcmNonceCounter(ccm_direction_t sendDirection) : _sendDirection(sendDirection) {
+		reset();
+	}
+
+	/** Start a new session: both counters start at 0.
+	 */
+	void reset() {
+		_sendCounter = 0;
+		_receiveCounter = 0;
+	}
+
+	/** Write the counter of the next packet that is sent to the packet, and create its nonce.
+	 *
+	 * @param[in,out] packet           The packet, with the user level after the counter.
+	 * @param[in]     sessionNonce     SESSION_NONCE_LENGTH bytes.
+	 * @param[out]    nonce            CCM_NONCE_LENGTH bytes.
+	 * @return                         False when all counters of this session are used.
+	 */
+	bool createSendNonce(uint8_t* packet, const uint8_t* sessionNonce, uint8_t* nonce) {
+		if (_sendCounter > CCM_MAX_PACKET_COUNTER) {
+			return false;
+		}
+		for (uint8_t i = 0; i < PACKET_NONCE_LENGTH; ++i) {
+			packet[i] = _sendCounter >> (8 * i);
+		}
+		++_sendCounter;
+		createNonce(packet, _sendDirection, sessionNonce, nonce);
+		return true;
+	}
+
+	/** Create the nonce of a received packet.
+	 *
+	 * @param[in]  packet              The packet: counter, user level.
+	 * @param[in]  sessionNonce        SESSION_NONCE_LENGTH bytes.
+	 * @param[out] nonce               CCM_NONCE_LENGTH bytes.
+	 * @return                         False when the counter is not higher than that of the last accepted packet.
+	 */
+	bool createReceiveNonce(const uint8_t* packet, const uint8_t* sessionNonce, uint8_t* nonce) const {
+		if (getCounter(packet) < _receiveCounter) {
+			return false;
+		}
+		ccm_direction_t direction = _sendDirection == CCM_DIRECTION_TO_CROWNSTONE ?
+				CCM_DIRECTION_FROM_CROWNSTONE : CCM_DIRECTION_TO_CROWNSTONE;
+		createNonce(packet, direction, sessionNonce, nonce);
+		return true;
+	}
+
+	/** Accept the counter of a received packet, after its tag was checked.
+	 */
+	void accept(const uint8_t* packet) {
+		_receiveCounter = getCounter(packet) + 1;
+	}
+
+private:
+	ccm_direction_t _sendDirection;
+
+	//! Counter of the next packet that is sent.
+	uint32_t _sendCounter;
+
+	//! Lowest counter of a packet that can be accepted.
+	uint32_t _receiveCounter;
+
+	static uint32_t getCounter(const uint8_t* packet) {
+		uint32_t counter = 0;
+		for (uint8_t i = 0; i < PACKET_NONCE_LENGTH; ++i) {
+			counter |= (uint32_t)packet[i] << (8 * i);
+		}
+		return counter;
+	}
+
+	static void createNonce(const uint8_t* packet, ccm_direction_t direction, const uint8_t* sessionNonce,
+			uint8_t* nonce) {
+		memcpy(nonce, packet, PACKET_NONCE_LENGTH);
+		nonce[PACKET_NONCE_LENGTH] = direction;
+		nonce[PACKET_NONCE_LENGTH + CCM_DIRECTION_LENGTH] = packet[PACKET_NONCE_LENGTH];
+		memcpy(nonce + PACKET_NONCE_LENGTH + CCM_DIRECTION_LENGTH + USER_LEVEL_LENGTH, sessionNonce,
+				SESSION_NONCE_LENGTH);
+	}
+};
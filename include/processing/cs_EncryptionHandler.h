@@ -12,11 +12,11 @@
 #include "nrf_soc.h"
 #include <drivers/cs_RNG.h>
 #include <events/cs_EventListener.h>
+#include <processing/cs_CcmNonceCounter.h>
+#include <processing/cs_KeystreamCache.h>
+#include <processing/cs_PacketCipher.h>
+#include <processing/cs_SoftdeviceAes.h>
 
-#define PACKET_NONCE_LENGTH  	3
-#define USER_LEVEL_LENGTH 		1
-#define VALIDATION_NONCE_LENGTH 4
-#define SESSION_NONCE_LENGTH 	5
 #define DEFAULT_SESSION_KEY 	0xcafebabe
 #define DEFAULT_SESSION_KEY_LENGTH 4
 
@@ -41,17 +41,41 @@ enum EncryptionType {
 	CTR,
 	CTR_CAFEBABE,
 	ECB_GUEST,
-	ECB_GUEST_CAFEBABE
+	ECB_GUEST_CAFEBABE,
+	CCM
 };
 
 class EncryptionHandler : EventListener {
 private:
-	EncryptionHandler()  {}
+	EncryptionHandler() : _cipher(_aes), _keystreamCipher(_keystreamAes), _ccmCounter(CCM_DIRECTION_FROM_CROWNSTONE) {}
 	~EncryptionHandler() {}
 
 	uint8_t _operationMode;
 	uint8_t _sessionNonce[SESSION_NONCE_LENGTH];
-	nrf_ecb_hal_data_t _block __attribute__ ((aligned (4)));
+
+	//! AES backend, should be declared before the cipher that uses it.
+	SoftdeviceAes _aes;
+	PacketCipher _cipher;
+
+	//! IV of the packet that is being encrypted or decrypted, the counter is set per block.
+	uint8_t _iv[AES_BLOCK_LENGTH];
+
+	//! Keystreams of the next packets, computed while idle.
+	KeystreamCache _keystreamCache;
+
+	//! AES backend and cipher of the keystream cache, so that packets can be encrypted and decrypted in an interrupt
+	//! while a keystream is computed.
+	SoftdeviceAes _keystreamAes;
+	PacketCipher _keystreamCipher;
+
+	//! Incremented whenever a key changes, part of the key id of the keystream cache, see _keyId().
+	uint8_t _keyGeneration = 0;
+
+	//! Packet counters of the CCM packets of this connection.
+	CcmNonceCounter _ccmCounter;
+
+	//! Bitmask of the access levels that encrypted a CTR packet in this connection, see _keystreamLevelBit().
+	uint8_t _keystreamLevels = 0;
 	uint8_t _setupKey[SOC_ECB_KEY_LENGTH];
 	bool _setupKeyValid = false;
 
@@ -91,6 +115,12 @@ public:
 	 */
 	bool decrypt(uint8_t* encryptedDataPacket, uint16_t encryptedDataPacketLength, uint8_t* target, uint16_t targetLength, EncryptionAccessLevel& userLevelInPackage, EncryptionType encryptionType = CTR);
 
+	/**
+	 * Compute the keystream of a next packet in advance, so that encrypt() only has to XOR it with the data.
+	 * To be called when there is nothing else to do.
+	 */
+	void precomputeKeystream();
+
 	/**
 	 * make sure we create a new nonce for each connection
 	 */
@@ -120,7 +150,7 @@ public:
 	 * Determine the required size of the decryption buffer based on how long the encrypted packet is.
 	 * The encrypted packet is the total size of what was written to the characteristic.
 	 */
-	static uint16_t calculateDecryptionBufferLength(uint16_t encryptedPacketLength);
+	static uint16_t calculateDecryptionBufferLength(uint16_t encryptedPacketLength, EncryptionType encryptionType = CTR);
 
 	/**
 	 * Generate a 16 byte key to be used during the setup phase.
@@ -138,11 +168,16 @@ private:
 
 	inline bool _encryptECB(uint8_t* data, uint8_t dataLength, uint8_t* target, uint8_t targetLength, EncryptionAccessLevel userLevel, EncryptionType encryptionType);
 	inline bool _prepareEncryptCTR(uint8_t* data, uint16_t dataLength, uint8_t* target, uint16_t targetLength, EncryptionAccessLevel userLevel, EncryptionType encryptionType);
-	inline bool _encryptCTR(uint8_t* validationNonce, uint8_t* input, uint16_t inputLength, uint8_t* output, uint16_t outputLength);
+	inline bool _encryptCTR(uint8_t* validationNonce, uint8_t* input, uint16_t inputLength, uint8_t* output, uint16_t outputLength, const uint8_t* keystream = NULL, uint16_t keystreamLength = 0);
+	bool _prepareDecrypt(uint8_t* encryptedDataPacket, uint16_t encryptedDataPacketLength, EncryptionAccessLevel& levelOfPackage, EncryptionType encryptionType, uint8_t*& validationNonce);
 	inline bool _decryptCTR(uint8_t* validationNonce, uint8_t* input, uint16_t inputLength, uint8_t* target, uint16_t targetLength);
+	bool _encryptCCM(uint8_t* data, uint16_t dataLength, uint8_t* target, uint16_t targetLength, EncryptionAccessLevel userLevel);
+	inline bool _decryptCCM(uint8_t* encryptedDataPacket, uint16_t encryptedDataPacketLength, uint8_t* target, uint16_t targetLength);
 	bool _checkAndSetKey(uint8_t userLevel);
-	bool _validateBlockLength(uint16_t length);
-	bool _validateDecryption(uint8_t* buffer, uint8_t* validationNonce);
+	bool _getKey(uint8_t userLevel, uint8_t* key);
+	static uint8_t _keystreamLevelBit(EncryptionAccessLevel userLevel);
+	uint16_t _keyId(EncryptionAccessLevel userLevel);
+	void _setKey(ConfigurationTypes keyConfigType);
 	void _generateSessionNonce();
 	void _generateNonceInTarget(uint8_t* target);
 	void _createIV(uint8_t* target, uint8_t* nonce, EncryptionType encryptionType);
@@ -0,0 +1,87 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "cfg/cs_Config.h"
+
+/** Integrates the power of each ADC buffer into the used energy.
+ *
+ * The power of a buffer is integrated over the RTC ticks since the previous buffer. The remainder of the division by
+ * the tick frequency is kept, so the energy is exactly the sum of power times time, without rounding drift. Ticks are
+ * subtracted modulo the counter size, so the counter may wrap.
+ *
+ * Buffers that the ADC had to overwrite (see ADC::getOverrunCount) are gaps: the time of those buffers is bridged
+ * with the average of the power before and after the gap. The missed buffers also tell how much time should have
+ * passed, which resolves multiple wraps of the counter. When the time since the previous buffer is more than
+ * POWER_SAMPLING_ENERGY_MAX_GAP_MS longer than expected, the sampling must have stopped: that time is not metered, but
+ * is kept up in getUnmeteredMs().
+ */
+class EnergyAccumulator {
+public:
+	EnergyAccumulator();
+
+	/** Start over, with zero energy.
+	 *
+	 * @param[in] ticksPerSecond       Frequency of the RTC.
+	 * @param[in] counterMask          Maximum value of the RTC counter, must be 2^n - 1.
+	 * @param[in] bufferIntervalUs     Time between two buffers.
+	 */
+	void init(uint32_t ticksPerSecond, uint32_t counterMask, uint32_t bufferIntervalUs);
+
+	/** Add the energy of a buffer.
+	 *
+	 * The first buffer after init only marks the start time.
+	 *
+	 * @param[in] rtcCount             RTC counter when the buffer is processed.
+	 * @param[in] powerMicroWatt       Real power of the buffer.
+	 * @param[in] numMissedBuffers     Number of buffers that were skipped since the previous buffer.
+	 */
+	void add(uint32_t rtcCount, int64_t powerMicroWatt, uint32_t numMissedBuffers);
+
+	/** Get the used energy in µJ.
+	 */
+	int64_t getEnergyMicroJoule() const {
+		return _energyMicroJoule;
+	}
+
+	/** Get the number of gaps that were bridged.
+	 */
+	uint32_t getGapCount() const {
+		return _gapCount;
+	}
+
+	/** Get the total time of the bridged gaps.
+	 */
+	uint32_t getGapMs() const;
+
+	/** Get the total time that was not metered, because the sampling had stopped.
+	 */
+	uint32_t getUnmeteredMs() const;
+
+private:
+	uint32_t _ticksPerSecond;
+	uint32_t _counterMask;
+	uint32_t _bufferIntervalUs;
+	uint32_t _maxGapTicks;
+
+	bool _started;
+	uint32_t _lastCount;
+	int64_t _lastPowerMicroWatt;
+
+	int64_t _energyMicroJoule;
+
+	//! Energy not yet added to _energyMicroJoule, in µW times ticks. Always smaller than 1 µJ.
+	int64_t _remainder;
+
+	uint32_t _gapCount;
+	uint64_t _gapTicks;
+	uint64_t _unmeteredTicks;
+
+	uint32_t ticksToMs(uint64_t ticks) const;
+};
@@ -0,0 +1,76 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "cfg/cs_Config.h"
+#include "processing/cs_PowerCalculation.h"
+
+/**
+ * Power quality of one AC period.
+ *
+ * This is the payload of EVT_POWER_QUALITY.
+ */
+typedef struct __attribute__((packed)) {
+	int16_t powerFactor;                                      //! Real power divided by apparent power, times 1000.
+	int16_t phaseShiftDeciDegrees;                            //! Phase of the current fundamental behind the voltage fundamental, in 0.1 degree.
+	uint16_t currentThd;                                      //! Total harmonic distortion of the current (of the analysed harmonics), times 1000.
+	uint16_t currentHarmonics[POWER_SAMPLING_HARMONICS_COUNT]; //! Amplitude of the 3rd, 5th, ... current harmonic, divided by the fundamental, times 1000.
+} power_quality_t;
+
+/** Estimates power factor, phase shift and current harmonics from a buffer of ADC samples.
+ *
+ * The buffer should start with exactly one AC period, so that each harmonic falls exactly on a DFT bin. Each bin is
+ * calculated with a Goertzel filter in fixed point: one multiply per sample per bin. The fundamental of the voltage
+ * is used as phase reference, the current gets a filter for the fundamental and each analysed odd harmonic.
+ *
+ * The DC offset of the samples only ends up in bin 0, so there's no need to subtract the zero lines first.
+ */
+class HarmonicAnalysis {
+public:
+	HarmonicAnalysis();
+
+	/** Analyse the first numSamples samples of a buffer.
+	 *
+	 * @param[in] power                Buffer with interleaved samples.
+	 * @param[in] numSamples           Number of samples in one AC period.
+	 * @param[in] result               Irms, Vrms and power of the same period, to calculate the power factor.
+	 */
+	void analyse(const power_t& power, uint16_t numSamples, const power_calculation_result_t& result);
+
+	/** Get the results of the last analysed buffer.
+	 */
+	const power_quality_t& getPowerQuality() const {
+		return _quality;
+	}
+
+private:
+	//! Number of Goertzel filters: voltage fundamental, current fundamental, and current harmonics.
+	static const uint8_t numBins = POWER_SAMPLING_HARMONICS_COUNT + 2;
+
+	//! Number of samples the coefficients are calculated for.
+	uint16_t _numSamples;
+
+	//! 2 * cos(2 * pi * k / numSamples) for each bin, times 2^14.
+	int32_t _coefficients[numBins];
+
+	//! sin(2 * pi * k / numSamples) for each bin, times 2^14.
+	int32_t _sines[numBins];
+
+	power_quality_t _quality;
+
+	/** Calculate the Goertzel coefficients for a number of samples per period.
+	 */
+	void initCoefficients(uint16_t numSamples);
+};
+
+/** Get the angle of a vector in 0.1 degree, between -1800 and 1800.
+ *
+ * Fixed point CORDIC, the error is below 0.1 degree.
+ */
+int16_t atan2DeciDegrees(int64_t y, int64_t x);
@@ -0,0 +1,89 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "cfg/cs_Config.h"
+#include "processing/cs_PacketCipher.h"
+
+struct keystream_cache_entry_t {
+	//! Only set once the whole keystream is computed.
+	bool valid;
+	//! Identifies the key, without keeping the key itself.
+	uint16_t keyId;
+	//! Packet nonce and session nonce, zero padded, like the IV of a packet.
+	uint8_t iv[AES_BLOCK_LENGTH];
+	//! The encrypted counter blocks of the IV, for counter 0 to KEYSTREAM_CACHE_BLOCKS - 1.
+	uint8_t keystream[KEYSTREAM_CACHE_BLOCKS * AES_BLOCK_LENGTH] __attribute__ ((aligned (4)));
+};
+
+/** Keystreams of CTR packets that are yet to be sent, computed while idle.
+ *
+ * The IV of a packet only depends on the random packet nonce and the session nonce, not on the payload. So the packet
+ * nonce can be picked in advance, and the counter blocks can be encrypted before the payload is known. When the
+ * packet is sent, only the XOR with the payload is left.
+ *
+ * Entries are keyed by a key id and the session nonce, and the counter is the block number within the keystream. The
+ * key id should change whenever the key it stands for changes. An entry is taken out when it's used, so that a
+ * keystream is never used twice.
+ *
+ * A packet can be encrypted in an interrupt while a keystream is stored: the entry that is being computed is invalid
+ * until all of its keystream is computed under its key and IV. The cipher given to store() should not be used by
+ * anything else, since it can be interrupted half way.
+ */
+class KeystreamCache {
+public:
+	KeystreamCache();
+
+	/** Whether there is a keystream for given key id and session nonce.
+	 */
+	bool contains(uint16_t keyId, const uint8_t* sessionNonce) const;
+
+	/** Compute the keystream of given IV, and store it.
+	 *
+	 * Replaces an entry when the cache is full.
+	 * Overwrites the key of the cipher.
+	 *
+	 * @param[in] cipher               Cipher that is only used for the cache.
+	 * @param[in] keyId                Id of the key.
+	 * @param[in] key                  AES_KEY_LENGTH bytes, only used to compute the keystream.
+	 * @param[in] iv                   AES_BLOCK_LENGTH bytes: packet nonce, session nonce, zero padded.
+	 */
+	void store(PacketCipher& cipher, uint16_t keyId, const uint8_t* key, const uint8_t* iv);
+
+	/** Take out the keystream for given key id and session nonce, counts a hit or a miss.
+	 *
+	 * @return                         The entry, valid until the next store(), or NULL on a miss.
+	 */
+	const keystream_cache_entry_t* take(uint16_t keyId, const uint8_t* sessionNonce);
+
+	/** Remove all entries, for example when the session nonce changes.
+	 */
+	void clear();
+
+	uint32_t getHitCount() const {
+		return _hitCount;
+	}
+
+	uint32_t getMissCount() const {
+		return _missCount;
+	}
+
+	void resetStatistics();
+
+private:
+	keystream_cache_entry_t _entries[KEYSTREAM_CACHE_ENTRIES];
+
+	//! Entry to replace when the cache is full, round robin.
+	uint8_t _nextReplace;
+
+	uint32_t _hitCount;
+	uint32_t _missCount;
+
+	int find(uint16_t keyId, const uint8_t* sessionNonce) const;
+};
@@ -0,0 +1,81 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "cfg/cs_Config.h"
+
+enum load_event_type_t {
+	LOAD_EVENT_NONE = 0,
+	LOAD_EVENT_SWITCHED_ON,
+	LOAD_EVENT_SWITCHED_OFF,
+};
+
+/**
+ * A step of the current.
+ *
+ * This is the payload of EVT_LOAD_SWITCHED.
+ */
+struct __attribute__((packed)) load_event_t {
+	uint8_t type;                 //! See load_event_type_t.
+	int32_t deltaMilliAmp;        //! Change of the filtered Irms.
+	int32_t currentRmsMilliAmp;   //! Filtered Irms after the step.
+};
+
+/** Detects appliances being switched on or off, as steps of the filtered Irms.
+ *
+ * The input is the median of the filtered Irms history, so peaks shorter than half the history don't get through. A
+ * step is a change of at least LOAD_EVENT_MIN_STEP_MILLI_AMP and LOAD_EVENT_MIN_STEP_PERCENT of the level before it.
+ * The Irms then has to stay within half the step size of the average Irms after the step, for
+ * LOAD_EVENT_DEBOUNCE_PERIODS periods, so that a ramp (like a motor that speeds up) results in a single event once it
+ * has settled. Only filtered periods count: in monitor mode of the SamplingScheduler, the debounce takes longer, but a
+ * step of the unfiltered Irms starts a burst, in which every period is filtered.
+ *
+ * Below the step size, the level follows the Irms slowly, so that drift doesn't add up to a step.
+ */
+class LoadEventDetector {
+public:
+	LoadEventDetector();
+
+	/** Start over: the next Irms is taken as the level.
+	 */
+	void reset();
+
+	/** Add the Irms of a filtered period.
+	 *
+	 * @param[in] currentRmsMilliAmp   Median of the filtered Irms.
+	 * @return                         True when a step is detected, see getEvent().
+	 */
+	bool update(int32_t currentRmsMilliAmp);
+
+	/** Get the last detected step.
+	 */
+	const load_event_t& getEvent() const {
+		return _event;
+	}
+
+	/** Get the level of the Irms.
+	 */
+	int32_t getLevel() const {
+		return _level;
+	}
+
+private:
+	bool _started;
+
+	//! Level of the Irms since the last step.
+	int32_t _level;
+
+	//! Average Irms after the step that is being debounced.
+	int32_t _candidate;
+	uint16_t _candidateCount;
+
+	load_event_t _event;
+
+	int32_t minStep(int32_t level) const;
+};
@@ -0,0 +1,172 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cfg/cs_Config.h"
+#include "processing/cs_AesBackend.h"
+
+#define PACKET_NONCE_LENGTH     3
+#define USER_LEVEL_LENGTH       1
+#define VALIDATION_NONCE_LENGTH 4
+#define SESSION_NONCE_LENGTH    5
+
+#define CCM_MIN_NONCE_LENGTH    7
+#define CCM_MAX_NONCE_LENGTH    13
+#define CCM_DIRECTION_LENGTH    1
+//! Nonce of a CCM packet: packet counter, direction, user level, session nonce, see CcmNonceCounter.
+#define CCM_NONCE_LENGTH        (PACKET_NONCE_LENGTH + CCM_DIRECTION_LENGTH + USER_LEVEL_LENGTH + SESSION_NONCE_LENGTH)
+//! The block number of a CCM packet is in the last byte of the counter block, as with CTR.
+#define CCM_MAX_PAYLOAD_LENGTH  (255 * AES_BLOCK_LENGTH)
+
+/** The block modes of the encrypted packets, see the encryption section of docs/PROTOCOL.md.
+ *
+ * CTR: the counter block is the IV (packet nonce and session nonce, zero padded), with the block number in the last
+ * byte. The cleartext is the validation nonce followed by the payload, zero padded to whole blocks.
+ *
+ * ECB: a single block.
+ *
+ * CCM (NIST SP 800-38C, RFC 3610): CTR encryption of the payload, without padding, and a CBC-MAC over the nonce, the
+ * associated data and the payload, encrypted and truncated to a tag behind the payload. The MAC is one AES block per
+ * 16 bytes that has to be computed in order, so it can't be batched like the counter blocks.
+ *
+ * The counter blocks are encrypted AES_BATCH_BLOCKS at a time, and XORed with the data word by word.
+ *
+ * This class has no dependencies on the SoftDevice, the settings or the connection, those are left to
+ * EncryptionHandler. The AES itself is done by the given backend, so that the packet encryption can be tested and
+ * benchmarked on the host.
+ */
+class PacketCipher {
+public:
+	PacketCipher(AesBackend& aes);
+
+	/** Set the key for the following packets.
+	 *
+	 * @param[in] key                  AES_KEY_LENGTH bytes.
+	 */
+	void setKey(const uint8_t* key);
+
+	/** Encrypt a single block.
+	 */
+	void encryptEcb(const uint8_t* cleartext, uint8_t* ciphertext);
+
+	/** Encrypt the validation nonce and the input.
+	 *
+	 * The outputLength should be larger than 0 and a multiple of 16 or this will return false.
+	 * It is possible that the input is smaller than the output, in this case it will be zero padded.
+	 *
+	 * @param[in] iv                   AES_BLOCK_LENGTH bytes, the last byte is replaced by the counter.
+	 * @param[in] validationNonce      VALIDATION_NONCE_LENGTH bytes, put in front of the input.
+	 * @param[in] keystream            Optional keystream of the same IV, made with keystream(). The blocks that it
+	 *                                 covers are XORed right away, the rest is encrypted as usual.
+	 * @param[in] keystreamLength      Length of the keystream, a multiple of 16.
+	 */
+	bool encryptCtr(const uint8_t* iv, const uint8_t* validationNonce, const uint8_t* input, uint16_t inputLength,
+			uint8_t* output, uint16_t outputLength, const uint8_t* keystream = NULL, uint16_t keystreamLength = 0);
+
+	/** Encrypt the counter blocks of an IV in advance, starting at counter 0.
+	 *
+	 * @param[in] iv                   AES_BLOCK_LENGTH bytes, the last byte is replaced by the counter.
+	 * @param[out] keystream           The encrypted counter blocks.
+	 * @param[in] keystreamLength      Length of the keystream, a multiple of 16.
+	 */
+	void keystream(const uint8_t* iv, uint8_t* keystream, uint16_t keystreamLength);
+
+	/** Decrypt the input, check the validation nonce, and write the payload to the target.
+	 *
+	 * The input length should be a multiple of 16 bytes.
+	 * It is possible that the target is smaller than the input, in this case the remainder is discarded.
+	 *
+	 * @param[in] iv                   AES_BLOCK_LENGTH bytes, the last byte is replaced by the counter.
+	 * @param[in] validationNonce      VALIDATION_NONCE_LENGTH bytes, expected in front of the payload.
+	 */
+	bool decryptCtr(const uint8_t* iv, const uint8_t* validationNonce, const uint8_t* input, uint16_t inputLength,
+			uint8_t* target, uint16_t targetLength);
+
+	/** Decrypt the data where it is, and check the validation nonce.
+	 *
+	 * Afterwards, the payload starts at data + VALIDATION_NONCE_LENGTH, no copy is needed.
+	 * On failure, the data may be partly decrypted.
+	 *
+	 * @param[in] iv                   AES_BLOCK_LENGTH bytes, the last byte is replaced by the counter.
+	 * @param[in] validationNonce      VALIDATION_NONCE_LENGTH bytes, expected in front of the payload.
+	 * @param[in,out] data             The encrypted blocks, replaced by the decrypted blocks.
+	 * @param[in] length               Length of the data, a multiple of 16.
+	 */
+	bool decryptCtrInPlace(const uint8_t* iv, const uint8_t* validationNonce, uint8_t* data, uint16_t length);
+
+	/** Encrypt and authenticate the input with CCM.
+	 *
+	 * The output is the ciphertext, of the same length as the input, followed by the tag. The output may be the input.
+	 *
+	 * @param[in] nonce                Between CCM_MIN_NONCE_LENGTH and CCM_MAX_NONCE_LENGTH bytes, unique per key.
+	 * @param[in] aad                  Associated data: authenticated, but not encrypted. May be NULL if aadLength is 0.
+	 * @param[in] inputLength          At most CCM_MAX_PAYLOAD_LENGTH.
+	 * @param[out] output              inputLength + tagLength bytes.
+	 * @param[in] tagLength            An even number from 4 to 16.
+	 */
+	bool encryptCcm(const uint8_t* nonce, uint8_t nonceLength, const uint8_t* aad, uint16_t aadLength,
+			const uint8_t* input, uint16_t inputLength, uint8_t* output, uint8_t tagLength);
+
+	/** Decrypt the input with CCM, and check the tag.
+	 *
+	 * The target may be the input. On failure, the target is cleared.
+	 *
+	 * @param[in] input                The ciphertext, followed by the tag.
+	 * @param[in] inputLength          Length of the ciphertext and the tag.
+	 * @param[out] target              inputLength - tagLength bytes.
+	 */
+	bool decryptCcm(const uint8_t* nonce, uint8_t nonceLength, const uint8_t* aad, uint16_t aadLength,
+			const uint8_t* input, uint16_t inputLength, uint8_t* target, uint8_t tagLength);
+
+	/** Verify if the block length is correct: a multiple of the block length, and not 0.
+	 */
+	static bool validBlockLength(uint16_t length);
+
+private:
+	AesBackend& _aes;
+
+	//! A batch of counter blocks: the IV with the counter.
+	uint8_t _counterBlocks[AES_BATCH_BLOCKS * AES_BLOCK_LENGTH] __attribute__ ((aligned (4)));
+
+	//! Number of counter blocks that have the IV of the current packet.
+	uint8_t _counterBlockCount;
+
+	//! Encrypted counter blocks, XORed with the data.
+	uint8_t _keystream[AES_BATCH_BLOCKS * AES_BLOCK_LENGTH] __attribute__ ((aligned (4)));
+
+	//! Start a packet with given IV.
+	void startCtr(const uint8_t* iv);
+
+	/** Encrypt the counter blocks of given block numbers.
+	 *
+	 * @param[in] counter              Block number of the first block.
+	 * @param[in] blockCount           Number of blocks, at most AES_BATCH_BLOCKS.
+	 * @param[out] keystream           The encrypted counter blocks.
+	 */
+	void encryptCounters(uint16_t counter, uint8_t blockCount, uint8_t* keystream);
+
+	/** Check the CCM parameters, compute the MAC of the first block and the associated data, and start the counter
+	 * blocks.
+	 *
+	 * @param[out] mac                 AES_BLOCK_LENGTH bytes, the MAC so far.
+	 */
+	bool startCcm(const uint8_t* nonce, uint8_t nonceLength, const uint8_t* aad, uint16_t aadLength,
+			uint16_t payloadLength, uint8_t tagLength, uint8_t* mac);
+
+	/** Continue the CBC-MAC with the data, zero padded to whole blocks.
+	 */
+	void cbcMac(uint8_t* mac, const uint8_t* data, uint16_t length);
+
+	/** XOR the payload with the counter blocks 1 and on.
+	 *
+	 * @param[out] tagKeystream        AES_BLOCK_LENGTH bytes: counter block 0, to encrypt the tag with.
+	 */
+	void ccmCtr(const uint8_t* input, uint8_t* output, uint16_t length, uint8_t* tagKeystream);
+};
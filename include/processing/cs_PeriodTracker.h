@@ -0,0 +1,86 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "cfg/cs_Config.h"
+#include "processing/cs_PowerCalculation.h"
+
+/** Tracks the period of the mains voltage, from the zero crossings in the ADC buffers.
+ *
+ * Each buffer is searched for upward zero crossings of the voltage, with some hysteresis against noise. The position
+ * of a crossing is interpolated between the two samples around it, in 1/256 sample. The buffers follow each other
+ * without gaps, so the time between two crossings can span multiple buffers. Intervals outside of the allowed mains
+ * frequency range (for example because a buffer was skipped) are ignored, the others are averaged.
+ *
+ * The power calculation then integrates over one period, rounded to whole samples, instead of a fixed 20 ms. This way
+ * 60 Hz and drifting mains are handled as well. The ADC buffers are sized to hold the longest accepted period.
+ */
+class PeriodTracker {
+public:
+	PeriodTracker();
+
+	/** Start over, with the nominal period.
+	 *
+	 * @param[in] sampleIntervalUs     Time between two samples of a channel.
+	 */
+	void init(uint32_t sampleIntervalUs);
+
+	/** Find the zero crossings of the voltage in a buffer.
+	 *
+	 * Should be called for every buffer, in order.
+	 *
+	 * @param[in] power                Buffer with interleaved samples.
+	 * @param[in] zeroVoltage          Zero line of the voltage (times 1000).
+	 */
+	void update(const power_t& power, int32_t zeroVoltage);
+
+	/** Returns true when the period has been measured a few times in a row.
+	 */
+	bool isLocked() const {
+		return _numMeasurements >= POWER_SAMPLING_PERIOD_LOCK_COUNT;
+	}
+
+	/** Get the measured period, or the nominal period when not locked.
+	 */
+	uint32_t getPeriodUs() const;
+
+	/** Get the period rounded to whole samples, at most the given number of samples.
+	 *
+	 * This is the value to use as acPeriodUs of the power struct.
+	 */
+	uint32_t getWindowUs(uint16_t maxSamples) const;
+
+private:
+	uint32_t _sampleIntervalUs;
+
+	//! Averaged period, in 1/256 sample.
+	uint32_t _period;
+
+	//! Number of accepted period measurements, up to the lock count.
+	uint16_t _numMeasurements;
+
+	//! Index of the first sample of the next buffer, counted from init.
+	uint32_t _sampleCount;
+
+	//! Position of the last upward zero crossing, in 1/256 sample.
+	uint32_t _lastCrossing;
+
+	//! Whether _lastCrossing is valid.
+	bool _lastCrossingValid;
+
+	//! Whether the voltage went below the hysteresis, so that the next upward crossing can be detected.
+	bool _armed;
+
+	//! Last voltage sample of the previous buffer, minus the zero (times 1000).
+	int32_t _lastVoltage;
+
+	/** Handle a zero crossing at given position (in 1/256 sample).
+	 */
+	void onCrossing(uint32_t position);
+};
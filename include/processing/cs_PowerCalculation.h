@@ -0,0 +1,176 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "cfg/cs_Config.h"
+#include "structs/buffer/cs_MedianWindow.h"
+#include "processing/cs_PowerKernel.h"
+#include "processing/cs_BlockMedianFilter.h"
+#include "processing/cs_SlidingMedianFilter.h"
+
+/**
+ * Struct that defines the buffer received from the ADC sampler in scanning mode.
+ *
+ * The samples of all channels are interleaved: buf[i*numChannels + voltageIndex] is the i-th voltage sample.
+ * The sample type is the same as nrf_saadc_value_t, but is kept free of Nordic headers so that it can be used on the
+ * host as well.
+ */
+typedef struct {
+	int16_t* buf;
+	uint16_t bufSize;
+	uint16_t numChannels;
+	uint16_t voltageIndex;
+	uint16_t currentIndex;
+	uint32_t sampleIntervalUs;
+	uint32_t acPeriodUs;
+} power_t;
+
+/**
+ * Calibration and averaging parameters, as read from the settings.
+ */
+typedef struct {
+	float voltageMultiplier;         //! Voltage multiplier (mV per adc value, divided by 1000).
+	float currentMultiplier;         //! Current multiplier (mA per adc value, divided by 1000).
+	int32_t voltageZero;             //! Initial value of the voltage zero (adc value).
+	int32_t currentZero;             //! Initial value of the current zero (adc value).
+	int32_t powerZero;               //! Power offset (mW).
+	uint16_t avgZeroVoltageDiscount; //! Discount of the exponential moving average of the voltage zero (divided by 1000).
+	uint16_t avgZeroCurrentDiscount; //! Discount of the exponential moving average of the current zero (divided by 1000).
+	uint16_t avgPowerDiscount;       //! Discount of the exponential moving average of the power (divided by 1000).
+} power_calculation_config_t;
+
+/**
+ * Values that were calculated from the last buffer.
+ */
+typedef struct {
+	int32_t currentRmsMilliAmp;                 //! Irms of this period.
+	int32_t currentRmsMedianMilliAmp;           //! Median of Irms over the last periods.
+	int32_t filteredCurrentRmsMilliAmp;         //! Irms of the median filtered current curve of the last filtered period.
+	int32_t filteredCurrentRmsMedianMilliAmp;   //! Median of the filtered Irms over the last filtered periods.
+	int32_t voltageRmsMilliVolt;                //! Vrms of this period.
+	int32_t avgVoltageRmsMilliVolt;             //! Median of Vrms over the last periods.
+	int32_t powerMilliWatt;                     //! Real power of this period.
+	int64_t powerMicroWatt;                     //! Real power of this period, in µW, to meter the energy.
+	int32_t avgPowerMilliWatt;                  //! Exponential moving average of the real power.
+	uint32_t powerMilliWattApparent;            //! Apparent power: Irms * Vrms.
+} power_calculation_result_t;
+
+/** Calculates power, Irms and Vrms from buffers of ADC samples.
+ *
+ * This class holds all the math of the power sampling: the zero line estimates, the median filter of the current
+ * curve, and the filtering of Irms, Vrms and power over multiple periods. It has no dependencies on the hardware,
+ * timers or the event system, so it can also be compiled for and tested on the host.
+ *
+ * PowerSampling feeds every filled ADC buffer to process(), then reads the results to update the state and check the
+ * soft fuse.
+ */
+class PowerCalculation {
+public:
+	PowerCalculation();
+
+	/** Set the calibration values, and start over with the zero lines of the config.
+	 */
+	void init(const power_calculation_config_t& config);
+
+	/** Reset the averages to the values given in the config.
+	 */
+	void initAverages();
+
+	/** Change the current multiplier, when the range of the current channel changed.
+	 *
+	 * The zero current is scaled along, so that it stays the same current.
+	 */
+	void setCurrentMultiplier(float currentMultiplier);
+
+	/** Process a buffer: filter the current curve, update the zero lines and calculate the power.
+	 *
+	 * Without filtering the current curve, the filtered Irms and its median keep the values of the last filtered buffer,
+	 * the current zero is not updated, and the filtered current curve is left as it was.
+	 *
+	 * @param[in] power                Buffer with interleaved samples, should contain at least one AC period.
+	 * @param[in] filterCurrent        Whether to filter the current curve.
+	 * @return                         True when the results are updated.
+	 */
+	bool process(const power_t& power, bool filterCurrent = true);
+
+	/** Get the results of the last processed buffer.
+	 */
+	const power_calculation_result_t& getResult() const {
+		return _result;
+	}
+
+	/** Get the median filtered current curve of the last processed buffer.
+	 */
+	const int16_t* getFilteredCurrent() const {
+		return _filteredSamples;
+	}
+
+	//! Get the average zero voltage (times 1000).
+	int32_t getAvgZeroVoltage() const {
+		return _avgZeroVoltage;
+	}
+
+	//! Get the average zero current (times 1000).
+	int32_t getAvgZeroCurrent() const {
+		return _avgZeroCurrent;
+	}
+
+private:
+	power_calculation_config_t _config;
+
+	fixed_multiplier_t _currentMultiplier; //! Current multiplier of the config, in fixed point.
+	fixed_multiplier_t _voltageMultiplier; //! Voltage multiplier of the config, in fixed point.
+	fixed_multiplier_t _powerMultiplier;   //! Current multiplier times voltage multiplier, in fixed point.
+
+	power_calculation_result_t _result;
+
+	int32_t _avgZeroVoltage; //! Used for storing and calculating the average zero voltage value (times 1000).
+	int32_t _avgZeroCurrent; //! Used for storing and calculating the average zero current value (times 1000).
+	bool _recalibrateZeroVoltage; //! Whether or not the zero voltage value should be recalculated.
+	bool _recalibrateZeroCurrent; //! Whether or not the zero current value should be recalculated.
+
+	//! Number of samples of the current curve in a buffer.
+	static const uint16_t curveSize = CS_ADC_BUF_SIZE / 2;
+
+#if POWER_SAMPLING_CURVE_SLIDING_MEDIAN == 1
+	typedef SlidingMedianFilter<POWER_SAMPLING_CURVE_HALF_WINDOW_SIZE> CurveFilter;
+#else
+	static const uint16_t curveWindowSize = 2 * POWER_SAMPLING_CURVE_HALF_WINDOW_SIZE + 1;
+	typedef BlockMedianFilter<POWER_SAMPLING_CURVE_HALF_WINDOW_SIZE,
+			(curveSize + 2 * POWER_SAMPLING_CURVE_HALF_WINDOW_SIZE + curveWindowSize - 1) / curveWindowSize> CurveFilter;
+#endif
+	CurveFilter _curveFilter; //! Moving median filter of the current curve.
+	int16_t _filteredSamples[curveSize]; //! Used for storing the filtered samples.
+
+	typedef MedianWindow<int32_t, POWER_SAMPLING_RMS_WINDOW_SIZE> RmsHistory;
+
+	RmsHistory _currentRmsMilliAmpHist;  //! Used to store a history of the current_rms
+	RmsHistory _filteredCurrentRmsHistMA; //! Used to store a history of the filtered current_rms
+	RmsHistory _voltageRmsMilliVoltHist; //! Used to store a history of the voltage_rms
+
+	/** Calculate the value of the zero line of the voltage samples
+	 */
+	void calculateVoltageZero(const power_sums_t& sums);
+
+	/** Calculate the value of the zero line of the current samples
+	 */
+	void calculateCurrentZero(const power_sums_t& sums);
+
+	/** Filter the samples
+	 */
+	void filter(const power_t& power);
+
+	/** Calculate the average power usage
+	 */
+	void calculatePower(const power_sums_t& sums, const power_sums_t& filteredSums, bool filtered);
+
+	/** Push a value to a history, and return the median of the history, or the average when it is not full yet.
+	 */
+	int32_t pushAndGetMedian(RmsHistory& hist, int32_t value);
+};
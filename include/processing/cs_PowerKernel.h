@@ -0,0 +1,438 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define POWER_KERNEL_SIMD 1
+#include <immintrin.h>
+#else
+#define POWER_KERNEL_SIMD 0
+#endif
+
+/** Fixed point integer kernels to calculate RMS and power from ADC samples.
+ *
+ * The Cortex-M4F has a single precision FPU and a 32 bit hardware divide, but a 64 bit division is a library call, and
+ * the float path converted every sample between int and float. So the per sample work is limited to 32 bit multiplies
+ * and 64 bit additions, without divisions or conversions. The zero offsets (in 1/1000 adc values, as PowerCalculation
+ * stores them) are only applied to the sums, and the calibration is applied once per period, with a fixed point
+ * multiplier.
+ *
+ * The sums stay exact up to about 5*10^5 samples: 2^63 / (2^12 * 1000 * 2^12 * 1000).
+ *
+ * This header has no dependencies, so that recorded traces can be processed offline with the same code as on the
+ * device. On x86-64, the sums are made with SSE2 or AVX2 (picked at run time) when the samples are interleaved in
+ * pairs, as they come from the ADC. Since all sums are integer sums, the order doesn't matter and the results are
+ * bit-identical to the scalar loop on the device.
+ */
+
+/**
+ * Sums of the raw samples of one channel, or of two channels and their product.
+ */
+typedef struct {
+	uint16_t count;
+	int32_t sumVoltage;
+	int32_t sumCurrent;
+	uint64_t sumVoltageSquare;
+	uint64_t sumCurrentSquare;
+	int64_t sumProduct;
+} power_sums_t;
+
+/**
+ * Multiplier in fixed point: value = mantissa / 2^shift.
+ */
+typedef struct {
+	int32_t mantissa;
+	uint8_t shift;
+} fixed_multiplier_t;
+
+/** Convert a (calibration) multiplier to fixed point, with 24 bits of precision.
+ *
+ * Only to be used at init: this loops over the exponent with float operations.
+ */
+inline fixed_multiplier_t toFixedMultiplier(float value) {
+	fixed_multiplier_t multiplier;
+	bool negative = value < 0;
+	if (negative) {
+		value = -value;
+	}
+	multiplier.shift = 0;
+	while (value != 0 && value < (1 << 23) && multiplier.shift < 62) {
+		value *= 2;
+		++multiplier.shift;
+	}
+	while (value >= (1 << 24) && multiplier.shift > 0) {
+		value /= 2;
+		--multiplier.shift;
+	}
+	multiplier.mantissa = (int32_t)(value + 0.5f);
+	if (negative) {
+		multiplier.mantissa = -multiplier.mantissa;
+	}
+	return multiplier;
+}
+
+/** Multiply a value with a fixed point multiplier, rounded towards zero (like a cast of a float).
+ *
+ * The value must be smaller than 2^39, so that the product fits in 64 bits.
+ */
+inline int64_t applyMultiplier(int64_t value, fixed_multiplier_t multiplier) {
+	bool negative = (value < 0) != (multiplier.mantissa < 0);
+	uint64_t product = (uint64_t)(value < 0 ? -value : value);
+	product *= (uint32_t)(multiplier.mantissa < 0 ? -multiplier.mantissa : multiplier.mantissa);
+	product >>= multiplier.shift;
+	return negative ? -(int64_t)product : (int64_t)product;
+}
+
+/** Integer square root, rounded down.
+ *
+ * Bit by bit, so only shifts, additions and compares.
+ */
+inline uint32_t isqrt64(uint64_t value) {
+	uint64_t result = 0;
+	uint64_t bit = (uint64_t)1 << 62;
+	while (bit > value) {
+		bit >>= 2;
+	}
+	while (bit != 0) {
+		if (value >= result + bit) {
+			value -= result + bit;
+			result = (result >> 1) + bit;
+		}
+		else {
+			result >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t)result;
+}
+
+/** Update a zero offset with the average of the samples of a period, with an exponential moving average.
+ *
+ * @param[in]  avgZero             Zero offset, times 1000.
+ * @param[in]  sum                 Sum of the samples of a period.
+ * @param[in]  count               Number of samples.
+ * @param[in]  discount            Weight of the new average (divided by 1000).
+ * @return                         The new zero offset, times 1000.
+ */
+inline int32_t updateZero(int32_t avgZero, int32_t sum, uint16_t count, int64_t discount) {
+	int32_t zero = (int64_t)sum * 1000 / count;
+	return ((1000 - discount) * avgZero + discount * zero) / 1000;
+}
+
+/** Scalar implementation of sumPower().
+ */
+inline void sumPowerScalar(const int16_t* voltage, const int16_t* current, uint16_t stride, uint16_t count, power_sums_t& sums) {
+	int32_t sumVoltage = 0;
+	int32_t sumCurrent = 0;
+	uint64_t sumVoltageSquare = 0;
+	uint64_t sumCurrentSquare = 0;
+	int64_t sumProduct = 0;
+	for (uint16_t i = 0; i < count * stride; i += stride) {
+		int32_t v = voltage[i];
+		int32_t c = current[i];
+		sumVoltage += v;
+		sumCurrent += c;
+		sumVoltageSquare += (uint32_t)(v * v);
+		sumCurrentSquare += (uint32_t)(c * c);
+		sumProduct += v * c;
+	}
+	sums.count = count;
+	sums.sumVoltage = sumVoltage;
+	sums.sumCurrent = sumCurrent;
+	sums.sumVoltageSquare = sumVoltageSquare;
+	sums.sumCurrentSquare = sumCurrentSquare;
+	sums.sumProduct = sumProduct;
+}
+
+#if POWER_KERNEL_SIMD == 1
+
+/** Add the 32 bit lanes of a vector.
+ */
+inline int32_t horizontalSum32(const int32_t* lanes, uint8_t numLanes) {
+	int32_t sum = 0;
+	for (uint8_t i = 0; i < numLanes; ++i) {
+		sum += lanes[i];
+	}
+	return sum;
+}
+
+inline int64_t horizontalSum64(const int64_t* lanes, uint8_t numLanes) {
+	int64_t sum = 0;
+	for (uint8_t i = 0; i < numLanes; ++i) {
+		sum += lanes[i];
+	}
+	return sum;
+}
+
+/** Add the sums of the remaining samples, and assign the sums of the first and second channel to voltage and current.
+ */
+inline void finishInterleaved(const int16_t* first, bool voltageFirst, uint16_t done, uint16_t count,
+		int32_t sumA, int32_t sumB, uint64_t sumASquare, uint64_t sumBSquare, int64_t sumProduct, power_sums_t& sums) {
+	// The scalar loop takes the first channel as voltage.
+	power_sums_t rest;
+	sumPowerScalar(first + 2 * done, first + 2 * done + 1, 2, count - done, rest);
+	sumA += rest.sumVoltage;
+	sumB += rest.sumCurrent;
+	sumASquare += rest.sumVoltageSquare;
+	sumBSquare += rest.sumCurrentSquare;
+	sums.count = count;
+	sums.sumVoltage = voltageFirst ? sumA : sumB;
+	sums.sumCurrent = voltageFirst ? sumB : sumA;
+	sums.sumVoltageSquare = voltageFirst ? sumASquare : sumBSquare;
+	sums.sumCurrentSquare = voltageFirst ? sumBSquare : sumASquare;
+	sums.sumProduct = sumProduct + rest.sumProduct;
+}
+
+/** SSE2 implementation of sumPower(), for two interleaved channels.
+ *
+ * Each 32 bit lane holds a sample of the first channel (a) and of the second channel (b). Masking one of them out
+ * makes every multiply-add a single product, so the squares and products can't overflow a lane.
+ *
+ * @param[in]  first               Pointer to the first sample of the first channel.
+ * @param[in]  voltageFirst        True when the first channel is the voltage.
+ */
+inline void sumPowerSse2(const int16_t* first, bool voltageFirst, uint16_t count, power_sums_t& sums) {
+	const __m128i lowMask = _mm_set1_epi32(0xFFFF);
+	const __m128i one = _mm_set1_epi32(1);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sumA = zero;
+	__m128i sumB = zero;
+	__m128i sumASquare = zero;
+	__m128i sumBSquare = zero;
+	__m128i sumProduct = zero;
+	uint16_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i*)(first + 2 * i));
+		__m128i a = _mm_and_si128(x, lowMask);
+		__m128i b = _mm_srli_epi32(x, 16);
+		sumA = _mm_add_epi32(sumA, _mm_madd_epi16(a, one));
+		sumB = _mm_add_epi32(sumB, _mm_madd_epi16(b, one));
+		__m128i aSquare = _mm_madd_epi16(a, a);
+		__m128i bSquare = _mm_madd_epi16(b, b);
+		__m128i product = _mm_madd_epi16(a, b);
+		__m128i productSign = _mm_srai_epi32(product, 31);
+		sumASquare = _mm_add_epi64(sumASquare, _mm_unpacklo_epi32(aSquare, zero));
+		sumASquare = _mm_add_epi64(sumASquare, _mm_unpackhi_epi32(aSquare, zero));
+		sumBSquare = _mm_add_epi64(sumBSquare, _mm_unpacklo_epi32(bSquare, zero));
+		sumBSquare = _mm_add_epi64(sumBSquare, _mm_unpackhi_epi32(bSquare, zero));
+		sumProduct = _mm_add_epi64(sumProduct, _mm_unpacklo_epi32(product, productSign));
+		sumProduct = _mm_add_epi64(sumProduct, _mm_unpackhi_epi32(product, productSign));
+	}
+	int32_t lanes32[2][4];
+	int64_t lanes64[3][2];
+	_mm_storeu_si128((__m128i*)lanes32[0], sumA);
+	_mm_storeu_si128((__m128i*)lanes32[1], sumB);
+	_mm_storeu_si128((__m128i*)lanes64[0], sumASquare);
+	_mm_storeu_si128((__m128i*)lanes64[1], sumBSquare);
+	_mm_storeu_si128((__m128i*)lanes64[2], sumProduct);
+	finishInterleaved(first, voltageFirst, i, count, horizontalSum32(lanes32[0], 4), horizontalSum32(lanes32[1], 4),
+			horizontalSum64(lanes64[0], 2), horizontalSum64(lanes64[1], 2), horizontalSum64(lanes64[2], 2), sums);
+}
+
+/** AVX2 implementation of sumPower(), the same as sumPowerSse2(), with twice as many lanes.
+ *
+ * Only to be called when the CPU supports AVX2.
+ */
+__attribute__((target("avx2")))
+inline void sumPowerAvx2(const int16_t* first, bool voltageFirst, uint16_t count, power_sums_t& sums) {
+	const __m256i lowMask = _mm256_set1_epi32(0xFFFF);
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i sumA = zero;
+	__m256i sumB = zero;
+	__m256i sumASquare = zero;
+	__m256i sumBSquare = zero;
+	__m256i sumProduct = zero;
+	uint16_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i x = _mm256_loadu_si256((const __m256i*)(first + 2 * i));
+		__m256i a = _mm256_and_si256(x, lowMask);
+		__m256i b = _mm256_srli_epi32(x, 16);
+		sumA = _mm256_add_epi32(sumA, _mm256_madd_epi16(a, one));
+		sumB = _mm256_add_epi32(sumB, _mm256_madd_epi16(b, one));
+		__m256i aSquare = _mm256_madd_epi16(a, a);
+		__m256i bSquare = _mm256_madd_epi16(b, b);
+		__m256i product = _mm256_madd_epi16(a, b);
+		__m256i productSign = _mm256_srai_epi32(product, 31);
+		sumASquare = _mm256_add_epi64(sumASquare, _mm256_unpacklo_epi32(aSquare, zero));
+		sumASquare = _mm256_add_epi64(sumASquare, _mm256_unpackhi_epi32(aSquare, zero));
+		sumBSquare = _mm256_add_epi64(sumBSquare, _mm256_unpacklo_epi32(bSquare, zero));
+		sumBSquare = _mm256_add_epi64(sumBSquare, _mm256_unpackhi_epi32(bSquare, zero));
+		sumProduct = _mm256_add_epi64(sumProduct, _mm256_unpacklo_epi32(product, productSign));
+		sumProduct = _mm256_add_epi64(sumProduct, _mm256_unpackhi_epi32(product, productSign));
+	}
+	int32_t lanes32[2][8];
+	int64_t lanes64[3][4];
+	_mm256_storeu_si256((__m256i*)lanes32[0], sumA);
+	_mm256_storeu_si256((__m256i*)lanes32[1], sumB);
+	_mm256_storeu_si256((__m256i*)lanes64[0], sumASquare);
+	_mm256_storeu_si256((__m256i*)lanes64[1], sumBSquare);
+	_mm256_storeu_si256((__m256i*)lanes64[2], sumProduct);
+	finishInterleaved(first, voltageFirst, i, count, horizontalSum32(lanes32[0], 8), horizontalSum32(lanes32[1], 8),
+			horizontalSum64(lanes64[0], 4), horizontalSum64(lanes64[1], 4), horizontalSum64(lanes64[2], 4), sums);
+}
+
+inline bool cpuSupportsAvx2() {
+	static const bool supported = __builtin_cpu_supports("avx2");
+	return supported;
+}
+
+#endif // POWER_KERNEL_SIMD
+
+/** Sum the samples of a voltage and a current channel, their squares and their product.
+ *
+ * @param[in]  voltage             Pointer to the first voltage sample.
+ * @param[in]  current             Pointer to the first current sample.
+ * @param[in]  stride              Distance between two consecutive samples (the number of interleaved channels).
+ * @param[in]  count               Number of samples of each channel.
+ * @param[out] sums                The sums.
+ */
+inline void sumPower(const int16_t* voltage, const int16_t* current, uint16_t stride, uint16_t count, power_sums_t& sums) {
+#if POWER_KERNEL_SIMD == 1
+	if (stride == 2 && (current == voltage + 1 || voltage == current + 1)) {
+		bool voltageFirst = voltage < current;
+		const int16_t* first = voltageFirst ? voltage : current;
+		if (cpuSupportsAvx2()) {
+			sumPowerAvx2(first, voltageFirst, count, sums);
+		}
+		else {
+			sumPowerSse2(first, voltageFirst, count, sums);
+		}
+		return;
+	}
+#endif
+	sumPowerScalar(voltage, current, stride, count, sums);
+}
+
+/** Sum the samples of a single (current) channel and their squares.
+ *
+ * Only count, sumCurrent and sumCurrentSquare are set.
+ */
+template <typename T>
+inline void sumCurrentScalar(const T* current, uint16_t count, power_sums_t& sums) {
+	int32_t sum = 0;
+	uint64_t sumSquare = 0;
+	for (uint16_t i = 0; i < count; ++i) {
+		int32_t c = current[i];
+		sum += c;
+		sumSquare += (uint32_t)(c * c);
+	}
+	sums.count = count;
+	sums.sumCurrent = sum;
+	sums.sumCurrentSquare = sumSquare;
+}
+
+template <typename T>
+inline void sumCurrent(const T* current, uint16_t count, power_sums_t& sums) {
+	sumCurrentScalar(current, count, sums);
+}
+
+#if POWER_KERNEL_SIMD == 1
+
+/** SSE2 implementation of sumCurrent(), for 16 bit samples.
+ *
+ * A multiply-add of two squares is at most 2^31, which still fits in an unsigned lane.
+ */
+inline void sumCurrent(const int16_t* current, uint16_t count, power_sums_t& sums) {
+	const __m128i one = _mm_set1_epi16(1);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sum = zero;
+	__m128i sumSquare = zero;
+	uint16_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m128i x = _mm_loadu_si128((const __m128i*)(current + i));
+		__m128i square = _mm_madd_epi16(x, x);
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(x, one));
+		sumSquare = _mm_add_epi64(sumSquare, _mm_unpacklo_epi32(square, zero));
+		sumSquare = _mm_add_epi64(sumSquare, _mm_unpackhi_epi32(square, zero));
+	}
+	int32_t lanes32[4];
+	int64_t lanes64[2];
+	_mm_storeu_si128((__m128i*)lanes32, sum);
+	_mm_storeu_si128((__m128i*)lanes64, sumSquare);
+	sumCurrentScalar(current + i, count - i, sums);
+	sums.count = count;
+	sums.sumCurrent += horizontalSum32(lanes32, 4);
+	sums.sumCurrentSquare += horizontalSum64(lanes64, 2);
+}
+
+/** SSE2 implementation of sumCurrent(), for 32 bit samples.
+ *
+ * Like the scalar loop, only the lower 32 bits of each square are summed.
+ */
+inline void sumCurrent(const int32_t* current, uint16_t count, power_sums_t& sums) {
+	const __m128i lowMask = _mm_set1_epi64x(0xFFFFFFFF);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sum = zero;
+	__m128i sumSquare = zero;
+	uint16_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i*)(current + i));
+		__m128i odd = _mm_srli_epi64(x, 32);
+		sum = _mm_add_epi32(sum, x);
+		sumSquare = _mm_add_epi64(sumSquare, _mm_and_si128(_mm_mul_epu32(x, x), lowMask));
+		sumSquare = _mm_add_epi64(sumSquare, _mm_and_si128(_mm_mul_epu32(odd, odd), lowMask));
+	}
+	int32_t lanes32[4];
+	int64_t lanes64[2];
+	_mm_storeu_si128((__m128i*)lanes32, sum);
+	_mm_storeu_si128((__m128i*)lanes64, sumSquare);
+	sumCurrentScalar(current + i, count - i, sums);
+	sums.count = count;
+	sums.sumCurrent += horizontalSum32(lanes32, 4);
+	sums.sumCurrentSquare += horizontalSum64(lanes64, 2);
+}
+
+#endif // POWER_KERNEL_SIMD
+
+/** Get sum((1000*x - zero)^2) from sum(x) and sum(x^2).
+ *
+ * @param[in]  sum                 Sum of the samples.
+ * @param[in]  sumSquare           Sum of the squares of the samples.
+ * @param[in]  zero                Zero offset, times 1000.
+ * @param[in]  count               Number of samples.
+ */
+inline uint64_t centeredSquareSum(int32_t sum, uint64_t sumSquare, int32_t zero, uint16_t count) {
+	return 1000 * 1000 * sumSquare - (int64_t)2000 * zero * sum + (int64_t)count * zero * zero;
+}
+
+/** Get sum((1000*v - zeroVoltage) * (1000*c - zeroCurrent)) from the sums.
+ */
+inline int64_t centeredProductSum(const power_sums_t& sums, int32_t zeroVoltage, int32_t zeroCurrent) {
+	return 1000 * 1000 * sums.sumProduct - (int64_t)1000 * zeroCurrent * sums.sumVoltage
+			- (int64_t)1000 * zeroVoltage * sums.sumCurrent + (int64_t)sums.count * zeroVoltage * zeroCurrent;
+}
+
+/** Get the RMS, from the centered square sum.
+ *
+ * @param[in]  squareSum           Result of centeredSquareSum().
+ * @param[in]  count               Number of samples.
+ * @param[in]  multiplier          Current or voltage multiplier (A or V per adc value), so that the RMS is in mA or mV.
+ */
+inline int32_t rmsFromSquareSum(uint64_t squareSum, uint16_t count, fixed_multiplier_t multiplier) {
+	return applyMultiplier(isqrt64(squareSum / count), multiplier);
+}
+
+/** Get the average power, from the centered product sum.
+ *
+ * @param[in]  productSum          Result of centeredProductSum().
+ * @param[in]  count               Number of samples.
+ * @param[in]  multiplier          Current multiplier times voltage multiplier, so that the power is in mW.
+ */
+inline int32_t powerFromProductSum(int64_t productSum, uint16_t count, fixed_multiplier_t multiplier) {
+	return applyMultiplier(productSum / ((int32_t)count * 1000), multiplier);
+}
+
+/** Get the average power in µW, from the centered product sum.
+ *
+ * The resolution is 10 µW: the product sum is first scaled to that, to stay within the range of applyMultiplier().
+ */
+inline int64_t powerMicroWattFromProductSum(int64_t productSum, uint16_t count, fixed_multiplier_t multiplier) {
+	return applyMultiplier(productSum / ((int32_t)count * 10), multiplier) * 10;
+}
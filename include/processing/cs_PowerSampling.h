@@ -13,7 +13,15 @@ extern "C" {
 #include "structs/buffer/cs_CircularBuffer.h"
 #include "cfg/cs_Boards.h"
 #include "drivers/cs_ADC.h"
-#include "third/Median.h"
+#include "processing/cs_PowerCalculation.h"
+#include "processing/cs_HarmonicAnalysis.h"
+#include "processing/cs_PeriodTracker.h"
+#include "processing/cs_AdcRangeController.h"
+#include "processing/cs_EnergyAccumulator.h"
+#include "processing/cs_LoadEventDetector.h"
+#include "processing/cs_SoftFuse.h"
+#include "processing/cs_SamplingScheduler.h"
+#include "processing/cs_WaveformCodec.h"
 #include "events/cs_EventListener.h"
 #include "processing/cs_Switch.h"
 
@@ -72,19 +80,6 @@ public:
 	 */
 	void handleEvent(uint16_t evt, void* p_data, uint16_t length);
 
-	/**
-	 * Struct that defines the buffer received from the ADC sampler in scanning mode.
-	 */
-	typedef struct {
-		nrf_saadc_value_t* buf;
-		uint16_t bufSize;
-		uint16_t numChannels;
-		uint16_t voltageIndex;
-		uint16_t currentIndex;
-		uint32_t sampleIntervalUs;
-		uint32_t acPeriodUs;
-	} power_t;
-
 
 private:
 	PowerSampling();
@@ -102,50 +97,68 @@ private:
 	//! Operation mode of this device.
 	uint8_t _operationMode;
 
-	//! Buffer that holds the data of the power samples.
+	//! Buffer that holds the data of the power samples, or of a compressed waveform chunk.
 	buffer_ptr_t _powerSamplesBuffer;
 
+	//! Size of the power samples buffer.
+	uint16_t _powerSamplesBufferSize;
+
+	//! Whether to stream compressed waveform chunks, instead of sending a burst of samples every few seconds.
+	bool _streamingEnabled;
+
+	//! Compresses the buffers to stream.
+	WaveformEncoder _waveformEncoder;
+
+	//! Number of buffers that were handed to the power sampling, the overruns excluded.
+	uint32_t _numProcessedBuffers;
+
 	//! Power samples to be sent via characteristic.
 	PowerSamples _powerSamples;
 
-	float _voltageMultiplier; //! Voltage multiplier from settings.
-	float _currentMultiplier; //! Current multiplier from settings.
-	int32_t _voltageZero; //! Voltage zero from settings.
-	int32_t _currentZero; //! Current zero from settings.
-	int32_t _powerZero; //! Power zero from settings.
-
-	bool _sendingSamples; //! Whether or not currently sending power samples.
+	//! The power math: zero lines, filters, Irms, Vrms and power.
+	PowerCalculation _powerCalculation;
 
-	uint16_t _avgZeroCurrentDiscount;
-	uint16_t _avgZeroVoltageDiscount;
-	uint16_t _avgPowerDiscount;
+#if POWER_SAMPLING_PERIOD_TRACKING == 1
+	//! Measures the mains period, so that the power is calculated over whole periods.
+	PeriodTracker _periodTracker;
+#endif
 
-	int32_t _avgZeroVoltage; //! Used for storing and calculating the average zero voltage value (times 1000).
-	int32_t _avgZeroCurrent; //! Used for storing and calculating the average zero current value (times 1000).
-	bool _recalibrateZeroVoltage; //! Whether or not the zero voltage value should be recalculated.
-	bool _recalibrateZeroCurrent; //! Whether or not the zero current value should be recalculated.
-	double _avgPower; //! Used for storing and calculating the average power (in mW).
-	int32_t _avgPowerMilliWatt; //! Used to send out the average power (in mW).
-	int32_t _avgCurrentRmsMilliAmp; //! Used for storing the average rms current (in mA).
-	int32_t _avgVoltageRmsMilliVolt; //! Used for storing the average rms voltage (in mV).
+#if POWER_SAMPLING_HARMONIC_ANALYSIS == 1
+	//! Power factor, phase shift and current harmonics.
+	HarmonicAnalysis _harmonicAnalysis;
+#endif
 
-	PowerVector* _inputSamples;  //! Used for storing the samples to be filtered.
-	PowerVector* _outputSamples; //! Used for storing the filtered samples.
-	MedianFilter* _filterParams;  //! Stores the parameters for the moving median filter.
+#if POWER_SAMPLING_SCHEDULER == 1
+	//! Decides which periods get the median filter, harmonic analysis and sample copies.
+	SamplingScheduler _samplingScheduler;
+#endif
 
-	CircularBuffer<int32_t>* _powerMilliWattHist;      //! Used to store a history of the power
-	CircularBuffer<int32_t>* _currentRmsMilliAmpHist;  //! Used to store a history of the current_rms
-	CircularBuffer<int32_t>* _filteredCurrentRmsHistMA; //! Used to store a history of the filtered current_rms
-	CircularBuffer<int32_t>* _voltageRmsMilliVoltHist; //! Used to store a history of the voltage_rms
-	int32_t _histCopy[POWER_SAMPLING_RMS_WINDOW_SIZE];     //! Used to copy a history to (so it can be used to calculate the median)
-	uint16_t _consecutivePwmOvercurrent;
+	int32_t _voltageZero; //! Voltage zero from settings.
 
+	bool _sendingSamples; //! Whether or not currently sending power samples.
 
 	uint16_t _currentMilliAmpThreshold;    //! Current threshold from settings.
 	uint16_t _currentMilliAmpThresholdPwm; //! Current threshold when using dimmer from settings.
 
-	uint32_t _lastEnergyCalculationTicks; //! Ticks of RTC when last energy calculation was performed.
-	int64_t _energyUsedmicroJoule; //! Energy used in micro joule
+#if LOAD_EVENT_DETECTION == 1
+	//! Detects the attached appliance being switched on or off.
+	LoadEventDetector _loadEventDetector;
+#endif
+
+	SoftFuse _softFuse;    //! Soft fuse of the relay.
+	SoftFuse _softFusePwm; //! Soft fuse of the dimmer.
+
+#if POWER_SAMPLING_AUTO_RANGE == 1
+	AdcRangeController _rangeController; //! Picks the range and gain of the current channel.
+	bool _autoRange;                     //! Whether the range controller is in use, debug commands turn it off.
+	bool _rangeChangePending;            //! Whether the ADC still has to apply a level of the range controller.
+	uint8_t _rangeCalibratedLevel;       //! Level at which the current multiplier is calibrated.
+	float _currentMultiplier;            //! Current multiplier at the calibrated level.
+#endif
+
+	EnergyAccumulator _energyAccumulator; //! Integrates the power into the used energy.
+	uint32_t _lastOverrunCount;           //! Overrun count of the ADC at the last energy calculation.
+	uint32_t _numUncalculatedBuffers;     //! Buffers without a power calculation since the last energy calculation.
 
 	switch_state_t _lastSwitchState; //! Stores the last seen switch state.
 	uint32_t _lastSwitchOffTicks;    //! RTC ticks when the switch was last turned off.
@@ -184,37 +197,27 @@ private:
 	 */
 	void readyToSendPowerSamples();
 
-	/** Initialize the moving averages
+	/** Compress the adc samples into a waveform chunk, and send it out over bluetooth
 	 */
-	void initAverages();
-	
+	void streamBuffer(const power_t& power);
+
 	/** Determine which index is actually the current index, this should not be necessary!
 	 */
 	uint16_t determineCurrentIndex(power_t power);
 
-	/** Calculate the value of the zero line of the voltage samples
-	 */
-	void calculateVoltageZero(power_t power);
-
-	/** Calculate the value of the zero line of the current samples
-	 */
-	void calculateCurrentZero(power_t power);
-
-	/** Filter the samples
-	 */
-	void filter(power_t power);
-
-	/** Calculate the average power usage
+	/** Print the calculated values and the curves, if enabled
 	 */
-	void calculatePower(power_t power);
+	void printPowerSamples(const power_t& power);
 
-	/** Calculate the energy used
+	/** Calculate the energy used, only for buffers of which the power was calculated.
 	 */
 	void calculateEnergy();
 
-	/** If current goes beyond predefined threshold levels, take action!
+	/** If current goes beyond predefined threshold levels for too long, take action!
+	 *
+	 * @param[in] periodUs             Duration of the period of the given Irms.
 	 */
-	void checkSoftfuse(int32_t currentRmsMilliAmp, int32_t currentRmsMilliAmpFiltered);
+	void checkSoftfuse(int32_t currentRmsMilliAmp, int32_t currentRmsMilliAmpFiltered, uint32_t periodUs);
 
 	/** Start IGBT failure detection
 	 */
@@ -227,5 +230,17 @@ private:
 	void toggleDifferentialModeVoltage();
 
 	void changeRange(uint8_t channel, int32_t amount);
+
+#if POWER_SAMPLING_AUTO_RANGE == 1
+	/** Check the current range with the range controller, and apply a new range once the ADC uses it.
+	 *
+	 * @param[in] power                Buffer that was just processed.
+	 */
+	void updateRange(const power_t& power);
+
+	/** Stop changing the range automatically, because it's changed by a debug command.
+	 */
+	void disableAutoRange();
+#endif
 };
 
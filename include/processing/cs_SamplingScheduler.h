@@ -0,0 +1,83 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "cfg/cs_Config.h"
+
+enum sampling_mode_t {
+	SAMPLING_MODE_MONITOR = 0, //! Only a period every POWER_SAMPLING_MONITOR_INTERVAL_MS is fully processed.
+	SAMPLING_MODE_BURST,       //! Every period is fully processed.
+};
+
+/** Decides which ADC buffers get the full processing.
+ *
+ * The ADC samples continuously, and every period gets the cheap part of the processing: the sums of the samples, which
+ * give the Irms, Vrms and power for the soft fuses and the energy. The expensive part (the median filter of the current
+ * curve, the harmonic analysis, and copying or streaming the samples) only has to run every period when something
+ * happens. While the Irms is steady, only a period every POWER_SAMPLING_MONITOR_INTERVAL_MS is fully processed.
+ *
+ * A burst (every period fully processed for POWER_SAMPLING_BURST_MS) is started by a step of the Irms, an Irms near
+ * the current threshold, or a request (like switching). A hold keeps the burst going, for streaming or logging.
+ *
+ * Soft fuse latency: the soft fuses get an Irms every period in both modes. Without the median filter, that is the
+ * unfiltered Irms, which is only higher than the filtered Irms. Above POWER_SAMPLING_BURST_GUARD_PERCENT of the
+ * threshold, every period is filtered again, from the next period on.
+ */
+class SamplingScheduler {
+public:
+	SamplingScheduler();
+
+	/** Start in burst mode.
+	 *
+	 * @param[in] guardMilliAmp        Irms above which every period is fully processed.
+	 */
+	void init(int32_t guardMilliAmp);
+
+	/** Fully process every period for POWER_SAMPLING_BURST_MS.
+	 */
+	void requestBurst();
+
+	/** Keep fully processing every period, as long as hold is set.
+	 */
+	void setHold(bool hold);
+
+	/** Whether the next period should be fully processed.
+	 */
+	bool processNext() const;
+
+	/** Update the mode after a period.
+	 *
+	 * @param[in] currentRmsMilliAmp   Unfiltered Irms of the period.
+	 * @param[in] periodUs             Duration of the period.
+	 * @param[in] processed            Whether the period was fully processed.
+	 */
+	void update(int32_t currentRmsMilliAmp, uint32_t periodUs, bool processed);
+
+	sampling_mode_t getMode() const {
+		return _mode;
+	}
+
+private:
+	sampling_mode_t _mode;
+	bool _hold;
+	int32_t _guardMilliAmp;
+
+	//! Irms of the last fully processed period, steps are measured from there.
+	int32_t _referenceMilliAmp;
+	bool _referenceValid;
+
+	//! Time left in the burst.
+	uint32_t _burstLeftUs;
+
+	//! Time since the last fully processed period, and the duration of the last period.
+	uint32_t _sinceProcessedUs;
+	uint32_t _lastPeriodUs;
+
+	int32_t minStep(int32_t currentRmsMilliAmp) const;
+};
@@ -0,0 +1,154 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+/** Running median filter with a window of 2*halfWindowSize+1 samples.
+ *
+ * The window is kept sorted, in a ring buffer. Each step the oldest sample is removed and the newest one is inserted,
+ * which only shifts the samples on the shorter side of their position. On the slopes of a sinusoid the oldest sample
+ * is the lowest and the newest the highest (or the other way around), so nothing has to be shifted at all. The median
+ * is simply the middle of the sorted window.
+ *
+ * The input is read in place from the interleaved ADC buffer, no copy is made. Like the block sort median, the input
+ * is padded at both ends with the first and last sample, so the output has as many samples as the input, and is
+ * identical to the output of sort_median() for the same padded input.
+ *
+ * @param halfWindowSize           Number of samples on each side of the output sample. Can be any value above 0.
+ */
+template <uint16_t halfWindowSize>
+class SlidingMedianFilter {
+public:
+	static const uint16_t windowSize = 2 * halfWindowSize + 1;
+
+	/** Filter a curve.
+	 *
+	 * @param[in]  input               Pointer to the first sample.
+	 * @param[in]  stride              Distance between two consecutive samples (the number of interleaved channels).
+	 * @param[in]  count               Number of samples to filter.
+	 * @param[out] output              Array of at least count elements, to write the filtered samples to.
+	 */
+	template <typename T>
+	void filter(const int16_t* input, uint16_t stride, uint16_t count, T* output) {
+		if (count == 0) {
+			return;
+		}
+		// Fill the window for the first output sample: the padding (which is already sorted), then the first samples.
+		_start = 0;
+		for (_size = 0; _size <= halfWindowSize; ++_size) {
+			_ring[_size] = input[0];
+		}
+		for (int32_t i = 1; i <= halfWindowSize; ++i) {
+			insert(at(input, stride, count, i));
+		}
+		output[0] = get(halfWindowSize);
+		for (int32_t i = 1; i < count; ++i) {
+			int16_t oldValue = at(input, stride, count, i - halfWindowSize - 1);
+			int16_t newValue = at(input, stride, count, i + halfWindowSize);
+			if (oldValue != newValue) {
+				remove(oldValue);
+				insert(newValue);
+			}
+			output[i] = get(halfWindowSize);
+		}
+	}
+
+private:
+	//! Smallest power of 2 that is larger than the window size, so that indices can be wrapped with a mask.
+	static const uint16_t capacity =
+			windowSize < 16 ? 16 : windowSize < 32 ? 32 : windowSize < 64 ? 64 : windowSize < 128 ? 128 : 256;
+	static const uint16_t mask = capacity - 1;
+
+	//! The samples in the window, sorted, starting at _start.
+	int16_t _ring[capacity];
+
+	//! Index in the ring of the lowest value.
+	uint16_t _start;
+
+	//! Number of values in the window.
+	uint16_t _size;
+
+	//! Get the value at given position in the sorted window.
+	inline int16_t get(uint16_t pos) const {
+		return _ring[(_start + pos) & mask];
+	}
+
+	inline void set(uint16_t pos, int16_t value) {
+		_ring[(_start + pos) & mask] = value;
+	}
+
+	//! Get input sample at index, clamped to the first and last sample.
+	inline int16_t at(const int16_t* input, uint16_t stride, uint16_t count, int32_t index) const {
+		if (index < 0) {
+			index = 0;
+		}
+		else if (index >= count) {
+			index = count - 1;
+		}
+		return input[index * stride];
+	}
+
+	//! Position of the first value in the sorted window that is not lower than the given value.
+	inline uint16_t lowerBound(int16_t value) const {
+		// Most of the time, the value is at one of the ends.
+		if (_size == 0 || value <= get(0)) {
+			return 0;
+		}
+		if (value > get(_size - 1)) {
+			return _size;
+		}
+		// Binary search, without branches in the loop body.
+		uint16_t low = 0;
+		uint16_t len = _size;
+		while (len > 1) {
+			uint16_t half = len / 2;
+			low = (get(low + half - 1) < value) ? low + half : low;
+			len -= half;
+		}
+		return (get(low) < value) ? low + 1 : low;
+	}
+
+	//! Remove a value, which must be in the window.
+	inline void remove(int16_t value) {
+		uint16_t pos = lowerBound(value);
+		if (pos < _size / 2) {
+			// Shift the lower values up.
+			for (uint16_t i = pos; i > 0; --i) {
+				set(i, get(i-1));
+			}
+			_start = (_start + 1) & mask;
+		}
+		else {
+			// Shift the higher values down.
+			for (uint16_t i = pos; i < _size - 1; ++i) {
+				set(i, get(i+1));
+			}
+		}
+		--_size;
+	}
+
+	//! Insert a value, the window must not be full.
+	inline void insert(int16_t value) {
+		uint16_t pos = lowerBound(value);
+		if (pos < _size / 2) {
+			// Shift the lower values down.
+			_start = (_start - 1) & mask;
+			for (uint16_t i = 0; i < pos; ++i) {
+				set(i, get(i+1));
+			}
+		}
+		else {
+			// Shift the higher values up.
+			for (uint16_t i = _size; i > pos; --i) {
+				set(i, get(i-1));
+			}
+		}
+		set(pos, value);
+		++_size;
+	}
+};
@@ -0,0 +1,108 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "cfg/cs_Config.h"
+
+enum soft_fuse_load_class_t {
+	SOFT_FUSE_LOAD_RESISTIVE = 0,
+	SOFT_FUSE_LOAD_MOTOR,
+	SOFT_FUSE_LOAD_ELECTRONIC,
+	SOFT_FUSE_NUM_LOAD_CLASSES
+};
+
+/**
+ * Trip curve of a load class.
+ */
+struct soft_fuse_curve_t {
+	uint16_t tripMs;       //! Time to trip at SOFT_FUSE_TRIP_MULTIPLE_PERCENT of the threshold.
+	uint16_t shortPercent; //! Trip when the current is above this percentage of the threshold ..
+	uint8_t shortPeriods;  //! .. for this many periods in a row.
+	uint8_t maxPeriods;    //! Trip when the current is above the threshold for this many periods in a row, 0 for never.
+};
+
+/** Decides when the current has been too high for too long, like a thermal fuse.
+ *
+ * The fuse heats up with I² - Ith² every period, where Ith is the threshold current, and cools down in the same way
+ * below the threshold, but never below zero. It trips when the heat reaches (m² - 1) * Ith² * tripMs, so that a
+ * current of m times the threshold trips after tripMs, a higher current sooner, and a current just above the
+ * threshold only after a long time. A short (a current above shortPercent of the threshold for shortPeriods) trips
+ * right away. A curve also caps the time above the threshold, for mild overcurrent that heats up slowly: the default
+ * curves trip when the current stays above the threshold for as many periods as fit in tripMs.
+ *
+ * Each load class has its own curve: motors may draw several times their current for some periods while starting,
+ * while a resistive load drawing that much is a fault. The class follows the given class during the first
+ * SOFT_FUSE_CLASS_LATCH_PERIODS periods of heating, so that the inrush of a motor gets the motor curve. After that, it
+ * is latched until the fuse cooled down: a stale or flipping class can't change the curve of an ongoing overload.
+ */
+class SoftFuse {
+public:
+	SoftFuse();
+
+	/** Set the threshold, the default curves of the relay, and cool down.
+	 *
+	 * @param[in] thresholdMilliAmp    Current that may flow forever.
+	 */
+	void init(uint32_t thresholdMilliAmp);
+
+	/** Change the trip curve of a load class.
+	 */
+	void setCurve(soft_fuse_load_class_t loadClass, const soft_fuse_curve_t& curve);
+
+	/** Cool down.
+	 */
+	void reset();
+
+	/** Add the current of a period.
+	 *
+	 * @param[in] currentRmsMilliAmp   Irms of the period.
+	 * @param[in] periodUs             Duration of the period.
+	 * @param[in] loadClass            Class of the load, which determines the trip curve, unless it's latched.
+	 * @return                         True when the fuse trips.
+	 */
+	bool update(int32_t currentRmsMilliAmp, uint32_t periodUs, soft_fuse_load_class_t loadClass);
+
+	/** Get the load class of which the curve is used.
+	 */
+	soft_fuse_load_class_t getLoadClass() const {
+		return _loadClass;
+	}
+
+	/** Get the heat, as percentage of the heat at which the fuse trips with given load class.
+	 */
+	uint32_t getHeatPercent(soft_fuse_load_class_t loadClass) const;
+
+	/** Determine the load class from the power quality.
+	 *
+	 * @param[in] phaseShiftDeciDegrees  Phase of the current fundamental behind the voltage.
+	 * @param[in] currentThd             Total harmonic distortion of the current, times 1000.
+	 */
+	static soft_fuse_load_class_t classify(int16_t phaseShiftDeciDegrees, uint16_t currentThd);
+
+private:
+	uint32_t _thresholdMilliAmp;
+	soft_fuse_curve_t _curves[SOFT_FUSE_NUM_LOAD_CLASSES];
+
+	//! Heat in mA² ms.
+	int64_t _heat;
+
+	//! Number of periods in a row with a current above the short percentage.
+	uint8_t _shortCount;
+
+	//! Number of periods in a row with a current above the threshold.
+	uint8_t _aboveCount;
+
+	//! Load class of which the curve is used.
+	soft_fuse_load_class_t _loadClass;
+
+	//! Number of periods that the fuse has been heated, up to SOFT_FUSE_CLASS_LATCH_PERIODS.
+	uint8_t _heatedCount;
+
+	int64_t tripHeat(soft_fuse_load_class_t loadClass) const;
+};
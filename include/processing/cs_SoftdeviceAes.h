@@ -0,0 +1,28 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include "nrf_soc.h"
+
+#include "processing/cs_AesBackend.h"
+
+/** AES backend of the device: the ECB peripheral, through the SoftDevice.
+ */
+class SoftdeviceAes : public AesBackend {
+public:
+	void setKey(const uint8_t* key);
+
+	void encryptBlock(const uint8_t* cleartext, uint8_t* ciphertext);
+
+	/** The SoftDevice only encrypts a single block per call, but the blocks can be copied in and out of the aligned
+	 * ECB data structure word wise, without a virtual call per block.
+	 */
+	void encryptBlocks(const uint8_t* cleartext, uint8_t* ciphertext, uint16_t blockCount);
+
+private:
+	nrf_ecb_hal_data_t _block __attribute__ ((aligned (4)));
+};
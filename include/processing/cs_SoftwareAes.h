@@ -0,0 +1,56 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include "processing/cs_AesBackend.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SOFTWARE_AES_NI 1
+#else
+#define SOFTWARE_AES_NI 0
+#endif
+
+/** Portable AES-128 encryption, for the host.
+ *
+ * A byte oriented implementation of FIPS-197, without lookup tables other than the S-box, so it's small rather than
+ * fast. On x86-64, the AES-NI instructions are used when the CPU has them.
+ */
+class SoftwareAes : public AesBackend {
+public:
+	/**
+	 * @param[in] allowAesNi           Whether to use AES-NI when the CPU has it.
+	 */
+	SoftwareAes(bool allowAesNi = true);
+
+	void setKey(const uint8_t* key);
+
+	void encryptBlock(const uint8_t* cleartext, uint8_t* ciphertext);
+
+	/** With AES-NI, four blocks are encrypted at once, so that the latency of the rounds overlaps.
+	 */
+	void encryptBlocks(const uint8_t* cleartext, uint8_t* ciphertext, uint16_t blockCount);
+
+	//! Whether the AES-NI instructions are used.
+	bool usesAesNi() const {
+		return _useAesNi;
+	}
+
+private:
+	static const uint8_t numRounds = 10;
+
+	//! Expanded key: a round key for the initial round and each of the rounds.
+	uint8_t _roundKeys[(numRounds + 1) * AES_BLOCK_LENGTH] __attribute__ ((aligned (16)));
+
+	bool _useAesNi;
+
+	void encryptBlockPortable(const uint8_t* cleartext, uint8_t* ciphertext);
+
+#if SOFTWARE_AES_NI == 1
+	void encryptBlockAesNi(const uint8_t* cleartext, uint8_t* ciphertext);
+	void encryptBlocksAesNi(const uint8_t* cleartext, uint8_t* ciphertext, uint16_t blockCount);
+#endif
+};
@@ -0,0 +1,106 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "processing/cs_PowerCalculation.h"
+
+#define POWER_WAVEFORM_PROTOCOL 1
+
+/** Header of a compressed waveform chunk, followed by the voltage and then the current channel.
+ *
+ * Each channel is byte aligned, and starts with the code width (1 byte) and the first sample (int16_t). Then, for every
+ * next sample, a residual of width bits: the sample minus the prediction 2*x[n-1] - x[n-2] (for the second sample the
+ * prediction is x[n-1]). Residuals that don't fit are sent as the escape code -2^(width-1), followed by the full
+ * sample in 16 bits. Bits are packed LSB first.
+ */
+struct __attribute__((__packed__)) power_waveform_header_t {
+	uint8_t protocol;
+	uint16_t sequence;          //! Number of the ADC buffer, so that buffers that were not sent can be detected.
+	uint32_t timestamp;         //! RTC count when the buffer was processed.
+	uint16_t sampleIntervalUs;  //! Time between two samples of a channel.
+	uint16_t numSamples;        //! Number of samples per channel.
+};
+
+//! Smallest and largest code width. Residuals of int16_t samples need at most 19 bits, so the largest width never needs
+//! an escape code.
+#define POWER_WAVEFORM_MIN_WIDTH 2
+#define POWER_WAVEFORM_MAX_WIDTH 19
+
+/** Compresses ADC buffers into waveform chunks.
+ */
+class WaveformEncoder {
+public:
+	/** Encode both channels of a buffer.
+	 *
+	 * @param[in] power                Buffer with interleaved samples.
+	 * @param[in] sequence             Sequence number to put in the header: the number of the buffer.
+	 * @param[in] timestamp            Timestamp to put in the header.
+	 * @param[out] out                 Buffer to write the chunk to.
+	 * @param[in] outSize              Size of the buffer.
+	 * @return                         Size of the chunk, or 0 when it didn't fit.
+	 */
+	uint16_t encode(const power_t& power, uint16_t sequence, uint32_t timestamp, uint8_t* out, uint16_t outSize);
+
+	/** Encode one channel.
+	 *
+	 * @param[in] samples              First sample.
+	 * @param[in] stride               Distance between two samples.
+	 * @param[in] count                Number of samples, at least 1.
+	 * @param[out] out                 Buffer to write to.
+	 * @param[in] outSize              Size of the buffer.
+	 * @return                         Number of bytes written, or 0 when it didn't fit.
+	 */
+	static uint16_t encodeChannel(const int16_t* samples, uint16_t stride, uint16_t count, uint8_t* out, uint16_t outSize);
+
+	/** Largest possible size of a chunk with given number of samples per channel.
+	 */
+	static uint16_t maxEncodedSize(uint16_t numSamples) {
+		return sizeof(power_waveform_header_t) + 2 * maxChannelSize(numSamples);
+	}
+
+	static uint16_t maxChannelSize(uint16_t numSamples) {
+		return 1 + sizeof(int16_t) + ((numSamples - 1) * POWER_WAVEFORM_MAX_WIDTH + 7) / 8;
+	}
+};
+
+/** Decompresses waveform chunks, as a receiver would.
+ */
+class WaveformDecoder {
+public:
+	WaveformDecoder();
+
+	/** Decode a chunk.
+	 *
+	 * @param[in] in                   The chunk.
+	 * @param[in] size                 Size of the chunk.
+	 * @param[out] header              Header of the chunk.
+	 * @param[out] voltage             Voltage samples.
+	 * @param[out] current             Current samples.
+	 * @param[in] maxSamples           Size of the sample buffers.
+	 * @return                         False when the chunk is invalid.
+	 */
+	bool decode(const uint8_t* in, uint16_t size, power_waveform_header_t& header, int16_t* voltage, int16_t* current, uint16_t maxSamples);
+
+	/** Decode one channel.
+	 *
+	 * @return                         Number of bytes read, or 0 when the data is invalid.
+	 */
+	static uint16_t decodeChannel(const uint8_t* in, uint16_t size, uint16_t count, int16_t* samples);
+
+	/** Number of buffers that were missed, according to the sequence numbers.
+	 */
+	uint32_t getNumMissed() const {
+		return _numMissed;
+	}
+
+private:
+	bool _started;
+	uint16_t _nextSequence;
+	uint32_t _numMissed;
+};
@@ -6,6 +6,7 @@ enum MeshStateItemType {
 	MESH_STATE_ITEM_TYPE_STATE = 0,
 	MESH_STATE_ITEM_TYPE_ERROR = 1,
 	MESH_STATE_ITEM_TYPE_EVENT_STATE = 2,
+	MESH_STATE_ITEM_TYPE_LOAD_EVENT = 3,
 };
 
 struct __attribute__((__packed__)) state_item_state_t {
@@ -28,12 +29,23 @@ struct __attribute__((__packed__)) state_item_error_t {
 	uint16_t  partialTimestamp;
 };
 
+//! An appliance that was switched on or off, see LoadEventDetector.
+struct __attribute__((__packed__)) state_item_load_event_t {
+	stone_id_t id;
+	uint8_t   eventType; // See load_event_type_t.
+	int32_t   deltaMilliAmp;
+	int32_t   currentRmsMilliAmp;
+	uint8_t   switchState;
+	uint16_t  partialTimestamp;
+};
+
 struct __attribute__((__packed__)) state_item_t {
 	uint8_t   type;
 	union {
 		state_item_state_t state;
 		state_item_error_t error;
 		state_item_state_t eventState; // Uses same struct as normal state
+		state_item_load_event_t loadEvent;
 	};
 };
 
@@ -66,6 +78,8 @@ inline stone_id_t meshStateItemGetId(state_item_t* item) {
 		return item->error.id;
 	case MESH_STATE_ITEM_TYPE_EVENT_STATE:
 		return item->eventState.id;
+	case MESH_STATE_ITEM_TYPE_LOAD_EVENT:
+		return item->loadEvent.id;
 	default:
 		return 0;
 	}
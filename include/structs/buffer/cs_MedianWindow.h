@@ -0,0 +1,125 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+/** Window of the last values, that keeps track of their median.
+ *
+ * The values are stored twice: in order of arrival, to know which one is the oldest, and sorted. Pushing a value into a
+ * full window removes the oldest value from the sorted array and inserts the new one, shifting only the values in
+ * between, so no copy or sort is needed to get the median.
+ *
+ * @param T                        Element type, should be an integer type.
+ * @param capacity                 Number of values in the window, can be any value above 0.
+ */
+template <class T, uint16_t capacity>
+class MedianWindow {
+public:
+	MedianWindow(): _head(0), _size(0), _sum(0) {}
+
+	/** Remove all values.
+	 */
+	void clear() {
+		_head = 0;
+		_size = 0;
+		_sum = 0;
+	}
+
+	/** Add a value, removes the oldest value when the window is full.
+	 */
+	void push(T value) {
+		uint16_t pos;
+		if (capacity < 2) {
+			// The new value replaces the only value.
+			_sum = 0;
+			_size = 1;
+			pos = 0;
+		}
+		else if (_size == capacity) {
+			T oldest = _values[_head];
+			_sum -= oldest;
+			// Find the oldest value in the sorted array, and shift the values between there and the new position.
+			pos = 0;
+			while (_sorted[pos] != oldest) {
+				++pos;
+			}
+			if (value < oldest) {
+				while (pos > 0 && value < _sorted[pos - 1]) {
+					_sorted[pos] = _sorted[pos - 1];
+					--pos;
+				}
+			}
+			else {
+				while (pos < capacity - 1 && _sorted[pos + 1] < value) {
+					_sorted[pos] = _sorted[pos + 1];
+					++pos;
+				}
+			}
+		}
+		else {
+			pos = _size;
+			while (pos > 0 && value < _sorted[pos - 1]) {
+				_sorted[pos] = _sorted[pos - 1];
+				--pos;
+			}
+			++_size;
+		}
+		_sorted[pos] = value;
+		_values[_head] = value;
+		_head = (_head + 1) % capacity;
+		_sum += value;
+	}
+
+	/** Returns true when the window is full.
+	 */
+	bool full() const {
+		return _size == capacity;
+	}
+
+	/** Returns the number of values in the window.
+	 */
+	uint16_t size() const {
+		return _size;
+	}
+
+	/** Returns the median of the values, or the average of the middle two values for an even number of values.
+	 *
+	 * The window should not be empty.
+	 */
+	T median() const {
+		if (_size % 2) {
+			return _sorted[_size / 2];
+		}
+		return ((int64_t)_sorted[_size / 2 - 1] + _sorted[_size / 2]) / 2;
+	}
+
+	/** Returns the average of the values.
+	 *
+	 * The window should not be empty.
+	 */
+	T average() const {
+		return _sum / _size;
+	}
+
+private:
+	//! The values, in order of arrival.
+	T _values[capacity];
+
+	//! The values, sorted.
+	T _sorted[capacity];
+
+	//! Index in _values where the next value will be written, this is the oldest value when the window is full.
+	uint16_t _head;
+
+	//! Number of values in the window.
+	uint16_t _size;
+
+	//! Sum of the values.
+	int64_t _sum;
+
+};
@@ -0,0 +1,138 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+/** Lock-free single producer, single consumer queue of a fixed number of items.
+ *
+ * Meant to hand small descriptors (like a buffer pointer and size) from an interrupt handler to the main thread,
+ * without critical regions: the producer only writes the tail, the consumer only writes the head. The interrupt
+ * never waits: when the queue is full, push() fails, and the item counts as overrun.
+ *
+ * Only one context may push, and only one context may pop. Several interrupt handlers can share the producer side
+ * when they can't preempt each other, or when they push from within a critical region.
+ *
+ * The statistics only show the backlog in this queue. When the producer only pushes after the consumer is done with
+ * the previous item, like the ADC does, the high water stays at 1, and there are no overruns: the backlog is where
+ * the producer keeps the items it didn't push yet.
+ *
+ * The indices are written with release, and read with acquire semantics, so that an item is completely written
+ * before the consumer sees it, and completely read before the producer overwrites it. On the Cortex-M4 these are
+ * plain loads and stores with a memory barrier.
+ *
+ * @param T                        Type of the items, should be cheap to copy.
+ * @param capacity                 Maximum number of items in the queue.
+ */
+template <class T, uint16_t capacity>
+class SpscQueue {
+public:
+	SpscQueue() {
+		reset();
+	}
+
+	/** Empty the queue, and reset the statistics.
+	 *
+	 * Only when neither the producer nor the consumer is using the queue.
+	 */
+	void reset() {
+		_head = 0;
+		_tail = 0;
+		_pushCount = 0;
+		_overrunCount = 0;
+		_highWater = 0;
+	}
+
+	/** Add an item at the back, to be called by the producer.
+	 *
+	 * @return                         False when the queue is full, the item is dropped then.
+	 */
+	bool push(const T& item) {
+		uint16_t tail = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+		uint16_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+		uint16_t next = increment(tail);
+		if (next == head) {
+			__atomic_store_n(&_overrunCount, _overrunCount + 1, __ATOMIC_RELAXED);
+			return false;
+		}
+		_items[tail] = item;
+		__atomic_store_n(&_tail, next, __ATOMIC_RELEASE);
+		__atomic_store_n(&_pushCount, _pushCount + 1, __ATOMIC_RELAXED);
+		uint16_t count = distance(head, next);
+		if (count > _highWater) {
+			__atomic_store_n(&_highWater, count, __ATOMIC_RELAXED);
+		}
+		return true;
+	}
+
+	/** Remove the item at the front, to be called by the consumer.
+	 *
+	 * @param[out] item                The removed item.
+	 * @return                         False when the queue is empty.
+	 */
+	bool pop(T& item) {
+		uint16_t head = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+		if (head == __atomic_load_n(&_tail, __ATOMIC_ACQUIRE)) {
+			return false;
+		}
+		item = _items[head];
+		__atomic_store_n(&_head, increment(head), __ATOMIC_RELEASE);
+		return true;
+	}
+
+	/** Number of items in the queue.
+	 *
+	 * From the producer, there may be less, and from the consumer, there may be more by the time it's used.
+	 */
+	uint16_t size() const {
+		return distance(__atomic_load_n(&_head, __ATOMIC_ACQUIRE), __atomic_load_n(&_tail, __ATOMIC_ACQUIRE));
+	}
+
+	bool empty() const {
+		return size() == 0;
+	}
+
+	//! Number of items that were pushed.
+	uint32_t getPushCount() const {
+		return __atomic_load_n(&_pushCount, __ATOMIC_RELAXED);
+	}
+
+	//! Number of items that were dropped, because the queue was full.
+	uint32_t getOverrunCount() const {
+		return __atomic_load_n(&_overrunCount, __ATOMIC_RELAXED);
+	}
+
+	//! Highest number of items that were in the queue at once.
+	uint16_t getHighWater() const {
+		return __atomic_load_n(&_highWater, __ATOMIC_RELAXED);
+	}
+
+private:
+	//! One slot stays empty, so that a full queue can be told apart from an empty one.
+	static const uint16_t numSlots = capacity + 1;
+
+	T _items[numSlots];
+
+	//! Slot of the front item, only written by the consumer.
+	uint16_t _head;
+
+	//! Slot for the next item, only written by the producer.
+	uint16_t _tail;
+
+	//! Statistics, only written by the producer.
+	uint32_t _pushCount;
+	uint32_t _overrunCount;
+	uint16_t _highWater;
+
+	static inline uint16_t increment(uint16_t index) {
+		return index + 1 == numSlots ? 0 : index + 1;
+	}
+
+	static inline uint16_t distance(uint16_t head, uint16_t tail) {
+		return tail >= head ? tail - head : tail + numSlots - head;
+	}
+};
@@ -0,0 +1,77 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <structs/cs_StreamHeader.h>
+
+/** View on the payload of a packet that was written to a characteristic.
+ *
+ * An encrypted packet (see the encryption section of docs/PROTOCOL.md) is laid out as:
+ *
+ *   | packet nonce (3) | user level (1) | validation nonce (4) | payload | zero padding |
+ *
+ * A characteristic decrypts the payload into its value, and points the view at it there (see onWriteView()), so that
+ * the handler doesn't have to parse the value again. Without encryption, the whole packet is payload.
+ *
+ * The payload of the control and mesh control characteristics is a stream buffer: a stream_header_t, followed by the
+ * data. Since an encrypted payload is padded to whole blocks, only the length in the header tells how much of it is
+ * data, and isStream() checks that this data is actually inside the payload.
+ */
+class PacketView {
+public:
+	PacketView() : _payload(NULL), _payloadLength(0) {}
+
+	void assign(uint8_t* payload, uint16_t payloadLength) {
+		_payload = payload;
+		_payloadLength = payloadLength;
+	}
+
+	uint8_t* payload() const {
+		return _payload;
+	}
+
+	//! Length of the payload, including the padding of an encrypted packet.
+	uint16_t payloadLength() const {
+		return _payloadLength;
+	}
+
+	//! Whether the payload starts with a stream header, and the data of the length in that header follows it.
+	bool isStream() const {
+		return _payload != NULL && _payloadLength >= SB_HEADER_SIZE && length() <= _payloadLength - SB_HEADER_SIZE;
+	}
+
+	//! Type in the stream header, only when isStream().
+	uint8_t type() const {
+		return header()->type;
+	}
+
+	//! Op code in the stream header, only when isStream().
+	uint8_t opCode() const {
+		return header()->opCode;
+	}
+
+	//! Length of the data, from the stream header, only when isStream().
+	uint16_t length() const {
+		return header()->length;
+	}
+
+	//! Data after the stream header, only when isStream().
+	uint8_t* data() const {
+		return _payload + SB_HEADER_SIZE;
+	}
+
+private:
+	uint8_t* _payload;
+	uint16_t _payloadLength;
+
+	const stream_header_t* header() const {
+		return (const stream_header_t*)_payload;
+	}
+};
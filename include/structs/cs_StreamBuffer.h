@@ -8,6 +8,7 @@
 #pragma once
 
 #include <structs/cs_BufferAccessor.h>
+#include <structs/cs_StreamHeader.h>
 #include <util/cs_BleError.h>
 #include <util/cs_Utils.h>
 #include <common/cs_Types.h>
@@ -21,23 +22,6 @@
 #define SB_BUFFER_NOT_INITIALIZED                1
 #define SB_BUFFER_NOT_LARGE_ENOUGH               2
 
-enum OpCode {
-	READ_VALUE       = 0,
-	WRITE_VALUE,
-	NOTIFY_VALUE
-};
-
-/** Header of a stream buffer
- *
- */
-struct __attribute__((__packed__)) stream_header_t {
-	uint8_t type;
-	uint8_t opCode; //! can be used as op code, see <OpCode>
-	uint16_t length;
-};
-
-#define SB_HEADER_SIZE                           sizeof(stream_header_t)
-
 /** Structure for a StreamBuffer
  *
  * typename T defines the type of the payload elements
@@ -0,0 +1,26 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+#pragma once
+
+#include <stdint.h>
+
+enum OpCode {
+	READ_VALUE       = 0,
+	WRITE_VALUE,
+	NOTIFY_VALUE
+};
+
+/** Header of a stream buffer
+ *
+ */
+struct __attribute__((__packed__)) stream_header_t {
+	uint8_t type;
+	uint8_t opCode; //! can be used as op code, see <OpCode>
+	uint16_t length;
+};
+
+#define SB_HEADER_SIZE                           sizeof(stream_header_t)
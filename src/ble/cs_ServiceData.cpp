@@ -41,6 +41,7 @@ ServiceData::ServiceData() :
 	,_meshSendCount(0)
 	,_meshLastSentTimestamp(0)
 	,_meshNextEventType(0)
+	,_loadEvent()
 #endif
 {
 	// we want to update the advertisement packet on a fixed interval.
@@ -321,6 +322,10 @@ bool ServiceData::getExternalAdvertisement(stone_id_t ownId, service_data_t& ser
 		int16_t idx = -1;
 		state_item_t* stateItem;
 		while (peek_prev_state_item(&(messages[chan]), &stateItem, idx)) {
+			// A load event holds no state to advertise, look for the state item before it.
+			if (stateItem->type == MESH_STATE_ITEM_TYPE_LOAD_EVENT) {
+				continue;
+			}
 			stone_id_t itemId = meshStateItemGetId(stateItem);
 			if (itemId == advertiseId) {
 				if (!isMeshStateNotTimedOut(advertiseId, chan, currentTime)) {
@@ -672,6 +677,15 @@ void ServiceData::sendMeshState(bool event, uint16_t eventType) {
 		state_item_t stateItem = {};
 		if (event) {
 			switch (eventType) {
+			case EVT_LOAD_SWITCHED:
+				stateItem.type = MESH_STATE_ITEM_TYPE_LOAD_EVENT;
+				stateItem.loadEvent.id = _crownstoneId;
+				stateItem.loadEvent.eventType = _loadEvent.type;
+				stateItem.loadEvent.deltaMilliAmp = _loadEvent.deltaMilliAmp;
+				stateItem.loadEvent.currentRmsMilliAmp = _loadEvent.currentRmsMilliAmp;
+				stateItem.loadEvent.switchState = _switchState;
+				stateItem.loadEvent.partialTimestamp = getPartialTimestampOrCounter(timestamp, _meshSendCount);
+				break;
 			case STATE_SWITCH_STATE:
 			default:
 				stateItem.type = MESH_STATE_ITEM_TYPE_EVENT_STATE;
@@ -773,6 +787,16 @@ void ServiceData::handleEvent(uint16_t evt, void* p_data, uint16_t length) {
 		// todo create mesh state event if changes significantly
 		break;
 	}
+	case EVT_LOAD_SWITCHED: {
+#if BUILD_MESHING == 1
+		if (length != sizeof(load_event_t)) {
+			break;
+		}
+		memcpy(&_loadEvent, p_data, sizeof(load_event_t));
+		sendMeshState(true, EVT_LOAD_SWITCHED);
+#endif
+		break;
+	}
 	case STATE_TEMPERATURE: {
 		// TODO: isn't the temperature an int32_t ?
 		updateTemperature(*(int8_t*)p_data);
@@ -94,6 +94,8 @@ void asACR01B6D(boards_config_t* p_config) {
 	p_config->pinAinCurrent                      = 4; // highest gain
 	p_config->pinAinCurrentGainMed               = 5;
 	p_config->pinAinCurrentGainLow               = 6; // lowest gain
+	p_config->currentGainMed                     = 0; // Not calibrated: no auto range.
+	p_config->currentGainLow                     = 0; // Not calibrated: no auto range.
 	p_config->pinAinVoltage                      = 2;
 	p_config->pinAinZeroRef                      = 0;
 	p_config->pinAinPwmTemp                      = 3;
@@ -712,6 +712,9 @@ void Crownstone::run() {
 
 		app_sched_execute();
 
+		// all scheduled events are handled, use the idle time to prepare the encryption of the next notifications
+		EncryptionHandler::getInstance().precomputeKeystream();
+
 #if(NORDIC_SDK_VERSION > 5)
 		BLE_CALL(sd_app_evt_wait, ());
 #else
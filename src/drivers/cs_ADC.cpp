@@ -25,6 +25,7 @@
 
 
 extern "C" void saadc_callback(nrf_drv_saadc_evt_t const * p_event);
+void adc_done(void * p_event_data, uint16_t event_size);
 
 ADC::ADC()
 {
@@ -34,10 +35,12 @@ ADC::ADC()
 	_doneCallbackData.callback = NULL;
 	_doneCallbackData.buffer = NULL;
 	_doneCallbackData.bufSize = 0;
-	// TODO: misuse: overload of bufNum field to indicate also initialization
-	_doneCallbackData.bufNum = CS_ADC_NUM_BUFFERS;
+	_doneCallbackData.bufNum = CS_ADC_BUFFER_NONE;
+	_doneCallbackData.handedOutTicks = 0;
+	_doneEventPending = false;
+	_maxDoneLatencyTicks = 0;
 	_zeroCrossingCallback = NULL;
-	_numBuffersQueued = 0;
+	_changeConfig = false;
 	_lastZeroCrossUpTime = 0;
 }
 
@@ -100,9 +103,11 @@ cs_adc_error_t ADC::init(const adc_config_t & config) {
 	// Allocate buffers
 	for (int i=0; i<CS_ADC_NUM_BUFFERS; i++) {
 		_bufferPointers[i] = new nrf_saadc_value_t[CS_ADC_BUF_SIZE];
-		/* Start conversion in non-blocking mode. Sampling is not triggered yet. */
-		addBufferToSampleQueue(_bufferPointers[i]);
 	}
+	_bufferQueue.init();
+
+	/* Start conversion in non-blocking mode. Sampling is not triggered yet. */
+	fillSampleQueue(false);
 
 	return 0;
 }
@@ -196,33 +201,109 @@ void ADC::start() {
 	nrf_timer_task_trigger(CS_ADC_TIMER, NRF_TIMER_TASK_START);
 }
 
-void ADC::addBufferToSampleQueue(nrf_saadc_value_t* buf) {
+void ADC::addBufferToSampleQueue(cs_adc_buffer_id_t bufNum) {
 	ret_code_t err_code;
-	err_code = nrf_drv_saadc_buffer_convert(buf, CS_ADC_BUF_SIZE);
+	err_code = nrf_drv_saadc_buffer_convert(_bufferPointers[bufNum], CS_ADC_BUF_SIZE);
 	APP_ERROR_CHECK(err_code);
-	_numBuffersQueued++;
 }
 
-bool ADC::releaseBuffer(nrf_saadc_value_t* buf) {
-	if (_doneCallbackData.buffer != buf) {
-		LOGe("buffer mismatch! %i vs %i", _doneCallbackData.buffer, buf);
-		return false;
+void ADC::fillSampleQueue(bool overwrite) {
+	cs_adc_buffer_id_t bufNum;
+	while ((bufNum = _bufferQueue.nextToQueue(overwrite)) != CS_ADC_BUFFER_NONE) {
+		addBufferToSampleQueue(bufNum);
 	}
+}
 
-	// Clear the callback data
-	_doneCallbackData.buffer = NULL;
-	_doneCallbackData.bufSize = 0;
-	_doneCallbackData.bufNum = CS_ADC_NUM_BUFFERS;
+void ADC::startProcessing() {
+	if (_doneCallbackData.callback == NULL) {
+		return;
+	}
+	cs_adc_buffer_id_t bufNum = _bufferQueue.startProcessing();
+	if (bufNum == CS_ADC_BUFFER_NONE) {
+		return;
+	}
+	//! Fill callback data object, should become available again in releaseBuffer()
+	_doneCallbackData.buffer = _bufferPointers[bufNum];
+	_doneCallbackData.bufSize = CS_ADC_BUF_SIZE;
+	_doneCallbackData.bufNum = bufNum;
+	_doneCallbackData.handedOutTicks = RTC::getCount();
+
+	// Decouple done callback from adc interrupt handler, and put it on app scheduler instead.
+	// Only one buffer is handed out at a time, so the done queue is empty, unless the buffer queue is broken.
+	if (!_doneQueue.push(_doneCallbackData)) {
+		_bufferQueue.release(bufNum);
+		return;
+	}
+	scheduleDoneEvent();
+}
+
+void ADC::scheduleDoneEvent() {
+	if (!__atomic_exchange_n(&_doneEventPending, true, __ATOMIC_SEQ_CST)) {
+		uint32_t errorCode = app_sched_event_put(NULL, 0, adc_done);
+		APP_ERROR_CHECK(errorCode);
+	}
+}
+
+void ADC::_handleDoneQueue() {
+	// Clear the flag before popping: a buffer that is pushed after this schedules a new event.
+	__atomic_store_n(&_doneEventPending, false, __ATOMIC_SEQ_CST);
+	adc_done_cb_data_t cbData;
+	if (!_doneQueue.pop(cbData)) {
+		return;
+	}
+	uint32_t latencyTicks = RTC::difference(RTC::getCount(), cbData.handedOutTicks);
+	if (latencyTicks > _maxDoneLatencyTicks) {
+		_maxDoneLatencyTicks = latencyTicks;
+	}
+	cbData.callback(cbData.buffer, cbData.bufSize, cbData.bufNum);
+
+	// One buffer per event, so that other events get their turn in between.
+	if (!_doneQueue.empty()) {
+		scheduleDoneEvent();
+	}
+}
 
-	if (_changeConfig) {
-		// Don't queue up the the buffer, we need the adc to be idle.
-		if (_numBuffersQueued == 0) {
-			applyConfig();
+uint32_t ADC::getMaxDoneLatencyMs() const {
+	return RTC::ticksToMs(_maxDoneLatencyTicks);
+}
+
+cs_adc_buffer_id_t ADC::getBufferIndex(nrf_saadc_value_t* buf) {
+	for (cs_adc_buffer_id_t i = 0; i < CS_ADC_NUM_BUFFERS; ++i) {
+		if (_bufferPointers[i] == buf) {
+			return i;
 		}
-		return true;
 	}
-	addBufferToSampleQueue(buf);
-	return true;
+	return CS_ADC_BUFFER_NONE;
+}
+
+bool ADC::releaseBuffer(nrf_saadc_value_t* buf) {
+	bool success;
+	// The done interrupt changes the buffer queue as well.
+	CRITICAL_REGION_ENTER();
+	success = _bufferQueue.release(getBufferIndex(buf));
+	if (success) {
+		// Clear the callback data
+		_doneCallbackData.buffer = NULL;
+		_doneCallbackData.bufSize = 0;
+		_doneCallbackData.bufNum = CS_ADC_BUFFER_NONE;
+
+		if (_changeConfig) {
+			// Don't queue up the the buffer, we need the adc to be idle.
+			if (_bufferQueue.numQueued() == 0) {
+				applyConfig();
+			}
+		}
+		else {
+			fillSampleQueue(false);
+		}
+		// Hand out the buffers that were filled during processing.
+		startProcessing();
+	}
+	CRITICAL_REGION_EXIT();
+	if (!success) {
+		LOGe("buffer mismatch! %i vs %i", _doneCallbackData.buffer, buf);
+	}
+	return success;
 }
 
 void ADC::setZeroCrossingCallback(adc_zero_crossing_cb_t callback) {
@@ -264,10 +345,11 @@ void ADC::applyConfig() {
 	// Mark as done
 	_changeConfig = false;
 
+	// Samples that were taken with the old config are of no use anymore, they count as overruns.
+	_bufferQueue.dropFilled();
+
 	// Add all buffers again
-	for (int i=0; i<CS_ADC_NUM_BUFFERS; i++) {
-		addBufferToSampleQueue(_bufferPointers[i]);
-	}
+	fillSampleQueue(false);
 }
 
 void ADC::setLimitUp() {
@@ -279,40 +361,21 @@ void ADC::setLimitDown() {
 }
 
 void adc_done(void * p_event_data, uint16_t event_size) {
-	adc_done_cb_data_t* cbData = (adc_done_cb_data_t*)p_event_data;
-	cbData->callback(cbData->buffer, cbData->bufSize, cbData->bufNum);
+	ADC::getInstance()._handleDoneQueue();
 }
 
 void ADC::_handleAdcDoneInterrupt(nrf_saadc_value_t* buf) {
-	_numBuffersQueued--;
-//	if (_changeConfig) {
-//		if (_numBuffersQueued == 0) {
-//			applyConfig();
-//		}
-//		return;
-//	}
-
-	if (_doneCallbackData.callback != NULL && _doneCallbackData.buffer == NULL) {
-		//! Fill callback data object, should become available again in releaseBuffer()
-		_doneCallbackData.buffer = buf;
-		_doneCallbackData.bufSize = CS_ADC_BUF_SIZE;
-		_doneCallbackData.bufNum = CS_ADC_NUM_BUFFERS;
+	if (!_bufferQueue.onFilled(getBufferIndex(buf))) {
+		return;
+	}
 
-		// Decouple done callback from adc interrupt handler, and put it on app scheduler instead
-		uint32_t errorCode = app_sched_event_put(&_doneCallbackData, sizeof(_doneCallbackData), adc_done);
-		APP_ERROR_CHECK(errorCode);
-	} else {
-//		write("/!\\");
-		// Don't queue up the the buffer, we need the adc to be idle.
-		if (_changeConfig) {
-//			if (_numBuffersQueued == 0) {
-//				applyConfig();
-//			}
-			return;
-		}
-		//! Skip the callback, just put buffer in queue again.
-		addBufferToSampleQueue(buf);
+	// Don't queue up any buffer when the config should be changed, we need the adc to be idle.
+	// The config is then applied when the last buffer is released.
+	if (!_changeConfig) {
+		// Keep the SAADC going, even if that means overwriting a buffer that wasn't processed yet.
+		fillSampleQueue(true);
 	}
+	startProcessing();
 }
 
 void ADC::_handleAdcLimitInterrupt(nrf_saadc_limit_t type) {
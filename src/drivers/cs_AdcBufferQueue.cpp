@@ -0,0 +1,103 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+#include <drivers/cs_AdcBufferQueue.h>
+
+AdcBufferQueue::AdcBufferQueue() {
+	init();
+}
+
+void AdcBufferQueue::init() {
+	for (cs_adc_buffer_id_t i = 0; i < CS_ADC_NUM_BUFFERS; ++i) {
+		_states[i] = ADC_BUFFER_FREE;
+	}
+	_numQueued = 0;
+	_filledStart = 0;
+	_numFilled = 0;
+	_maxFilled = 0;
+	_processing = CS_ADC_BUFFER_NONE;
+	_overrunCount = 0;
+	_errorCount = 0;
+}
+
+cs_adc_buffer_id_t AdcBufferQueue::nextToQueue(bool overwrite) {
+	if (_numQueued >= CS_ADC_MAX_QUEUED_BUFFERS) {
+		return CS_ADC_BUFFER_NONE;
+	}
+	cs_adc_buffer_id_t id = CS_ADC_BUFFER_NONE;
+	for (cs_adc_buffer_id_t i = 0; i < CS_ADC_NUM_BUFFERS; ++i) {
+		if (_states[i] == ADC_BUFFER_FREE) {
+			id = i;
+			break;
+		}
+	}
+	if (id == CS_ADC_BUFFER_NONE) {
+		if (!overwrite || _numFilled == 0) {
+			return CS_ADC_BUFFER_NONE;
+		}
+		// Rather lose the oldest samples than let the SAADC run out of buffers.
+		id = popFilled();
+		++_overrunCount;
+	}
+	_states[id] = ADC_BUFFER_QUEUED;
+	_queued[_numQueued++] = id;
+	return id;
+}
+
+bool AdcBufferQueue::onFilled(cs_adc_buffer_id_t id) {
+	// The SAADC fills the buffers in the order they were queued.
+	if (_numQueued == 0 || _queued[0] != id) {
+		++_errorCount;
+		return false;
+	}
+	for (cs_adc_buffer_count_t i = 1; i < _numQueued; ++i) {
+		_queued[i - 1] = _queued[i];
+	}
+	--_numQueued;
+	_states[id] = ADC_BUFFER_FILLED;
+	_filled[(_filledStart + _numFilled) % CS_ADC_NUM_BUFFERS] = id;
+	++_numFilled;
+	if (_numFilled > _maxFilled) {
+		_maxFilled = _numFilled;
+	}
+	return true;
+}
+
+cs_adc_buffer_id_t AdcBufferQueue::startProcessing() {
+	if (_processing != CS_ADC_BUFFER_NONE || _numFilled == 0) {
+		return CS_ADC_BUFFER_NONE;
+	}
+	_processing = popFilled();
+	_states[_processing] = ADC_BUFFER_PROCESSING;
+	return _processing;
+}
+
+bool AdcBufferQueue::release(cs_adc_buffer_id_t id) {
+	if (id != _processing || id == CS_ADC_BUFFER_NONE) {
+		++_errorCount;
+		return false;
+	}
+	_states[id] = ADC_BUFFER_FREE;
+	_processing = CS_ADC_BUFFER_NONE;
+	return true;
+}
+
+cs_adc_buffer_count_t AdcBufferQueue::dropFilled() {
+	cs_adc_buffer_count_t numDropped = _numFilled;
+	while (_numFilled != 0) {
+		_states[popFilled()] = ADC_BUFFER_FREE;
+	}
+	_overrunCount += numDropped;
+	return numDropped;
+}
+
+cs_adc_buffer_id_t AdcBufferQueue::popFilled() {
+	cs_adc_buffer_id_t id = _filled[_filledStart];
+	_filledStart = (_filledStart + 1) % CS_ADC_NUM_BUFFERS;
+	--_numFilled;
+	return id;
+}
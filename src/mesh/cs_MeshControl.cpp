@@ -252,6 +252,9 @@ ERR_CODE MeshControl::handleStateMessage(state_message_t* msg, uint16_t length,
 		case MESH_STATE_ITEM_TYPE_ERROR:
 			LOGi("idx=%i type=%u id=%u error=%u time=%u flags=%u temp=%i time=%u", idx, stateItem->type, stateItem->error.id, stateItem->error.errors, stateItem->error.timestamp, stateItem->error.flags, stateItem->error.temperature, stateItem->error.partialTimestamp);
 			break;
+		case MESH_STATE_ITEM_TYPE_LOAD_EVENT:
+			LOGi("idx=%i type=%u id=%u event=%u delta=%i I=%i switch=%u time=%u", idx, stateItem->type, stateItem->loadEvent.id, stateItem->loadEvent.eventType, stateItem->loadEvent.deltaMilliAmp, stateItem->loadEvent.currentRmsMilliAmp, stateItem->loadEvent.switchState, stateItem->loadEvent.partialTimestamp);
+			break;
 		default:
 			LOGi("idx=%i type=%u", idx, stateItem->type);
 		}
@@ -892,6 +895,9 @@ void MeshControl::sendServiceDataMessage(state_item_t& stateItem, bool event) {
 	case MESH_STATE_ITEM_TYPE_ERROR:
 		LOGi("  type=%u id=%u error=%u time=%u flags=%u temp=%i time=%u", stateItem.type, stateItem.error.id, stateItem.error.errors, stateItem.error.timestamp, stateItem.error.flags, stateItem.error.temperature, stateItem.error.partialTimestamp);
 		break;
+	case MESH_STATE_ITEM_TYPE_LOAD_EVENT:
+		LOGi("  type=%u id=%u event=%u delta=%i I=%i switch=%u time=%u", stateItem.type, stateItem.loadEvent.id, stateItem.loadEvent.eventType, stateItem.loadEvent.deltaMilliAmp, stateItem.loadEvent.currentRmsMilliAmp, stateItem.loadEvent.switchState, stateItem.loadEvent.partialTimestamp);
+		break;
 	default:
 		LOGi("  type=%u", stateItem.type);
 	}
@@ -0,0 +1,98 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+#include <processing/cs_AdcRangeController.h>
+
+//! The ranges the ADC supports, one for each gain of the SAADC.
+static const uint16_t adcRanges[] = {150, 300, 600, 1200, 1800, 2400, 3000, 3600};
+
+AdcRangeController::AdcRangeController() {
+	init(-2048, 2047);
+}
+
+void AdcRangeController::init(int32_t adcMin, int32_t adcMax) {
+	_numLevels = 0;
+	_level = 0;
+	_adcMin = adcMin;
+	_adcMax = adcMax;
+	_fitCount = 0;
+}
+
+void AdcRangeController::addPin(uint8_t pin, float gain, uint16_t maxRangeMilliVolt) {
+	if (gain <= 0) {
+		return;
+	}
+	for (uint8_t i = 0; i < sizeof(adcRanges) / sizeof(adcRanges[0]); ++i) {
+		if (adcRanges[i] > maxRangeMilliVolt || _numLevels >= ADC_RANGE_MAX_LEVELS) {
+			return;
+		}
+		adc_range_level_t& level = _levels[_numLevels];
+		level.pin = pin;
+		level.rangeMilliVolt = adcRanges[i];
+		level.gain = gain;
+		if (_numLevels == 0 || sensitivity(_numLevels) < sensitivity(_numLevels - 1)) {
+			++_numLevels;
+		}
+	}
+}
+
+bool AdcRangeController::setLevel(uint8_t pin, uint16_t rangeMilliVolt) {
+	for (uint8_t i = 0; i < _numLevels; ++i) {
+		if (_levels[i].pin == pin && _levels[i].rangeMilliVolt == rangeMilliVolt) {
+			_level = i;
+			_fitCount = 0;
+			return true;
+		}
+	}
+	return false;
+}
+
+float AdcRangeController::getScale(uint8_t fromLevel, uint8_t toLevel) const {
+	return sensitivity(toLevel) / sensitivity(fromLevel);
+}
+
+bool AdcRangeController::withinPercent(int32_t minSample, int32_t maxSample, float scale, uint8_t percent) const {
+	return maxSample * scale * 100 < _adcMax * percent && minSample * scale * 100 > _adcMin * percent;
+}
+
+bool AdcRangeController::update(const power_t& power) {
+	if (_numLevels == 0) {
+		return false;
+	}
+	int32_t minSample = power.buf[power.currentIndex];
+	int32_t maxSample = minSample;
+	for (uint16_t i = power.currentIndex; i < power.bufSize; i += power.numChannels) {
+		int32_t sample = power.buf[i];
+		if (sample < minSample) {
+			minSample = sample;
+		}
+		if (sample > maxSample) {
+			maxSample = sample;
+		}
+	}
+
+	if (!withinPercent(minSample, maxSample, 1.0f, POWER_SAMPLING_RANGE_DOWN_PERCENT)) {
+		_fitCount = 0;
+		if (_level + 1 < _numLevels) {
+			++_level;
+			return true;
+		}
+		return false;
+	}
+
+	if (_level > 0 && withinPercent(minSample, maxSample, getScale(_level, _level - 1), POWER_SAMPLING_RANGE_UP_PERCENT)) {
+		if (++_fitCount >= POWER_SAMPLING_RANGE_UP_BUFFERS) {
+			_fitCount = 0;
+			--_level;
+			return true;
+		}
+	}
+	else {
+		_fitCount = 0;
+	}
+	return false;
+}
@@ -774,7 +774,19 @@ ERR_CODE CommandHandler::handleCmdEnableContPowerMeasure(buffer_ptr_t buffer, co
 
 //	if (!EncryptionHandler::getInstance().allowAccess(ADMIN, accessLevel)) return ERR_ACCESS_NOT_ALLOWED;
 	LOGi(STR_HANDLE_COMMAND, "enable cont power measure");
-	return ERR_NOT_IMPLEMENTED;
+
+	if (size != sizeof(enable_message_payload_t)) {
+		LOGe(FMT_WRONG_PAYLOAD_LENGTH, size);
+		return ERR_WRONG_PAYLOAD_LENGTH;
+	}
+
+	enable_message_payload_t* payload = (enable_message_payload_t*) buffer;
+	bool enable = payload->enable;
+
+	LOGi("%s cont power measure", enable ? STR_ENABLE : STR_DISABLE);
+	Settings::getInstance().updateFlag(CONFIG_CONT_POWER_SAMPLER_ENABLED, enable, true);
+	EventDispatcher::getInstance().dispatch(EVT_CONT_POWER_SAMPLER_ENABLED, &enable, sizeof(bool));
+	return ERR_SUCCESS;
 }
 
 ERR_CODE CommandHandler::handleCmdAllowDimming(buffer_ptr_t buffer, const uint16_t size, const EncryptionAccessLevel accessLevel) {
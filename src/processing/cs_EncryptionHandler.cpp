@@ -35,14 +35,19 @@ uint16_t EncryptionHandler::calculateEncryptionBufferLength(uint16_t inputLength
 
 		return requiredLength;
 	}
+	else if (encryptionType == CCM) {
+		// no padding, the tag follows the payload.
+		return PACKET_NONCE_LENGTH + USER_LEVEL_LENGTH + inputLength + CCM_TAG_LENGTH;
+	}
 	else {
 		return SOC_ECB_CIPHERTEXT_LENGTH;
 	}
 }
 
 
-uint16_t EncryptionHandler::calculateDecryptionBufferLength(uint16_t encryptedPacketLength) {
-	uint16_t overhead = VALIDATION_NONCE_LENGTH + PACKET_NONCE_LENGTH + USER_LEVEL_LENGTH;
+uint16_t EncryptionHandler::calculateDecryptionBufferLength(uint16_t encryptedPacketLength, EncryptionType encryptionType) {
+	uint16_t overhead = PACKET_NONCE_LENGTH + USER_LEVEL_LENGTH;
+	overhead += encryptionType == CCM ? CCM_TAG_LENGTH : VALIDATION_NONCE_LENGTH;
 	// catch case where the length can be smaller than the overhead and the int overflows.
 	if (encryptedPacketLength <= overhead) {
 		return 0;
@@ -53,9 +58,26 @@ uint16_t EncryptionHandler::calculateDecryptionBufferLength(uint16_t encryptedPa
 void EncryptionHandler::handleEvent(uint16_t evt, void* p_data, uint16_t length) {
 	switch (evt) {
 	case EVT_BLE_CONNECT:
+		// the keystreams are only valid for the session nonce of the previous connection
+		_keystreamCache.clear();
+		_keystreamCache.resetStatistics();
+		_keystreamLevels = 0;
+		_ccmCounter.reset();
 		if (Settings::getInstance().isSet(CONFIG_ENCRYPTION_ENABLED))
 			_generateSessionNonce();
 		break;
+	case EVT_BLE_DISCONNECT:
+		LOGd("Keystream cache: %u hits, %u misses", _keystreamCache.getHitCount(), _keystreamCache.getMissCount());
+		_keystreamCache.clear();
+		_keystreamLevels = 0;
+		break;
+	case CONFIG_KEY_ADMIN:
+	case CONFIG_KEY_MEMBER:
+	case CONFIG_KEY_GUEST:
+		// keystreams of the old key are no longer found.
+		++_keyGeneration;
+		_keystreamCache.clear();
+		break;
 	}
 }
 
@@ -95,30 +117,24 @@ bool EncryptionHandler::_encryptECB(uint8_t* data, uint8_t dataLength, uint8_t*
 	if (_checkAndSetKey(userLevel) == false)
 		return false;
 
-	// set the guest key as active encryption key
-	uint32_t err_code;
-
 	// set the cleartext to 0x0 so we automatically zeropad the cleartext
-	memset(_block.cleartext, 0x0, SOC_ECB_CLEARTEXT_LENGTH);
+	uint8_t cleartext[AES_BLOCK_LENGTH];
+	memset(cleartext, 0x0, AES_BLOCK_LENGTH);
 
 	if (encryptionType == ECB_GUEST_CAFEBABE) {
 		// copy the validation key into the cleartext
-		memcpy(_block.cleartext, _defaultValidationKey.a, DEFAULT_SESSION_KEY_LENGTH);
+		memcpy(cleartext, _defaultValidationKey.a, DEFAULT_SESSION_KEY_LENGTH);
 
 		// after which, copy the data into the cleartext
-		memcpy(_block.cleartext + DEFAULT_SESSION_KEY_LENGTH, data, dataLength);
+		memcpy(cleartext + DEFAULT_SESSION_KEY_LENGTH, data, dataLength);
 	}
 	else {
 		// copy the data over into the cleartext
-		memcpy(_block.cleartext, data, dataLength);
+		memcpy(cleartext, data, dataLength);
 	}
 
-	// encrypts the cleartext and puts it in ciphertext
-	err_code = sd_ecb_block_encrypt(&_block);
-	APP_ERROR_CHECK(err_code);
-
-	// copy result into target.
-	memcpy(target, _block.ciphertext, SOC_ECB_CIPHERTEXT_LENGTH);
+	// encrypts the cleartext and puts it in the target
+	_cipher.encryptEcb(cleartext, target);
 
 	return true;
 }
@@ -126,7 +142,7 @@ bool EncryptionHandler::_encryptECB(uint8_t* data, uint8_t dataLength, uint8_t*
 
 bool EncryptionHandler::encryptMesh(mesh_nonce_t nonce, uint8_t* data, uint16_t dataLength, uint8_t* target, uint16_t targetLength) {
 
-	Settings::getInstance().get(CONFIG_KEY_ADMIN, _block.key);
+	_setKey(CONFIG_KEY_ADMIN);
 
 	// first MESH_OVERHEAD bytes of the target are overhead, which is a random number + nonce (message number)
 	uint16_t targetNetLength = targetLength - MESH_OVERHEAD;
@@ -145,9 +161,9 @@ bool EncryptionHandler::encryptMesh(mesh_nonce_t nonce, uint8_t* data, uint16_t
 
 	// Set the nonce to zero to ensure it is consistent.
 	// Since we only have 1 uint8_t as counter doing this once is enough.
-	memset(_block.cleartext, 0x00, SOC_ECB_CLEARTEXT_LENGTH);
+	memset(_iv, 0x00, AES_BLOCK_LENGTH);
 	// use the mesh overhead as IV (first nonce, second part random)
-	memcpy(_block.cleartext, target, MESH_OVERHEAD);
+	memcpy(_iv, target, MESH_OVERHEAD);
 
 	if (_encryptCTR((uint8_t*)&nonce, data, dataLength, target + MESH_OVERHEAD, targetNetLength) == false) {
 		LOGe("Error while encrypting");
@@ -166,7 +182,7 @@ bool EncryptionHandler::decryptMesh(uint8_t* encryptedDataPacket, uint16_t encry
 		return false;
 	}
 
-	Settings::getInstance().get(CONFIG_KEY_ADMIN, _block.key);
+	_setKey(CONFIG_KEY_ADMIN);
 
 	// the actual encrypted part is after the overhead
 	uint16_t sourceNetLength = encryptedDataPacketLength - MESH_OVERHEAD;
@@ -176,9 +192,9 @@ bool EncryptionHandler::decryptMesh(uint8_t* encryptedDataPacket, uint16_t encry
 
 	// Set the nonce to zero to ensure it is consistent.
 	// Since we only have 1 uint8_t as counter doing this once is enough.
-	memset(_block.cleartext, 0x00, SOC_ECB_CLEARTEXT_LENGTH);
+	memset(_iv, 0x00, AES_BLOCK_LENGTH);
 	// copy the mesh overhead of the encrypted data packet to be used as IV (first nonce, second part random)
-	memcpy(_block.cleartext, encryptedDataPacket, MESH_OVERHEAD);
+	memcpy(_iv, encryptedDataPacket, MESH_OVERHEAD);
 
 	if (_decryptCTR((uint8_t*)nonce, encryptedDataPacket + MESH_OVERHEAD, sourceNetLength, target, targetLength) == false) {
 		LOGe("Error while decrypting");
@@ -192,6 +208,8 @@ bool EncryptionHandler::decryptMesh(uint8_t* encryptedDataPacket, uint16_t encry
 bool EncryptionHandler::encrypt(uint8_t* data, uint16_t dataLength, uint8_t* target, uint16_t targetLength, EncryptionAccessLevel userLevel, EncryptionType encryptionType) {
 	if (encryptionType == CTR || encryptionType == CTR_CAFEBABE) {
 		return _prepareEncryptCTR(data,dataLength,target,targetLength,userLevel,encryptionType);
+	} else if (encryptionType == CCM) {
+		return _encryptCCM(data,dataLength,target,targetLength,userLevel);
 	} else {
 		return _encryptECB(data,dataLength,target,targetLength,userLevel,encryptionType);
 	}
@@ -199,8 +217,10 @@ bool EncryptionHandler::encrypt(uint8_t* data, uint16_t dataLength, uint8_t* tar
 
 bool EncryptionHandler::_prepareEncryptCTR(uint8_t* data, uint16_t dataLength, uint8_t* target, uint16_t targetLength, EncryptionAccessLevel userLevel, EncryptionType encryptionType) {
 	// check if the userLevel has been set
-	if (_checkAndSetKey(userLevel) == false)
+	uint8_t key[AES_KEY_LENGTH];
+	if (_getKey(userLevel, key) == false)
 		return false;
+	_cipher.setKey(key);
 
 	uint16_t targetNetLength = targetLength - _overhead;
 
@@ -211,14 +231,25 @@ bool EncryptionHandler::_prepareEncryptCTR(uint8_t* data, uint16_t dataLength, u
 		return false;
 	}
 
+	// use the packet nonce and keystream that were computed in advance, if any, else
 	// generate a Nonce for this session and write it to the first 3 bytes of the target.
-	_generateNonceInTarget(target);
+	const keystream_cache_entry_t* cached = NULL;
+	if (encryptionType == CTR) {
+		_keystreamLevels |= _keystreamLevelBit(userLevel);
+		cached = _keystreamCache.take(_keyId(userLevel), _sessionNonce);
+	}
+	if (cached != NULL) {
+		memcpy(target, cached->iv, PACKET_NONCE_LENGTH);
+	}
+	else {
+		_generateNonceInTarget(target);
+	}
 
 //	 write the userLevel to the target
 	target[PACKET_NONCE_LENGTH] = uint8_t(userLevel);
 
 	// create the IV
-	_createIV(_block.cleartext, target, encryptionType);
+	_createIV(_iv, target, encryptionType);
 
 	uint8_t* validationNonce;
 	if (encryptionType == CTR_CAFEBABE) {
@@ -230,7 +261,14 @@ bool EncryptionHandler::_prepareEncryptCTR(uint8_t* data, uint16_t dataLength, u
 		validationNonce = _sessionNonce;
 	}
 
-	if (_encryptCTR(validationNonce, data, dataLength, target+_overhead, targetNetLength) == false) {
+	bool success;
+	if (cached != NULL) {
+		success = _encryptCTR(validationNonce, data, dataLength, target+_overhead, targetNetLength, cached->keystream, sizeof(cached->keystream));
+	}
+	else {
+		success = _encryptCTR(validationNonce, data, dataLength, target+_overhead, targetNetLength);
+	}
+	if (success == false) {
 		LOGe("Error while encrypting");
 		return false;
 	}
@@ -238,16 +276,96 @@ bool EncryptionHandler::_prepareEncryptCTR(uint8_t* data, uint16_t dataLength, u
 	return true;
 }
 
+/**
+ * Compute the keystream of the next packet of one of the access levels that were used in this connection.
+ *
+ * Only one packet per call, so that other events don't have to wait long.
+ */
+void EncryptionHandler::precomputeKeystream() {
+	if (_keystreamLevels == 0 || !Nrf51822BluetoothStack::getInstance().connected()) {
+		return;
+	}
+	const EncryptionAccessLevel levels[] = {ADMIN, MEMBER, GUEST, SETUP};
+	for (uint8_t i = 0; i < sizeof(levels) / sizeof(levels[0]); ++i) {
+		if ((_keystreamLevels & _keystreamLevelBit(levels[i])) == 0) {
+			continue;
+		}
+		// get the id before the key: when the key changes in between, the entry is never found.
+		uint16_t keyId = _keyId(levels[i]);
+		if (_keystreamCache.contains(keyId, _sessionNonce)) {
+			continue;
+		}
+		uint8_t key[AES_KEY_LENGTH];
+		if (_getKey(levels[i], key) == false) {
+			// don't try again in this connection.
+			_keystreamLevels &= ~_keystreamLevelBit(levels[i]);
+			continue;
+		}
+		uint8_t packetNonce[PACKET_NONCE_LENGTH];
+		uint8_t iv[AES_BLOCK_LENGTH];
+		_generateNonceInTarget(packetNonce);
+		_createIV(iv, packetNonce, CTR);
+		_keystreamCache.store(_keystreamCipher, keyId, key, iv);
+		return;
+	}
+}
+
+/**
+ * The key id of the keystream cache: the user level, and the generation of the keys.
+ */
+uint16_t EncryptionHandler::_keyId(EncryptionAccessLevel userLevel) {
+	return (_keyGeneration << 8) | userLevel;
+}
+
+uint8_t EncryptionHandler::_keystreamLevelBit(EncryptionAccessLevel userLevel) {
+	switch (userLevel) {
+	case ADMIN:
+		return 1 << 0;
+	case MEMBER:
+		return 1 << 1;
+	case GUEST:
+		return 1 << 2;
+	case SETUP:
+		return 1 << 3;
+	default:
+		return 0;
+	}
+}
+
 
 
 bool EncryptionHandler::decrypt(uint8_t* encryptedDataPacket, uint16_t encryptedDataPacketLength, uint8_t* target, uint16_t targetLength, EncryptionAccessLevel& levelOfPackage, EncryptionType encryptionType) {
-	if (!(encryptionType == CTR || encryptionType == CTR_CAFEBABE)) {
+	uint8_t* validationNonce;
+	if (_prepareDecrypt(encryptedDataPacket, encryptedDataPacketLength, levelOfPackage, encryptionType, validationNonce) == false)
+		return false;
+
+	if (encryptionType == CCM) {
+		return _decryptCCM(encryptedDataPacket, encryptedDataPacketLength, target, targetLength);
+	}
+
+	// the actual encrypted part is after the overhead
+	uint16_t sourceNetLength = encryptedDataPacketLength - _overhead;
+
+	if (_decryptCTR(validationNonce, encryptedDataPacket + _overhead, sourceNetLength, target, targetLength) == false) {
+		LOGe("Error while decrypting");
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Check the packet, set the key of its user level, and set up the IV.
+ */
+bool EncryptionHandler::_prepareDecrypt(uint8_t* encryptedDataPacket, uint16_t encryptedDataPacketLength, EncryptionAccessLevel& levelOfPackage, EncryptionType encryptionType, uint8_t*& validationNonce) {
+	if (!(encryptionType == CTR || encryptionType == CTR_CAFEBABE || encryptionType == CCM)) {
 		LOGe("Cannot decrypt ECB");
 		return false;
 	}
 
-	// check if the size of the encrypted data packet makes sense: min 1 block and overhead
-	if (encryptedDataPacketLength < SOC_ECB_CIPHERTEXT_LENGTH + _overhead) {
+	// check if the size of the encrypted data packet makes sense: min 1 block (or a tag) and overhead
+	uint16_t minimumLength = encryptionType == CCM ? CCM_TAG_LENGTH : SOC_ECB_CIPHERTEXT_LENGTH;
+	if (encryptedDataPacketLength < minimumLength + _overhead) {
 		LOGe(STR_ERR_BUFFER_NOT_LARGE_ENOUGH);
 //		LOGe("Encryted data packet is smaller than the minimum possible size of a block and overhead (20 bytes).");
 		return false;
@@ -269,13 +387,9 @@ bool EncryptionHandler::decrypt(uint8_t* encryptedDataPacket, uint16_t encrypted
 			levelOfPackage = SETUP; break;
 	}
 
-	// the actual encrypted part is after the overhead
-	uint16_t sourceNetLength = encryptedDataPacketLength - _overhead;
-
 	// setup the IV
-	_createIV(_block.cleartext, encryptedDataPacket, encryptionType);
+	_createIV(_iv, encryptedDataPacket, encryptionType);
 
-	uint8_t* validationNonce;
 	if (encryptionType == CTR_CAFEBABE) {
 		validationNonce = _defaultValidationKey.a;
 	}
@@ -283,195 +397,99 @@ bool EncryptionHandler::decrypt(uint8_t* encryptedDataPacket, uint16_t encrypted
 		validationNonce = _sessionNonce;
 	}
 
-	if (_decryptCTR(validationNonce, encryptedDataPacket + _overhead, sourceNetLength, target, targetLength) == false) {
-		LOGe("Error while decrypting");
-		return false;
-	}
-
 	return true;
 }
 
 /**
- * This is where the magic happens. There are a few things that have to be done before this method is called:
- * 1) The correct key has to be set in the _block.key
- * 2) The correct Nonce has to be set in the _block.clearText
+ * Before this method is called, the correct key has to be set in the cipher, and the correct nonce in the IV.
  *
  * The input length should be a multiple of 16 bytes.
  * It is possible that the target is smaller than the input, in this case the remainder is discarded.
- *
  */
 bool EncryptionHandler::_decryptCTR(uint8_t* validationNonce, uint8_t* input, uint16_t inputLength, uint8_t* target, uint16_t targetLength) {
-	if (_validateBlockLength(inputLength) == false) {
-		LOGe(STR_ERR_MULTIPLE_OF_16);
-//		LOGe("Length of input block does not match the expected length (N*16 Bytes).");
-		return false;
-	}
-	uint32_t err_code;
-
-	// amount of blocks to loop over
-	uint8_t blockOverflow = (targetLength + VALIDATION_NONCE_LENGTH) %  SOC_ECB_CIPHERTEXT_LENGTH;
-	uint16_t blockCount = (targetLength + VALIDATION_NONCE_LENGTH) / SOC_ECB_CIPHERTEXT_LENGTH;
-	blockCount += (blockOverflow > 0) ? 1 : 0;
-
-	// variables to keep track of where data is written
-	uint16_t inputReadIndex = 0;
-	uint16_t writtenToTarget = 0;
-	uint16_t targetLengthLeftToWrite = targetLength;
-	uint16_t maxIterationWriteAmount;
-
-	// encrypt all blocks using AES 128 CTR block mode.
-	for (uint8_t counter = 0; counter < blockCount; counter++) {
-		// prepare the IV for the next step by concatenating the nonce with the counter
-		_block.cleartext[SOC_ECB_CLEARTEXT_LENGTH-1] = counter;
-
-		// encrypts the cleartext and puts it in ciphertext
-		err_code = sd_ecb_block_encrypt(&_block);
-		APP_ERROR_CHECK(err_code);
-
-		// XOR the ciphertext with the data to finish encrypting the block.
-		for (uint8_t i = 0; i < SOC_ECB_CIPHERTEXT_LENGTH; i++) {
-			inputReadIndex = i + counter * SOC_ECB_CIPHERTEXT_LENGTH;
-			if (inputReadIndex < inputLength)
-				_block.ciphertext[i] ^= input[inputReadIndex];
-			else {
-				LOGe("Length mismatch %d, counter: %d, i: %d", inputReadIndex, counter, i);
-				return false;
-			}
-		}
-
-
-		// check the validation nonce
-		if (counter == 0) {
-			if (_validateDecryption(_block.ciphertext, validationNonce) == false)
-				return false;
-
-			// the first iteration we can only write 12 relevant bytes to the target because the first 4 are the nonce.
-			maxIterationWriteAmount = SOC_ECB_CIPHERTEXT_LENGTH - VALIDATION_NONCE_LENGTH;
-			if (targetLengthLeftToWrite < maxIterationWriteAmount)
-				maxIterationWriteAmount = targetLengthLeftToWrite;
+	return _cipher.decryptCtr(_iv, validationNonce, input, inputLength, target, targetLength);
+}
 
-			// we offset the pointer of the cipher text by the length of the validation length
-			memcpy(target, _block.ciphertext + VALIDATION_NONCE_LENGTH, maxIterationWriteAmount);
+/**
+ * Before this method is called, the correct key has to be set in the cipher, and the correct nonce in the IV.
+ *
+ * The outputLength should be larger than 0 and a multiple of 16 or this will return false.
+ * It is possible that the input is smaller than the output, in this case it will be zero padded.
+ *
+ * The validation nonce is automatically added to the input.
+ */
+bool EncryptionHandler::_encryptCTR(uint8_t* validationNonce, uint8_t* input, uint16_t inputLength, uint8_t* output, uint16_t outputLength, const uint8_t* keystream, uint16_t keystreamLength) {
+	return _cipher.encryptCtr(_iv, validationNonce, input, inputLength, output, outputLength, keystream, keystreamLength);
+}
 
-		}
-		else {
-			// after the first iteration, we can write the full 16 bytes.
-			maxIterationWriteAmount = SOC_ECB_CIPHERTEXT_LENGTH;
-			if (targetLengthLeftToWrite < maxIterationWriteAmount)
-				maxIterationWriteAmount = targetLengthLeftToWrite;
 
-			memcpy(target + writtenToTarget, _block.ciphertext, maxIterationWriteAmount);
-		}
+/**
+ * The nonce of CCM is the packet counter, the direction, the user level and the session nonce, see CcmNonceCounter.
+ * The user level is part of the nonce, so that it's authenticated without a block of associated data.
+ */
+bool EncryptionHandler::_encryptCCM(uint8_t* data, uint16_t dataLength, uint8_t* target, uint16_t targetLength, EncryptionAccessLevel userLevel) {
+	if (_checkAndSetKey(userLevel) == false)
+		return false;
 
-		// update the variables that keep track of the writing.
-		targetLengthLeftToWrite -= maxIterationWriteAmount;
-		writtenToTarget += maxIterationWriteAmount;
+	if (dataLength + _overhead + CCM_TAG_LENGTH > targetLength) {
+		LOGe(STR_ERR_BUFFER_NOT_LARGE_ENOUGH);
+		return false;
 	}
 
-	if (targetLengthLeftToWrite != 0) {
-		LOGe("Not all decrypted data has been written! %d", targetLengthLeftToWrite);
+	target[PACKET_NONCE_LENGTH] = uint8_t(userLevel);
+	uint8_t nonce[CCM_NONCE_LENGTH];
+	if (_ccmCounter.createSendNonce(target, _sessionNonce, nonce) == false) {
+		LOGe("No packet counters left in this session");
 		return false;
 	}
 
-	return true;
-}
-
-
-/**
- * Checks if the first 4 bytes of the decrypted buffer match the session nonce or the cafebabe if useSessionNonce is false.
- */
-bool EncryptionHandler::_validateDecryption(uint8_t* buffer, uint8_t* validationNonce) {
-	for (uint8_t i = 0; i < VALIDATION_NONCE_LENGTH; i++) {
-		if (buffer[i] != *(validationNonce + i)) {
-			LOGe("Nonce mismatch");
-			return false;
-		}
+	if (_cipher.encryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0, data, dataLength, target + _overhead, CCM_TAG_LENGTH) == false) {
+		LOGe("Error while encrypting");
+		return false;
 	}
 	return true;
 }
 
-
-
-
 /**
- * This is where the magic happens. There are a few things that have to be done before this method is called:
- * 1) The correct key has to be set in the _block.key
- * 2) The correct Nonce has to be set in the _block.clearText
+ * Before this method is called, the correct key has to be set in the cipher.
  *
- * The outputLength should be larger than 0 and a multiple of 16 or this will return false.
- * It is possible that the input is smaller than the output, in this case it will be zero padded.
- *
- * The validation nonce is automatically added to the input.
+ * The target may be the ciphertext in the packet.
  */
-bool EncryptionHandler::_encryptCTR(uint8_t* validationNonce, uint8_t* input, uint16_t inputLength, uint8_t* output, uint16_t outputLength) {
-	if (_validateBlockLength(outputLength) == false) {
-		LOGe(STR_ERR_MULTIPLE_OF_16);
-//		LOGe("Length of output block does not match the expected length (N*16 Bytes).");
+bool EncryptionHandler::_decryptCCM(uint8_t* encryptedDataPacket, uint16_t encryptedDataPacketLength, uint8_t* target, uint16_t targetLength) {
+	uint16_t sourceNetLength = encryptedDataPacketLength - _overhead;
+	if (targetLength < sourceNetLength - CCM_TAG_LENGTH) {
+		LOGe(STR_ERR_BUFFER_NOT_LARGE_ENOUGH);
 		return false;
 	}
-
-	uint32_t err_code;
-
-	// amount of blocks to loop over
-	uint16_t blockCount = outputLength / SOC_ECB_CIPHERTEXT_LENGTH;
-
-	// shift is the position in the data that is being encrypted.
-	uint16_t shift = 0;
-
-	uint32_t inputReadIndex = 0;
-
-#ifdef TESTING_ENCRYPTION
-	for (uint8_t i = 0; i < SOC_ECB_KEY_LENGTH; i++) {
-		LOGi("key: %d", _block.key[i]);
-	}
-#endif
-
-	// encrypt all blocks using AES 128 CTR block mode.
-	for (uint8_t counter = 0; counter < blockCount; counter++) {
-		// prepare the nonce for the next step by concatenating the nonce with the counter
-		_block.cleartext[SOC_ECB_CLEARTEXT_LENGTH-1] = counter;
-
-#ifdef TESTING_ENCRYPTION
-	for (uint8_t i = 0; i < SOC_ECB_CLEARTEXT_LENGTH; i++) {
-		LOGi("IV: %d", _block.cleartext[i]);
+	uint8_t nonce[CCM_NONCE_LENGTH];
+	if (_ccmCounter.createReceiveNonce(encryptedDataPacket, _sessionNonce, nonce) == false) {
+		LOGe("Packet counter not increasing");
+		return false;
 	}
-#endif
-		// encrypts the cleartext and puts it in ciphertext
-		err_code = sd_ecb_block_encrypt(&_block);
-		APP_ERROR_CHECK(err_code);
-
-		// calculate the location in the byte array that we are using
-		shift = counter * SOC_ECB_CIPHERTEXT_LENGTH;
-
-		// XOR the ciphertext with the data to finish encrypting the block.
-		for (uint8_t i = 0; i < SOC_ECB_CIPHERTEXT_LENGTH; i++) {
-			// if we are at the first block, we will add the validation nonce (VN) to the first 4 bytes
-			if (shift == 0 && i < VALIDATION_NONCE_LENGTH) {
-				_block.ciphertext[i] ^= *(validationNonce + i);
-			} else {
-				inputReadIndex = i + shift - VALIDATION_NONCE_LENGTH;
-
-				if (inputReadIndex < inputLength)
-					_block.ciphertext[i] ^= input[inputReadIndex];
-				else
-					_block.ciphertext[i] ^= 0; // zero padding the data to fit in the block.
-			}
-		}
-
-
-		// copy the encrypted block over to the target
-		// the buffer is shifted by the block count (output + shift -. pointer to output[shift])
-		memcpy(output + shift, _block.ciphertext, SOC_ECB_CIPHERTEXT_LENGTH);
+	if (_cipher.decryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0, encryptedDataPacket + _overhead, sourceNetLength, target,
+			CCM_TAG_LENGTH) == false) {
+		return false;
 	}
-
+	_ccmCounter.accept(encryptedDataPacket);
 	return true;
 }
 
-
 /**
  * Check if the key that we need is set in the memory and if so, set it into the encryption block
  */
 bool EncryptionHandler::_checkAndSetKey(uint8_t userLevel) {
+	uint8_t key[AES_KEY_LENGTH];
+	if (_getKey(userLevel, key) == false)
+		return false;
+
+	_cipher.setKey(key);
+	return true;
+}
+
+/**
+ * Get the key of a user level: the setup key, or the key from the storage.
+ */
+bool EncryptionHandler::_getKey(uint8_t userLevel, uint8_t* key) {
 	// check if the userLevel is set.
 	if (userLevel == NOT_SET) {
 		LOGe("User level is not set.");
@@ -491,7 +509,7 @@ bool EncryptionHandler::_checkAndSetKey(uint8_t userLevel) {
 		break;
 	case SETUP: {
 		if (_operationMode == OPERATION_MODE_SETUP && _setupKeyValid) {
-			memcpy(_block.key, _setupKey, SOC_ECB_KEY_LENGTH);
+			memcpy(key, _setupKey, AES_KEY_LENGTH);
 			return true;
 		}
 		LOGe("Can't use this setup key");
@@ -503,11 +521,19 @@ bool EncryptionHandler::_checkAndSetKey(uint8_t userLevel) {
 		return false;
 	}
 
-	// get the key from the storage
-	Settings::getInstance().get(keyConfigType, _block.key);
+	Settings::getInstance().get(keyConfigType, key);
 	return true;
 }
 
+/**
+ * Get the key from the storage, and set it in the cipher.
+ */
+void EncryptionHandler::_setKey(ConfigurationTypes keyConfigType) {
+	uint8_t key[AES_KEY_LENGTH];
+	Settings::getInstance().get(keyConfigType, key);
+	_cipher.setKey(key);
+}
+
 /**
  * This method will fill the buffer with 3 random bytes. These are included in the message
  */
@@ -555,18 +581,6 @@ void EncryptionHandler::_createIV(uint8_t* IV, uint8_t* nonce, EncryptionType en
 }
 
 
-/**
- * Verify if the block length is correct
- */
-bool EncryptionHandler::_validateBlockLength(uint16_t length) {
-	if (length % SOC_ECB_CLEARTEXT_LENGTH != 0 || length == 0) {
-		return false;
-	}
-	return true;
-}
-
-
-
 bool EncryptionHandler::allowAccess(EncryptionAccessLevel minimum, EncryptionAccessLevel provided) {
 	// always allow access when encryption is disabled.
 	if (Settings::getInstance().isSet(CONFIG_ENCRYPTION_ENABLED) == false) {
@@ -594,6 +608,8 @@ bool EncryptionHandler::allowAccess(EncryptionAccessLevel minimum, EncryptionAcc
 }
 
 uint8_t* EncryptionHandler::generateNewSetupKey() {
+	++_keyGeneration;
+	_keystreamCache.clear();
 	if (_operationMode == OPERATION_MODE_SETUP) {
 		RNG::fillBuffer(_setupKey, SOC_ECB_KEY_LENGTH);
 		_setupKeyValid = true;
@@ -606,5 +622,7 @@ uint8_t* EncryptionHandler::generateNewSetupKey() {
 }
 
 void EncryptionHandler::invalidateSetupKey() {
+	++_keyGeneration;
+	_keystreamCache.clear();
 	_setupKeyValid = false;
 }
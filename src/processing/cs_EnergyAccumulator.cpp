@@ -0,0 +1,78 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+#include <processing/cs_EnergyAccumulator.h>
+
+EnergyAccumulator::EnergyAccumulator() {
+	init(1000, 0xFFFFFFFF, POWER_SAMPLING_NOMINAL_PERIOD_US);
+}
+
+void EnergyAccumulator::init(uint32_t ticksPerSecond, uint32_t counterMask, uint32_t bufferIntervalUs) {
+	_ticksPerSecond = ticksPerSecond;
+	_counterMask = counterMask;
+	_bufferIntervalUs = bufferIntervalUs;
+	_maxGapTicks = (uint64_t)POWER_SAMPLING_ENERGY_MAX_GAP_MS * ticksPerSecond / 1000;
+	_started = false;
+	_lastCount = 0;
+	_lastPowerMicroWatt = 0;
+	_energyMicroJoule = 0;
+	_remainder = 0;
+	_gapCount = 0;
+	_gapTicks = 0;
+	_unmeteredTicks = 0;
+}
+
+void EnergyAccumulator::add(uint32_t rtcCount, int64_t powerMicroWatt, uint32_t numMissedBuffers) {
+	if (!_started) {
+		_started = true;
+		_lastCount = rtcCount;
+		_lastPowerMicroWatt = powerMicroWatt;
+		return;
+	}
+	uint64_t ticks = (rtcCount - _lastCount) & _counterMask;
+	_lastCount = rtcCount;
+
+	// When buffers were missed, the counter may have wrapped more than once.
+	uint64_t missedTicks = (uint64_t)numMissedBuffers * _bufferIntervalUs * _ticksPerSecond / 1000000;
+	uint64_t counterSize = (uint64_t)_counterMask + 1;
+	while (ticks + counterSize / 2 < missedTicks) {
+		ticks += counterSize;
+	}
+
+	// Time without any buffers.
+	uint64_t expectedTicks = (uint64_t)(numMissedBuffers + 1) * _bufferIntervalUs * _ticksPerSecond / 1000000;
+	if (ticks > expectedTicks + _maxGapTicks) {
+		_unmeteredTicks += ticks - expectedTicks;
+		ticks = expectedTicks;
+	}
+
+	if (missedTicks > ticks) {
+		missedTicks = ticks;
+	}
+	if (numMissedBuffers) {
+		++_gapCount;
+		_gapTicks += missedTicks;
+	}
+
+	int64_t bridgePowerMicroWatt = (_lastPowerMicroWatt + powerMicroWatt) / 2;
+	_remainder += powerMicroWatt * (int64_t)(ticks - missedTicks) + bridgePowerMicroWatt * (int64_t)missedTicks;
+	_energyMicroJoule += _remainder / _ticksPerSecond;
+	_remainder %= _ticksPerSecond;
+	_lastPowerMicroWatt = powerMicroWatt;
+}
+
+uint32_t EnergyAccumulator::getGapMs() const {
+	return ticksToMs(_gapTicks);
+}
+
+uint32_t EnergyAccumulator::getUnmeteredMs() const {
+	return ticksToMs(_unmeteredTicks);
+}
+
+uint32_t EnergyAccumulator::ticksToMs(uint64_t ticks) const {
+	return ticks * 1000 / _ticksPerSecond;
+}
@@ -0,0 +1,146 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <processing/cs_HarmonicAnalysis.h>
+
+#define GOERTZEL_SHIFT 14
+
+//! Index of the voltage fundamental in the bins, the current bins follow.
+#define VOLTAGE_BIN 0
+#define CURRENT_BIN 1
+
+//! atan(2^-i) in 0.01 degree.
+static const int16_t cordicAngles[] = {4500, 2657, 1404, 713, 358, 179, 90, 45, 22, 11, 6, 3, 1, 1};
+
+HarmonicAnalysis::HarmonicAnalysis() :
+		_numSamples(0)
+{
+	memset(_coefficients, 0, sizeof(_coefficients));
+	memset(_sines, 0, sizeof(_sines));
+	memset(&_quality, 0, sizeof(_quality));
+}
+
+/**
+ * Only done when the number of samples per period changes, so the float math is fine.
+ */
+void HarmonicAnalysis::initCoefficients(uint16_t numSamples) {
+	_numSamples = numSamples;
+	for (uint8_t bin = 0; bin < numBins; ++bin) {
+		// Voltage and current fundamental, then the odd current harmonics: 3, 5, 7, ...
+		uint8_t harmonic = (bin <= CURRENT_BIN) ? 1 : 2 * (bin - CURRENT_BIN) + 1;
+		double w = 2 * M_PI * harmonic / numSamples;
+		_coefficients[bin] = lround(2 * cos(w) * (1 << GOERTZEL_SHIFT));
+		_sines[bin] = lround(sin(w) * (1 << GOERTZEL_SHIFT));
+	}
+}
+
+/**
+ * For each bin: s[n] = x[n] + 2*cos(w)*s[n-1] - s[n-2]
+ * After the last sample, the DFT bin (up to a phase that is the same for every signal in the same bin) is:
+ *   s[n-1] - cos(w)*s[n-2] + j*sin(w)*s[n-2]
+ * An amplitude A of the harmonic gives a magnitude of A * numSamples / 2.
+ */
+void HarmonicAnalysis::analyse(const power_t& power, uint16_t numSamples, const power_calculation_result_t& result) {
+	if (numSamples != _numSamples) {
+		initCoefficients(numSamples);
+	}
+
+	int32_t s1[numBins];
+	int32_t s2[numBins];
+	memset(s1, 0, sizeof(s1));
+	memset(s2, 0, sizeof(s2));
+	const int16_t* buf = power.buf;
+	for (uint16_t i = 0; i < numSamples * power.numChannels; i += power.numChannels) {
+		int32_t voltage = buf[i + power.voltageIndex];
+		int32_t current = buf[i + power.currentIndex];
+		for (uint8_t bin = 0; bin < numBins; ++bin) {
+			int32_t s0 = ((bin == VOLTAGE_BIN) ? voltage : current)
+					+ (int32_t)(((int64_t)_coefficients[bin] * s1[bin]) >> GOERTZEL_SHIFT) - s2[bin];
+			s2[bin] = s1[bin];
+			s1[bin] = s0;
+		}
+	}
+
+	int64_t real[numBins];
+	int64_t imag[numBins];
+	for (uint8_t bin = 0; bin < numBins; ++bin) {
+		real[bin] = s1[bin] - (((int64_t)_coefficients[bin] * s2[bin]) >> (GOERTZEL_SHIFT + 1));
+		imag[bin] = ((int64_t)_sines[bin] * s2[bin]) >> GOERTZEL_SHIFT;
+	}
+
+	// Phase of the current fundamental behind the voltage fundamental: the angle of V * conj(I).
+	int64_t crossReal = real[VOLTAGE_BIN] * real[CURRENT_BIN] + imag[VOLTAGE_BIN] * imag[CURRENT_BIN];
+	int64_t crossImag = imag[VOLTAGE_BIN] * real[CURRENT_BIN] - real[VOLTAGE_BIN] * imag[CURRENT_BIN];
+	_quality.phaseShiftDeciDegrees = atan2DeciDegrees(crossImag, crossReal);
+
+	// Harmonics relative to the fundamental.
+	uint32_t fundamental = isqrt64(real[CURRENT_BIN] * real[CURRENT_BIN] + imag[CURRENT_BIN] * imag[CURRENT_BIN]);
+	uint64_t harmonicsSquareSum = 0;
+	for (uint8_t i = 0; i < POWER_SAMPLING_HARMONICS_COUNT; ++i) {
+		uint8_t bin = CURRENT_BIN + 1 + i;
+		uint64_t square = real[bin] * real[bin] + imag[bin] * imag[bin];
+		harmonicsSquareSum += square;
+		_quality.currentHarmonics[i] = fundamental ? (uint64_t)isqrt64(square) * 1000 / fundamental : 0;
+	}
+	_quality.currentThd = fundamental ? (uint64_t)isqrt64(harmonicsSquareSum) * 1000 / fundamental : 0;
+
+	// Power factor: real power / (Irms * Vrms).
+	int64_t apparent = (int64_t)result.currentRmsMilliAmp * result.voltageRmsMilliVolt;
+	int64_t powerFactor = apparent ? (int64_t)result.powerMilliWatt * 1000 * 1000 / apparent : 0;
+	if (powerFactor > 1000) {
+		powerFactor = 1000;
+	}
+	if (powerFactor < -1000) {
+		powerFactor = -1000;
+	}
+	_quality.powerFactor = powerFactor;
+}
+
+int16_t atan2DeciDegrees(int64_t y, int64_t x) {
+	if (x == 0 && y == 0) {
+		return 0;
+	}
+	// Scale down, so that the vector can grow by the CORDIC gain without overflow.
+	while (x > (1 << 28) || x < -(1 << 28) || y > (1 << 28) || y < -(1 << 28)) {
+		x /= 2;
+		y /= 2;
+	}
+	int32_t cx = x;
+	int32_t cy = y;
+	int32_t angle = 0;
+	// Rotate to the right half plane.
+	if (cx < 0) {
+		angle = (cy < 0) ? -18000 : 18000;
+		cx = -cx;
+		cy = -cy;
+	}
+	// Rotate towards the x axis, and keep up the total rotation.
+	for (uint8_t i = 0; i < sizeof(cordicAngles) / sizeof(cordicAngles[0]); ++i) {
+		int32_t dx = cx >> i;
+		int32_t dy = cy >> i;
+		if (cy > 0) {
+			cx += dy;
+			cy -= dx;
+			angle += cordicAngles[i];
+		}
+		else {
+			cx -= dy;
+			cy += dx;
+			angle -= cordicAngles[i];
+		}
+	}
+	if (angle > 18000) {
+		angle -= 36000;
+	}
+	if (angle < -18000) {
+		angle += 36000;
+	}
+	return (angle >= 0) ? (angle + 5) / 10 : (angle - 5) / 10;
+}
@@ -0,0 +1,78 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+#include <string.h>
+
+#include <processing/cs_KeystreamCache.h>
+
+KeystreamCache::KeystreamCache() {
+	clear();
+	resetStatistics();
+}
+
+int KeystreamCache::find(uint16_t keyId, const uint8_t* sessionNonce) const {
+	for (int i = 0; i < KEYSTREAM_CACHE_ENTRIES; ++i) {
+		const keystream_cache_entry_t& entry = _entries[i];
+		if (__atomic_load_n(&entry.valid, __ATOMIC_ACQUIRE) && entry.keyId == keyId
+				&& memcmp(entry.iv + PACKET_NONCE_LENGTH, sessionNonce, SESSION_NONCE_LENGTH) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool KeystreamCache::contains(uint16_t keyId, const uint8_t* sessionNonce) const {
+	return find(keyId, sessionNonce) >= 0;
+}
+
+void KeystreamCache::store(PacketCipher& cipher, uint16_t keyId, const uint8_t* key, const uint8_t* iv) {
+	// use a free entry, or else replace one.
+	int index = -1;
+	for (uint8_t i = 0; i < KEYSTREAM_CACHE_ENTRIES; ++i) {
+		if (!__atomic_load_n(&_entries[i].valid, __ATOMIC_RELAXED)) {
+			index = i;
+			break;
+		}
+	}
+	if (index < 0) {
+		index = _nextReplace;
+		_nextReplace = (_nextReplace + 1) % KEYSTREAM_CACHE_ENTRIES;
+	}
+
+	// the entry can't be taken while it's being replaced.
+	keystream_cache_entry_t& entry = _entries[index];
+	__atomic_store_n(&entry.valid, false, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	entry.keyId = keyId;
+	memcpy(entry.iv, iv, AES_BLOCK_LENGTH);
+	cipher.setKey(key);
+	cipher.keystream(iv, entry.keystream, sizeof(entry.keystream));
+	__atomic_store_n(&entry.valid, true, __ATOMIC_RELEASE);
+}
+
+const keystream_cache_entry_t* KeystreamCache::take(uint16_t keyId, const uint8_t* sessionNonce) {
+	int index = find(keyId, sessionNonce);
+	if (index < 0) {
+		++_missCount;
+		return NULL;
+	}
+	++_hitCount;
+	__atomic_store_n(&_entries[index].valid, false, __ATOMIC_RELEASE);
+	return &_entries[index];
+}
+
+void KeystreamCache::clear() {
+	for (uint8_t i = 0; i < KEYSTREAM_CACHE_ENTRIES; ++i) {
+		__atomic_store_n(&_entries[i].valid, false, __ATOMIC_RELEASE);
+	}
+	_nextReplace = 0;
+}
+
+void KeystreamCache::resetStatistics() {
+	_hitCount = 0;
+	_missCount = 0;
+}
@@ -0,0 +1,66 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <processing/cs_LoadEventDetector.h>
+
+//! The level follows the Irms with an exponential moving average of this discount (divided by 1000).
+#define LEVEL_DISCOUNT 50
+
+LoadEventDetector::LoadEventDetector() {
+	reset();
+}
+
+void LoadEventDetector::reset() {
+	_started = false;
+	_level = 0;
+	_candidate = 0;
+	_candidateCount = 0;
+	memset(&_event, 0, sizeof(_event));
+}
+
+int32_t LoadEventDetector::minStep(int32_t level) const {
+	int32_t relative = abs(level) * LOAD_EVENT_MIN_STEP_PERCENT / 100;
+	return relative > LOAD_EVENT_MIN_STEP_MILLI_AMP ? relative : LOAD_EVENT_MIN_STEP_MILLI_AMP;
+}
+
+bool LoadEventDetector::update(int32_t currentRmsMilliAmp) {
+	if (!_started) {
+		_started = true;
+		_level = currentRmsMilliAmp;
+		return false;
+	}
+
+	int32_t step = minStep(_level);
+	if (abs(currentRmsMilliAmp - _level) < step) {
+		_candidateCount = 0;
+		_level += (currentRmsMilliAmp - _level) * LEVEL_DISCOUNT / 1000;
+		return false;
+	}
+
+	if (_candidateCount == 0 || abs(currentRmsMilliAmp - _candidate) > minStep(_candidate) / 2) {
+		// Still changing: start debouncing again.
+		_candidate = currentRmsMilliAmp;
+		_candidateCount = 1;
+		return false;
+	}
+
+	++_candidateCount;
+	_candidate += (currentRmsMilliAmp - _candidate) / _candidateCount;
+	if (_candidateCount < LOAD_EVENT_DEBOUNCE_PERIODS) {
+		return false;
+	}
+
+	_event.type = _candidate > _level ? LOAD_EVENT_SWITCHED_ON : LOAD_EVENT_SWITCHED_OFF;
+	_event.deltaMilliAmp = _candidate - _level;
+	_event.currentRmsMilliAmp = _candidate;
+	_level = _candidate;
+	_candidateCount = 0;
+	return true;
+}
@@ -0,0 +1,353 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+#include <string.h>
+
+#include <processing/cs_PacketCipher.h>
+
+#include <cfg/cs_Strings.h>
+#include <drivers/cs_Serial.h>
+
+PacketCipher::PacketCipher(AesBackend& aes) : _aes(aes) {
+	memset(_counterBlocks, 0, sizeof(_counterBlocks));
+	_counterBlockCount = 0;
+	memset(_keystream, 0, sizeof(_keystream));
+}
+
+void PacketCipher::setKey(const uint8_t* key) {
+	_aes.setKey(key);
+}
+
+void PacketCipher::encryptEcb(const uint8_t* cleartext, uint8_t* ciphertext) {
+	_aes.encryptBlock(cleartext, ciphertext);
+}
+
+/**
+ * XOR a block of data with the keystream, a word at a time.
+ *
+ * The words are copied with memcpy, which compiles to single loads and stores: the data may be unaligned (the
+ * Cortex-M4 allows that for single words), only the keystream and scratch blocks are aligned.
+ */
+static inline void xorBlock(uint8_t* output, const uint8_t* input, const uint8_t* keystream) {
+	for (uint8_t i = 0; i < AES_BLOCK_LENGTH; i += sizeof(uint32_t)) {
+		uint32_t data;
+		uint32_t key;
+		memcpy(&data, input + i, sizeof(uint32_t));
+		memcpy(&key, keystream + i, sizeof(uint32_t));
+		data ^= key;
+		memcpy(output + i, &data, sizeof(uint32_t));
+	}
+}
+
+void PacketCipher::startCtr(const uint8_t* iv) {
+	// the other counter blocks get the IV when they're needed, most packets are a single block.
+	memcpy(_counterBlocks, iv, AES_BLOCK_LENGTH);
+	_counterBlockCount = 1;
+}
+
+void PacketCipher::encryptCounters(uint16_t counter, uint8_t blockCount, uint8_t* keystream) {
+	for (; _counterBlockCount < blockCount; ++_counterBlockCount) {
+		memcpy(_counterBlocks + _counterBlockCount * AES_BLOCK_LENGTH, _counterBlocks, AES_BLOCK_LENGTH);
+	}
+	// prepare the IVs for the next step by concatenating the nonce with the counter
+	for (uint8_t i = 0; i < blockCount; ++i) {
+		_counterBlocks[(i + 1) * AES_BLOCK_LENGTH - 1] = (uint8_t)(counter + i);
+	}
+	_aes.encryptBlocks(_counterBlocks, keystream, blockCount);
+}
+
+void PacketCipher::keystream(const uint8_t* iv, uint8_t* keystream, uint16_t keystreamLength) {
+	startCtr(iv);
+	uint16_t blockCount = keystreamLength / AES_BLOCK_LENGTH;
+	for (uint16_t counter = 0; counter < blockCount; counter += AES_BATCH_BLOCKS) {
+		uint8_t batchCount = blockCount - counter < AES_BATCH_BLOCKS ? blockCount - counter : AES_BATCH_BLOCKS;
+		encryptCounters(counter, batchCount, keystream + counter * AES_BLOCK_LENGTH);
+	}
+}
+
+bool PacketCipher::encryptCtr(const uint8_t* iv, const uint8_t* validationNonce, const uint8_t* input,
+		uint16_t inputLength, uint8_t* output, uint16_t outputLength, const uint8_t* keystream,
+		uint16_t keystreamLength) {
+	if (!validBlockLength(outputLength)) {
+		LOGe(STR_ERR_MULTIPLE_OF_16);
+		return false;
+	}
+
+	// amount of blocks to loop over, of which the first ones may have a precomputed keystream.
+	uint16_t blockCount = outputLength / AES_BLOCK_LENGTH;
+	uint16_t precomputedCount = keystreamLength / AES_BLOCK_LENGTH;
+
+	startCtr(iv);
+
+	// encrypt all blocks using AES 128 CTR block mode.
+	uint8_t block[AES_BLOCK_LENGTH] __attribute__ ((aligned (4)));
+	uint16_t counter = 0;
+	while (counter < blockCount) {
+		const uint8_t* batchKeystream;
+		uint16_t batchEnd;
+		if (counter < precomputedCount) {
+			batchKeystream = keystream + counter * AES_BLOCK_LENGTH;
+			batchEnd = precomputedCount < blockCount ? precomputedCount : blockCount;
+		}
+		else {
+			uint8_t batchCount = blockCount - counter < AES_BATCH_BLOCKS ? blockCount - counter : AES_BATCH_BLOCKS;
+			encryptCounters(counter, batchCount, _keystream);
+			batchKeystream = _keystream;
+			batchEnd = counter + batchCount;
+		}
+
+		for (const uint8_t* blockKeystream = batchKeystream; counter < batchEnd; ++counter) {
+			// calculate the location in the byte array that we are using
+			uint16_t shift = counter * AES_BLOCK_LENGTH;
+
+			// the cleartext is the validation nonce (VN), followed by the input, zero padded to fit in the blocks.
+			if (counter > 0 && shift - VALIDATION_NONCE_LENGTH + AES_BLOCK_LENGTH <= inputLength) {
+				xorBlock(output + shift, input + shift - VALIDATION_NONCE_LENGTH, blockKeystream);
+			}
+			else if (counter == 0 && inputLength >= AES_BLOCK_LENGTH - VALIDATION_NONCE_LENGTH) {
+				memcpy(block, validationNonce, VALIDATION_NONCE_LENGTH);
+				memcpy(block + VALIDATION_NONCE_LENGTH, input, AES_BLOCK_LENGTH - VALIDATION_NONCE_LENGTH);
+				xorBlock(output + shift, block, blockKeystream);
+			}
+			else {
+				memset(block, 0, AES_BLOCK_LENGTH);
+				if (counter == 0) {
+					memcpy(block, validationNonce, VALIDATION_NONCE_LENGTH);
+					memcpy(block + VALIDATION_NONCE_LENGTH, input, inputLength);
+				}
+				else if (shift - VALIDATION_NONCE_LENGTH < inputLength) {
+					memcpy(block, input + shift - VALIDATION_NONCE_LENGTH, inputLength - (shift - VALIDATION_NONCE_LENGTH));
+				}
+				xorBlock(output + shift, block, blockKeystream);
+			}
+			blockKeystream += AES_BLOCK_LENGTH;
+		}
+	}
+	return true;
+}
+
+bool PacketCipher::decryptCtr(const uint8_t* iv, const uint8_t* validationNonce, const uint8_t* input,
+		uint16_t inputLength, uint8_t* target, uint16_t targetLength) {
+	if (!validBlockLength(inputLength)) {
+		LOGe(STR_ERR_MULTIPLE_OF_16);
+		return false;
+	}
+
+	// amount of blocks to loop over
+	uint16_t blockCount = (targetLength + VALIDATION_NONCE_LENGTH + AES_BLOCK_LENGTH - 1) / AES_BLOCK_LENGTH;
+	if (blockCount * AES_BLOCK_LENGTH > inputLength) {
+		LOGe("Length mismatch %d, blocks: %d", inputLength, blockCount);
+		return false;
+	}
+
+	startCtr(iv);
+
+	uint8_t block[AES_BLOCK_LENGTH] __attribute__ ((aligned (4)));
+	for (uint16_t counter = 0; counter < blockCount; counter += AES_BATCH_BLOCKS) {
+		uint8_t batchCount = blockCount - counter < AES_BATCH_BLOCKS ? blockCount - counter : AES_BATCH_BLOCKS;
+		encryptCounters(counter, batchCount, _keystream);
+
+		for (uint8_t i = 0; i < batchCount; ++i) {
+			uint16_t blockIndex = counter + i;
+			const uint8_t* blockInput = input + blockIndex * AES_BLOCK_LENGTH;
+			const uint8_t* blockKeystream = _keystream + i * AES_BLOCK_LENGTH;
+
+			// the first block starts with the validation nonce, the target only gets the data after it.
+			if (blockIndex == 0) {
+				xorBlock(block, blockInput, blockKeystream);
+				if (memcmp(block, validationNonce, VALIDATION_NONCE_LENGTH) != 0) {
+					LOGe("Nonce mismatch");
+					return false;
+				}
+				if (targetLength >= AES_BLOCK_LENGTH - VALIDATION_NONCE_LENGTH) {
+					memcpy(target, block + VALIDATION_NONCE_LENGTH, AES_BLOCK_LENGTH - VALIDATION_NONCE_LENGTH);
+				}
+				else {
+					memcpy(target, block + VALIDATION_NONCE_LENGTH, targetLength);
+				}
+				continue;
+			}
+
+			// whole blocks are decrypted straight into the target, the remainder is discarded.
+			uint16_t targetIndex = blockIndex * AES_BLOCK_LENGTH - VALIDATION_NONCE_LENGTH;
+			uint16_t writeAmount = targetLength - targetIndex;
+			if (writeAmount >= AES_BLOCK_LENGTH) {
+				xorBlock(target + targetIndex, blockInput, blockKeystream);
+			}
+			else {
+				xorBlock(block, blockInput, blockKeystream);
+				memcpy(target + targetIndex, block, writeAmount);
+			}
+		}
+	}
+	return true;
+}
+
+bool PacketCipher::decryptCtrInPlace(const uint8_t* iv, const uint8_t* validationNonce, uint8_t* data,
+		uint16_t length) {
+	if (!validBlockLength(length)) {
+		LOGe(STR_ERR_MULTIPLE_OF_16);
+		return false;
+	}
+
+	startCtr(iv);
+
+	uint16_t blockCount = length / AES_BLOCK_LENGTH;
+	for (uint16_t counter = 0; counter < blockCount; counter += AES_BATCH_BLOCKS) {
+		uint8_t batchCount = blockCount - counter < AES_BATCH_BLOCKS ? blockCount - counter : AES_BATCH_BLOCKS;
+		encryptCounters(counter, batchCount, _keystream);
+
+		for (uint8_t i = 0; i < batchCount; ++i) {
+			uint8_t* block = data + (counter + i) * AES_BLOCK_LENGTH;
+			xorBlock(block, block, _keystream + i * AES_BLOCK_LENGTH);
+		}
+
+		// check the validation nonce before decrypting the rest.
+		if (counter == 0 && memcmp(data, validationNonce, VALIDATION_NONCE_LENGTH) != 0) {
+			LOGe("Nonce mismatch");
+			return false;
+		}
+	}
+	return true;
+}
+
+bool PacketCipher::startCcm(const uint8_t* nonce, uint8_t nonceLength, const uint8_t* aad, uint16_t aadLength,
+		uint16_t payloadLength, uint8_t tagLength, uint8_t* mac) {
+	if (nonceLength < CCM_MIN_NONCE_LENGTH || nonceLength > CCM_MAX_NONCE_LENGTH || tagLength < 4
+			|| tagLength > AES_BLOCK_LENGTH || tagLength % 2 != 0) {
+		LOGe("Invalid CCM nonce length %d or tag length %d", nonceLength, tagLength);
+		return false;
+	}
+	if (payloadLength > CCM_MAX_PAYLOAD_LENGTH || aadLength >= 0xFF00) {
+		LOGe(STR_ERR_BUFFER_NOT_LARGE_ENOUGH);
+		return false;
+	}
+
+	// the size of the length field, the rest of the block is flags and nonce.
+	uint8_t lengthSize = AES_BLOCK_LENGTH - 1 - nonceLength;
+
+	// the first block: flags, nonce, payload length.
+	uint8_t block[AES_BLOCK_LENGTH] __attribute__ ((aligned (4)));
+	memset(block, 0, AES_BLOCK_LENGTH);
+	block[0] = (aadLength > 0 ? 0x40 : 0) | ((tagLength - 2) / 2) << 3 | (lengthSize - 1);
+	memcpy(block + 1, nonce, nonceLength);
+	block[AES_BLOCK_LENGTH - 2] = payloadLength >> 8;
+	block[AES_BLOCK_LENGTH - 1] = payloadLength & 0xFF;
+	_aes.encryptBlock(block, mac);
+
+	// the associated data is preceded by its length.
+	if (aadLength > 0) {
+		uint8_t firstLength = aadLength < AES_BLOCK_LENGTH - 2 ? aadLength : AES_BLOCK_LENGTH - 2;
+		block[0] = aadLength >> 8;
+		block[1] = aadLength & 0xFF;
+		memcpy(block + 2, aad, firstLength);
+		cbcMac(mac, block, 2 + firstLength);
+		cbcMac(mac, aad + firstLength, aadLength - firstLength);
+	}
+
+	// the counter blocks: flags, nonce, block number.
+	memset(block, 0, AES_BLOCK_LENGTH);
+	block[0] = lengthSize - 1;
+	memcpy(block + 1, nonce, nonceLength);
+	startCtr(block);
+	return true;
+}
+
+void PacketCipher::cbcMac(uint8_t* mac, const uint8_t* data, uint16_t length) {
+	uint8_t block[AES_BLOCK_LENGTH] __attribute__ ((aligned (4)));
+	for (uint16_t i = 0; i < length; i += AES_BLOCK_LENGTH) {
+		if (length - i >= AES_BLOCK_LENGTH) {
+			xorBlock(block, data + i, mac);
+		}
+		else {
+			memcpy(block, mac, AES_BLOCK_LENGTH);
+			for (uint8_t j = 0; j < length - i; ++j) {
+				block[j] ^= data[i + j];
+			}
+		}
+		_aes.encryptBlock(block, mac);
+	}
+}
+
+void PacketCipher::ccmCtr(const uint8_t* input, uint8_t* output, uint16_t length, uint8_t* tagKeystream) {
+	// block 0 is for the tag, the payload starts at block 1.
+	uint16_t blockCount = (length + AES_BLOCK_LENGTH - 1) / AES_BLOCK_LENGTH + 1;
+	for (uint16_t counter = 0; counter < blockCount; counter += AES_BATCH_BLOCKS) {
+		uint8_t batchCount = blockCount - counter < AES_BATCH_BLOCKS ? blockCount - counter : AES_BATCH_BLOCKS;
+		encryptCounters(counter, batchCount, _keystream);
+
+		for (uint8_t i = 0; i < batchCount; ++i) {
+			uint16_t blockIndex = counter + i;
+			const uint8_t* blockKeystream = _keystream + i * AES_BLOCK_LENGTH;
+			if (blockIndex == 0) {
+				memcpy(tagKeystream, blockKeystream, AES_BLOCK_LENGTH);
+				continue;
+			}
+			uint16_t offset = (blockIndex - 1) * AES_BLOCK_LENGTH;
+			if (length - offset >= AES_BLOCK_LENGTH) {
+				xorBlock(output + offset, input + offset, blockKeystream);
+			}
+			else {
+				for (uint8_t j = 0; j < length - offset; ++j) {
+					output[offset + j] = input[offset + j] ^ blockKeystream[j];
+				}
+			}
+		}
+	}
+}
+
+bool PacketCipher::encryptCcm(const uint8_t* nonce, uint8_t nonceLength, const uint8_t* aad, uint16_t aadLength,
+		const uint8_t* input, uint16_t inputLength, uint8_t* output, uint8_t tagLength) {
+	uint8_t mac[AES_BLOCK_LENGTH] __attribute__ ((aligned (4)));
+	if (!startCcm(nonce, nonceLength, aad, aadLength, inputLength, tagLength, mac)) {
+		return false;
+	}
+
+	// the MAC is of the cleartext, so before it's overwritten.
+	cbcMac(mac, input, inputLength);
+
+	uint8_t tagKeystream[AES_BLOCK_LENGTH] __attribute__ ((aligned (4)));
+	ccmCtr(input, output, inputLength, tagKeystream);
+	for (uint8_t i = 0; i < tagLength; ++i) {
+		output[inputLength + i] = mac[i] ^ tagKeystream[i];
+	}
+	return true;
+}
+
+bool PacketCipher::decryptCcm(const uint8_t* nonce, uint8_t nonceLength, const uint8_t* aad, uint16_t aadLength,
+		const uint8_t* input, uint16_t inputLength, uint8_t* target, uint8_t tagLength) {
+	if (inputLength < tagLength) {
+		LOGe(STR_ERR_BUFFER_NOT_LARGE_ENOUGH);
+		return false;
+	}
+	uint16_t payloadLength = inputLength - tagLength;
+
+	uint8_t mac[AES_BLOCK_LENGTH] __attribute__ ((aligned (4)));
+	if (!startCcm(nonce, nonceLength, aad, aadLength, payloadLength, tagLength, mac)) {
+		return false;
+	}
+
+	uint8_t tagKeystream[AES_BLOCK_LENGTH] __attribute__ ((aligned (4)));
+	ccmCtr(input, target, payloadLength, tagKeystream);
+	cbcMac(mac, target, payloadLength);
+
+	// compare all bytes of the tag, so that the time doesn't tell how many are right.
+	uint8_t difference = 0;
+	for (uint8_t i = 0; i < tagLength; ++i) {
+		difference |= mac[i] ^ tagKeystream[i] ^ input[payloadLength + i];
+	}
+	if (difference != 0) {
+		memset(target, 0, payloadLength);
+		LOGe("Tag mismatch");
+		return false;
+	}
+	return true;
+}
+
+bool PacketCipher::validBlockLength(uint16_t length) {
+	return length % AES_BLOCK_LENGTH == 0 && length != 0;
+}
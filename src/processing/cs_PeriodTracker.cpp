@@ -0,0 +1,104 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+#include <processing/cs_PeriodTracker.h>
+
+//! Positions and periods are in 1/256 sample.
+#define PERIOD_SHIFT 8
+
+//! Weight of a new measurement in the average period: 1/2^PERIOD_AVG_SHIFT.
+#define PERIOD_AVG_SHIFT 3
+
+PeriodTracker::PeriodTracker() :
+		_sampleIntervalUs(CS_ADC_SAMPLE_INTERVAL_US),
+		_period(0),
+		_numMeasurements(0),
+		_sampleCount(0),
+		_lastCrossing(0),
+		_lastCrossingValid(false),
+		_armed(false),
+		_lastVoltage(0)
+{
+}
+
+void PeriodTracker::init(uint32_t sampleIntervalUs) {
+	_sampleIntervalUs = sampleIntervalUs;
+	_period = (POWER_SAMPLING_NOMINAL_PERIOD_US << PERIOD_SHIFT) / sampleIntervalUs;
+	_numMeasurements = 0;
+	_sampleCount = 0;
+	_lastCrossingValid = false;
+	_armed = false;
+	_lastVoltage = 0;
+}
+
+void PeriodTracker::update(const power_t& power, int32_t zeroVoltage) {
+	const int32_t hysteresis = POWER_SAMPLING_ZERO_CROSSING_HYSTERESIS * 1000;
+	int32_t previous = _lastVoltage;
+	uint16_t numSamples = power.bufSize / power.numChannels;
+	for (uint16_t i = 0; i < numSamples; ++i) {
+		int32_t voltage = power.buf[i * power.numChannels + power.voltageIndex] * 1000 - zeroVoltage;
+		if (voltage < -hysteresis) {
+			_armed = true;
+		}
+		else if (_armed && voltage >= 0 && previous < 0) {
+			// Interpolate between the previous sample (index i-1) and this one.
+			uint32_t fraction = ((int64_t)-previous << PERIOD_SHIFT) / (voltage - previous);
+			onCrossing(((_sampleCount + i - 1) << PERIOD_SHIFT) + fraction);
+			_armed = false;
+		}
+		previous = voltage;
+	}
+	_lastVoltage = previous;
+	_sampleCount += numSamples;
+}
+
+void PeriodTracker::onCrossing(uint32_t position) {
+	uint32_t period = position - _lastCrossing;
+	bool valid = _lastCrossingValid;
+	_lastCrossing = position;
+	_lastCrossingValid = true;
+	if (!valid) {
+		return;
+	}
+
+	// Only accept periods within the mains frequency range.
+	uint64_t periodUs = ((uint64_t)period * _sampleIntervalUs) >> PERIOD_SHIFT;
+	if (periodUs < POWER_SAMPLING_MIN_PERIOD_US || periodUs > POWER_SAMPLING_MAX_PERIOD_US) {
+		return;
+	}
+
+	if (_numMeasurements == 0) {
+		_period = period;
+	}
+	else {
+		_period += ((int32_t)period - (int32_t)_period) >> PERIOD_AVG_SHIFT;
+	}
+	if (_numMeasurements < POWER_SAMPLING_PERIOD_LOCK_COUNT) {
+		++_numMeasurements;
+	}
+}
+
+uint32_t PeriodTracker::getPeriodUs() const {
+	if (!isLocked()) {
+		return POWER_SAMPLING_NOMINAL_PERIOD_US;
+	}
+	return ((uint64_t)_period * _sampleIntervalUs) >> PERIOD_SHIFT;
+}
+
+uint32_t PeriodTracker::getWindowUs(uint16_t maxSamples) const {
+	uint32_t numSamples;
+	if (isLocked()) {
+		numSamples = (_period + (1 << (PERIOD_SHIFT - 1))) >> PERIOD_SHIFT;
+	}
+	else {
+		numSamples = POWER_SAMPLING_NOMINAL_PERIOD_US / _sampleIntervalUs;
+	}
+	if (numSamples > maxSamples) {
+		numSamples = maxSamples;
+	}
+	return numSamples * _sampleIntervalUs;
+}
@@ -0,0 +1,193 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+#include <string.h>
+
+#include <processing/cs_PowerCalculation.h>
+
+#include <drivers/cs_Serial.h>
+
+PowerCalculation::PowerCalculation() :
+		_avgZeroVoltage(0),
+		_avgZeroCurrent(0),
+		_recalibrateZeroVoltage(true),
+		_recalibrateZeroCurrent(true)
+{
+	memset(&_config, 0, sizeof(_config));
+	memset(&_result, 0, sizeof(_result));
+	memset(&_currentMultiplier, 0, sizeof(_currentMultiplier));
+	memset(&_voltageMultiplier, 0, sizeof(_voltageMultiplier));
+	memset(&_powerMultiplier, 0, sizeof(_powerMultiplier));
+}
+
+void PowerCalculation::init(const power_calculation_config_t& config) {
+	_config = config;
+	_currentMultiplier = toFixedMultiplier(config.currentMultiplier);
+	_voltageMultiplier = toFixedMultiplier(config.voltageMultiplier);
+	_powerMultiplier = toFixedMultiplier(config.currentMultiplier * config.voltageMultiplier);
+	initAverages();
+	_recalibrateZeroVoltage = true;
+	_recalibrateZeroCurrent = true;
+}
+
+void PowerCalculation::initAverages() {
+	_avgZeroVoltage = _config.voltageZero * 1000;
+	_avgZeroCurrent = _config.currentZero * 1000;
+	_result.avgPowerMilliWatt = 0;
+}
+
+void PowerCalculation::setCurrentMultiplier(float currentMultiplier) {
+	_avgZeroCurrent = (int64_t)_avgZeroCurrent * _config.currentMultiplier / currentMultiplier;
+	_config.currentMultiplier = currentMultiplier;
+	_currentMultiplier = toFixedMultiplier(currentMultiplier);
+	_powerMultiplier = toFixedMultiplier(currentMultiplier * _config.voltageMultiplier);
+}
+
+/**
+ * The sums of the samples are used for both the zero lines and the power. Since the zero lines are only applied to the
+ * sums, they can be updated after summing, before calculating the power.
+ */
+bool PowerCalculation::process(const power_t& power, bool filterCurrent) {
+	uint16_t numSamples = power.acPeriodUs / power.sampleIntervalUs;
+
+	if ((int)power.bufSize < numSamples * power.numChannels) {
+		LOGe("Should have at least a whole period in a buffer!");
+		return false;
+	}
+	if (power.bufSize / power.numChannels > curveSize) {
+		LOGe("Buffer too large");
+		return false;
+	}
+
+	power_sums_t sums;
+	sumPower(power.buf + power.voltageIndex, power.buf + power.currentIndex, power.numChannels, numSamples, sums);
+
+	power_sums_t filteredSums = sums;
+	if (filterCurrent) {
+		filter(power);
+		sumCurrent(_filteredSamples, numSamples, filteredSums);
+	}
+
+	if (_recalibrateZeroVoltage) {
+		calculateVoltageZero(sums);
+//		_recalibrateZeroVoltage = false;
+	}
+	if (_recalibrateZeroCurrent && filterCurrent) {
+		calculateCurrentZero(filteredSums);
+//		_recalibrateZeroCurrent = false;
+	}
+
+	calculatePower(sums, filteredSums, filterCurrent);
+	return true;
+}
+
+/**
+ * The voltage curve is a distorted sinusoid. We calculate the zero(-crossing) by averaging over the buffer over
+ * exactly one cycle (positive and negative) of the sinusoid. The cycle does not start at a particular known phase.
+ *
+ * @param sums                                   Sums of the samples of one cycle: acPeriodUs / sampleIntervalUs samples
+ *                                               (at 50Hz and a sample interval of 200us, this means: 100 samples).
+ */
+void PowerCalculation::calculateVoltageZero(const power_sums_t& sums) {
+	_avgZeroVoltage = updateZero(_avgZeroVoltage, sums.sumVoltage, sums.count, _config.avgZeroVoltageDiscount);
+}
+
+/**
+ * The same as for the voltage curve, but for the current.
+ *
+ * The sums are of the filtered samples.
+ */
+void PowerCalculation::calculateCurrentZero(const power_sums_t& sums) {
+	_avgZeroCurrent = updateZero(_avgZeroCurrent, sums.sumCurrent, sums.count, _config.avgZeroCurrentDiscount);
+}
+
+void PowerCalculation::filter(const power_t& power) {
+	// Filter the data in place, the filter takes care of the padding
+	_curveFilter.filter(power.buf + power.currentIndex, power.numChannels, power.bufSize / power.numChannels,
+			_filteredSamples);
+}
+
+/**
+ * Calculate power.
+ *
+ * The zero offsets and calibration are applied to the sums, see cs_PowerKernel.h.
+ *
+ * Without filtered sums, the filtered Irms and its history are left as they were.
+ */
+void PowerCalculation::calculatePower(const power_sums_t& sums, const power_sums_t& filteredSums, bool filtered) {
+	uint16_t numSamples = sums.count;
+
+	//////////////////////////////////////////////////
+	// Calculatate power, Irms, and Vrms
+	//////////////////////////////////////////////////
+
+	uint64_t cSquareSum = centeredSquareSum(sums.sumCurrent, sums.sumCurrentSquare, _avgZeroCurrent, numSamples);
+	uint64_t vSquareSum = centeredSquareSum(sums.sumVoltage, sums.sumVoltageSquare, _avgZeroVoltage, numSamples);
+	int64_t pSum = centeredProductSum(sums, _avgZeroVoltage, _avgZeroCurrent);
+
+	int32_t powerMilliWatt = powerFromProductSum(pSum, numSamples, _powerMultiplier) - _config.powerZero;
+	int64_t powerMicroWatt = powerMicroWattFromProductSum(pSum, numSamples, _powerMultiplier) - (int64_t)_config.powerZero * 1000;
+	int32_t currentRmsMA = rmsFromSquareSum(cSquareSum, numSamples, _currentMultiplier);
+	int32_t voltageRmsMilliVolt = rmsFromSquareSum(vSquareSum, numSamples, _voltageMultiplier);
+
+
+
+	////////////////////////////////////////////////////////////////////////////////
+	// Calculate Irms of median filtered samples, and filter over multiple periods
+	////////////////////////////////////////////////////////////////////////////////
+
+	if (filtered) {
+		// Calculate Irms again, but now with the filtered current samples
+		cSquareSum = centeredSquareSum(filteredSums.sumCurrent, filteredSums.sumCurrentSquare, _avgZeroCurrent, numSamples);
+		_result.filteredCurrentRmsMilliAmp = rmsFromSquareSum(cSquareSum, numSamples, _currentMultiplier);
+
+		// Calculate median when there are enough values in history, else calculate the average.
+		_result.filteredCurrentRmsMedianMilliAmp = pushAndGetMedian(_filteredCurrentRmsHistMA,
+				_result.filteredCurrentRmsMilliAmp);
+	}
+
+
+
+	/////////////////////////////////////////////////////////
+	// Filter Irms, Vrms, and Power (over multiple periods)
+	/////////////////////////////////////////////////////////
+
+	// Calculate median when there are enough values in history, else calculate the average.
+	int32_t currentRmsMedianMA = pushAndGetMedian(_currentRmsMilliAmpHist, currentRmsMA);
+
+//	// Exponential moving average of the median
+//	int64_t discountCurrent = 200;
+//	_avgCurrentRmsMilliAmp = ((1000-discountCurrent) * _avgCurrentRmsMilliAmp + discountCurrent * medianCurrentRmsMilliAmp) / 1000;
+	// Use median as average
+
+	// Calculate median when there are enough values in history, else calculate the average.
+	int32_t avgVoltageRmsMilliVolt = pushAndGetMedian(_voltageRmsMilliVoltHist, voltageRmsMilliVolt);
+
+	// Calculate apparent power: current_rms * voltage_rms
+	uint32_t powerMilliWattApparent = (int64_t)currentRmsMedianMA * avgVoltageRmsMilliVolt / 1000;
+
+	// Exponential moving average
+	int64_t avgPowerDiscount = _config.avgPowerDiscount;
+	_result.avgPowerMilliWatt = ((1000-avgPowerDiscount) * _result.avgPowerMilliWatt + avgPowerDiscount * powerMilliWatt) / 1000;
+//	_result.avgPowerMilliWatt = powerMilliWatt;
+
+	_result.currentRmsMilliAmp = currentRmsMA;
+	_result.currentRmsMedianMilliAmp = currentRmsMedianMA;
+	_result.voltageRmsMilliVolt = voltageRmsMilliVolt;
+	_result.avgVoltageRmsMilliVolt = avgVoltageRmsMilliVolt;
+	_result.powerMilliWatt = powerMilliWatt;
+	_result.powerMicroWatt = powerMicroWatt;
+	_result.powerMilliWattApparent = powerMilliWattApparent;
+}
+
+int32_t PowerCalculation::pushAndGetMedian(RmsHistory& hist, int32_t value) {
+	hist.push(value);
+	if (hist.full()) {
+		return hist.median();
+	}
+	return hist.average();
+}
@@ -14,15 +14,11 @@
 #include <events/cs_EventDispatcher.h>
 #include <storage/cs_State.h>
 #include <processing/cs_Switch.h>
-#include <third/optmed.h>
 
 #if BUILD_MESHING == 1
 #include <mesh/cs_MeshControl.h>
 #endif
 
-#include <math.h>
-#include "third/SortMedian.h"
-
 // Define test pin to enable gpio debug.
 //#define TEST_PIN 20
 
@@ -37,9 +33,17 @@ PowerSampling::PowerSampling() :
 		_adc(NULL),
 		_powerSamplingSentDoneTimerId(NULL),
 		_powerSamplesBuffer(NULL),
-		_consecutivePwmOvercurrent(0),
-		_lastEnergyCalculationTicks(0),
-		_energyUsedmicroJoule(0),
+		_powerSamplesBufferSize(0),
+		_streamingEnabled(false),
+		_numProcessedBuffers(0),
+#if POWER_SAMPLING_AUTO_RANGE == 1
+		_autoRange(false),
+		_rangeChangePending(false),
+		_rangeCalibratedLevel(0),
+		_currentMultiplier(0),
+#endif
+		_lastOverrunCount(0),
+		_numUncalculatedBuffers(0),
 //		_lastSwitchState(0),
 		_lastSwitchOffTicks(0),
 		_lastSwitchOffTicksValid(false),
@@ -48,21 +52,9 @@ PowerSampling::PowerSampling() :
 	_powerSamplingReadTimerData = { {0} };
 	_powerSamplingSentDoneTimerId = &_powerSamplingReadTimerData;
 	_adc = &(ADC::getInstance());
-	_powerMilliWattHist = new CircularBuffer<int32_t>(POWER_SAMPLING_RMS_WINDOW_SIZE);
-	_currentRmsMilliAmpHist = new CircularBuffer<int32_t>(POWER_SAMPLING_RMS_WINDOW_SIZE);
-	_voltageRmsMilliVoltHist = new CircularBuffer<int32_t>(POWER_SAMPLING_RMS_WINDOW_SIZE);
-	_filteredCurrentRmsHistMA = new CircularBuffer<int32_t>(POWER_SAMPLING_RMS_WINDOW_SIZE);
 	_logsEnabled.asInt = 0;
 }
 
-#if POWER_SAMPLING_RMS_WINDOW_SIZE == 7
-#define opt_med(arr) opt_med7(arr)
-#elif POWER_SAMPLING_RMS_WINDOW_SIZE == 9
-#define opt_med(arr) opt_med9(arr)
-#elif POWER_SAMPLING_RMS_WINDOW_SIZE == 25
-#define opt_med(arr) opt_med25(arr)
-#endif
-
 #ifdef PRINT_POWER_SAMPLES
 static int printPower = 0;
 #endif
@@ -78,45 +70,52 @@ void PowerSampling::init(const boards_config_t& boardConfig) {
 	Timer::getInstance().createSingleShot(_powerSamplingSentDoneTimerId, (app_timer_timeout_handler_t)PowerSampling::staticPowerSampleRead);
 
 	Settings& settings = Settings::getInstance();
-	settings.get(CONFIG_VOLTAGE_MULTIPLIER, &_voltageMultiplier);
-	settings.get(CONFIG_CURRENT_MULTIPLIER, &_currentMultiplier);
-	settings.get(CONFIG_VOLTAGE_ZERO, &_voltageZero);
-	settings.get(CONFIG_CURRENT_ZERO, &_currentZero);
-	settings.get(CONFIG_POWER_ZERO, &_powerZero);
+	power_calculation_config_t calculationConfig;
+	settings.get(CONFIG_VOLTAGE_MULTIPLIER, &calculationConfig.voltageMultiplier);
+	settings.get(CONFIG_CURRENT_MULTIPLIER, &calculationConfig.currentMultiplier);
+	settings.get(CONFIG_VOLTAGE_ZERO, &calculationConfig.voltageZero);
+	settings.get(CONFIG_CURRENT_ZERO, &calculationConfig.currentZero);
+	settings.get(CONFIG_POWER_ZERO, &calculationConfig.powerZero);
 	settings.get(CONFIG_SOFT_FUSE_CURRENT_THRESHOLD, &_currentMilliAmpThreshold);
 	settings.get(CONFIG_SOFT_FUSE_CURRENT_THRESHOLD_PWM, &_currentMilliAmpThresholdPwm);
-
-	initAverages();
-	_recalibrateZeroVoltage = true;
-	_recalibrateZeroCurrent = true;
-	_avgZeroVoltageDiscount = VOLTAGE_ZERO_EXP_AVG_DISCOUNT;
-	_avgZeroCurrentDiscount = CURRENT_ZERO_EXP_AVG_DISCOUNT;
-	_avgPowerDiscount = POWER_EXP_AVG_DISCOUNT;
+	_softFuse.init(_currentMilliAmpThreshold);
+#if POWER_SAMPLING_SCHEDULER == 1
+	_samplingScheduler.init((int32_t)_currentMilliAmpThreshold * POWER_SAMPLING_BURST_GUARD_PERCENT / 100);
+#endif
+	_softFusePwm.init(_currentMilliAmpThresholdPwm);
+	// The dimmer heats up quickly, whatever the load.
+	for (uint8_t loadClass = 0; loadClass < SOFT_FUSE_NUM_LOAD_CLASSES; ++loadClass) {
+		soft_fuse_curve_t curve;
+		curve.tripMs = SOFT_FUSE_TRIP_MS_PWM;
+		curve.shortPercent = SOFT_FUSE_SHORT_PERCENT;
+		curve.shortPeriods = loadClass == SOFT_FUSE_LOAD_ELECTRONIC ? SOFT_FUSE_SHORT_PERIODS + 1 : SOFT_FUSE_SHORT_PERIODS;
+		curve.maxPeriods = SOFT_FUSE_MAX_PERIODS_PWM;
+		_softFusePwm.setCurve((soft_fuse_load_class_t)loadClass, curve);
+	}
+	calculationConfig.avgZeroVoltageDiscount = VOLTAGE_ZERO_EXP_AVG_DISCOUNT;
+	calculationConfig.avgZeroCurrentDiscount = CURRENT_ZERO_EXP_AVG_DISCOUNT;
+	calculationConfig.avgPowerDiscount = POWER_EXP_AVG_DISCOUNT;
+	_voltageZero = calculationConfig.voltageZero;
 	_sendingSamples = false;
+	_streamingEnabled = settings.isSet(CONFIG_CONT_POWER_SAMPLER_ENABLED);
 
 	LOGi(FMT_INIT, "buffers");
 	uint16_t burstSize = _powerSamples.getMaxLength();
+	uint16_t streamSize = WaveformEncoder::maxEncodedSize(CS_ADC_BUF_SIZE / 2);
 
-	size_t size = burstSize;
+	size_t size = burstSize > streamSize ? burstSize : streamSize;
 	_powerSamplesBuffer = (buffer_ptr_t) calloc(size, sizeof(uint8_t));
+	_powerSamplesBufferSize = size;
 	LOGd("power sample buffer=%u size=%u", _powerSamplesBuffer, size);
 
 	_powerSamples.assign(_powerSamplesBuffer, size);
-	_powerMilliWattHist->init(); // Allocates buffer
-	_currentRmsMilliAmpHist->init(); // Allocates buffer
-	_voltageRmsMilliVoltHist->init(); // Allocates buffer
-	_filteredCurrentRmsHistMA->init(); // Allocates buffer
-
-	// Init moving median filter
-	unsigned halfWindowSize = POWER_SAMPLING_CURVE_HALF_WINDOW_SIZE;
-//	unsigned halfWindowSize = 5;  // Takes 0.74ms
-//	unsigned halfWindowSize = 16; // Takes 0.93ms
-	unsigned windowSize = halfWindowSize * 2 + 1;
-	uint16_t bufSize = CS_ADC_BUF_SIZE / 2;
-	unsigned blockCount = (bufSize + halfWindowSize*2) / windowSize; // Shouldn't have a remainder!
-	_filterParams = new MedianFilter(halfWindowSize, blockCount);
-	_inputSamples = new PowerVector(bufSize + halfWindowSize*2);
-	_outputSamples = new PowerVector(bufSize);
+
+	// The buffers of the filters and histories are members, only the calibration has to be set.
+	_powerCalculation.init(calculationConfig);
+#if POWER_SAMPLING_PERIOD_TRACKING == 1
+	_periodTracker.init(CS_ADC_SAMPLE_INTERVAL_US);
+#endif
+	_energyAccumulator.init(RTC::msToTicks(1000), MAX_RTC_COUNTER_VAL, CS_ADC_BUF_SIZE / 2 * CS_ADC_SAMPLE_INTERVAL_US);
 
 	LOGd(FMT_INIT, "ADC");
 	adc_config_t adcConfig;
@@ -145,6 +144,20 @@ void PowerSampling::init(const boards_config_t& boardConfig) {
 	_adcConfig.currentDifferential = true;
 	_adcConfig.voltageDifferential = true;
 
+#if POWER_SAMPLING_AUTO_RANGE == 1
+	// Only in differential mode, the samples are centered around 0.
+	_rangeController.init(-2048, 2047);
+	_rangeController.addPin(_adcConfig.currentPinGainHigh, 1.0f, 3600);
+	_rangeController.addPin(_adcConfig.currentPinGainMed, boardConfig.currentGainMed, 3600);
+	_rangeController.addPin(_adcConfig.currentPinGainLow, boardConfig.currentGainLow, 3600);
+	// Without calibrated gains, the other levels would only make the current less accurate.
+	_autoRange = _adcConfig.zeroReferencePin != CS_ADC_REF_PIN_NOT_AVAILABLE
+			&& boardConfig.currentGainMed > 0 && boardConfig.currentGainLow > 0
+			&& _rangeController.setLevel(_adcConfig.currentPinGainHigh, boardConfig.currentRange);
+	_rangeCalibratedLevel = _rangeController.getLevel();
+	_currentMultiplier = calculationConfig.currentMultiplier;
+#endif
+
 	EventDispatcher::getInstance().addListener(this);
 
 #ifdef TEST_PIN
@@ -193,6 +206,9 @@ void PowerSampling::handleEvent(uint16_t evt, void* p_data, uint16_t length) {
 	case EVT_TOGGLE_LOG_FILTERED_CURRENT:
 		_logsEnabled.flags.filteredCurrent = !_logsEnabled.flags.filteredCurrent;
 		break;
+	case EVT_CONT_POWER_SAMPLER_ENABLED:
+		_streamingEnabled = *(bool*)p_data;
+		break;
 	case EVT_TOGGLE_ADC_VOLTAGE_VDD_REFERENCE_PIN:
 		toggleVoltageChannelInput();
 		break;
@@ -226,6 +242,7 @@ void PowerSampling::powerSampleAdcDone(nrf_saadc_value_t* buf, uint16_t size, ui
 #ifdef TEST_PIN
 	nrf_gpio_pin_toggle(TEST_PIN);
 #endif
+	++_numProcessedBuffers;
 	power_t power;
 	power.buf = buf;
 	power.bufSize = size;
@@ -233,37 +250,81 @@ void PowerSampling::powerSampleAdcDone(nrf_saadc_value_t* buf, uint16_t size, ui
 	power.currentIndex = CURRENT_CHANNEL_IDX;
 	power.numChannels = 2;
 	power.sampleIntervalUs = CS_ADC_SAMPLE_INTERVAL_US;
-	power.acPeriodUs = 20000;
-
-	filter(power);
-#ifdef TEST_PIN
-	nrf_gpio_pin_toggle(TEST_PIN);
+#if POWER_SAMPLING_PERIOD_TRACKING == 1
+	_periodTracker.update(power, _powerCalculation.getAvgZeroVoltage());
+	power.acPeriodUs = _periodTracker.getWindowUs(size / power.numChannels);
+#else
+	power.acPeriodUs = POWER_SAMPLING_NOMINAL_PERIOD_US;
 #endif
 
-	if (_recalibrateZeroVoltage) {
-		calculateVoltageZero(power);
-//		_recalibrateZeroVoltage = false;
-	}
-	if (_recalibrateZeroCurrent) {
-		calculateCurrentZero(power);
-//		_recalibrateZeroCurrent = false;
-	}
+#if POWER_SAMPLING_AUTO_RANGE == 1
+	updateRange(power);
+#endif
 
+	// Between bursts, only some periods get the filter, harmonic analysis and sample copies.
+	bool fullProcessing = true;
+#if POWER_SAMPLING_SCHEDULER == 1
+	_samplingScheduler.setHold(_streamingEnabled || _logsEnabled.asInt != 0);
+	fullProcessing = _samplingScheduler.processNext();
+#endif
+	bool calculated = _powerCalculation.process(power, fullProcessing);
 #ifdef TEST_PIN
 	nrf_gpio_pin_toggle(TEST_PIN);
 #endif
 
-	calculatePower(power);
-	calculateEnergy();
+	if (calculated) {
+		const power_calculation_result_t& result = _powerCalculation.getResult();
+		// Now that Irms is known: first check the soft fuse.
+		// Without the filter, the filtered Irms is of an earlier period: use the unfiltered Irms, which is only higher.
+		int32_t filteredCurrentRmsMA = fullProcessing ? result.filteredCurrentRmsMilliAmp : result.currentRmsMilliAmp;
+		checkSoftfuse(result.currentRmsMilliAmp, filteredCurrentRmsMA, power.acPeriodUs);
+#if POWER_SAMPLING_SCHEDULER == 1
+		_samplingScheduler.update(result.currentRmsMilliAmp, power.acPeriodUs, fullProcessing);
+#endif
+		if (fullProcessing) {
+#if POWER_SAMPLING_HARMONIC_ANALYSIS == 1
+			_harmonicAnalysis.analyse(power, power.acPeriodUs / power.sampleIntervalUs, result);
+#endif
+			printPowerSamples(power);
+		}
+		calculateEnergy();
+	}
+	else {
+		// The power is still that of a previous buffer: bridge this buffer like a missed one.
+		++_numUncalculatedBuffers;
+	}
 
 	if (_operationMode == OPERATION_MODE_NORMAL) {
-		if (!_sendingSamples) {
-			copyBufferToPowerSamples(power);
+		if (!_sendingSamples && fullProcessing) {
+			if (_streamingEnabled) {
+				streamBuffer(power);
+			}
+			else {
+				copyBufferToPowerSamples(power);
+			}
 		}
 		// TODO: use State.set() for this.
-		EventDispatcher::getInstance().dispatch(STATE_POWER_USAGE, &_avgPowerMilliWatt, sizeof(_avgPowerMilliWatt));
+		int32_t avgPowerMilliWatt = _powerCalculation.getResult().avgPowerMilliWatt;
+		EventDispatcher::getInstance().dispatch(STATE_POWER_USAGE, &avgPowerMilliWatt, sizeof(avgPowerMilliWatt));
+
+		int64_t energyUsedMicroJoule = _energyAccumulator.getEnergyMicroJoule();
+		EventDispatcher::getInstance().dispatch(STATE_ACCUMULATED_ENERGY, &energyUsedMicroJoule, sizeof(energyUsedMicroJoule));
+
+#if LOAD_EVENT_DETECTION == 1
+		// Without the filter, the filtered Irms median is that of an earlier period: only feed filtered periods.
+		if (calculated && fullProcessing && _loadEventDetector.update(_powerCalculation.getResult().filteredCurrentRmsMedianMilliAmp)) {
+			load_event_t loadEvent = _loadEventDetector.getEvent();
+			LOGi("load switched %s: delta=%i mA", loadEvent.type == LOAD_EVENT_SWITCHED_ON ? "on" : "off", loadEvent.deltaMilliAmp);
+			EventDispatcher::getInstance().dispatch(EVT_LOAD_SWITCHED, &loadEvent, sizeof(loadEvent));
+		}
+#endif
 
-		EventDispatcher::getInstance().dispatch(STATE_ACCUMULATED_ENERGY, &_energyUsedmicroJoule, sizeof(_energyUsedmicroJoule));
+#if POWER_SAMPLING_HARMONIC_ANALYSIS == 1
+		if (calculated && fullProcessing) {
+			power_quality_t quality = _harmonicAnalysis.getPowerQuality();
+			EventDispatcher::getInstance().dispatch(EVT_POWER_QUALITY, &quality, sizeof(quality));
+		}
+#endif
 	}
 
 #ifdef TEST_PIN
@@ -273,7 +334,8 @@ void PowerSampling::powerSampleAdcDone(nrf_saadc_value_t* buf, uint16_t size, ui
 }
 
 void PowerSampling::getBuffer(buffer_ptr_t& buffer, uint16_t& size) {
-	_powerSamples.getBuffer(buffer, size);
+	buffer = _powerSamplesBuffer;
+	size = _powerSamplesBufferSize;
 }
 
 /**
@@ -315,242 +377,36 @@ void PowerSampling::readyToSendPowerSamples() {
 	Timer::getInstance().start(_powerSamplingSentDoneTimerId, MS_TO_TICKS(3000), this);
 }
 
-void PowerSampling::initAverages() {
-	_avgZeroVoltage = _voltageZero * 1000;
-	_avgZeroCurrent = _currentZero * 1000;
-	_avgPower = 0.0;
-}
-
 /**
- * This just returns the given currentIndex. 
+ * Each chunk is sent as back-to-back notifications, and the next chunk follows POWER_SAMPLE_STREAM_INTERVAL_MS later.
+ * That's longer than a buffer, so the stream is decimated: only every other buffer is sent. The sequence number of a
+ * chunk counts every filled buffer, the overwritten ones included, so the gaps in the sequence show which buffers were
+ * skipped.
  */
-uint16_t PowerSampling::determineCurrentIndex(power_t power) {
-	return power.currentIndex;
-}
-
-/**
- * The voltage curve is a distorted sinusoid. We calculate the zero(-crossing) by averaging over the buffer over 
- * exactly one cycle (positive and negative) of the sinusoid. The cycle does not start at a particular known phase.
- *
- * @param buf                                    Series of samples for voltage and current (we skip every numChannel).
- * @param bufSize                                Not used.
- * @param numChannels                            By default 2 channels, voltage and current.
- * @param voltageIndex                           Offset into the array.
- * @param currentIndex                           Offset into the array for current (irrelevant).
- * @param sampleIntervalUs                       CS_ADC_SAMPLE_INTERVAL_US (default 200).
- * @param acPeriodUs                             20000 (at 50Hz this is 20.000 microseconds, this means: 100 samples).
- *
- * We iterate over the buffer. The number of samples within a single buffer (either voltage or current) depends on the
- * period in microseconds and the sample interval also in microseconds.
- */
-void PowerSampling::calculateVoltageZero(power_t power) {
-	uint16_t numSamples = power.acPeriodUs / power.sampleIntervalUs; 
-
-	int64_t sum = 0;
-	for (int i = power.voltageIndex; i < numSamples * power.numChannels; i += power.numChannels) {
-		sum += power.buf[i];
+void PowerSampling::streamBuffer(const power_t& power) {
+	EventDispatcher::getInstance().dispatch(EVT_POWER_SAMPLES_START);
+	uint16_t sequence = _numProcessedBuffers + _adc->getOverrunCount();
+	uint16_t size = _waveformEncoder.encode(power, sequence, RTC::getCount(), _powerSamplesBuffer, _powerSamplesBufferSize);
+	if (size == 0) {
+		return;
 	}
-	int32_t zeroVoltage = sum * 1000 / numSamples;
-//	_avgZeroVoltage = zeroVoltage;
-	
-	// Exponential moving average
-	int64_t avgZeroVoltageDiscount = _avgZeroVoltageDiscount; // Make sure calculations are in int64_t
-	_avgZeroVoltage = ((1000 - avgZeroVoltageDiscount) * _avgZeroVoltage + avgZeroVoltageDiscount * zeroVoltage) / 1000;
+	_sendingSamples = true;
+	EventDispatcher::getInstance().dispatch(EVT_POWER_SAMPLES_END, _powerSamplesBuffer, size);
+	Timer::getInstance().start(_powerSamplingSentDoneTimerId, MS_TO_TICKS(POWER_SAMPLE_STREAM_INTERVAL_MS), this);
 }
 
 /**
- * The same as for the voltage curve, but for the current.
+ * This just returns the given currentIndex. 
  */
-void PowerSampling::calculateCurrentZero(power_t power) {
-	uint16_t numSamples = power.acPeriodUs / power.sampleIntervalUs; 
-
-	int64_t sum = 0;
-//	for (int i = power.currentIndex; i < numSamples * power.numChannels; i += power.numChannels) {
-//		sum += power.buf[i];
-//	}
-	// Use filtered samples to calculate the zero.
-	for (int i = 0; i < numSamples; ++i) {
-		sum += _outputSamples->at(i);
-	}
-	int32_t zeroCurrent = sum * 1000 / numSamples;
-//	_avgZeroCurrent = zeroCurrent;
-
-	// Exponential moving average
-	int64_t avgZeroCurrentDiscount = _avgZeroCurrentDiscount; // Make sure calculations are in int64_t
-	_avgZeroCurrent = ((1000 - avgZeroCurrentDiscount) * _avgZeroCurrent + avgZeroCurrentDiscount * zeroCurrent) / 1000;
-}
-
-void PowerSampling::filter(power_t power) {
-	uint16_t bufSize = power.bufSize / power.numChannels;
-//
-//	// Parameters
-//	unsigned halfWindowSize = 5;  // Takes 0.74ms
-//	unsigned halfWindowSize = 16; // Takes 0.93ms
-//	unsigned windowSize = halfWindowSize * 2 + 1;
-//	unsigned blockCount = (bufSize + halfWindowSize*2) / windowSize; // Shouldn't have a remainder!
-//	MedianFilter filterParams(halfWindowSize, blockCount);
-//
-//	Vector samples(bufSize + halfWindowSize*2);
-//	Vector filtered(bufSize);
-
-
-	// Pad the start of the input vector with the first sample in the buffer
-	uint16_t j = 0;
-	for (; j<_filterParams->half; ++j) {
-		_inputSamples->at(j) = power.buf[power.currentIndex];
-	}
-	// Copy samples from buffer to input vector
-	uint16_t i = power.currentIndex;
-	for (; i<power.bufSize; i += power.numChannels) {
-		_inputSamples->at(j) = power.buf[i];
-		++j;
-	}
-	// Pad the end of the buffer with the last sample in the buffer
-	for (; j<bufSize+_filterParams->half; ++j) {
-		_inputSamples->at(j) = power.buf[i];
-	}
-
-	// Filter the data
-	sort_median(*_filterParams, *_inputSamples, *_outputSamples);
+uint16_t PowerSampling::determineCurrentIndex(power_t power) {
+	return power.currentIndex;
 }
 
-
-/**
- * Calculate power.
- *
- * The int64_t sum is large enough: 2^63 / (2^12 * 1000 * 2^12 * 1000) = 5*10^5. Many more samples than the 100 we use.
- */
-void PowerSampling::calculatePower(power_t power) {
-
-	uint16_t numSamples = power.acPeriodUs / power.sampleIntervalUs; 
-
-	if ((int)power.bufSize < numSamples * power.numChannels) {
-		LOGe("Should have at least a whole period in a buffer!");
-		return;
-	}
-
-	//////////////////////////////////////////////////
-	// Calculatate power, Irms, and Vrms
-	//////////////////////////////////////////////////
-
-	int64_t pSum = 0;
-	int64_t cSquareSum = 0;
-	int64_t vSquareSum = 0;
-	int64_t current;
-	int64_t voltage;
-	for (uint16_t i = 0; i < numSamples * power.numChannels; i += power.numChannels) {
-		current = (int64_t)power.buf[i+power.currentIndex]*1000 - _avgZeroCurrent;
-		voltage = (int64_t)power.buf[i+power.voltageIndex]*1000 - _avgZeroVoltage;
-		cSquareSum += (current * current) / (1000*1000);
-		vSquareSum += (voltage * voltage) / (1000*1000);
-		pSum +=       (current * voltage) / (1000*1000);
-	}
-	int32_t powerMilliWatt = pSum * _currentMultiplier * _voltageMultiplier * 1000 / numSamples - _powerZero;
-	int32_t currentRmsMA =  sqrt((double)cSquareSum * _currentMultiplier * _currentMultiplier / numSamples) * 1000;
-	int32_t voltageRmsMilliVolt = sqrt((double)vSquareSum * _voltageMultiplier * _voltageMultiplier / numSamples) * 1000;
-
-
-
-	////////////////////////////////////////////////////////////////////////////////
-	// Calculate Irms of median filtered samples, and filter over multiple periods
-	////////////////////////////////////////////////////////////////////////////////
-
-	// Calculate Irms again, but now with the filtered current samples
-	cSquareSum = 0;
-	for (uint16_t i=0; i<numSamples; ++i) {
-		current = (int64_t)_outputSamples->at(i)*1000 - _avgZeroCurrent;
-		cSquareSum += (current * current) / (1000*1000);
-	}
-	int32_t filteredCurrentRmsMA =  sqrt((double)cSquareSum * _currentMultiplier * _currentMultiplier / numSamples) * 1000;
-
-	// Calculate median when there are enough values in history, else calculate the average.
-	_filteredCurrentRmsHistMA->push(filteredCurrentRmsMA);
-	int32_t filteredCurrentRmsMedianMA;
-	if (_filteredCurrentRmsHistMA->full()) {
-		memcpy(_histCopy, _filteredCurrentRmsHistMA->getBuffer(), _filteredCurrentRmsHistMA->getMaxByteSize());
-		filteredCurrentRmsMedianMA = opt_med(_histCopy);
-	}
-	else {
-		int64_t currentRmsSumMA = 0;
-		for (uint16_t i=0; i<_filteredCurrentRmsHistMA->size(); ++i) {
-			currentRmsSumMA += _filteredCurrentRmsHistMA->operator [](i);
-		}
-		filteredCurrentRmsMedianMA = currentRmsSumMA / _filteredCurrentRmsHistMA->size();
-	}
-
-	// Now that Irms is known: first check the soft fuse.
-	checkSoftfuse(filteredCurrentRmsMedianMA, filteredCurrentRmsMedianMA);
-
-
-
-	/////////////////////////////////////////////////////////
-	// Filter Irms, Vrms, and Power (over multiple periods)
-	/////////////////////////////////////////////////////////
-
-	// Calculate median when there are enough values in history, else calculate the average.
-	_currentRmsMilliAmpHist->push(currentRmsMA);
-	int32_t currentRmsMedianMA;
-	if (_currentRmsMilliAmpHist->full()) {
-		memcpy(_histCopy, _currentRmsMilliAmpHist->getBuffer(), _currentRmsMilliAmpHist->getMaxByteSize());
-		currentRmsMedianMA = opt_med(_histCopy);
-	}
-	else {
-		int64_t currentRmsMilliAmpSum = 0;
-		for (uint16_t i=0; i<_currentRmsMilliAmpHist->size(); ++i) {
-			currentRmsMilliAmpSum += _currentRmsMilliAmpHist->operator [](i);
-		}
-		currentRmsMedianMA = currentRmsMilliAmpSum / _currentRmsMilliAmpHist->size();
-	}
-
-//	// Exponential moving average of the median
-//	int64_t discountCurrent = 200;
-//	_avgCurrentRmsMilliAmp = ((1000-discountCurrent) * _avgCurrentRmsMilliAmp + discountCurrent * medianCurrentRmsMilliAmp) / 1000;
-	// Use median as average
-	_avgCurrentRmsMilliAmp = currentRmsMedianMA;
-
-	// Calculate median when there are enough values in history, else calculate the average.
-	_voltageRmsMilliVoltHist->push(voltageRmsMilliVolt);
-	if (_voltageRmsMilliVoltHist->full()) {
-		memcpy(_histCopy, _voltageRmsMilliVoltHist->getBuffer(), _voltageRmsMilliVoltHist->getMaxByteSize());
-		_avgVoltageRmsMilliVolt = opt_med(_histCopy);
-	}
-	else {
-		int64_t voltageRmsMilliVoltSum = 0;
-		for (uint16_t i=0; i<_voltageRmsMilliVoltHist->size(); ++i) {
-			voltageRmsMilliVoltSum += _voltageRmsMilliVoltHist->operator [](i);
-		}
-		_avgVoltageRmsMilliVolt = voltageRmsMilliVoltSum / _voltageRmsMilliVoltHist->size();
-	}
-
-	// Calculate apparent power: current_rms * voltage_rms
-	__attribute__((unused)) uint32_t powerMilliWattApparent = (int64_t)_avgCurrentRmsMilliAmp * _avgVoltageRmsMilliVolt / 1000;
-
-//	// Calculate median when there are enough values in history, else calculate the average.
-//	_powerMilliWattHist->push(powerMilliWatt);
-//	if (_powerMilliWattHist->full()) {
-//		memcpy(_histCopy, _powerMilliWattHist->getBuffer(), _powerMilliWattHist->getMaxByteSize());
-//		_avgPowerMilliWatt = opt_med(_histCopy);
-//	}
-//	else {
-//		int64_t powerMilliWattSum = 0;
-//		for (uint16_t i=0; i<_powerMilliWattHist->size(); ++i) {
-//			powerMilliWattSum += _powerMilliWattHist->operator [](i);
-//		}
-//		_avgPowerMilliWatt = powerMilliWattSum / _powerMilliWattHist->size();
-//	}
-
-	// Exponential moving average
-	int64_t avgPowerDiscount = _avgPowerDiscount;
-	_avgPowerMilliWatt = ((1000-avgPowerDiscount) * _avgPowerMilliWatt + avgPowerDiscount * powerMilliWatt) / 1000;
-//	_avgPowerMilliWatt = powerMilliWatt;
-
-
-
-	/////////////////////////////////////////////////////////
-	// Debug prints
-	/////////////////////////////////////////////////////////
-
+void PowerSampling::printPowerSamples(const power_t& power) {
 #ifdef PRINT_POWER_SAMPLES
+	uint16_t numSamples = power.acPeriodUs / power.sampleIntervalUs;
+	const power_calculation_result_t& result = _powerCalculation.getResult();
+
 	if (printPower % 500 == 0) {
 //	if (printPower % 500 == 0 || currentRmsMedianMA > _currentMilliAmpThresholdPwm || currentRmsMA > _currentMilliAmpThresholdPwm) {
 
@@ -560,11 +416,16 @@ void PowerSampling::calculatePower(power_t power) {
 //			write("%i %i ", currentRmsMilliAmp, _avgCurrentRmsMilliAmp);
 //			write("%i %i ", voltageRmsMilliVolt, _avgVoltageRmsMilliVolt);
 //			write("%i %i ", powerMilliWatt, _avgPowerMilliWatt);
-			write("I=%i I_med=%i filt_I=%i filt_I_med=%i ", currentRmsMA, currentRmsMedianMA, filteredCurrentRmsMA, filteredCurrentRmsMedianMA);
-			write("vZero=%i cZero=%i ", _avgZeroVoltage, _avgZeroCurrent);
+			write("I=%i I_med=%i filt_I=%i filt_I_med=%i ", result.currentRmsMilliAmp, result.currentRmsMedianMilliAmp, result.filteredCurrentRmsMilliAmp, result.filteredCurrentRmsMedianMilliAmp);
+			write("vZero=%i cZero=%i ", _powerCalculation.getAvgZeroVoltage(), _powerCalculation.getAvgZeroCurrent());
 //			write("pSum=%lld ", pSum);
-			write("apparent=%u ", powerMilliWattApparent);
-			write("power=%d avg=%d ",powerMilliWatt, _avgPowerMilliWatt);
+			write("apparent=%u ", result.powerMilliWattApparent);
+			write("power=%d avg=%d ", result.powerMilliWatt, result.avgPowerMilliWatt);
+			write("overruns=%u backlog=%u latency=%u ", _adc->getOverrunCount(), _adc->getMaxFilledCount(), _adc->getMaxDoneLatencyMs());
+#if POWER_SAMPLING_HARMONIC_ANALYSIS == 1
+			const power_quality_t& quality = _harmonicAnalysis.getPowerQuality();
+			write("pf=%i phase=%i thd=%u ", quality.powerFactor, quality.phaseShiftDeciDegrees, quality.currentThd);
+#endif
 			write("\r\n");
 		}
 
@@ -586,7 +447,7 @@ void PowerSampling::calculatePower(power_t power) {
 			write("Filtered: ");
 //			write("\r\n");
 			for (int i = 0; i < numSamples; ++i) {
-				write("%d ", _outputSamples->at(i));
+				write("%d ", _powerCalculation.getFilteredCurrent()[i]);
 				if (i % 20 == 20 - 1) {
 //					write("\r\n");
 				}
@@ -612,18 +473,22 @@ void PowerSampling::calculatePower(power_t power) {
 }
 
 void PowerSampling::calculateEnergy() {
-	uint32_t rtcCount = RTC::getCount();
-	uint32_t diffTicks = RTC::difference(rtcCount, _lastEnergyCalculationTicks);
-	// TODO: using ms introduces more error (due to rounding to ms), maybe use ticks directly?
-//	_energyUsedmicroJoule += (int64_t)_avgPowerMilliWatt * RTC::ticksToMs(diffTicks);
-//	_energyUsedmicroJoule += (int64_t)_avgPowerMilliWatt * diffTicks * (NRF_RTC0->PRESCALER + 1) * 1000 / RTC_CLOCK_FREQ;
-
-	// In order to keep more precision: multiply ticks by some number, then divide the result by the same number.
-	_energyUsedmicroJoule += (int64_t)_avgPowerMilliWatt * RTC::ticksToMs(1024*diffTicks) / 1024;
-	_lastEnergyCalculationTicks = rtcCount;
+	// Buffers that the ADC overwrote are gaps in the energy.
+	uint32_t overrunCount = _adc->getOverrunCount();
+	uint32_t numMissedBuffers = overrunCount - _lastOverrunCount + _numUncalculatedBuffers;
+	_lastOverrunCount = overrunCount;
+	_numUncalculatedBuffers = 0;
+
+	// Use the power of this period, not the averaged power, which lags behind.
+	_energyAccumulator.add(RTC::getCount(), _powerCalculation.getResult().powerMicroWatt, numMissedBuffers);
 }
 
-void PowerSampling::checkSoftfuse(int32_t currentRmsMA, int32_t currentRmsFilteredMA) {
+/**
+ * The soft fuses are evaluated every period, with the Irms of that period. The load class is determined from the power
+ * quality of the previous period, so that the inrush of a motor already gets the motor curve. Between bursts that power
+ * quality can be older, the soft fuses latch the class during an overload.
+ */
+void PowerSampling::checkSoftfuse(int32_t currentRmsMA, int32_t currentRmsFilteredMA, uint32_t periodUs) {
 	//! Get the current state errors
 	state_errors_t stateErrors;
 	State::getInstance().get(STATE_ERRORS, stateErrors.asInt);
@@ -641,6 +506,12 @@ void PowerSampling::checkSoftfuse(int32_t currentRmsMA, int32_t currentRmsFilter
 	switch_state_t prevSwitchState = _lastSwitchState;
 	State::getInstance().get(STATE_SWITCH_STATE, &switchState, sizeof(switch_state_t));
 	_lastSwitchState = switchState;
+#if POWER_SAMPLING_SCHEDULER == 1
+	if (switchState.relay_state != prevSwitchState.relay_state || switchState.pwm_state != prevSwitchState.pwm_state) {
+		// Follow the inrush of the switched load closely.
+		_samplingScheduler.requestBurst();
+	}
+#endif
 
 	if (switchState.relay_state == 0 && switchState.pwm_state == 0 && (prevSwitchState.relay_state || prevSwitchState.pwm_state)) {
 		// switch has been turned off
@@ -663,24 +534,30 @@ void PowerSampling::checkSoftfuse(int32_t currentRmsMA, int32_t currentRmsFilter
 	// ---------------------- end of to do --------------------------
 
 
-	// Check if the filtered Irms is above threshold.
-	if ((currentRmsFilteredMA > _currentMilliAmpThreshold) && (!stateErrors.errors.overCurrent)) {
+	soft_fuse_load_class_t loadClass = SOFT_FUSE_LOAD_RESISTIVE;
+#if POWER_SAMPLING_HARMONIC_ANALYSIS == 1
+	const power_quality_t& quality = _harmonicAnalysis.getPowerQuality();
+	loadClass = SoftFuse::classify(quality.phaseShiftDeciDegrees, quality.currentThd);
+#endif
+
+	// Check if the filtered Irms has been above threshold for too long.
+	if (_softFuse.update(currentRmsFilteredMA, periodUs, loadClass) && (!stateErrors.errors.overCurrent)) {
 		LOGw("current above threshold");
 		EventDispatcher::getInstance().dispatch(EVT_CURRENT_USAGE_ABOVE_THRESHOLD);
 		State::getInstance().set(STATE_ERROR_OVER_CURRENT, (uint8_t)1);
 		return;
 	}
 
-	// When the dimmer is on: check if the filtered Irms is above threshold, or if the unfiltered Irms is way above threshold.
-//	if ((currentRmsFilteredMA > _currentMilliAmpThresholdPwm || currentRmsMA > (int32_t)_currentMilliAmpThresholdPwm*5) && (!stateErrors.errors.overCurrentPwm)) {
-//	if ((currentRmsFilteredMA > _currentMilliAmpThresholdPwm) && (!stateErrors.errors.overCurrentPwm)) {
-	if (currentRmsMA > _currentMilliAmpThresholdPwm) {
-		++_consecutivePwmOvercurrent;
+	// Check if the unfiltered Irms has been above the dimmer threshold for too long.
+	// When the relay is on, the current doesn't go through the dimmer.
+	bool pwmTripped = false;
+	if (switchState.relay_state) {
+		_softFusePwm.reset();
 	}
 	else {
-		_consecutivePwmOvercurrent = 0;
+		pwmTripped = _softFusePwm.update(currentRmsMA, periodUs, loadClass);
 	}
-	if ((_consecutivePwmOvercurrent > 20) && (!stateErrors.errors.overCurrentPwm)) {
+	if (pwmTripped && (!stateErrors.errors.overCurrentPwm)) {
 		// Get the current pwm state before we dispatch the event (as that may change the pwm).
 		switch_state_t switchState;
 		State::getInstance().get(STATE_SWITCH_STATE, &switchState, sizeof(switch_state_t));
@@ -741,6 +618,9 @@ void PowerSampling::toggleVoltageChannelInput() {
 }
 
 void PowerSampling::toggleDifferentialModeCurrent() {
+#if POWER_SAMPLING_AUTO_RANGE == 1
+	disableAutoRange();
+#endif
 	_adcConfig.currentDifferential = !_adcConfig.currentDifferential;
 	adc_channel_config_t channelConfig;
 	channelConfig.pin = _adcConfig.currentPinGainHigh;
@@ -759,6 +639,11 @@ void PowerSampling::toggleDifferentialModeVoltage() {
 }
 
 void PowerSampling::changeRange(uint8_t channel, int32_t amount) {
+#if POWER_SAMPLING_AUTO_RANGE == 1
+	if (channel == CURRENT_CHANNEL_IDX) {
+		disableAutoRange();
+	}
+#endif
 	_adcConfig.rangeMilliVolt[channel] += amount;
 	if (_adcConfig.rangeMilliVolt[channel] < 150 || _adcConfig.rangeMilliVolt[channel] > 3600) {
 		_adcConfig.rangeMilliVolt[channel] -= amount;
@@ -777,3 +662,42 @@ void PowerSampling::changeRange(uint8_t channel, int32_t amount) {
 	channelConfig.rangeMilliVolt = _adcConfig.rangeMilliVolt[channel];
 	_adc->changeChannel(channel, channelConfig);
 }
+
+#if POWER_SAMPLING_AUTO_RANGE == 1
+/**
+ * The ADC applies a changed config only when it's idle, and drops the buffers that were filled in the meantime. So the
+ * buffers that are handed out while the change is pending, still have the old range. The first buffer after that has
+ * the new range: only then the current multiplier is changed, before the buffer is processed.
+ */
+void PowerSampling::updateRange(const power_t& power) {
+	if (!_autoRange || _adc->isConfigChangePending()) {
+		return;
+	}
+	if (_rangeChangePending) {
+		_rangeChangePending = false;
+		uint8_t level = _rangeController.getLevel();
+		_powerCalculation.setCurrentMultiplier(_currentMultiplier / _rangeController.getScale(_rangeCalibratedLevel, level));
+		return;
+	}
+	if (_rangeController.update(power)) {
+		const adc_range_level_t& level = _rangeController.getLevelConfig();
+		adc_channel_config_t channelConfig;
+		channelConfig.pin = level.pin;
+		channelConfig.rangeMilliVolt = level.rangeMilliVolt;
+		channelConfig.referencePin = _adcConfig.zeroReferencePin;
+		_adcConfig.rangeMilliVolt[CURRENT_CHANNEL_IDX] = level.rangeMilliVolt;
+		_adc->changeChannel(CURRENT_CHANNEL_IDX, channelConfig);
+		_rangeChangePending = true;
+	}
+}
+
+void PowerSampling::disableAutoRange() {
+	if (!_autoRange) {
+		return;
+	}
+	_autoRange = false;
+	_rangeChangePending = false;
+	// Like before, the debug commands don't change the multiplier.
+	_powerCalculation.setCurrentMultiplier(_currentMultiplier);
+}
+#endif
@@ -0,0 +1,70 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+#include <stdlib.h>
+
+#include <processing/cs_SamplingScheduler.h>
+
+SamplingScheduler::SamplingScheduler() {
+	init(CURRENT_USAGE_THRESHOLD * POWER_SAMPLING_BURST_GUARD_PERCENT / 100);
+}
+
+void SamplingScheduler::init(int32_t guardMilliAmp) {
+	_guardMilliAmp = guardMilliAmp;
+	_hold = false;
+	_referenceMilliAmp = 0;
+	_referenceValid = false;
+	_sinceProcessedUs = 0;
+	_lastPeriodUs = POWER_SAMPLING_NOMINAL_PERIOD_US;
+	requestBurst();
+}
+
+void SamplingScheduler::requestBurst() {
+	_mode = SAMPLING_MODE_BURST;
+	_burstLeftUs = POWER_SAMPLING_BURST_MS * 1000;
+}
+
+void SamplingScheduler::setHold(bool hold) {
+	_hold = hold;
+	if (hold) {
+		requestBurst();
+	}
+}
+
+bool SamplingScheduler::processNext() const {
+	return _mode == SAMPLING_MODE_BURST || _sinceProcessedUs + _lastPeriodUs >= POWER_SAMPLING_MONITOR_INTERVAL_MS * 1000;
+}
+
+int32_t SamplingScheduler::minStep(int32_t currentRmsMilliAmp) const {
+	int32_t relative = abs(currentRmsMilliAmp) * POWER_SAMPLING_BURST_STEP_PERCENT / 100;
+	return relative > POWER_SAMPLING_BURST_STEP_MILLI_AMP ? relative : POWER_SAMPLING_BURST_STEP_MILLI_AMP;
+}
+
+void SamplingScheduler::update(int32_t currentRmsMilliAmp, uint32_t periodUs, bool processed) {
+	_lastPeriodUs = periodUs;
+	bool trigger = currentRmsMilliAmp >= _guardMilliAmp
+			|| (_referenceValid && abs(currentRmsMilliAmp - _referenceMilliAmp) >= minStep(_referenceMilliAmp));
+	if (processed) {
+		_sinceProcessedUs = 0;
+		_referenceMilliAmp = currentRmsMilliAmp;
+		_referenceValid = true;
+	}
+	else {
+		_sinceProcessedUs += periodUs;
+	}
+
+	if (trigger || _hold) {
+		requestBurst();
+		return;
+	}
+	if (_burstLeftUs > periodUs) {
+		_burstLeftUs -= periodUs;
+		return;
+	}
+	_burstLeftUs = 0;
+	_mode = SAMPLING_MODE_MONITOR;
+}
@@ -0,0 +1,112 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+#include <processing/cs_SoftFuse.h>
+
+SoftFuse::SoftFuse() {
+	init(CURRENT_USAGE_THRESHOLD);
+}
+
+/**
+ * Number of nominal periods in the trip time of a curve, so that even a current just above the threshold trips within
+ * the trip time, instead of after the long time that it takes to heat up.
+ */
+static uint8_t maxPeriods(uint16_t tripMs) {
+	uint32_t periods = (uint32_t)tripMs * 1000 / POWER_SAMPLING_NOMINAL_PERIOD_US;
+	return periods < 255 ? periods : 255;
+}
+
+void SoftFuse::init(uint32_t thresholdMilliAmp) {
+	_thresholdMilliAmp = thresholdMilliAmp;
+	_curves[SOFT_FUSE_LOAD_RESISTIVE].tripMs = SOFT_FUSE_TRIP_MS_RESISTIVE;
+	_curves[SOFT_FUSE_LOAD_RESISTIVE].shortPercent = SOFT_FUSE_SHORT_PERCENT;
+	_curves[SOFT_FUSE_LOAD_RESISTIVE].shortPeriods = SOFT_FUSE_SHORT_PERIODS;
+	_curves[SOFT_FUSE_LOAD_RESISTIVE].maxPeriods = maxPeriods(SOFT_FUSE_TRIP_MS_RESISTIVE);
+	_curves[SOFT_FUSE_LOAD_MOTOR].tripMs = SOFT_FUSE_TRIP_MS_MOTOR;
+	_curves[SOFT_FUSE_LOAD_MOTOR].shortPercent = SOFT_FUSE_SHORT_PERCENT_MOTOR;
+	_curves[SOFT_FUSE_LOAD_MOTOR].shortPeriods = SOFT_FUSE_SHORT_PERIODS;
+	_curves[SOFT_FUSE_LOAD_MOTOR].maxPeriods = maxPeriods(SOFT_FUSE_TRIP_MS_MOTOR);
+	_curves[SOFT_FUSE_LOAD_ELECTRONIC].tripMs = SOFT_FUSE_TRIP_MS_ELECTRONIC;
+	_curves[SOFT_FUSE_LOAD_ELECTRONIC].shortPercent = SOFT_FUSE_SHORT_PERCENT;
+	// The inrush peak of an electronic load lasts at most a period.
+	_curves[SOFT_FUSE_LOAD_ELECTRONIC].shortPeriods = SOFT_FUSE_SHORT_PERIODS + 1;
+	_curves[SOFT_FUSE_LOAD_ELECTRONIC].maxPeriods = maxPeriods(SOFT_FUSE_TRIP_MS_ELECTRONIC);
+	reset();
+}
+
+void SoftFuse::setCurve(soft_fuse_load_class_t loadClass, const soft_fuse_curve_t& curve) {
+	_curves[loadClass] = curve;
+}
+
+void SoftFuse::reset() {
+	_heat = 0;
+	_shortCount = 0;
+	_aboveCount = 0;
+	_loadClass = SOFT_FUSE_LOAD_RESISTIVE;
+	_heatedCount = 0;
+}
+
+int64_t SoftFuse::tripHeat(soft_fuse_load_class_t loadClass) const {
+	int64_t threshold = _thresholdMilliAmp;
+	int64_t multiple = SOFT_FUSE_TRIP_MULTIPLE_PERCENT;
+	return threshold * threshold * (multiple * multiple - 100 * 100) / (100 * 100) * _curves[loadClass].tripMs;
+}
+
+bool SoftFuse::update(int32_t currentRmsMilliAmp, uint32_t periodUs, soft_fuse_load_class_t loadClass) {
+	if (_heatedCount < SOFT_FUSE_CLASS_LATCH_PERIODS) {
+		_loadClass = loadClass;
+	}
+
+	int64_t current = currentRmsMilliAmp;
+	int64_t threshold = _thresholdMilliAmp;
+	_heat += (current * current - threshold * threshold) * periodUs / 1000;
+	if (_heat < 0) {
+		_heat = 0;
+	}
+
+	const soft_fuse_curve_t& curve = _curves[_loadClass];
+	if (current * 100 > threshold * curve.shortPercent) {
+		if (_shortCount < 255) {
+			++_shortCount;
+		}
+	}
+	else {
+		_shortCount = 0;
+	}
+	if (current > threshold) {
+		if (_aboveCount < 255) {
+			++_aboveCount;
+		}
+	}
+	else {
+		_aboveCount = 0;
+	}
+
+	if (_heat == 0 && _shortCount == 0) {
+		_heatedCount = 0;
+	}
+	else if (_heatedCount < SOFT_FUSE_CLASS_LATCH_PERIODS) {
+		++_heatedCount;
+	}
+	return _shortCount >= curve.shortPeriods || (curve.maxPeriods && _aboveCount >= curve.maxPeriods)
+			|| _heat >= tripHeat(_loadClass);
+}
+
+uint32_t SoftFuse::getHeatPercent(soft_fuse_load_class_t loadClass) const {
+	int64_t trip = tripHeat(loadClass);
+	return trip ? _heat * 100 / trip : 0;
+}
+
+soft_fuse_load_class_t SoftFuse::classify(int16_t phaseShiftDeciDegrees, uint16_t currentThd) {
+	if (phaseShiftDeciDegrees > SOFT_FUSE_MOTOR_PHASE_DECI_DEGREES) {
+		return SOFT_FUSE_LOAD_MOTOR;
+	}
+	if (currentThd > SOFT_FUSE_ELECTRONIC_THD) {
+		return SOFT_FUSE_LOAD_ELECTRONIC;
+	}
+	return SOFT_FUSE_LOAD_RESISTIVE;
+}
@@ -0,0 +1,35 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+#include <string.h>
+
+#include <processing/cs_SoftdeviceAes.h>
+
+#include <util/cs_BleError.h>
+
+void SoftdeviceAes::setKey(const uint8_t* key) {
+	memcpy(_block.key, key, SOC_ECB_KEY_LENGTH);
+}
+
+void SoftdeviceAes::encryptBlock(const uint8_t* cleartext, uint8_t* ciphertext) {
+	memcpy(_block.cleartext, cleartext, SOC_ECB_CLEARTEXT_LENGTH);
+
+	// encrypts the cleartext and puts it in ciphertext
+	uint32_t err_code = sd_ecb_block_encrypt(&_block);
+	APP_ERROR_CHECK(err_code);
+
+	memcpy(ciphertext, _block.ciphertext, SOC_ECB_CIPHERTEXT_LENGTH);
+}
+
+void SoftdeviceAes::encryptBlocks(const uint8_t* cleartext, uint8_t* ciphertext, uint16_t blockCount) {
+	for (uint16_t i = 0; i < blockCount; ++i) {
+		memcpy(_block.cleartext, cleartext + i * SOC_ECB_CLEARTEXT_LENGTH, SOC_ECB_CLEARTEXT_LENGTH);
+		uint32_t err_code = sd_ecb_block_encrypt(&_block);
+		APP_ERROR_CHECK(err_code);
+		memcpy(ciphertext + i * SOC_ECB_CIPHERTEXT_LENGTH, _block.ciphertext, SOC_ECB_CIPHERTEXT_LENGTH);
+	}
+}
@@ -0,0 +1,179 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+#include <string.h>
+
+#include <processing/cs_SoftwareAes.h>
+
+#if SOFTWARE_AES_NI == 1
+#include <immintrin.h>
+#endif
+
+static const uint8_t sbox[256] = {
+	0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+	0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+	0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+	0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+	0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+	0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+	0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+	0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+	0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+	0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+	0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+	0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+	0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+	0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+	0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+	0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+//! Multiplication by x (2) in GF(2^8).
+static inline uint8_t xtime(uint8_t a) {
+	return (uint8_t)((a << 1) ^ ((a & 0x80) ? 0x1b : 0x00));
+}
+
+#if SOFTWARE_AES_NI == 1
+static bool cpuSupportsAesNi() {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("aes");
+}
+#endif
+
+SoftwareAes::SoftwareAes(bool allowAesNi) {
+	memset(_roundKeys, 0, sizeof(_roundKeys));
+#if SOFTWARE_AES_NI == 1
+	_useAesNi = allowAesNi && cpuSupportsAesNi();
+#else
+	_useAesNi = false;
+#endif
+}
+
+/**
+ * Key expansion of FIPS-197 section 5.2, byte wise. AES-NI uses the same round keys for encryption.
+ */
+void SoftwareAes::setKey(const uint8_t* key) {
+	memcpy(_roundKeys, key, AES_KEY_LENGTH);
+	uint8_t rcon = 0x01;
+	for (uint8_t i = AES_KEY_LENGTH; i < sizeof(_roundKeys); i += 4) {
+		uint8_t temp[4];
+		memcpy(temp, _roundKeys + i - 4, 4);
+		if (i % AES_KEY_LENGTH == 0) {
+			// RotWord, SubWord, and the round constant.
+			uint8_t first = temp[0];
+			temp[0] = sbox[temp[1]] ^ rcon;
+			temp[1] = sbox[temp[2]];
+			temp[2] = sbox[temp[3]];
+			temp[3] = sbox[first];
+			rcon = xtime(rcon);
+		}
+		for (uint8_t j = 0; j < 4; ++j) {
+			_roundKeys[i + j] = _roundKeys[i + j - AES_KEY_LENGTH] ^ temp[j];
+		}
+	}
+}
+
+void SoftwareAes::encryptBlock(const uint8_t* cleartext, uint8_t* ciphertext) {
+#if SOFTWARE_AES_NI == 1
+	if (_useAesNi) {
+		encryptBlockAesNi(cleartext, ciphertext);
+		return;
+	}
+#endif
+	encryptBlockPortable(cleartext, ciphertext);
+}
+
+void SoftwareAes::encryptBlocks(const uint8_t* cleartext, uint8_t* ciphertext, uint16_t blockCount) {
+#if SOFTWARE_AES_NI == 1
+	if (_useAesNi) {
+		encryptBlocksAesNi(cleartext, ciphertext, blockCount);
+		return;
+	}
+#endif
+	for (uint16_t i = 0; i < blockCount; ++i) {
+		encryptBlockPortable(cleartext + i * AES_BLOCK_LENGTH, ciphertext + i * AES_BLOCK_LENGTH);
+	}
+}
+
+/**
+ * The state is kept column by column, like the bytes of the block: state[4*c + r] is row r of column c.
+ */
+void SoftwareAes::encryptBlockPortable(const uint8_t* cleartext, uint8_t* ciphertext) {
+	uint8_t state[AES_BLOCK_LENGTH];
+	for (uint8_t i = 0; i < AES_BLOCK_LENGTH; ++i) {
+		state[i] = cleartext[i] ^ _roundKeys[i];
+	}
+	for (uint8_t round = 1; round <= numRounds; ++round) {
+		// SubBytes and ShiftRows: row r is rotated left by r columns.
+		uint8_t shifted[AES_BLOCK_LENGTH];
+		for (uint8_t c = 0; c < 4; ++c) {
+			for (uint8_t r = 0; r < 4; ++r) {
+				shifted[4 * c + r] = sbox[state[4 * ((c + r) % 4) + r]];
+			}
+		}
+		const uint8_t* roundKey = _roundKeys + round * AES_BLOCK_LENGTH;
+		if (round == numRounds) {
+			// The last round has no MixColumns.
+			for (uint8_t i = 0; i < AES_BLOCK_LENGTH; ++i) {
+				state[i] = shifted[i] ^ roundKey[i];
+			}
+			break;
+		}
+		// MixColumns and AddRoundKey.
+		for (uint8_t c = 0; c < 4; ++c) {
+			const uint8_t* col = shifted + 4 * c;
+			uint8_t all = col[0] ^ col[1] ^ col[2] ^ col[3];
+			for (uint8_t r = 0; r < 4; ++r) {
+				state[4 * c + r] = col[r] ^ all ^ xtime(col[r] ^ col[(r + 1) % 4]) ^ roundKey[4 * c + r];
+			}
+		}
+	}
+	memcpy(ciphertext, state, AES_BLOCK_LENGTH);
+}
+
+#if SOFTWARE_AES_NI == 1
+__attribute__((target("aes,sse2")))
+void SoftwareAes::encryptBlockAesNi(const uint8_t* cleartext, uint8_t* ciphertext) {
+	const __m128i* roundKeys = (const __m128i*)_roundKeys;
+	__m128i state = _mm_xor_si128(_mm_loadu_si128((const __m128i*)cleartext), _mm_load_si128(roundKeys));
+	for (uint8_t round = 1; round < numRounds; ++round) {
+		state = _mm_aesenc_si128(state, _mm_load_si128(roundKeys + round));
+	}
+	state = _mm_aesenclast_si128(state, _mm_load_si128(roundKeys + numRounds));
+	_mm_storeu_si128((__m128i*)ciphertext, state);
+}
+
+__attribute__((target("aes,sse2")))
+void SoftwareAes::encryptBlocksAesNi(const uint8_t* cleartext, uint8_t* ciphertext, uint16_t blockCount) {
+	const __m128i* roundKeys = (const __m128i*)_roundKeys;
+	const __m128i* in = (const __m128i*)cleartext;
+	__m128i* out = (__m128i*)ciphertext;
+	uint16_t i = 0;
+	for (; i + 4 <= blockCount; i += 4) {
+		__m128i key = _mm_load_si128(roundKeys);
+		__m128i s0 = _mm_xor_si128(_mm_loadu_si128(in + i), key);
+		__m128i s1 = _mm_xor_si128(_mm_loadu_si128(in + i + 1), key);
+		__m128i s2 = _mm_xor_si128(_mm_loadu_si128(in + i + 2), key);
+		__m128i s3 = _mm_xor_si128(_mm_loadu_si128(in + i + 3), key);
+		for (uint8_t round = 1; round < numRounds; ++round) {
+			key = _mm_load_si128(roundKeys + round);
+			s0 = _mm_aesenc_si128(s0, key);
+			s1 = _mm_aesenc_si128(s1, key);
+			s2 = _mm_aesenc_si128(s2, key);
+			s3 = _mm_aesenc_si128(s3, key);
+		}
+		key = _mm_load_si128(roundKeys + numRounds);
+		_mm_storeu_si128(out + i, _mm_aesenclast_si128(s0, key));
+		_mm_storeu_si128(out + i + 1, _mm_aesenclast_si128(s1, key));
+		_mm_storeu_si128(out + i + 2, _mm_aesenclast_si128(s2, key));
+		_mm_storeu_si128(out + i + 3, _mm_aesenclast_si128(s3, key));
+	}
+	for (; i < blockCount; ++i) {
+		encryptBlockAesNi(cleartext + i * AES_BLOCK_LENGTH, ciphertext + i * AES_BLOCK_LENGTH);
+	}
+}
+#endif
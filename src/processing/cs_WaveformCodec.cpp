@@ -0,0 +1,262 @@
+/**
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+#include <string.h>
+
+#include <processing/cs_WaveformCodec.h>
+
+//! Size of a sample after an escape code.
+#define ESCAPE_WIDTH 16
+
+/** Writes values of a given number of bits, LSB first.
+ */
+class BitWriter {
+public:
+	BitWriter(uint8_t* out, uint16_t size) : _out(out), _size(size), _bytes(0), _bits(0), _numBits(0), _overflow(false) {}
+
+	void write(uint32_t value, uint8_t width) {
+		_bits |= (value & ((1UL << width) - 1)) << _numBits;
+		_numBits += width;
+		while (_numBits >= 8) {
+			put(_bits);
+			_bits >>= 8;
+			_numBits -= 8;
+		}
+	}
+
+	//! Write the remaining bits, and return the number of bytes written, or 0 on overflow.
+	uint16_t flush() {
+		if (_numBits) {
+			put(_bits);
+		}
+		return _overflow ? 0 : _bytes;
+	}
+
+private:
+	uint8_t* _out;
+	uint16_t _size;
+	uint16_t _bytes;
+	uint32_t _bits;
+	uint8_t _numBits;
+	bool _overflow;
+
+	void put(uint8_t byte) {
+		if (_bytes >= _size) {
+			_overflow = true;
+			return;
+		}
+		_out[_bytes++] = byte;
+	}
+};
+
+/** Reads values of a given number of bits, LSB first.
+ */
+class BitReader {
+public:
+	BitReader(const uint8_t* in, uint16_t size) : _in(in), _size(size), _bytes(0), _bits(0), _numBits(0), _underflow(false) {}
+
+	//! Read a signed value.
+	int32_t read(uint8_t width) {
+		while (_numBits < width) {
+			if (_bytes >= _size) {
+				_underflow = true;
+				return 0;
+			}
+			_bits |= (uint32_t)_in[_bytes++] << _numBits;
+			_numBits += 8;
+		}
+		uint32_t value = _bits & ((1UL << width) - 1);
+		_bits >>= width;
+		_numBits -= width;
+		// Sign extend.
+		if (value & (1UL << (width - 1))) {
+			return (int32_t)value - (int32_t)(1UL << width);
+		}
+		return value;
+	}
+
+	//! Number of bytes read, or 0 when reading past the end.
+	uint16_t bytesRead() const {
+		return _underflow ? 0 : _bytes;
+	}
+
+private:
+	const uint8_t* _in;
+	uint16_t _size;
+	uint16_t _bytes;
+	uint32_t _bits;
+	uint8_t _numBits;
+	bool _underflow;
+};
+
+//! Prediction of sample n, given the 2 samples before.
+static inline int32_t predict(int32_t previous, int32_t beforePrevious) {
+	return 2 * previous - beforePrevious;
+}
+
+//! Number of bits a residual needs, without being mistaken for the escape code.
+static inline uint8_t residualWidth(int32_t residual) {
+	uint32_t magnitude = residual < 0 ? -residual : residual;
+	uint8_t width = 1;
+	while (magnitude) {
+		magnitude >>= 1;
+		++width;
+	}
+	return width;
+}
+
+uint16_t WaveformEncoder::encode(const power_t& power, uint16_t sequence, uint32_t timestamp, uint8_t* out, uint16_t outSize) {
+	if (outSize < sizeof(power_waveform_header_t)) {
+		return 0;
+	}
+	power_waveform_header_t header;
+	header.protocol = POWER_WAVEFORM_PROTOCOL;
+	header.sequence = sequence;
+	header.timestamp = timestamp;
+	header.sampleIntervalUs = power.sampleIntervalUs;
+	header.numSamples = power.bufSize / power.numChannels;
+	memcpy(out, &header, sizeof(header));
+	uint16_t size = sizeof(header);
+
+	uint16_t channelSize = encodeChannel(power.buf + power.voltageIndex, power.numChannels, header.numSamples, out + size, outSize - size);
+	if (channelSize == 0) {
+		return 0;
+	}
+	size += channelSize;
+	channelSize = encodeChannel(power.buf + power.currentIndex, power.numChannels, header.numSamples, out + size, outSize - size);
+	if (channelSize == 0) {
+		return 0;
+	}
+	return size + channelSize;
+}
+
+/**
+ * First pass: count how many residuals need each width, so that the width with the smallest total size can be chosen.
+ * Second pass: write the residuals.
+ */
+uint16_t WaveformEncoder::encodeChannel(const int16_t* samples, uint16_t stride, uint16_t count, uint8_t* out, uint16_t outSize) {
+	if (count == 0 || outSize < 1 + sizeof(int16_t)) {
+		return 0;
+	}
+	uint16_t widthCount[POWER_WAVEFORM_MAX_WIDTH + 1];
+	memset(widthCount, 0, sizeof(widthCount));
+	int32_t previous = samples[0];
+	int32_t beforePrevious = samples[0];
+	for (uint16_t i = 1; i < count; ++i) {
+		int32_t sample = samples[i * stride];
+		widthCount[residualWidth(sample - predict(previous, beforePrevious))]++;
+		beforePrevious = previous;
+		previous = sample;
+	}
+
+	// Size in bits for each width: every residual takes width bits, the ones that don't fit take an extra 16.
+	uint8_t bestWidth = POWER_WAVEFORM_MAX_WIDTH;
+	uint32_t bestSize = 0xFFFFFFFF;
+	for (uint8_t width = POWER_WAVEFORM_MIN_WIDTH; width <= POWER_WAVEFORM_MAX_WIDTH; ++width) {
+		uint32_t numEscapes = 0;
+		for (uint8_t w = width + 1; w <= POWER_WAVEFORM_MAX_WIDTH; ++w) {
+			numEscapes += widthCount[w];
+		}
+		uint32_t bits = (uint32_t)(count - 1) * width + numEscapes * ESCAPE_WIDTH;
+		if (bits < bestSize) {
+			bestSize = bits;
+			bestWidth = width;
+		}
+	}
+
+	out[0] = bestWidth;
+	memcpy(out + 1, &samples[0], sizeof(int16_t));
+	BitWriter writer(out + 1 + sizeof(int16_t), outSize - 1 - sizeof(int16_t));
+	int32_t escape = -(1L << (bestWidth - 1));
+	previous = samples[0];
+	beforePrevious = samples[0];
+	for (uint16_t i = 1; i < count; ++i) {
+		int32_t sample = samples[i * stride];
+		int32_t residual = sample - predict(previous, beforePrevious);
+		if (residualWidth(residual) > bestWidth) {
+			writer.write(escape, bestWidth);
+			writer.write((uint16_t)sample, ESCAPE_WIDTH);
+		}
+		else {
+			writer.write(residual, bestWidth);
+		}
+		beforePrevious = previous;
+		previous = sample;
+	}
+	if (count == 1) {
+		return 1 + sizeof(int16_t);
+	}
+	uint16_t size = writer.flush();
+	return size ? 1 + sizeof(int16_t) + size : 0;
+}
+
+WaveformDecoder::WaveformDecoder() :
+		_started(false),
+		_nextSequence(0),
+		_numMissed(0)
+{
+}
+
+bool WaveformDecoder::decode(const uint8_t* in, uint16_t size, power_waveform_header_t& header, int16_t* voltage, int16_t* current, uint16_t maxSamples) {
+	if (size < sizeof(header)) {
+		return false;
+	}
+	memcpy(&header, in, sizeof(header));
+	if (header.protocol != POWER_WAVEFORM_PROTOCOL || header.numSamples > maxSamples) {
+		return false;
+	}
+	uint16_t offset = sizeof(header);
+	uint16_t channelSize = decodeChannel(in + offset, size - offset, header.numSamples, voltage);
+	if (channelSize == 0) {
+		return false;
+	}
+	offset += channelSize;
+	channelSize = decodeChannel(in + offset, size - offset, header.numSamples, current);
+	if (channelSize == 0) {
+		return false;
+	}
+
+	if (_started) {
+		_numMissed += (uint16_t)(header.sequence - _nextSequence);
+	}
+	_started = true;
+	_nextSequence = header.sequence + 1;
+	return true;
+}
+
+uint16_t WaveformDecoder::decodeChannel(const uint8_t* in, uint16_t size, uint16_t count, int16_t* samples) {
+	if (count == 0 || size < 1 + sizeof(int16_t)) {
+		return 0;
+	}
+	uint8_t width = in[0];
+	if (width < POWER_WAVEFORM_MIN_WIDTH || width > POWER_WAVEFORM_MAX_WIDTH) {
+		return 0;
+	}
+	memcpy(&samples[0], in + 1, sizeof(int16_t));
+	if (count == 1) {
+		return 1 + sizeof(int16_t);
+	}
+	BitReader reader(in + 1 + sizeof(int16_t), size - 1 - sizeof(int16_t));
+	int32_t escape = -(1L << (width - 1));
+	int32_t previous = samples[0];
+	int32_t beforePrevious = samples[0];
+	for (uint16_t i = 1; i < count; ++i) {
+		int32_t residual = reader.read(width);
+		int32_t sample;
+		if (residual == escape) {
+			sample = (int16_t)reader.read(ESCAPE_WIDTH);
+		}
+		else {
+			sample = predict(previous, beforePrevious) + residual;
+		}
+		samples[i] = sample;
+		beforePrevious = previous;
+		previous = sample;
+	}
+	uint16_t bytesRead = reader.bytesRead();
+	return bytesRead ? 1 + sizeof(int16_t) + bytesRead : 0;
+}
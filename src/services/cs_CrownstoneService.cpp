@@ -136,21 +136,38 @@ void CrownstoneService::addMeshCharacteristic() {
 	_meshControlCharacteristic->setValue(buffer);
 	_meshControlCharacteristic->setMinAccessLevel(MEMBER);
 	_meshControlCharacteristic->setMaxGattValueLength(size);
+	_meshControlCharacteristic->setMaxValueLength(size);
 	_meshControlCharacteristic->setValueLength(0);
-	_meshControlCharacteristic->onWrite([&](const EncryptionAccessLevel accessLevel, const buffer_ptr_t& value) -> void {
+	_meshControlCharacteristic->onWriteView([&](const EncryptionAccessLevel accessLevel, const PacketView& view) -> void {
 		// encryption level authentication is done in the decrypting step based on the setMinAccessLevel level.
 		// this is only for characteristics that the user writes to. The ones that are read are encrypted using the setMinAccessLevel level.
 		// If the user writes to this characteristic with insufficient rights, this method is not called
 
 		LOGi(MSG_MESH_MESSAGE_WRITE);
 
-		uint8_t handle = _meshCommand->type();
-		uint8_t* p_data = _meshCommand->payload();
-		uint16_t length = _meshCommand->length();
+		ERR_CODE error_code;
+		MasterBuffer& mb = MasterBuffer::getInstance();
+		// at this point it is too late to check if mb was locked, because the softdevice doesn't care
+		// if the mb was locked, it writes to the buffer in any case
+		if (!mb.isLocked()) {
+			mb.lock();
+
+			if (view.isStream()) {
+				// the message is read from the value, before the reply is written there.
+				error_code = MeshControl::getInstance().send(view.type(), view.data(), view.length());
+			} else {
+				LOGe(FMT_WRONG_PAYLOAD_LENGTH, view.payloadLength());
+				error_code = ERR_WRONG_PAYLOAD_LENGTH;
+			}
 
-		ERR_CODE error_code = MeshControl::getInstance().send(handle, p_data, length);
+			mb.unlock();
+		} else {
+			LOGe(MSG_BUFFER_IS_LOCKED);
+			error_code = ERR_BUFFER_LOCKED;
+		}
 
 //		LOGi("err error_code: %d", error_code);
+		buffer_ptr_t value = _meshControlCharacteristic->getValue();
 		memcpy(value, &error_code, sizeof(error_code));
 		_meshControlCharacteristic->setValueLength(sizeof(error_code));
 		_meshControlCharacteristic->updateValue();
@@ -170,8 +187,9 @@ void CrownstoneService::addControlCharacteristic(buffer_ptr_t buffer, uint16_t s
 	_controlCharacteristic->setValue(buffer);
 	_controlCharacteristic->setMinAccessLevel(minimumAccessLevel);
 	_controlCharacteristic->setMaxGattValueLength(size);
+	_controlCharacteristic->setMaxValueLength(size);
 	_controlCharacteristic->setValueLength(0);
-	_controlCharacteristic->onWrite([&](const EncryptionAccessLevel accessLevel, const buffer_ptr_t& value) -> void {
+	_controlCharacteristic->onWriteView([&](const EncryptionAccessLevel accessLevel, const PacketView& view) -> void {
 		// encryption in the write stage verifies if the key is at least GUEST, command specific permissions are
 		// handled in the commandHandler
 
@@ -180,12 +198,16 @@ void CrownstoneService::addControlCharacteristic(buffer_ptr_t buffer, uint16_t s
 		// at this point it is too late to check if mb was locked, because the softdevice doesn't care
 		// if the mb was locked, it writes to the buffer in any case
 		if (!mb.isLocked()) {
-			LOGi(MSG_CHAR_VALUE_WRITE);
-			CommandHandlerTypes type = (CommandHandlerTypes) _streamBuffer->type();
-			uint8_t *payload = _streamBuffer->payload();
-			uint8_t length = _streamBuffer->length();
+			mb.lock();
 
-			error_code = CommandHandler::getInstance().handleCommand(type, payload, length, accessLevel);
+			if (view.isStream()) {
+				LOGi(MSG_CHAR_VALUE_WRITE);
+				CommandHandlerTypes type = (CommandHandlerTypes) view.type();
+				error_code = CommandHandler::getInstance().handleCommand(type, view.data(), view.length(), accessLevel);
+			} else {
+				LOGe(FMT_WRONG_PAYLOAD_LENGTH, view.payloadLength());
+				error_code = ERR_WRONG_PAYLOAD_LENGTH;
+			}
 
 			mb.unlock();
 		} else {
@@ -194,6 +216,7 @@ void CrownstoneService::addControlCharacteristic(buffer_ptr_t buffer, uint16_t s
 		}
 
 //		LOGi("err error_code: %d", error_code);
+		buffer_ptr_t value = _controlCharacteristic->getValue();
 		memcpy(value, &error_code, sizeof(error_code)); //! TODO: why is it written to "value" and not to _controlCharacteristic?
 		_controlCharacteristic->setValueLength(sizeof(error_code));
 		_controlCharacteristic->updateValue();
@@ -0,0 +1,138 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+#pragma once
+
+/**
+ * Helpers for the host power sampling tests: read recorded ADC traces and synthesize mains waveforms.
+ *
+ * A trace is a flat array of int16_t samples, interleaved as voltage, current, voltage, current, ... exactly as the ADC
+ * writes them in a buffer (voltage index 0, current index 1). Trace files are raw little-endian int16_t.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <processing/cs_PowerCalculation.h>
+
+//! Calibration of the host tests, taken from the ACR01B2C board config (without power zero).
+#define TRACE_VOLTAGE_MULTIPLIER  0.171f
+#define TRACE_CURRENT_MULTIPLIER  0.0042f
+#define TRACE_VOLTAGE_ZERO        -99
+#define TRACE_CURRENT_ZERO        -270
+
+inline power_calculation_config_t traceCalculationConfig() {
+	power_calculation_config_t config;
+	config.voltageMultiplier = TRACE_VOLTAGE_MULTIPLIER;
+	config.currentMultiplier = TRACE_CURRENT_MULTIPLIER;
+	config.voltageZero = TRACE_VOLTAGE_ZERO;
+	config.currentZero = TRACE_CURRENT_ZERO;
+	config.powerZero = 0;
+	config.avgZeroVoltageDiscount = VOLTAGE_ZERO_EXP_AVG_DISCOUNT;
+	config.avgZeroCurrentDiscount = CURRENT_ZERO_EXP_AVG_DISCOUNT;
+	config.avgPowerDiscount = POWER_EXP_AVG_DISCOUNT;
+	return config;
+}
+
+/**
+ * Parameters of a synthetic load.
+ */
+struct trace_load_t {
+	double frequencyHz;      //! Mains frequency at sample index 0.
+	double frequencyDrift;   //! Change of the mains frequency, in Hz per second.
+	double voltageRms;       //! Mains voltage (V).
+	double currentRms;       //! Current of the fundamental (A).
+	double phaseDeg;         //! Phase of the current with respect to the voltage (positive is lagging).
+	double noiseLsb;         //! Amplitude of uniform noise on both channels (adc values).
+	double thirdHarmonic;    //! Amplitude of the 3rd current harmonic, relative to the fundamental.
+	double fifthHarmonic;    //! Amplitude of the 5th current harmonic, relative to the fundamental.
+	double phaseCutDeg;      //! Leading edge dimmer: no current during this angle after each voltage zero crossing.
+	double offsetDrift;      //! Change of the zero of both channels, in adc values per second.
+	trace_load_t() : frequencyHz(50), frequencyDrift(0), voltageRms(230), currentRms(1), phaseDeg(0), noiseLsb(0), thirdHarmonic(0), fifthHarmonic(0), phaseCutDeg(0), offsetDrift(0) {}
+};
+
+/**
+ * Phase of the mains at time t (s).
+ */
+inline double tracePhase(const trace_load_t& load, double t) {
+	return 2 * M_PI * (load.frequencyHz + 0.5 * load.frequencyDrift * t) * t;
+}
+
+/**
+ * Ideal voltage (V) at time t (s), without noise and offset.
+ */
+inline double traceVoltage(const trace_load_t& load, double t) {
+	return load.voltageRms * sqrt(2.0) * sin(tracePhase(load, t));
+}
+
+/**
+ * Ideal current (A) at time t (s), without noise and offset.
+ */
+inline double traceCurrent(const trace_load_t& load, double t) {
+	double w = tracePhase(load, t);
+	if (load.phaseCutDeg > 0 && fmod(w, M_PI) < load.phaseCutDeg * M_PI / 180) {
+		return 0;
+	}
+	double phase = load.phaseDeg * M_PI / 180;
+	double current = sin(w - phase) + load.thirdHarmonic * sin(3 * (w - phase)) + load.fifthHarmonic * sin(5 * (w - phase));
+	return load.currentRms * sqrt(2.0) * current;
+}
+
+/**
+ * Append numSamples sample pairs of the given load to the trace, continuing at sample index startIndex.
+ */
+inline void synthesizeTrace(std::vector<int16_t>& trace, const trace_load_t& load, uint32_t startIndex, uint32_t numSamples,
+		uint32_t sampleIntervalUs = CS_ADC_SAMPLE_INTERVAL_US) {
+	for (uint32_t i = startIndex; i < startIndex + numSamples; ++i) {
+		double t = i * sampleIntervalUs / 1000000.0;
+		double noiseV = load.noiseLsb * (2.0 * rand() / RAND_MAX - 1);
+		double noiseI = load.noiseLsb * (2.0 * rand() / RAND_MAX - 1);
+		double offset = load.offsetDrift * t;
+		trace.push_back((int16_t)lround(TRACE_VOLTAGE_ZERO + offset + traceVoltage(load, t) / TRACE_VOLTAGE_MULTIPLIER + noiseV));
+		trace.push_back((int16_t)lround(TRACE_CURRENT_ZERO + offset + traceCurrent(load, t) / TRACE_CURRENT_MULTIPLIER + noiseI));
+	}
+}
+
+/**
+ * Read a trace file with interleaved int16_t samples.
+ *
+ * @return                         False when the file could not be read.
+ */
+inline bool readTrace(const char* path, std::vector<int16_t>& trace) {
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		return false;
+	}
+	int16_t chunk[512];
+	size_t count;
+	while ((count = fread(chunk, sizeof(int16_t), 512, file)) > 0) {
+		trace.insert(trace.end(), chunk, chunk + count);
+	}
+	fclose(file);
+	return true;
+}
+
+/**
+ * Get a power struct for the buffer at given index of the trace, like PowerSampling::powerSampleAdcDone() makes.
+ */
+inline power_t traceBuffer(std::vector<int16_t>& trace, uint32_t bufIndex, uint32_t sampleIntervalUs = CS_ADC_SAMPLE_INTERVAL_US) {
+	power_t power;
+	power.buf = &trace[bufIndex * CS_ADC_BUF_SIZE];
+	power.bufSize = CS_ADC_BUF_SIZE;
+	power.voltageIndex = 0;
+	power.currentIndex = 1;
+	power.numChannels = 2;
+	power.sampleIntervalUs = sampleIntervalUs;
+	power.acPeriodUs = 20000;
+	return power;
+}
+
+inline uint32_t traceNumBuffers(const std::vector<int16_t>& trace) {
+	return trace.size() / CS_ADC_BUF_SIZE;
+}
@@ -0,0 +1,182 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+#pragma once
+
+/**
+ * Timeline of loads for the SamplingScheduler test and benchmark: steady loads, switches, a fluctuating load, an
+ * overload and streaming. Every period is fed through two pipelines of PowerCalculation, SoftFuse and
+ * HarmonicAnalysis: one that fully processes every period, and one that follows the SamplingScheduler.
+ */
+
+#include "PowerTrace.h"
+
+#include <processing/cs_HarmonicAnalysis.h>
+#include <processing/cs_SamplingScheduler.h>
+#include <processing/cs_SoftFuse.h>
+
+#include <chrono>
+
+#define NUM_SAMPLES  (CS_ADC_BUF_SIZE / 2)
+#define PERIOD_US    20000
+#define NEVER        -1
+
+struct segment_t {
+	const char* name;
+	uint32_t numPeriods;
+	//! Irms of the loads that are on.
+	std::vector<double> currents;
+	//! Random change of the current every period, relative to the current.
+	double fluctuation;
+	//! Whether samples are streamed.
+	bool hold;
+	//! Whether the Irms is steady, after the first periods.
+	bool steady;
+	//! Whether the fuse has to trip.
+	bool overload;
+};
+
+inline segment_t segment(const char* name, uint32_t numPeriods, std::vector<double> currents, double fluctuation = 0,
+		bool hold = false, bool steady = true, bool overload = false) {
+	segment_t s;
+	s.name = name;
+	s.numPeriods = numPeriods;
+	s.currents = currents;
+	s.fluctuation = fluctuation;
+	s.hold = hold;
+	s.steady = steady;
+	s.overload = overload;
+	return s;
+}
+
+inline void sampleBuffer(std::vector<int16_t>& buf, const segment_t& s, uint32_t period) {
+	trace_load_t voltage;
+	voltage.currentRms = 0;
+	voltage.noiseLsb = 2;
+	buf.clear();
+	synthesizeTrace(buf, voltage, period * NUM_SAMPLES, NUM_SAMPLES);
+	std::vector<int16_t> single;
+	for (double current : s.currents) {
+		trace_load_t load;
+		load.currentRms = current * (1 + s.fluctuation * (2.0 * rand() / RAND_MAX - 1));
+		single.clear();
+		synthesizeTrace(single, load, period * NUM_SAMPLES, NUM_SAMPLES);
+		for (uint32_t i = 1; i < CS_ADC_BUF_SIZE; i += 2) {
+			buf[i] += single[i] - TRACE_CURRENT_ZERO;
+		}
+	}
+}
+
+/**
+ * The processing of PowerSampling::powerSampleAdcDone() that depends on the mode.
+ */
+struct pipeline_t {
+	PowerCalculation calculation;
+	HarmonicAnalysis harmonicAnalysis;
+	SoftFuse fuse;
+	SamplingScheduler scheduler;
+	bool scheduled;
+
+	//! Per segment.
+	uint32_t numFull;
+	uint64_t processNs;
+	int32_t tripPeriod;
+	//! Whether the filtered Irms changed in a period that was not fully processed.
+	bool filteredChanged;
+
+	void init(bool useScheduler) {
+		calculation.init(traceCalculationConfig());
+		fuse.init(CURRENT_USAGE_THRESHOLD);
+		scheduler.init(CURRENT_USAGE_THRESHOLD * POWER_SAMPLING_BURST_GUARD_PERCENT / 100);
+		scheduled = useScheduler;
+	}
+
+	void startSegment(bool hold) {
+		numFull = 0;
+		processNs = 0;
+		tripPeriod = NEVER;
+		filteredChanged = false;
+		scheduler.setHold(hold);
+	}
+
+	/** Process a period, and time it.
+	 */
+	void process(const power_t& power, uint32_t period) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		bool full = !scheduled || scheduler.processNext();
+		power_calculation_result_t prevResult = calculation.getResult();
+		calculation.process(power, full);
+		const power_calculation_result_t& result = calculation.getResult();
+		if (!full && (result.filteredCurrentRmsMilliAmp != prevResult.filteredCurrentRmsMilliAmp
+				|| result.filteredCurrentRmsMedianMilliAmp != prevResult.filteredCurrentRmsMedianMilliAmp)) {
+			filteredChanged = true;
+		}
+		const power_quality_t& quality = harmonicAnalysis.getPowerQuality();
+		soft_fuse_load_class_t loadClass = SoftFuse::classify(quality.phaseShiftDeciDegrees, quality.currentThd);
+		int32_t filteredCurrentRmsMA = full ? result.filteredCurrentRmsMilliAmp : result.currentRmsMilliAmp;
+		bool tripped = fuse.update(filteredCurrentRmsMA, power.acPeriodUs, loadClass);
+		if (scheduled) {
+			scheduler.update(result.currentRmsMilliAmp, power.acPeriodUs, full);
+		}
+		if (full) {
+			harmonicAnalysis.analyse(power, power.acPeriodUs / power.sampleIntervalUs, result);
+		}
+		std::chrono::steady_clock::duration duration = std::chrono::steady_clock::now() - start;
+		processNs += std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+
+		numFull += full;
+		if (tripped) {
+			// The relay would be switched off, count the first trip only.
+			fuse.reset();
+			if (tripPeriod == NEVER) {
+				tripPeriod = period;
+			}
+		}
+	}
+};
+
+/**
+ * Get the timeline.
+ *
+ * @param[in] steadyPeriods        Number of periods of the segments with a steady load.
+ */
+inline std::vector<segment_t> timeline(uint32_t steadyPeriods) {
+	double lamp = 60.0 / 230;
+	double heater = 1500.0 / 230;
+	double tv = 100.0 / 230;
+	double overload = 2.0 * CURRENT_USAGE_THRESHOLD / 1000;
+	std::vector<segment_t> segments;
+	segments.push_back(segment("lamp", steadyPeriods, {lamp}));
+	segments.push_back(segment("lamp and heater", steadyPeriods, {lamp, heater}));
+	segments.push_back(segment("fluctuating tv", steadyPeriods, {lamp, tv}, 0.05, false, false));
+	segments.push_back(segment("lamp", steadyPeriods, {lamp}));
+	segments.push_back(segment("overload", 100, {overload}, 0, false, false, true));
+	segments.push_back(segment("lamp, streaming", 500, {lamp}, 0, true, false));
+	segments.push_back(segment("lamp", steadyPeriods, {lamp}));
+	return segments;
+}
+
+/**
+ * Feed the periods of a segment through both pipelines.
+ *
+ * @param[in] firstPeriod          Number of periods before the segment.
+ * @return                         Number of periods in burst mode.
+ */
+inline uint32_t runSegment(const segment_t& s, uint32_t firstPeriod, pipeline_t& full, pipeline_t& scheduled) {
+	full.startSegment(s.hold);
+	scheduled.startSegment(s.hold);
+	uint32_t numBurst = 0;
+	std::vector<int16_t> buf;
+	for (uint32_t i = 0; i < s.numPeriods; ++i) {
+		sampleBuffer(buf, s, firstPeriod + i);
+		power_t power = traceBuffer(buf, 0);
+		full.process(power, i);
+		scheduled.process(power, i);
+		numBurst += scheduled.scheduler.getMode() == SAMPLING_MODE_BURST;
+	}
+	return numBurst;
+}
@@ -0,0 +1,104 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Compares the speed and size of the int16 block median filter, the int32 block median filter and sort_median, which
+ * allocates on every call, on curves of random samples and of samples with few different values.
+ *
+ * The output of the filters is checked by test_BlockMedianFilter.
+ */
+
+#include <processing/cs_BlockMedianFilter.h>
+#include <third/SortMedian.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+#define NUM_CURVES 3000
+#define NUM_RUNS 5
+
+void makeCurve(vector<int16_t>& buf, bool smallRange, uint16_t count) {
+	buf.resize(count);
+	for (uint16_t i = 0; i < count; ++i) {
+		buf[i] = smallRange ? rand() % 3 - 1 : rand() % 65536 - 32768;
+	}
+}
+
+//! Same padding as PowerCalculation::filter() used to do before sort_median.
+void sortMedianFilter(MedianFilter& filterParams, const vector<int16_t>& buf, uint16_t count, PowerVector& input,
+		PowerVector& output) {
+	unsigned j = 0;
+	for (; j < filterParams.half; ++j) {
+		input[j] = buf[0];
+	}
+	for (unsigned i = 0; i < count; ++i) {
+		input[j++] = buf[i];
+	}
+	for (; j < input.size(); ++j) {
+		input[j] = buf[count - 1];
+	}
+	sort_median(filterParams, input, output);
+}
+
+/**
+ * Speed on curves of maxCount samples, which fill the blocks exactly.
+ */
+template <uint16_t halfWindowSize, uint16_t blockCount>
+void benchmark() {
+	typedef BlockMedianFilter<halfWindowSize, blockCount> Filter16;
+	typedef BlockMedianFilter<halfWindowSize, blockCount, int32_t> Filter32;
+	static Filter16 filter16;
+	static Filter32 filter32;
+	const uint16_t count = Filter16::maxCount;
+	MedianFilter filterParams(halfWindowSize, blockCount);
+	PowerVector input(Filter16::inputSize);
+	PowerVector outputSort(count);
+	vector<int16_t> output16(count);
+	vector<int32_t> output32(count);
+
+	vector<vector<int16_t> > bufs(NUM_CURVES);
+	for (int curve = 0; curve < NUM_CURVES; ++curve) {
+		makeCurve(bufs[curve], curve % 2 == 0, count);
+	}
+	uint64_t sortNs = UINT64_MAX;
+	uint64_t ns16 = UINT64_MAX;
+	uint64_t ns32 = UINT64_MAX;
+	for (int run = 0; run < NUM_RUNS; ++run) {
+		chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+		for (int curve = 0; curve < NUM_CURVES; ++curve) {
+			sortMedianFilter(filterParams, bufs[curve], count, input, outputSort);
+		}
+		chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+		for (int curve = 0; curve < NUM_CURVES; ++curve) {
+			filter32.filter(&bufs[curve][0], 1, count, &output32[0]);
+		}
+		chrono::steady_clock::time_point t2 = chrono::steady_clock::now();
+		for (int curve = 0; curve < NUM_CURVES; ++curve) {
+			filter16.filter(&bufs[curve][0], 1, count, &output16[0]);
+		}
+		chrono::steady_clock::time_point t3 = chrono::steady_clock::now();
+		sortNs = min(sortNs, (uint64_t)chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count());
+		ns32 = min(ns32, (uint64_t)chrono::duration_cast<chrono::nanoseconds>(t2 - t1).count());
+		ns16 = min(ns16, (uint64_t)chrono::duration_cast<chrono::nanoseconds>(t3 - t2).count());
+	}
+	cout << "  half window " << halfWindowSize << ": sort_median " << sortNs / NUM_CURVES << " ns/buffer, int32 "
+			<< ns32 / NUM_CURVES << " ns/buffer (" << sizeof(Filter32) << " bytes), int16 " << ns16 / NUM_CURVES
+			<< " ns/buffer (" << sizeof(Filter16) << " bytes)" << endl;
+}
+
+int main() {
+	cout << "Benchmark BlockMedianFilter" << endl;
+	srand(1);
+	// Blocks that fit the curve of one 50 Hz period: 100 samples.
+	benchmark<5, 10>();
+	benchmark<16, 4>();
+	return 0;
+}
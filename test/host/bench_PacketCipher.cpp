@@ -0,0 +1,303 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Microbenchmark of the CTR packet path, in cycles (of the time stamp counter) per block.
+ *
+ * Before: one call to the backend per block, with a byte wise XOR, as PacketCipher used to do. It's kept here as
+ * reference.
+ * After: PacketCipher, which encrypts AES_BATCH_BLOCKS counter blocks per call, and XORs word wise.
+ *
+ * Besides the portable and the AES-NI backend, a backend that only copies the block shows the overhead of the packet
+ * path itself: on the device, the AES is done by hardware, and the overhead is what's left.
+ *
+ * Both paths have to give the same packets.
+ *
+ * Then the cost per packet of CCM against CTR, in cycles and in AES blocks. On the device, the number of AES blocks is
+ * what counts: each is a call to the ECB peripheral of the SoftDevice.
+ */
+
+#include <processing/cs_PacketCipher.h>
+#include <processing/cs_SoftwareAes.h>
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <x86intrin.h>
+
+using namespace std;
+
+#define NUM_PACKETS 20000
+#define NUM_RUNS    3
+
+//! Backend without AES: the overhead of the packet path.
+class CopyAes : public AesBackend {
+public:
+	void setKey(const uint8_t*) {}
+
+	void encryptBlock(const uint8_t* cleartext, uint8_t* ciphertext) {
+		memcpy(ciphertext, cleartext, AES_BLOCK_LENGTH);
+	}
+
+	void encryptBlocks(const uint8_t* cleartext, uint8_t* ciphertext, uint16_t blockCount) {
+		memcpy(ciphertext, cleartext, blockCount * AES_BLOCK_LENGTH);
+	}
+};
+
+//! Backend that counts the blocks it encrypts.
+class CountingAes : public AesBackend {
+public:
+	CountingAes(AesBackend& aes) : _aes(aes), _blockCount(0) {}
+
+	void setKey(const uint8_t* key) {
+		_aes.setKey(key);
+	}
+
+	void encryptBlock(const uint8_t* cleartext, uint8_t* ciphertext) {
+		++_blockCount;
+		_aes.encryptBlock(cleartext, ciphertext);
+	}
+
+	void encryptBlocks(const uint8_t* cleartext, uint8_t* ciphertext, uint16_t blockCount) {
+		_blockCount += blockCount;
+		_aes.encryptBlocks(cleartext, ciphertext, blockCount);
+	}
+
+	uint32_t takeBlockCount() {
+		uint32_t blockCount = _blockCount;
+		_blockCount = 0;
+		return blockCount;
+	}
+
+private:
+	AesBackend& _aes;
+	uint32_t _blockCount;
+};
+
+/**
+ * The CTR encryption before batching: a counter block per call, and a byte wise XOR.
+ */
+void encryptPerBlock(AesBackend& aes, const uint8_t* iv, const uint8_t* validationNonce, const uint8_t* input,
+		uint16_t inputLength, uint8_t* output, uint16_t outputLength) {
+	uint8_t counterBlock[AES_BLOCK_LENGTH];
+	uint8_t keystream[AES_BLOCK_LENGTH];
+	memcpy(counterBlock, iv, AES_BLOCK_LENGTH);
+	uint16_t blockCount = outputLength / AES_BLOCK_LENGTH;
+	for (uint8_t counter = 0; counter < blockCount; counter++) {
+		counterBlock[AES_BLOCK_LENGTH - 1] = counter;
+		aes.encryptBlock(counterBlock, keystream);
+		uint16_t shift = counter * AES_BLOCK_LENGTH;
+		for (uint8_t i = 0; i < AES_BLOCK_LENGTH; i++) {
+			uint8_t cleartext;
+			if (shift == 0 && i < VALIDATION_NONCE_LENGTH) {
+				cleartext = validationNonce[i];
+			}
+			else {
+				uint32_t inputReadIndex = i + shift - VALIDATION_NONCE_LENGTH;
+				cleartext = inputReadIndex < inputLength ? input[inputReadIndex] : 0;
+			}
+			output[shift + i] = keystream[i] ^ cleartext;
+		}
+	}
+}
+
+/**
+ * The CTR decryption before batching.
+ */
+bool decryptPerBlock(AesBackend& aes, const uint8_t* iv, const uint8_t* validationNonce, const uint8_t* input,
+		uint8_t* target, uint16_t targetLength) {
+	uint8_t counterBlock[AES_BLOCK_LENGTH];
+	uint8_t keystream[AES_BLOCK_LENGTH];
+	memcpy(counterBlock, iv, AES_BLOCK_LENGTH);
+	uint16_t blockCount = (targetLength + VALIDATION_NONCE_LENGTH + AES_BLOCK_LENGTH - 1) / AES_BLOCK_LENGTH;
+	uint16_t written = 0;
+	for (uint8_t counter = 0; counter < blockCount; counter++) {
+		counterBlock[AES_BLOCK_LENGTH - 1] = counter;
+		aes.encryptBlock(counterBlock, keystream);
+		for (uint8_t i = 0; i < AES_BLOCK_LENGTH; i++) {
+			keystream[i] ^= input[counter * AES_BLOCK_LENGTH + i];
+		}
+		uint8_t start = 0;
+		if (counter == 0) {
+			if (memcmp(keystream, validationNonce, VALIDATION_NONCE_LENGTH) != 0) {
+				return false;
+			}
+			start = VALIDATION_NONCE_LENGTH;
+		}
+		uint16_t amount = min<uint16_t>(AES_BLOCK_LENGTH - start, targetLength - written);
+		memcpy(target + written, keystream + start, amount);
+		written += amount;
+	}
+	return true;
+}
+
+struct result_t {
+	double encryptBefore;
+	double encryptAfter;
+	double decryptBefore;
+	double decryptAfter;
+};
+
+//! Lowest number of cycles per block of a few runs.
+template <class F>
+double cyclesPerBlock(F f, uint16_t blockCount) {
+	uint64_t best = UINT64_MAX;
+	for (int run = 0; run < NUM_RUNS; ++run) {
+		uint64_t start = __rdtsc();
+		for (int i = 0; i < NUM_PACKETS; ++i) {
+			f(i);
+		}
+		best = min<uint64_t>(best, __rdtsc() - start);
+	}
+	return (double)best / NUM_PACKETS / blockCount;
+}
+
+bool run(AesBackend& aes, uint16_t payloadLength, result_t& result) {
+	uint8_t key[AES_KEY_LENGTH] = {0x41, 0x42, 0x43};
+	uint8_t iv[AES_BLOCK_LENGTH] = {1, 2, 3, 0x10, 0x11, 0x12, 0x13, 0x14};
+	const uint8_t* validationNonce = iv + PACKET_NONCE_LENGTH;
+	uint16_t length = (payloadLength + VALIDATION_NONCE_LENGTH + AES_BLOCK_LENGTH - 1) / AES_BLOCK_LENGTH * AES_BLOCK_LENGTH;
+	uint16_t blockCount = length / AES_BLOCK_LENGTH;
+	vector<uint8_t> payload(payloadLength);
+	for (uint16_t i = 0; i < payloadLength; ++i) {
+		payload[i] = i * 7;
+	}
+	// Offset by the packet header, like the payload in a characteristic buffer.
+	vector<uint8_t> before(length + PACKET_NONCE_LENGTH + USER_LEVEL_LENGTH);
+	vector<uint8_t> after(before.size());
+	uint8_t* beforePacket = &before[PACKET_NONCE_LENGTH + USER_LEVEL_LENGTH];
+	uint8_t* afterPacket = &after[PACKET_NONCE_LENGTH + USER_LEVEL_LENGTH];
+	vector<uint8_t> decrypted(payloadLength + 1);
+
+	aes.setKey(key);
+	PacketCipher cipher(aes);
+	encryptPerBlock(aes, iv, validationNonce, &payload[0], payloadLength, beforePacket, length);
+	cipher.encryptCtr(iv, validationNonce, &payload[0], payloadLength, afterPacket, length);
+	if (memcmp(beforePacket, afterPacket, length) != 0) {
+		cout << "packets differ for a payload of " << payloadLength << " bytes" << endl;
+		return false;
+	}
+	if (!cipher.decryptCtr(iv, validationNonce, afterPacket, length, &decrypted[0], payloadLength)
+			|| memcmp(&decrypted[0], &payload[0], payloadLength) != 0) {
+		cout << "decryption failed for a payload of " << payloadLength << " bytes" << endl;
+		return false;
+	}
+
+	result.encryptBefore = cyclesPerBlock([&](int i) {
+		iv[0] = i;
+		encryptPerBlock(aes, iv, validationNonce, &payload[0], payloadLength, beforePacket, length);
+	}, blockCount);
+	result.encryptAfter = cyclesPerBlock([&](int i) {
+		iv[0] = i;
+		cipher.encryptCtr(iv, validationNonce, &payload[0], payloadLength, afterPacket, length);
+	}, blockCount);
+	// The validation nonce won't match for the other IVs, so decrypt the same packet.
+	result.decryptBefore = cyclesPerBlock([&](int) {
+		decryptPerBlock(aes, iv, validationNonce, afterPacket, &decrypted[0], payloadLength);
+	}, blockCount);
+	result.decryptAfter = cyclesPerBlock([&](int) {
+		cipher.decryptCtr(iv, validationNonce, afterPacket, length, &decrypted[0], payloadLength);
+	}, blockCount);
+	return true;
+}
+
+bool benchmark(const char* name, AesBackend& aes) {
+	// A single block, the 20 bytes of a default MTU, and larger writes like schedule entries and mesh commands.
+	const uint16_t payloadLengths[] = {12, 20, 60, 124, 252};
+	cout << "  " << name << " (cycles per block, before -> after):" << endl;
+	for (uint16_t payloadLength : payloadLengths) {
+		result_t result;
+		if (!run(aes, payloadLength, result)) {
+			return false;
+		}
+		cout << "    " << payloadLength << " B: encrypt " << (int)result.encryptBefore << " -> " << (int)result.encryptAfter
+				<< ", decrypt " << (int)result.decryptBefore << " -> " << (int)result.decryptAfter << endl;
+	}
+	return true;
+}
+
+/**
+ * Cost per packet of CTR and CCM, in the layout of the packets: the CTR payload is preceded by the validation nonce and
+ * padded, the CCM payload is followed by a tag of CCM_TAG_LENGTH bytes.
+ */
+bool benchmarkCcm(const char* name, AesBackend& backend) {
+	const uint16_t payloadLengths[] = {12, 20, 60, 124, 252};
+	uint8_t key[AES_KEY_LENGTH] = {0x41, 0x42, 0x43};
+	uint8_t iv[AES_BLOCK_LENGTH] = {1, 2, 3, 0x10, 0x11, 0x12, 0x13, 0x14};
+	const uint8_t* validationNonce = iv + PACKET_NONCE_LENGTH;
+	const uint8_t nonce[CCM_NONCE_LENGTH] = {1, 2, 3, 0, 0x10, 0x11, 0x12, 0x13, 0x14};
+	CountingAes aes(backend);
+	aes.setKey(key);
+	PacketCipher cipher(aes);
+
+	cout << "  " << name << " (cycles per packet, CTR -> CCM):" << endl;
+	for (uint16_t payloadLength : payloadLengths) {
+		vector<uint8_t> payload(payloadLength, 0x5A);
+		uint16_t ctrLength = (payloadLength + VALIDATION_NONCE_LENGTH + AES_BLOCK_LENGTH - 1) / AES_BLOCK_LENGTH * AES_BLOCK_LENGTH;
+		uint16_t ccmLength = payloadLength + CCM_TAG_LENGTH;
+		vector<uint8_t> ctrPacket(ctrLength);
+		vector<uint8_t> ccmPacket(ccmLength);
+		vector<uint8_t> decrypted(payloadLength + 1);
+
+		cipher.encryptCtr(iv, validationNonce, &payload[0], payloadLength, &ctrPacket[0], ctrLength);
+		uint32_t ctrBlocks = aes.takeBlockCount();
+		cipher.encryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0,
+				&payload[0], payloadLength, &ccmPacket[0], CCM_TAG_LENGTH);
+		uint32_t ccmBlocks = aes.takeBlockCount();
+		if (!cipher.decryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0,
+				&ccmPacket[0], ccmLength, &decrypted[0], CCM_TAG_LENGTH)
+				|| memcmp(&decrypted[0], &payload[0], payloadLength) != 0) {
+			cout << "CCM decryption failed for a payload of " << payloadLength << " bytes" << endl;
+			return false;
+		}
+
+		double ctrEncrypt = cyclesPerBlock([&](int) {
+			cipher.encryptCtr(iv, validationNonce, &payload[0], payloadLength, &ctrPacket[0], ctrLength);
+		}, 1);
+		double ccmEncrypt = cyclesPerBlock([&](int) {
+			cipher.encryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0,
+					&payload[0], payloadLength, &ccmPacket[0], CCM_TAG_LENGTH);
+		}, 1);
+		double ctrDecrypt = cyclesPerBlock([&](int) {
+			cipher.decryptCtr(iv, validationNonce, &ctrPacket[0], ctrLength, &decrypted[0], payloadLength);
+		}, 1);
+		double ccmDecrypt = cyclesPerBlock([&](int) {
+			cipher.decryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0,
+					&ccmPacket[0], ccmLength, &decrypted[0], CCM_TAG_LENGTH);
+		}, 1);
+		aes.takeBlockCount();
+
+		cout << "    " << payloadLength << " B: encrypt " << (int)ctrEncrypt << " -> " << (int)ccmEncrypt
+				<< ", decrypt " << (int)ctrDecrypt << " -> " << (int)ccmDecrypt
+				<< ", AES blocks " << ctrBlocks << " -> " << ccmBlocks
+				<< ", encrypted part " << ctrLength << " -> " << ccmLength << " B" << endl;
+	}
+	return true;
+}
+
+int main() {
+	cout << "Benchmark PacketCipher" << endl;
+	bool success = true;
+
+	CopyAes copy;
+	success &= benchmark("overhead, without AES", copy);
+
+	SoftwareAes portable(false);
+	success &= benchmark("portable", portable);
+
+	SoftwareAes aesNi;
+	if (aesNi.usesAesNi()) {
+		success &= benchmark("AES-NI", aesNi);
+	}
+
+	cout << "CCM against CTR" << endl;
+	success &= benchmarkCcm("portable", portable);
+	if (aesNi.usesAesNi()) {
+		success &= benchmarkCcm("AES-NI", aesNi);
+	}
+	return success ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Accuracy benchmark of PowerCalculation with reference loads: resistive, inductive, capacitive, a leading edge
+ * dimmer, a switched mode power supply, noise, and a drifting zero.
+ *
+ * Every load is synthesized for some seconds, and every buffer is fed to PowerCalculation, as
+ * PowerSampling::powerSampleAdcDone() does. The results are compared with the true Irms and power of the ideal
+ * waveforms over the same period, which are integrated at a much higher sample rate. After the zero lines settled,
+ * the bias (mean error) and the largest error of the Irms, the filtered Irms and the power are reported, together
+ * with the processing time per buffer.
+ *
+ * Run it before and after a change to the power calculation to score the change. The test fails when an error
+ * exceeds the limit of its load, so that regressions don't go unnoticed.
+ */
+
+#include "PowerTrace.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+#define NUM_SAMPLES       (CS_ADC_BUF_SIZE / 2)
+#define NUM_BUFFERS       500
+//! Buffers to skip, until the zero lines settled.
+#define SETTLE_BUFFERS    100
+//! Sub samples per sample, to integrate the reference values.
+#define OVERSAMPLING      16
+
+struct reference_load_t {
+	const char* name;
+	trace_load_t load;
+	//! Largest accepted error, in mA and mW, plus a percentage of the true value.
+	double maxCurrentErrorMilliAmp;
+	double maxPowerErrorMilliWatt;
+	double maxErrorPercent;
+};
+
+struct error_stats_t {
+	double sum;
+	double maxAbs;
+	uint32_t count;
+	error_stats_t() : sum(0), maxAbs(0), count(0) {}
+	void add(double error) {
+		sum += error;
+		maxAbs = max(maxAbs, fabs(error));
+		++count;
+	}
+	double bias() const {
+		return count ? sum / count : 0;
+	}
+};
+
+reference_load_t reference(const char* name, double currentRms, double maxCurrentError, double maxPowerError,
+		double maxErrorPercent) {
+	reference_load_t r;
+	r.name = name;
+	r.load.currentRms = currentRms;
+	r.maxCurrentErrorMilliAmp = maxCurrentError;
+	r.maxPowerErrorMilliWatt = maxPowerError;
+	r.maxErrorPercent = maxErrorPercent;
+	return r;
+}
+
+/**
+ * True Irms (mA) and power (mW) of the ideal waveforms over a period that starts at given sample.
+ */
+void referenceValues(const trace_load_t& load, uint32_t startIndex, uint32_t numSamples, double& currentRmsMilliAmp,
+		double& powerMilliWatt) {
+	double sumSquares = 0;
+	double sumPower = 0;
+	uint32_t count = numSamples * OVERSAMPLING;
+	for (uint32_t i = 0; i < count; ++i) {
+		double t = (startIndex + (double)i / OVERSAMPLING) * CS_ADC_SAMPLE_INTERVAL_US / 1000000.0;
+		double current = traceCurrent(load, t);
+		sumSquares += current * current;
+		sumPower += current * traceVoltage(load, t);
+	}
+	currentRmsMilliAmp = sqrt(sumSquares / count) * 1000;
+	powerMilliWatt = sumPower / count * 1000;
+}
+
+bool run(const reference_load_t& ref) {
+	PowerCalculation calculation;
+	calculation.init(traceCalculationConfig());
+
+	error_stats_t currentError;
+	error_stats_t filteredCurrentError;
+	error_stats_t powerError;
+	double currentRms = 0;
+	double power = 0;
+	uint64_t totalNs = 0;
+	vector<int16_t> buf;
+	for (uint32_t b = 0; b < NUM_BUFFERS; ++b) {
+		buf.clear();
+		synthesizeTrace(buf, ref.load, b * NUM_SAMPLES, NUM_SAMPLES);
+		power_t powerBuf = traceBuffer(buf, 0);
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		calculation.process(powerBuf);
+		totalNs += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+		if (b < SETTLE_BUFFERS) {
+			continue;
+		}
+		referenceValues(ref.load, b * NUM_SAMPLES, powerBuf.acPeriodUs / powerBuf.sampleIntervalUs, currentRms, power);
+		const power_calculation_result_t& result = calculation.getResult();
+		currentError.add(result.currentRmsMilliAmp - currentRms);
+		filteredCurrentError.add(result.filteredCurrentRmsMilliAmp - currentRms);
+		powerError.add(result.powerMilliWatt - power);
+	}
+
+	cout << "  " << ref.name << " (" << (int)currentRms << " mA, " << (int)power << " mW): "
+			<< "Irms " << currentError.bias() << " / " << currentError.maxAbs << " mA, "
+			<< "filtered " << filteredCurrentError.bias() << " / " << filteredCurrentError.maxAbs << " mA, "
+			<< "power " << powerError.bias() << " / " << powerError.maxAbs << " mW, "
+			<< totalNs / NUM_BUFFERS << " ns/buffer" << endl;
+
+	double maxCurrentError = ref.maxCurrentErrorMilliAmp + currentRms * ref.maxErrorPercent / 100;
+	double maxPowerError = ref.maxPowerErrorMilliWatt + fabs(power) * ref.maxErrorPercent / 100;
+	if (currentError.maxAbs > maxCurrentError || powerError.maxAbs > maxPowerError) {
+		cout << "error too large" << endl;
+		return false;
+	}
+	return true;
+}
+
+int main() {
+	cout << "Benchmark PowerCalculation accuracy (bias / largest error)" << endl;
+	srand(1);
+
+	vector<reference_load_t> loads;
+	loads.push_back(reference("resistive", 1, 10, 2000, 1));
+	loads.push_back(reference("resistive, small", 0.1, 10, 2000, 1));
+	loads.push_back(reference("inductive", 2, 10, 2000, 1));
+	loads.back().load.phaseDeg = 37;
+	loads.push_back(reference("capacitive", 0.5, 10, 2000, 1));
+	loads.back().load.phaseDeg = -30;
+	loads.push_back(reference("dimmer at 90 degrees", 1, 10, 2000, 5));
+	loads.back().load.phaseCutDeg = 90;
+	loads.push_back(reference("switched mode power supply", 0.3, 10, 2000, 1));
+	loads.back().load.thirdHarmonic = 0.8;
+	loads.back().load.fifthHarmonic = 0.6;
+	loads.push_back(reference("resistive, noise", 1, 10, 2000, 2));
+	loads.back().load.noiseLsb = 20;
+	loads.push_back(reference("resistive, zero drift", 1, 10, 2000, 1));
+	loads.back().load.offsetDrift = 2;
+
+	bool success = true;
+	for (const reference_load_t& ref : loads) {
+		success &= run(ref);
+	}
+	return success ? 0 : 1;
+}
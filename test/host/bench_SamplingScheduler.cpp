@@ -0,0 +1,59 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Feeds the timeline of SamplingTimeline.h through a pipeline that fully processes every period, and one that follows
+ * the SamplingScheduler, and reports per segment how many periods were fully processed, and the CPU occupancy
+ * (processing time as percentage of the real time) of both pipelines.
+ *
+ * The behaviour of the scheduler is checked by test_SamplingScheduler.
+ */
+
+#include "SamplingTimeline.h"
+
+#include <iostream>
+
+using namespace std;
+
+//! Periods of a steady load: 30 seconds.
+#define STEADY_PERIODS 1500
+
+double occupancyPercent(uint64_t processNs, uint32_t numPeriods) {
+	return 100.0 * processNs / (numPeriods * PERIOD_US * 1000.0);
+}
+
+int main() {
+	cout << "Benchmark SamplingScheduler" << endl;
+	srand(1);
+
+	pipeline_t full;
+	pipeline_t scheduled;
+	full.init(false);
+	scheduled.init(true);
+
+	uint64_t totalFullNs = 0;
+	uint64_t totalScheduledNs = 0;
+	uint32_t totalFull = 0;
+	uint32_t numPeriods = 0;
+	for (const segment_t& s : timeline(STEADY_PERIODS)) {
+		uint32_t numBurst = runSegment(s, numPeriods, full, scheduled);
+		numPeriods += s.numPeriods;
+		totalFullNs += full.processNs;
+		totalScheduledNs += scheduled.processNs;
+		totalFull += scheduled.numFull;
+
+		uint32_t monitorPercent = 100 * (s.numPeriods - numBurst) / s.numPeriods;
+		cout << "  " << s.name << ": " << s.numPeriods << " periods, " << scheduled.numFull << " fully processed, "
+				<< monitorPercent << "% in monitor mode, CPU " << occupancyPercent(scheduled.processNs, s.numPeriods)
+				<< "% vs " << occupancyPercent(full.processNs, s.numPeriods) << "% always full" << endl;
+	}
+
+	cout << "  total: " << numPeriods << " periods, " << totalFull << " fully processed, CPU "
+			<< occupancyPercent(totalScheduledNs, numPeriods) << "% vs " << occupancyPercent(totalFullNs, numPeriods)
+			<< "% always full" << endl;
+	return 0;
+}
@@ -0,0 +1,135 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Stresses the SpscQueue with a producer and a consumer thread, with a fast and a slow consumer. Every item is checked
+ * for torn writes, the order is checked, and every item should either be popped or counted as overrun. The latency from
+ * push to pop is reported.
+ *
+ * This takes long, so it only runs as a test with HOST_BENCHMARKS.
+ */
+
+#include <structs/buffer/cs_SpscQueue.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+#define CAPACITY   4
+#define NUM_ITEMS  1000000
+
+struct item_t {
+	uint32_t seq;
+	uint32_t check[3];
+	int64_t pushNs;
+};
+
+typedef SpscQueue<item_t, CAPACITY> Queue;
+
+int64_t nowNs() {
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+item_t makeItem(uint32_t seq) {
+	item_t item;
+	item.seq = seq;
+	item.check[0] = seq * 2654435761u;
+	item.check[1] = ~seq;
+	item.check[2] = seq ^ 0x5A5A5A5A;
+	item.pushNs = nowNs();
+	return item;
+}
+
+bool isValid(const item_t& item) {
+	return item.check[0] == item.seq * 2654435761u && item.check[1] == ~item.seq && item.check[2] == (item.seq ^ 0x5A5A5A5A);
+}
+
+/**
+ * The producer pushes every item once, like an interrupt handler that never waits. The consumer pops until the
+ * producer is done and the queue is empty, and pauses every slowEvery items.
+ */
+bool stress(const char* name, uint32_t slowEvery) {
+	static Queue queue;
+	queue.reset();
+	bool producerDone = false;
+	uint32_t producerDrops = 0;
+
+	thread producer([&]() {
+		for (uint32_t seq = 0; seq < NUM_ITEMS; ++seq) {
+			if (!queue.push(makeItem(seq))) {
+				++producerDrops;
+			}
+			// Give the consumer a chance, also on a single core.
+			if (seq % CAPACITY == 0) {
+				this_thread::yield();
+			}
+		}
+		__atomic_store_n(&producerDone, true, __ATOMIC_RELEASE);
+	});
+
+	uint32_t numPopped = 0;
+	uint32_t numTorn = 0;
+	uint32_t numOutOfOrder = 0;
+	int64_t lastSeq = -1;
+	int64_t maxLatencyNs = 0;
+	int64_t sumLatencyNs = 0;
+	thread consumer([&]() {
+		item_t item;
+		while (true) {
+			bool done = __atomic_load_n(&producerDone, __ATOMIC_ACQUIRE);
+			if (!queue.pop(item)) {
+				if (done) {
+					break;
+				}
+				this_thread::yield();
+				continue;
+			}
+			int64_t latencyNs = nowNs() - item.pushNs;
+			maxLatencyNs = max(maxLatencyNs, latencyNs);
+			sumLatencyNs += latencyNs;
+			numTorn += !isValid(item);
+			numOutOfOrder += (int64_t)item.seq <= lastSeq;
+			lastSeq = item.seq;
+			++numPopped;
+			if (slowEvery && numPopped % slowEvery == 0) {
+				this_thread::sleep_for(chrono::microseconds(50));
+			}
+		}
+	});
+	producer.join();
+	consumer.join();
+
+	cout << "  " << name << ": " << numPopped << " popped, " << queue.getOverrunCount() << " overruns, high water "
+			<< queue.getHighWater() << ", latency " << (numPopped ? sumLatencyNs / numPopped : 0) << " ns average, "
+			<< maxLatencyNs / 1000 << " us max" << endl;
+
+	bool success = true;
+	if (numTorn || numOutOfOrder) {
+		cout << numTorn << " torn and " << numOutOfOrder << " out of order items" << endl;
+		success = false;
+	}
+	if (numPopped + queue.getOverrunCount() != NUM_ITEMS || queue.getOverrunCount() != producerDrops
+			|| queue.getPushCount() != numPopped) {
+		cout << "items lost" << endl;
+		success = false;
+	}
+	if (!queue.empty()) {
+		cout << "queue not empty" << endl;
+		success = false;
+	}
+	return success;
+}
+
+int main() {
+	cout << "Benchmark SpscQueue with a producer and a consumer thread" << endl;
+	bool success = stress("fast consumer", 0);
+	success &= stress("slow consumer", 1000);
+	return success ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Replays a recorded ADC trace through PowerCalculation, as PowerSampling::powerSampleAdcDone() would do on the device.
+ *
+ * Usage: replay_PowerCalculation [trace.bin [results.csv]]
+ *
+ * The trace file contains interleaved voltage/current int16_t samples, see PowerTrace.h. Without a trace file, ten
+ * seconds of a synthetic 230V / 1A resistive load are replayed. When a results file is given, the calculated values of
+ * every buffer are written to it.
+ */
+
+#include "PowerTrace.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+	cout << "Replay PowerCalculation" << endl;
+
+	vector<int16_t> trace;
+	if (argc > 1) {
+		if (!readTrace(argv[1], trace)) {
+			cout << "Could not read " << argv[1] << endl;
+			return 1;
+		}
+	}
+	else {
+		trace_load_t load;
+		synthesizeTrace(trace, load, 0, 10 * 1000000 / CS_ADC_SAMPLE_INTERVAL_US);
+	}
+	FILE* results = NULL;
+	if (argc > 2) {
+		results = fopen(argv[2], "w");
+		if (results == NULL) {
+			cout << "Could not open " << argv[2] << endl;
+			return 1;
+		}
+		fprintf(results, "buffer,ns,Irms,IrmsMedian,filtIrms,filtIrmsMedian,Vrms,VrmsMedian,power,avgPower\n");
+	}
+
+	PowerCalculation calculation;
+	calculation.init(traceCalculationConfig());
+
+	uint32_t numBuffers = traceNumBuffers(trace);
+	uint64_t totalNs = 0;
+	uint64_t maxNs = 0;
+	for (uint32_t bufIndex = 0; bufIndex < numBuffers; ++bufIndex) {
+		power_t power = traceBuffer(trace, bufIndex);
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		calculation.process(power);
+		uint64_t ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+		totalNs += ns;
+		if (ns > maxNs) {
+			maxNs = ns;
+		}
+		if (results != NULL) {
+			const power_calculation_result_t& result = calculation.getResult();
+			fprintf(results, "%u,%llu,%i,%i,%i,%i,%i,%i,%i,%i\n", bufIndex, (unsigned long long)ns,
+					result.currentRmsMilliAmp, result.currentRmsMedianMilliAmp,
+					result.filteredCurrentRmsMilliAmp, result.filteredCurrentRmsMedianMilliAmp,
+					result.voltageRmsMilliVolt, result.avgVoltageRmsMilliVolt,
+					result.powerMilliWatt, result.avgPowerMilliWatt);
+		}
+	}
+	if (results != NULL) {
+		fclose(results);
+	}
+	if (numBuffers == 0) {
+		cout << "Trace is shorter than one buffer" << endl;
+		return 1;
+	}
+
+	const power_calculation_result_t& result = calculation.getResult();
+	double bufferNs = CS_ADC_BUF_SIZE / 2 * CS_ADC_SAMPLE_INTERVAL_US * 1000.0;
+	cout << "buffers: " << numBuffers << endl;
+	cout << "ns/buffer: avg=" << totalNs / numBuffers << " max=" << maxNs << endl;
+	cout << "real-time factor: " << bufferNs * numBuffers / totalNs << endl;
+	cout << "Irms: " << result.currentRmsMilliAmp << " mA (median " << result.currentRmsMedianMilliAmp << " mA)" << endl;
+	cout << "filtered Irms: " << result.filteredCurrentRmsMilliAmp << " mA (median " << result.filteredCurrentRmsMedianMilliAmp << " mA)" << endl;
+	cout << "Vrms: " << result.voltageRmsMilliVolt << " mV (median " << result.avgVoltageRmsMilliVolt << " mV)" << endl;
+	cout << "power: " << result.powerMilliWatt << " mW (avg " << result.avgPowerMilliWatt << " mW)" << endl;
+	cout << "apparent power: " << result.powerMilliWattApparent << " mW" << endl;
+	return 0;
+}
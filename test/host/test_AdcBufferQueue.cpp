@@ -0,0 +1,253 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Simulates the ADC driver on top of AdcBufferQueue: the SAADC fills a buffer every 20 ms, while the processing of a
+ * buffer takes a random time, with spikes. Checks that buffers are processed in order, are never released twice, that
+ * the SAADC always has a next buffer, that the overrun counter matches the buffers that were skipped, and that the
+ * backlog is the highest number of filled buffers that waited.
+ *
+ * Checks that the filled buffers that are dropped on a config change count as overruns.
+ */
+
+#include <drivers/cs_AdcBufferQueue.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+
+using namespace std;
+
+#define BUFFER_TIME_US (CS_ADC_BUF_SIZE / 2 * CS_ADC_SAMPLE_INTERVAL_US)
+#define NUM_FILLS 100000
+
+struct load_case_t {
+	const char* name;
+	//! Processing time, as fraction of the buffer time.
+	double minLoad;
+	double maxLoad;
+	//! Every spikeInterval-th buffer takes spikeLoad instead, 0 for never.
+	uint32_t spikeInterval;
+	double spikeLoad;
+	//! Whether overruns are allowed.
+	bool overrunsAllowed;
+};
+
+/**
+ * Same as ADC::fillSampleQueue(), with the SAADC replaced by a list of queued buffers.
+ */
+void fillSampleQueue(AdcBufferQueue& queue, deque<cs_adc_buffer_id_t>& saadc, bool overwrite) {
+	cs_adc_buffer_id_t id;
+	while ((id = queue.nextToQueue(overwrite)) != CS_ADC_BUFFER_NONE) {
+		saadc.push_back(id);
+	}
+}
+
+bool checkStates(const AdcBufferQueue& queue, const deque<cs_adc_buffer_id_t>& saadc, cs_adc_buffer_id_t processing) {
+	uint32_t counts[4] = {0, 0, 0, 0};
+	for (cs_adc_buffer_id_t i = 0; i < CS_ADC_NUM_BUFFERS; ++i) {
+		counts[queue.getState(i)]++;
+	}
+	if (counts[ADC_BUFFER_QUEUED] != saadc.size() || queue.numQueued() != saadc.size()
+			|| saadc.size() > CS_ADC_MAX_QUEUED_BUFFERS) {
+		cout << "wrong number of queued buffers" << endl;
+		return false;
+	}
+	for (cs_adc_buffer_id_t id : saadc) {
+		if (queue.getState(id) != ADC_BUFFER_QUEUED) {
+			cout << "buffer " << (int)id << " is in the SAADC, but not queued" << endl;
+			return false;
+		}
+	}
+	if (counts[ADC_BUFFER_FILLED] != queue.numFilled()) {
+		cout << "wrong number of filled buffers" << endl;
+		return false;
+	}
+	if (counts[ADC_BUFFER_PROCESSING] != (processing == CS_ADC_BUFFER_NONE ? 0 : 1)
+			|| (processing != CS_ADC_BUFFER_NONE && queue.getState(processing) != ADC_BUFFER_PROCESSING)) {
+		cout << "wrong buffer being processed" << endl;
+		return false;
+	}
+	return true;
+}
+
+uint64_t processingTime(const load_case_t& load, uint32_t numProcessed) {
+	double fraction = (load.maxLoad - load.minLoad) * rand() / RAND_MAX + load.minLoad;
+	if (load.spikeInterval && (numProcessed % load.spikeInterval) == load.spikeInterval - 1) {
+		fraction = load.spikeLoad;
+	}
+	return fraction * BUFFER_TIME_US;
+}
+
+bool simulate(const load_case_t& load) {
+	AdcBufferQueue queue;
+	deque<cs_adc_buffer_id_t> saadc;
+	fillSampleQueue(queue, saadc, false);
+
+	//! Sequence number of the samples in each buffer.
+	uint32_t contents[CS_ADC_NUM_BUFFERS];
+	uint32_t numFills = 0;
+	uint32_t numProcessed = 0;
+	uint32_t numSkipped = 0;
+	uint32_t lastProcessed = 0;
+	uint32_t numStarved = 0;
+	uint32_t numDoubleReleases = 0;
+	cs_adc_buffer_count_t maxFilled = 0;
+
+	cs_adc_buffer_id_t processing = CS_ADC_BUFFER_NONE;
+	uint64_t processingDone = 0;
+	uint64_t nextFill = BUFFER_TIME_US;
+
+	while (numFills < NUM_FILLS) {
+		if (processing != CS_ADC_BUFFER_NONE && processingDone <= nextFill) {
+			// Processing is done: check the order, and release the buffer.
+			uint32_t sequence = contents[processing];
+			if (sequence <= lastProcessed) {
+				cout << load.name << ": buffer " << sequence << " processed after " << lastProcessed << endl;
+				return false;
+			}
+			numSkipped += sequence - lastProcessed - 1;
+			lastProcessed = sequence;
+			++numProcessed;
+			if (!queue.release(processing)) {
+				cout << load.name << ": release failed" << endl;
+				return false;
+			}
+			// The second release should be refused.
+			if (queue.release(processing)) {
+				cout << load.name << ": buffer released twice" << endl;
+				return false;
+			}
+			++numDoubleReleases;
+			uint64_t now = processingDone;
+			processing = CS_ADC_BUFFER_NONE;
+
+			// Same as ADC::releaseBuffer().
+			fillSampleQueue(queue, saadc, false);
+			processing = queue.startProcessing();
+			if (processing != CS_ADC_BUFFER_NONE) {
+				processingDone = now + processingTime(load, numProcessed);
+			}
+		}
+		else {
+			// The SAADC filled a buffer, and should continue with the next one.
+			if (saadc.empty()) {
+				cout << load.name << ": no buffer to fill" << endl;
+				return false;
+			}
+			cs_adc_buffer_id_t id = saadc.front();
+			saadc.pop_front();
+			contents[id] = ++numFills;
+
+			// Same as ADC::_handleAdcDoneInterrupt().
+			if (!queue.onFilled(id)) {
+				cout << load.name << ": wrong buffer filled" << endl;
+				return false;
+			}
+			maxFilled = max(maxFilled, queue.numFilled());
+			fillSampleQueue(queue, saadc, true);
+			if (saadc.size() < CS_ADC_MAX_QUEUED_BUFFERS) {
+				// There is a gap between this buffer and the next one, while the interrupt is handled.
+				++numStarved;
+			}
+			if (processing == CS_ADC_BUFFER_NONE) {
+				processing = queue.startProcessing();
+				if (processing != CS_ADC_BUFFER_NONE) {
+					processingDone = nextFill + processingTime(load, numProcessed);
+				}
+			}
+			nextFill += BUFFER_TIME_US;
+		}
+		if (!checkStates(queue, saadc, processing)) {
+			cout << load.name << ": inconsistent state after " << numFills << " fills" << endl;
+			return false;
+		}
+	}
+
+	// Buffers that are filled, but not processed yet, are neither processed nor skipped.
+	uint32_t numPending = queue.numFilled() + (processing == CS_ADC_BUFFER_NONE ? 0 : 1);
+	// Overwritten buffers that came after the last processed one are not counted as skipped yet.
+	uint32_t numSkippedPending = numFills - numPending - numProcessed - numSkipped;
+
+	cout << "  " << load.name << ": processed=" << numProcessed << " overruns=" << queue.getOverrunCount()
+			<< " (" << 100.0 * queue.getOverrunCount() / numFills << "%) starved=" << numStarved
+			<< " refused releases=" << queue.getErrorCount() << " backlog=" << (int)queue.getMaxFilled() << endl;
+
+	if (queue.getOverrunCount() != numSkipped + numSkippedPending) {
+		cout << load.name << ": overrun count " << queue.getOverrunCount() << " does not match " << numSkipped
+				<< " skipped buffers" << endl;
+		return false;
+	}
+	if (queue.getMaxFilled() != maxFilled) {
+		cout << load.name << ": backlog " << (int)queue.getMaxFilled() << " does not match " << (int)maxFilled << endl;
+		return false;
+	}
+	if (queue.getErrorCount() != numDoubleReleases) {
+		cout << load.name << ": error count does not match the refused releases" << endl;
+		return false;
+	}
+	if (CS_ADC_NUM_BUFFERS >= 3 && numStarved) {
+		cout << load.name << ": the SAADC ran short of buffers" << endl;
+		return false;
+	}
+	if (!load.overrunsAllowed && queue.getOverrunCount()) {
+		cout << load.name << ": unexpected overruns" << endl;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Like a config change: the SAADC stops, and the buffers that were filled in the meantime are dropped.
+ */
+bool testDropFilled() {
+	AdcBufferQueue queue;
+	deque<cs_adc_buffer_id_t> saadc;
+	fillSampleQueue(queue, saadc, false);
+	while (!saadc.empty()) {
+		queue.onFilled(saadc.front());
+		saadc.pop_front();
+	}
+	cs_adc_buffer_id_t processing = queue.startProcessing();
+	cs_adc_buffer_count_t numFilled = queue.numFilled();
+	if (queue.dropFilled() != numFilled || queue.getOverrunCount() != numFilled || queue.numFilled() != 0) {
+		cout << "dropped buffers are not counted as overruns" << endl;
+		return false;
+	}
+	if (!checkStates(queue, saadc, processing) || !queue.release(processing)) {
+		cout << "inconsistent state after dropping the filled buffers" << endl;
+		return false;
+	}
+	fillSampleQueue(queue, saadc, false);
+	if (saadc.size() != CS_ADC_MAX_QUEUED_BUFFERS) {
+		cout << "dropped buffers are not free" << endl;
+		return false;
+	}
+	return true;
+}
+
+int main() {
+	cout << "Test AdcBufferQueue with " << CS_ADC_NUM_BUFFERS << " buffers" << endl;
+	srand(1);
+	// With N buffers, a spike of up to N-2 buffer times is absorbed: one buffer being filled, one queued, and the rest
+	// filled while processing. Spikes do need some time in between to catch up.
+	const double maxSpike = CS_ADC_NUM_BUFFERS - 2;
+	const load_case_t loads[] = {
+		{"light",        0.1, 0.3,  0,  0.0,            false},
+		{"heavy",        0.7, 0.95, 0,  0.0,            false},
+		{"spikes",       0.1, 0.4,  20, maxSpike * 0.9, CS_ADC_NUM_BUFFERS < 3},
+		{"big spikes",   0.1, 0.4,  20, maxSpike + 2.0, true},
+		{"overloaded",   0.8, 1.6,  0,  0.0,            true},
+	};
+	bool success = true;
+	for (const load_case_t& load : loads) {
+		success &= simulate(load);
+	}
+	success &= testDropFilled();
+	return success ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Replays a trace that switches between a 2 W and a 2 kW load, through a simulated ADC that quantizes and clips the
+ * current at the range that the AdcRangeController picks. The power and Irms are compared to the ones at the fixed
+ * board range, which measures the 2 W load at a few ADC values, and clips the 2 kW load.
+ */
+
+#include "PowerTrace.h"
+
+#include <processing/cs_AdcRangeController.h>
+
+#include <iostream>
+
+using namespace std;
+
+#define NUM_SAMPLES      (CS_ADC_BUF_SIZE / 2)
+#define HIGH_GAIN_PIN    4
+//! Range at which TRACE_CURRENT_MULTIPLIER is calibrated.
+#define BOARD_RANGE      600
+//! Noise of the current, before the ADC (A).
+#define CURRENT_NOISE    0.002
+//! Buffers to skip after a load switch, before the error is measured.
+#define SETTLE_BUFFERS   100
+
+struct range_segment_t {
+	const char* name;
+	double power;
+	uint32_t numBuffers;
+};
+
+struct segment_error_t {
+	//! Error of the average power, relative to the exact power.
+	double powerError;
+	//! RMS of the error of the power of each buffer, relative to the exact power.
+	double powerNoise;
+	//! Error of the average Irms, relative to the exact Irms.
+	double currentError;
+	//! Range at the end of the segment.
+	uint16_t rangeMilliVolt;
+};
+
+/**
+ * Sample a buffer: the voltage as in the traces, the current quantized and clipped at the given scale.
+ */
+void sampleBuffer(int16_t* buf, double currentRms, uint32_t startIndex, float scale) {
+	double voltageAmplitude = 230 * sqrt(2.0) / TRACE_VOLTAGE_MULTIPLIER;
+	double currentAmplitude = currentRms * sqrt(2.0);
+	for (uint32_t i = 0; i < NUM_SAMPLES; ++i) {
+		double w = 2 * M_PI * 50 * (startIndex + i) * CS_ADC_SAMPLE_INTERVAL_US / 1000000.0;
+		buf[2 * i] = lround(TRACE_VOLTAGE_ZERO + voltageAmplitude * sin(w));
+		double current = currentAmplitude * sin(w) + CURRENT_NOISE * (2.0 * rand() / RAND_MAX - 1);
+		double adc = (current / TRACE_CURRENT_MULTIPLIER + TRACE_CURRENT_ZERO) * scale;
+		buf[2 * i + 1] = max(-2048L, min(2047L, lround(adc)));
+	}
+}
+
+/**
+ * Run the segments, and return the error of each segment.
+ */
+vector<segment_error_t> run(const vector<range_segment_t>& segments, bool autoRange, uint32_t& numChanges) {
+	AdcRangeController controller;
+	controller.init(-2048, 2047);
+	controller.addPin(HIGH_GAIN_PIN, 1.0f, 3600);
+	controller.setLevel(HIGH_GAIN_PIN, BOARD_RANGE);
+	uint8_t calibratedLevel = controller.getLevel();
+	uint8_t adcLevel = calibratedLevel;
+
+	PowerCalculation calculation;
+	calculation.init(traceCalculationConfig());
+
+	vector<int16_t> trace(CS_ADC_BUF_SIZE);
+	uint32_t sampleIndex = 0;
+	bool changePending = false;
+	numChanges = 0;
+	vector<segment_error_t> errors;
+	for (const range_segment_t& segment : segments) {
+		double currentRms = segment.power / 230;
+		double sumPower = 0;
+		double sumSquareError = 0;
+		double sumCurrent = 0;
+		uint32_t count = 0;
+		for (uint32_t b = 0; b < segment.numBuffers; ++b) {
+			// Like PowerSampling: the buffer after a change is still sampled at the old range.
+			if (changePending) {
+				changePending = false;
+				adcLevel = controller.getLevel();
+				calculation.setCurrentMultiplier(TRACE_CURRENT_MULTIPLIER / controller.getScale(calibratedLevel, adcLevel));
+				++numChanges;
+			}
+			sampleBuffer(&trace[0], currentRms, sampleIndex, controller.getScale(calibratedLevel, adcLevel));
+			sampleIndex += NUM_SAMPLES;
+			power_t power = traceBuffer(trace, 0);
+			calculation.process(power);
+			if (autoRange && controller.update(power)) {
+				changePending = true;
+			}
+			if (b >= SETTLE_BUFFERS) {
+				double powerWatt = calculation.getResult().powerMicroWatt / 1000000.0;
+				sumPower += powerWatt;
+				sumSquareError += (powerWatt - segment.power) * (powerWatt - segment.power);
+				sumCurrent += calculation.getResult().currentRmsMilliAmp / 1000.0;
+				++count;
+			}
+		}
+		segment_error_t error;
+		error.powerError = fabs(sumPower / count - segment.power) / segment.power;
+		error.powerNoise = sqrt(sumSquareError / count) / segment.power;
+		error.currentError = fabs(sumCurrent / count - currentRms) / currentRms;
+		error.rangeMilliVolt = controller.getLevelConfig().rangeMilliVolt;
+		errors.push_back(error);
+	}
+	return errors;
+}
+
+int main() {
+	cout << "Test AdcRangeController implementation" << endl;
+	srand(1);
+	bool success = true;
+
+	// Every ADC range on the high gain pin.
+	AdcRangeController controller;
+	controller.addPin(HIGH_GAIN_PIN, 1.0f, 3600);
+	if (controller.getNumLevels() != 8 || !controller.setLevel(HIGH_GAIN_PIN, BOARD_RANGE) || controller.getLevel() != 2) {
+		cout << "wrong levels" << endl;
+		success = false;
+	}
+	// A pin with a quarter of the gain only adds ranges that are less sensitive.
+	controller.addPin(HIGH_GAIN_PIN + 1, 0.25f, 3600);
+	if (controller.getNumLevels() != 13 || controller.getLevelConfig().pin != HIGH_GAIN_PIN) {
+		cout << "wrong levels with a low gain pin" << endl;
+		success = false;
+	}
+
+	vector<range_segment_t> segments;
+	for (int i = 0; i < 3; ++i) {
+		range_segment_t low = {"2 W", 2, 500};
+		range_segment_t high = {"2 kW", 2000, 500};
+		segments.push_back(low);
+		segments.push_back(high);
+	}
+
+	uint32_t numChanges;
+	vector<segment_error_t> fixedErrors = run(segments, false, numChanges);
+	vector<segment_error_t> autoErrors = run(segments, true, numChanges);
+	cout << "  range changes: " << numChanges << endl;
+	for (size_t i = 0; i < segments.size(); ++i) {
+		const segment_error_t& fixed = fixedErrors[i];
+		const segment_error_t& autoError = autoErrors[i];
+		cout << "  " << segments[i].name << " at " << autoError.rangeMilliVolt << " mV: power error "
+				<< fixed.powerError * 100 << "% fixed, " << autoError.powerError * 100 << "% auto, power noise "
+				<< fixed.powerNoise * 100 << "% fixed, " << autoError.powerNoise * 100 << "% auto, Irms error "
+				<< fixed.currentError * 100 << "% fixed, " << autoError.currentError * 100 << "% auto" << endl;
+		if (autoError.powerError > 0.01 || autoError.powerNoise > fixed.powerNoise) {
+			cout << segments[i].name << ": power error too large" << endl;
+			success = false;
+		}
+		// Irms is in whole mA, which is too coarse for the 2 W load.
+		if (segments[i].power > 100 && autoError.currentError > 0.01) {
+			cout << segments[i].name << ": Irms error too large" << endl;
+			success = false;
+		}
+	}
+	// Once per load switch, plus the steps to get there: no going back and forth.
+	if (numChanges > segments.size() * 6) {
+		cout << "too many range changes" << endl;
+		success = false;
+	}
+	return success ? 0 : 1;
+}
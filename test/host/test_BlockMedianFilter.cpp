@@ -0,0 +1,129 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Fuzz test of the block median filter: compares the int16 and int32 filters against a naive median (sort every
+ * window) over random and adversarial curves, with random lengths and strides, for several window sizes.
+ *
+ * The speed is compared in bench_BlockMedianFilter.
+ */
+
+#include <processing/cs_BlockMedianFilter.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+#define NUM_CURVES 300
+
+enum curve_type_t {
+	CURVE_RANDOM,          // Full int16 range.
+	CURVE_SMALL_RANGE,     // Few different values: many equal samples.
+	CURVE_CONSTANT,
+	CURVE_ASCENDING,
+	CURVE_DESCENDING,
+	CURVE_EXTREMES,        // Alternating -32768 and 32767.
+	CURVE_SPIKES,          // Constant, with a few spikes at the extremes.
+	CURVE_SAWTOOTH,        // Period of a window size, so that every block is the same.
+	CURVE_TYPE_COUNT
+};
+
+void makeCurve(vector<int16_t>& buf, curve_type_t type, uint16_t count, uint16_t stride, uint16_t windowSize) {
+	buf.assign(count * stride, 12345);
+	for (uint16_t i = 0; i < count; ++i) {
+		int32_t value = 0;
+		switch (type) {
+		case CURVE_RANDOM:
+			value = rand() % 65536 - 32768;
+			break;
+		case CURVE_SMALL_RANGE:
+			value = rand() % 3 - 1;
+			break;
+		case CURVE_CONSTANT:
+			value = -7;
+			break;
+		case CURVE_ASCENDING:
+			value = i * 300 - 30000;
+			break;
+		case CURVE_DESCENDING:
+			value = 30000 - i * 300;
+			break;
+		case CURVE_EXTREMES:
+			value = (i % 2) ? 32767 : -32768;
+			break;
+		case CURVE_SPIKES:
+			value = (rand() % 10 == 0) ? ((rand() % 2) ? 32767 : -32768) : 100;
+			break;
+		default:
+			value = (i % windowSize) * 1000 - 16000;
+		}
+		buf[i * stride] = value;
+	}
+}
+
+//! Sort every window of the padded curve.
+void naiveMedian(const vector<int16_t>& buf, uint16_t stride, uint16_t count, uint16_t halfWindowSize, vector<int16_t>& output) {
+	output.resize(count);
+	vector<int16_t> window;
+	for (int32_t i = 0; i < count; ++i) {
+		window.clear();
+		for (int32_t j = i - halfWindowSize; j <= i + halfWindowSize; ++j) {
+			window.push_back(buf[max(0, min<int32_t>(j, count - 1)) * stride]);
+		}
+		sort(window.begin(), window.end());
+		output[i] = window[halfWindowSize];
+	}
+}
+
+template <uint16_t halfWindowSize, uint16_t blockCount>
+bool fuzz() {
+	typedef BlockMedianFilter<halfWindowSize, blockCount> Filter16;
+	typedef BlockMedianFilter<halfWindowSize, blockCount, int32_t> Filter32;
+	static Filter16 filter16;
+	static Filter32 filter32;
+	vector<int16_t> buf;
+	vector<int16_t> expected;
+	vector<int16_t> output16(Filter16::maxCount);
+	vector<int32_t> output32(Filter32::maxCount);
+	for (int curve = 0; curve < NUM_CURVES; ++curve) {
+		curve_type_t type = (curve_type_t)(curve % CURVE_TYPE_COUNT);
+		uint16_t count = 1 + rand() % Filter16::maxCount;
+		if (curve % 2) {
+			count = Filter16::maxCount;
+		}
+		uint16_t stride = 1 + rand() % 3;
+		makeCurve(buf, type, count, stride, Filter16::windowSize);
+		naiveMedian(buf, stride, count, halfWindowSize, expected);
+		filter16.filter(&buf[0], stride, count, &output16[0]);
+		filter32.filter(&buf[0], stride, count, &output32[0]);
+		for (uint16_t i = 0; i < count; ++i) {
+			if (output16[i] != expected[i] || output32[i] != expected[i]) {
+				cout << "half window " << halfWindowSize << ", " << blockCount << " blocks: curve " << curve << " (type "
+						<< type << ", " << count << " samples) differs at " << i << ": " << output16[i] << ", "
+						<< output32[i] << " vs " << expected[i] << endl;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int main() {
+	cout << "Test BlockMedianFilter implementation" << endl;
+	srand(1);
+	bool success = true;
+	success &= fuzz<1, 20>();
+	success &= fuzz<2, 7>();
+	success &= fuzz<5, 10>();
+	success &= fuzz<7, 1>();
+	success &= fuzz<16, 4>();
+	success &= fuzz<130, 3>();
+	return success ? 0 : 1;
+}
@@ -0,0 +1,324 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Checks the CCM mode of PacketCipher against the examples of NIST SP 800-38C (appendix C) and packet vector 1 of
+ * RFC 3610, which cover tags of 4, 6 and 8 bytes, and nonces of 7 to 13 bytes.
+ *
+ * Checks the round trip in the layout of a CCM packet (see the encryption section of docs/PROTOCOL.md), also when
+ * decrypted in place, and that a change of any bit of the ciphertext, the tag, or the nonce (which holds the user
+ * level) is detected.
+ *
+ * Checks the packet counters of CcmNonceCounter between a phone and a crownstone: every packet is accepted once, in
+ * order, and a replayed, reordered or reflected packet is refused.
+ */
+
+#include <processing/cs_CcmNonceCounter.h>
+#include <processing/cs_PacketCipher.h>
+#include <processing/cs_SoftwareAes.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+#define NUM_PACKETS   1000
+#define MAX_PAYLOAD   200
+
+struct ccm_vector_t {
+	const char* name;
+	const char* key;
+	const char* nonce;
+	const char* aad;
+	const char* payload;
+	//! Ciphertext followed by the tag.
+	const char* output;
+	uint8_t tagLength;
+};
+
+const ccm_vector_t vectors[] = {
+	{"SP 800-38C example 1",
+		"404142434445464748494a4b4c4d4e4f", "10111213141516", "0001020304050607",
+		"20212223",
+		"7162015b4dac255d", 4},
+	{"SP 800-38C example 2",
+		"404142434445464748494a4b4c4d4e4f", "1011121314151617", "000102030405060708090a0b0c0d0e0f",
+		"202122232425262728292a2b2c2d2e2f",
+		"d2a1f0e051ea5f62081a7792073d593d1fc64fbfaccd", 6},
+	{"SP 800-38C example 3",
+		"404142434445464748494a4b4c4d4e4f", "101112131415161718191a1b", "000102030405060708090a0b0c0d0e0f10111213",
+		"202122232425262728292a2b2c2d2e2f3031323334353637",
+		"e3b201a9f5b71a7a9b1ceaeccd97e70b6176aad9a4428aa5484392fbc1b09951", 8},
+	{"RFC 3610 packet vector 1",
+		"c0c1c2c3c4c5c6c7c8c9cacbcccdcecf", "00000003020100a0a1a2a3a4a5", "0001020304050607",
+		"08090a0b0c0d0e0f101112131415161718191a1b1c1d1e",
+		"588c979a61c663d2f066d0c2c0f989806d5f6b61dac38417e8d12cfdf926e0", 8},
+};
+
+vector<uint8_t> fromHex(const char* hex) {
+	vector<uint8_t> bytes;
+	for (size_t i = 0; hex[i] && hex[i + 1]; i += 2) {
+		char byte[3] = {hex[i], hex[i + 1], 0};
+		bytes.push_back(strtoul(byte, NULL, 16));
+	}
+	return bytes;
+}
+
+void randomBytes(uint8_t* buf, uint16_t length) {
+	for (uint16_t i = 0; i < length; ++i) {
+		buf[i] = rand();
+	}
+}
+
+bool testVectors(PacketCipher& cipher) {
+	bool success = true;
+	for (const ccm_vector_t& v : vectors) {
+		vector<uint8_t> key = fromHex(v.key);
+		vector<uint8_t> nonce = fromHex(v.nonce);
+		vector<uint8_t> aad = fromHex(v.aad);
+		vector<uint8_t> payload = fromHex(v.payload);
+		vector<uint8_t> expected = fromHex(v.output);
+		vector<uint8_t> output(payload.size() + v.tagLength);
+		vector<uint8_t> decrypted(payload.size());
+
+		cipher.setKey(&key[0]);
+		if (!cipher.encryptCcm(&nonce[0], nonce.size(), &aad[0], aad.size(), &payload[0], payload.size(), &output[0],
+				v.tagLength) || output != expected) {
+			cout << v.name << ": wrong ciphertext or tag" << endl;
+			success = false;
+			continue;
+		}
+		if (!cipher.decryptCcm(&nonce[0], nonce.size(), &aad[0], aad.size(), &expected[0], expected.size(),
+				&decrypted[0], v.tagLength) || decrypted != payload) {
+			cout << v.name << ": decryption failed" << endl;
+			success = false;
+		}
+	}
+	return success;
+}
+
+/**
+ * Round trips in the packet layout: the packet counter, direction, user level and session nonce as nonce, no
+ * associated data.
+ */
+bool testRoundTrip(PacketCipher& cipher) {
+	uint8_t nonce[CCM_NONCE_LENGTH];
+	uint8_t payload[MAX_PAYLOAD];
+	uint8_t packet[MAX_PAYLOAD + CCM_TAG_LENGTH];
+	uint8_t decrypted[MAX_PAYLOAD];
+	for (int i = 0; i < NUM_PACKETS; ++i) {
+		randomBytes(nonce, CCM_NONCE_LENGTH);
+		nonce[PACKET_NONCE_LENGTH] = rand() % 2;
+		nonce[PACKET_NONCE_LENGTH + CCM_DIRECTION_LENGTH] = rand() % 3;
+		uint16_t payloadLength = rand() % (MAX_PAYLOAD + 1);
+		randomBytes(payload, payloadLength);
+
+		if (!cipher.encryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0, payload, payloadLength, packet, CCM_TAG_LENGTH)) {
+			cout << "encryption failed" << endl;
+			return false;
+		}
+		if (!cipher.decryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0, packet, payloadLength + CCM_TAG_LENGTH, decrypted,
+				CCM_TAG_LENGTH) || memcmp(decrypted, payload, payloadLength) != 0) {
+			cout << "decryption failed for a payload of " << payloadLength << " bytes" << endl;
+			return false;
+		}
+		if (!cipher.decryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0, packet, payloadLength + CCM_TAG_LENGTH, packet,
+				CCM_TAG_LENGTH) || memcmp(packet, payload, payloadLength) != 0) {
+			cout << "decryption in place failed for a payload of " << payloadLength << " bytes" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool testTampering(PacketCipher& cipher) {
+	uint8_t nonce[CCM_NONCE_LENGTH] = {1, 2, 3, 0, 1, 5, 6, 7, 8, 9};
+	uint8_t payload[20];
+	randomBytes(payload, sizeof(payload));
+	const uint16_t length = sizeof(payload) + CCM_TAG_LENGTH;
+	uint8_t packet[length];
+	cipher.encryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0, payload, sizeof(payload), packet, CCM_TAG_LENGTH);
+
+	uint8_t decrypted[sizeof(payload)];
+	for (uint16_t bit = 0; bit < length * 8; ++bit) {
+		uint8_t changed[length];
+		memcpy(changed, packet, length);
+		changed[bit / 8] ^= 1 << (bit % 8);
+		memset(decrypted, 0xFF, sizeof(decrypted));
+		if (cipher.decryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0, changed, length, decrypted, CCM_TAG_LENGTH)) {
+			cout << "changed bit " << bit << " not detected" << endl;
+			return false;
+		}
+		for (uint8_t b : decrypted) {
+			if (b != 0) {
+				cout << "target not cleared on failure" << endl;
+				return false;
+			}
+		}
+	}
+
+	for (uint8_t i = 0; i < CCM_NONCE_LENGTH; ++i) {
+		nonce[i] ^= 1;
+		if (cipher.decryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0, packet, length, decrypted, CCM_TAG_LENGTH)) {
+			cout << "changed nonce byte " << (int)i << " not detected" << endl;
+			return false;
+		}
+		nonce[i] ^= 1;
+	}
+
+	// invalid parameters.
+	if (cipher.encryptCcm(nonce, CCM_MIN_NONCE_LENGTH - 1, NULL, 0, payload, sizeof(payload), packet, CCM_TAG_LENGTH)
+			|| cipher.encryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0, payload, sizeof(payload), packet, 5)
+			|| cipher.encryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0, payload, sizeof(payload), packet, 2)
+			|| cipher.decryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0, packet, CCM_TAG_LENGTH - 1, decrypted, CCM_TAG_LENGTH)) {
+		cout << "invalid parameters accepted" << endl;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * A packet of given payload length in the CCM layout, encrypted with the next counter of the sender.
+ */
+vector<uint8_t> sendPacket(PacketCipher& cipher, CcmNonceCounter& sender, const uint8_t* sessionNonce,
+		uint16_t payloadLength) {
+	const uint16_t overhead = PACKET_NONCE_LENGTH + USER_LEVEL_LENGTH;
+	vector<uint8_t> payload(payloadLength + 1);
+	randomBytes(&payload[0], payloadLength);
+	vector<uint8_t> packet(overhead + payloadLength + CCM_TAG_LENGTH);
+	packet[PACKET_NONCE_LENGTH] = 0;
+	uint8_t nonce[CCM_NONCE_LENGTH];
+	if (!sender.createSendNonce(&packet[0], sessionNonce, nonce)) {
+		return vector<uint8_t>();
+	}
+	cipher.encryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0, &payload[0], payloadLength, &packet[overhead], CCM_TAG_LENGTH);
+	return packet;
+}
+
+/**
+ * Decrypt a packet like EncryptionHandler does: check the counter, then the tag, then accept the counter.
+ */
+bool receivePacket(PacketCipher& cipher, CcmNonceCounter& receiver, const uint8_t* sessionNonce,
+		vector<uint8_t> packet) {
+	const uint16_t overhead = PACKET_NONCE_LENGTH + USER_LEVEL_LENGTH;
+	uint8_t nonce[CCM_NONCE_LENGTH];
+	if (!receiver.createReceiveNonce(&packet[0], sessionNonce, nonce)) {
+		return false;
+	}
+	uint16_t length = packet.size() - overhead;
+	vector<uint8_t> decrypted(length);
+	if (!cipher.decryptCcm(nonce, CCM_NONCE_LENGTH, NULL, 0, &packet[overhead], length, &decrypted[0],
+			CCM_TAG_LENGTH)) {
+		return false;
+	}
+	receiver.accept(&packet[0]);
+	return true;
+}
+
+bool testCounters(PacketCipher& cipher) {
+	uint8_t sessionNonce[SESSION_NONCE_LENGTH] = {1, 2, 3, 4, 5};
+	CcmNonceCounter phone(CCM_DIRECTION_TO_CROWNSTONE);
+	CcmNonceCounter crownstone(CCM_DIRECTION_FROM_CROWNSTONE);
+
+	vector<vector<uint8_t> > writes;
+	for (int i = 0; i < NUM_PACKETS; ++i) {
+		writes.push_back(sendPacket(cipher, phone, sessionNonce, rand() % MAX_PAYLOAD));
+		if (!receivePacket(cipher, crownstone, sessionNonce, writes.back())) {
+			cout << "write " << i << " refused" << endl;
+			return false;
+		}
+		vector<uint8_t> notification = sendPacket(cipher, crownstone, sessionNonce, rand() % MAX_PAYLOAD);
+		if (!receivePacket(cipher, phone, sessionNonce, notification)) {
+			cout << "notification " << i << " refused" << endl;
+			return false;
+		}
+		// the notification has the same counter as the write, but the other direction.
+		if (memcmp(&notification[0], &writes.back()[0], PACKET_NONCE_LENGTH) != 0) {
+			cout << "counters of both directions differ" << endl;
+			return false;
+		}
+		if (receivePacket(cipher, crownstone, sessionNonce, notification)) {
+			cout << "reflected notification accepted" << endl;
+			return false;
+		}
+	}
+	if (receivePacket(cipher, crownstone, sessionNonce, writes.back())
+			|| receivePacket(cipher, crownstone, sessionNonce, writes[0])) {
+		cout << "replayed write accepted" << endl;
+		return false;
+	}
+
+	// a lost packet is fine, but the one before it can't come later.
+	vector<uint8_t> late = sendPacket(cipher, phone, sessionNonce, 10);
+	vector<uint8_t> next = sendPacket(cipher, phone, sessionNonce, 10);
+	if (!receivePacket(cipher, crownstone, sessionNonce, next) || receivePacket(cipher, crownstone, sessionNonce, late)) {
+		cout << "wrong order accepted" << endl;
+		return false;
+	}
+
+	// a packet with a wrong tag doesn't move the counter.
+	vector<uint8_t> changed = sendPacket(cipher, phone, sessionNonce, 10);
+	vector<uint8_t> valid = changed;
+	changed.back() ^= 1;
+	if (receivePacket(cipher, crownstone, sessionNonce, changed)
+			|| !receivePacket(cipher, crownstone, sessionNonce, valid)) {
+		cout << "changed packet moved the counter" << endl;
+		return false;
+	}
+
+	// a new session starts over.
+	phone.reset();
+	crownstone.reset();
+	sessionNonce[0] ^= 1;
+	if (!receivePacket(cipher, crownstone, sessionNonce, sendPacket(cipher, phone, sessionNonce, 10))) {
+		cout << "first packet of a new session refused" << endl;
+		return false;
+	}
+
+	// the last counter of a session.
+	vector<uint8_t> packet(PACKET_NONCE_LENGTH + USER_LEVEL_LENGTH);
+	for (uint8_t i = 0; i < PACKET_NONCE_LENGTH; ++i) {
+		packet[i] = 0xFF;
+	}
+	uint8_t nonce[CCM_NONCE_LENGTH];
+	crownstone.accept(&packet[0]);
+	if (crownstone.createReceiveNonce(&packet[0], sessionNonce, nonce)) {
+		cout << "counter accepted after the last one" << endl;
+		return false;
+	}
+	uint32_t numSent = 0;
+	while (phone.createSendNonce(&packet[0], sessionNonce, nonce)) {
+		++numSent;
+	}
+	if (numSent != CCM_MAX_PACKET_COUNTER) {
+		cout << numSent << " packets sent after the first" << endl;
+		return false;
+	}
+	return true;
+}
+
+int main() {
+	cout << "Test CCM implementation" << endl;
+	srand(1);
+
+	bool success = true;
+	for (int useAesNi = 0; useAesNi < 2; ++useAesNi) {
+		SoftwareAes aes(useAesNi);
+		PacketCipher cipher(aes);
+		success &= testVectors(cipher);
+
+		uint8_t key[AES_KEY_LENGTH];
+		randomBytes(key, AES_KEY_LENGTH);
+		cipher.setKey(key);
+		success &= testRoundTrip(cipher);
+		success &= testTampering(cipher);
+		success &= testCounters(cipher);
+	}
+	return success ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Feeds hours of synthetic loads through PowerCalculation and EnergyAccumulator, with a 24 bit RTC that wraps every
+ * 512 s, scheduling jitter, and missed buffers. Checks the accumulated energy against the exact energy of the loads.
+ * The previous calculation (averaged power times RTC ms) is shown for comparison.
+ */
+
+#include "PowerTrace.h"
+
+#include <processing/cs_EnergyAccumulator.h>
+
+#include <iostream>
+
+using namespace std;
+
+#define RTC_FREQ         32768
+#define RTC_MASK         0x00FFFFFF
+#define BUFFER_US        (CS_ADC_BUF_SIZE / 2 * CS_ADC_SAMPLE_INTERVAL_US)
+#define BUFFERS_PER_LOAD 50
+
+//! Allowed error of the energy, relative to the exact energy.
+#define MAX_RELATIVE_ERROR 0.001
+
+struct energy_load_t {
+	const char* name;
+	trace_load_t load;
+	//! Exact real power (W).
+	double power;
+	//! Buffers of this load.
+	vector<int16_t> trace;
+};
+
+struct energy_case_t {
+	const char* name;
+	double hours;
+	uint32_t minutesPerLoad;
+	//! Chance that a buffer is missed.
+	double missChance;
+	//! Buffer index at which a long gap starts, and the number of buffers in it.
+	uint32_t longGapAt;
+	uint32_t longGapBuffers;
+	//! Buffer index at which sampling stops, and the time it is stopped.
+	uint32_t stopAt;
+	uint32_t stopMs;
+};
+
+void addLoad(vector<energy_load_t>& loads, const char* name, double currentRms, double phaseDeg, double thirdHarmonic) {
+	energy_load_t load;
+	load.name = name;
+	load.load.currentRms = currentRms;
+	load.load.phaseDeg = phaseDeg;
+	load.load.thirdHarmonic = thirdHarmonic;
+	load.load.noiseLsb = 3;
+	// Harmonics of the current don't add real power, as the voltage is a pure sine.
+	load.power = load.load.voltageRms * currentRms * cos(phaseDeg * M_PI / 180);
+	synthesizeTrace(load.trace, load.load, 0, BUFFERS_PER_LOAD * CS_ADC_BUF_SIZE / 2);
+	loads.push_back(load);
+}
+
+/**
+ * Same as ROUNDED_DIV(ticks, RTC_CLOCK_FREQ / 1000) in RTC::ticksToMs().
+ */
+uint64_t oldTicksToMs(uint64_t ticks) {
+	uint64_t divisor = RTC_FREQ / 1000;
+	return (ticks + divisor / 2) / divisor;
+}
+
+bool run(const energy_case_t& c, vector<energy_load_t>& loads) {
+	PowerCalculation calculation;
+	calculation.init(traceCalculationConfig());
+	EnergyAccumulator accumulator;
+	accumulator.init(RTC_FREQ, RTC_MASK, BUFFER_US);
+
+	// Start just before the counter wraps.
+	const uint32_t startCount = RTC_MASK - 1000;
+	uint32_t lastCount = startCount;
+	double lastTimeUs = 0;
+	int64_t oldEnergyMicroJoule = 0;
+	double exactEnergyMicroJoule = 0;
+	double stoppedUs = 0;
+
+	uint32_t numBuffers = c.hours * 3600 * 1000000 / BUFFER_US;
+	uint32_t buffersPerLoad = c.minutesPerLoad * 60 * 1000000 / BUFFER_US;
+	uint32_t numMissed = 0;
+	uint32_t totalMissed = 0;
+	for (uint32_t i = 0; i < numBuffers; ++i) {
+		energy_load_t& load = loads[(i / buffersPerLoad) % loads.size()];
+		if (i == c.stopAt && c.stopMs) {
+			stoppedUs += c.stopMs * 1000.0;
+		}
+		// The energy is there, whether the buffer is missed or not, but not while sampling is stopped.
+		exactEnergyMicroJoule += load.power * BUFFER_US;
+		bool missed = (rand() < c.missChance * RAND_MAX) || (i >= c.longGapAt && i < c.longGapAt + c.longGapBuffers);
+		if (missed) {
+			++numMissed;
+			++totalMissed;
+			continue;
+		}
+
+		calculation.process(traceBuffer(load.trace, i % BUFFERS_PER_LOAD));
+
+		// Processed some time after the buffer is filled, but in order.
+		double timeUs = (i + 1.0) * BUFFER_US + stoppedUs + 2000.0 * rand() / RAND_MAX;
+		if (rand() % 100 == 0) {
+			timeUs += 30000;
+		}
+		timeUs = max(timeUs, lastTimeUs);
+		lastTimeUs = timeUs;
+		uint32_t count = (startCount + (uint64_t)(timeUs * RTC_FREQ / 1000000)) & RTC_MASK;
+
+		accumulator.add(count, calculation.getResult().powerMicroWatt, numMissed);
+		numMissed = 0;
+
+		uint32_t diffTicks = (count - lastCount) & RTC_MASK;
+		oldEnergyMicroJoule += (int64_t)calculation.getResult().avgPowerMilliWatt * oldTicksToMs(1024 * (uint64_t)diffTicks) / 1024;
+		lastCount = count;
+	}
+	// The first buffer only starts the accumulator.
+	exactEnergyMicroJoule -= loads[0].power * BUFFER_US;
+
+	double energy = accumulator.getEnergyMicroJoule();
+	double error = (energy - exactEnergyMicroJoule) / exactEnergyMicroJoule;
+	double oldError = (oldEnergyMicroJoule - exactEnergyMicroJoule) / exactEnergyMicroJoule;
+	cout << "  " << c.name << ": exact " << exactEnergyMicroJoule / 3.6e9 << " Wh, accumulated " << energy / 3.6e9
+			<< " Wh (error " << error * 100 << "%), previous calculation " << oldEnergyMicroJoule / 3.6e9 << " Wh (error "
+			<< oldError * 100 << "%)" << endl;
+	cout << "    missed buffers " << totalMissed << ", gaps " << accumulator.getGapCount() << " (" << accumulator.getGapMs()
+			<< " ms), unmetered " << accumulator.getUnmeteredMs() << " ms" << endl;
+
+	bool success = true;
+	if (fabs(error) > MAX_RELATIVE_ERROR) {
+		cout << c.name << ": energy error too large" << endl;
+		success = false;
+	}
+	// Each missed buffer is bridged, but consecutive missed buffers are a single gap.
+	if (accumulator.getGapCount() > totalMissed || (totalMissed && accumulator.getGapCount() == 0)) {
+		cout << c.name << ": wrong gap count" << endl;
+		success = false;
+	}
+	double gapErrorMs = fabs(accumulator.getGapMs() - totalMissed * BUFFER_US / 1000.0);
+	if (gapErrorMs > totalMissed * 0.01 * BUFFER_US / 1000.0 + 1) {
+		cout << c.name << ": wrong gap time" << endl;
+		success = false;
+	}
+	if (fabs(accumulator.getUnmeteredMs() - (double)c.stopMs) > BUFFER_US / 1000.0 + 30) {
+		cout << c.name << ": wrong unmetered time" << endl;
+		success = false;
+	}
+	return success;
+}
+
+int main() {
+	cout << "Test EnergyAccumulator implementation" << endl;
+	srand(1);
+	vector<energy_load_t> loads;
+	addLoad(loads, "heater", 2000.0 / 230, 0, 0);
+	addLoad(loads, "lamp", 60.0 / 230, 0, 0);
+	addLoad(loads, "motor", 3.0, 45, 0);
+	addLoad(loads, "power supply", 1.0, 10, 0.4);
+
+	const energy_case_t cases[] = {
+			{"continuous",          2, 5, 0,     0,     0,     0,     0},
+			{"missed buffers",      2, 5, 0.005, 0,     0,     0,     0},
+			{"gap over RTC wraps",  1, 30, 0,    30000, 30000, 0,     0},
+			{"sampling stopped",    1, 5, 0.001, 0,     0,     90000, 10000},
+	};
+	bool success = true;
+	for (const energy_case_t& c : cases) {
+		success &= run(c, loads);
+	}
+	return success ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Checks power factor, phase shift and current harmonics of HarmonicAnalysis on synthetic loads, and its cost.
+ *
+ * The budget is 20 us per 20 ms buffer on the host, 0.1% of the period.
+ */
+
+#include "PowerTrace.h"
+
+#include <processing/cs_HarmonicAnalysis.h>
+
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+#define BUDGET_NS 20000
+
+struct harmonic_case_t {
+	double phaseDeg;
+	double thirdHarmonic;
+	double fifthHarmonic;
+};
+
+bool near(const char* name, int32_t value, int32_t expected, int32_t tolerance) {
+	if (value < expected - tolerance || value > expected + tolerance) {
+		cout << "  " << name << " is " << value << ", expected " << expected << endl;
+		return false;
+	}
+	return true;
+}
+
+int main() {
+	cout << "Test HarmonicAnalysis implementation" << endl;
+	srand(1);
+	const harmonic_case_t cases[] = {
+			{0, 0, 0},
+			{30, 0, 0},
+			{-60, 0, 0},
+			{90, 0, 0},
+			{0, 0.2, 0.1},
+			{45, 0.3, 0},
+	};
+	const uint32_t numBuffers = 50;
+	bool success = true;
+	uint64_t totalNs = 0;
+	uint32_t numAnalysed = 0;
+	for (const harmonic_case_t& c : cases) {
+		trace_load_t load;
+		load.currentRms = 2;
+		load.noiseLsb = 2;
+		load.phaseDeg = c.phaseDeg;
+		load.thirdHarmonic = c.thirdHarmonic;
+		load.fifthHarmonic = c.fifthHarmonic;
+		vector<int16_t> trace;
+		synthesizeTrace(trace, load, 0, numBuffers * CS_ADC_BUF_SIZE / 2);
+
+		PowerCalculation calculation;
+		calculation.init(traceCalculationConfig());
+		HarmonicAnalysis analysis;
+		for (uint32_t bufIndex = 0; bufIndex < numBuffers; ++bufIndex) {
+			power_t power = traceBuffer(trace, bufIndex);
+			calculation.process(power);
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			analysis.analyse(power, power.acPeriodUs / power.sampleIntervalUs, calculation.getResult());
+			totalNs += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+			++numAnalysed;
+		}
+
+		const power_quality_t& quality = analysis.getPowerQuality();
+		double thd = sqrt(c.thirdHarmonic * c.thirdHarmonic + c.fifthHarmonic * c.fifthHarmonic);
+		double powerFactor = cos(c.phaseDeg * M_PI / 180) / sqrt(1 + thd * thd);
+		cout << "phase " << c.phaseDeg << ", 3rd " << c.thirdHarmonic << ", 5th " << c.fifthHarmonic << ": pf="
+				<< quality.powerFactor << " phase=" << quality.phaseShiftDeciDegrees << " thd=" << quality.currentThd
+				<< " harmonics=" << quality.currentHarmonics[0] << " " << quality.currentHarmonics[1] << endl;
+		success &= near("power factor", quality.powerFactor, lround(powerFactor * 1000), 15);
+		success &= near("phase shift", quality.phaseShiftDeciDegrees, lround(c.phaseDeg * 10), 10);
+		success &= near("3rd harmonic", quality.currentHarmonics[0], lround(c.thirdHarmonic * 1000), 10);
+		success &= near("5th harmonic", quality.currentHarmonics[1], lround(c.fifthHarmonic * 1000), 10);
+		success &= near("thd", quality.currentThd, lround(thd * 1000), 10);
+	}
+
+	uint64_t avgNs = totalNs / numAnalysed;
+	cout << "analysis: " << avgNs << " ns/buffer, budget " << BUDGET_NS << " ns/buffer" << endl;
+	if (avgNs > BUDGET_NS) {
+		cout << "over budget" << endl;
+		success = false;
+	}
+	return success ? 0 : 1;
+}
@@ -0,0 +1,286 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Checks that packets encrypted with a keystream from the KeystreamCache are the same as packets encrypted the usual
+ * way, for random keys, nonces and payload lengths, also when the payload is longer than the cached keystream.
+ *
+ * Checks the keying of the cache: a keystream is only handed out for the same key id and session nonce, and only once.
+ *
+ * Checks that keystreams that are taken out while another one is stored, like a notification that is sent from an
+ * interrupt, are the whole keystream of their own IV.
+ *
+ * Reports the time to encrypt a notification with and without a cached keystream, which is the part that is left on
+ * the path of a notification.
+ */
+
+#include <processing/cs_KeystreamCache.h>
+#include <processing/cs_SoftwareAes.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+#define NUM_PACKETS   10000
+#define NUM_KEYS      3
+#define MAX_PAYLOAD   120
+
+void randomBytes(uint8_t* buf, uint16_t length) {
+	for (uint16_t i = 0; i < length; ++i) {
+		buf[i] = rand();
+	}
+}
+
+void makeIv(uint8_t* iv, const uint8_t* packetNonce, const uint8_t* sessionNonce) {
+	memset(iv, 0, AES_BLOCK_LENGTH);
+	memcpy(iv, packetNonce, PACKET_NONCE_LENGTH);
+	memcpy(iv + PACKET_NONCE_LENGTH, sessionNonce, SESSION_NONCE_LENGTH);
+}
+
+uint16_t encryptedLength(uint16_t payloadLength) {
+	return (payloadLength + VALIDATION_NONCE_LENGTH + AES_BLOCK_LENGTH - 1) / AES_BLOCK_LENGTH * AES_BLOCK_LENGTH;
+}
+
+bool testSameOutput(PacketCipher& cipher) {
+	KeystreamCache cache;
+	uint8_t keys[NUM_KEYS][AES_KEY_LENGTH];
+	randomBytes(keys[0], sizeof(keys));
+	uint8_t sessionNonce[SESSION_NONCE_LENGTH];
+	uint8_t payload[MAX_PAYLOAD];
+	uint8_t expected[MAX_PAYLOAD + AES_BLOCK_LENGTH];
+	uint8_t actual[MAX_PAYLOAD + AES_BLOCK_LENGTH];
+	uint8_t decrypted[MAX_PAYLOAD];
+	for (int i = 0; i < NUM_PACKETS; ++i) {
+		// a new connection now and then.
+		if (i % 100 == 0) {
+			randomBytes(sessionNonce, SESSION_NONCE_LENGTH);
+			cache.clear();
+		}
+		uint16_t keyId = rand() % NUM_KEYS;
+		const uint8_t* key = keys[keyId];
+		uint8_t packetNonce[PACKET_NONCE_LENGTH];
+		randomBytes(packetNonce, PACKET_NONCE_LENGTH);
+		uint8_t iv[AES_BLOCK_LENGTH];
+		makeIv(iv, packetNonce, sessionNonce);
+		uint16_t payloadLength = rand() % (MAX_PAYLOAD + 1);
+		uint16_t length = encryptedLength(payloadLength);
+		randomBytes(payload, payloadLength);
+
+		// without the cache.
+		cipher.setKey(key);
+		cipher.encryptCtr(iv, sessionNonce, payload, payloadLength, expected, length);
+
+		// computed in advance, then encrypted with the cached keystream, as EncryptionHandler does.
+		cache.store(cipher, keyId, key, iv);
+		const keystream_cache_entry_t* entry = cache.take(keyId, sessionNonce);
+		if (entry == NULL || memcmp(entry->iv, iv, AES_BLOCK_LENGTH) != 0) {
+			cout << "stored keystream not found" << endl;
+			return false;
+		}
+		cipher.setKey(key);
+		if (!cipher.encryptCtr(entry->iv, sessionNonce, payload, payloadLength, actual, length, entry->keystream,
+				sizeof(entry->keystream))) {
+			cout << "encryption failed" << endl;
+			return false;
+		}
+		if (memcmp(actual, expected, length) != 0) {
+			cout << "output differs for a payload of " << payloadLength << " bytes" << endl;
+			return false;
+		}
+		if (!cipher.decryptCtr(iv, sessionNonce, actual, length, decrypted, payloadLength)
+				|| memcmp(decrypted, payload, payloadLength) != 0) {
+			cout << "decryption failed for a payload of " << payloadLength << " bytes" << endl;
+			return false;
+		}
+	}
+	if (cache.getHitCount() != NUM_PACKETS || cache.getMissCount() != 0) {
+		cout << "wrong statistics: " << cache.getHitCount() << " hits, " << cache.getMissCount() << " misses" << endl;
+		return false;
+	}
+	return true;
+}
+
+bool testKeying(PacketCipher& cipher) {
+	KeystreamCache cache;
+	uint8_t key[AES_KEY_LENGTH] = {1};
+	const uint16_t keyA = 1;
+	const uint16_t keyB = 2;
+	uint8_t sessionA[SESSION_NONCE_LENGTH] = {1, 2, 3, 4, 5};
+	uint8_t sessionB[SESSION_NONCE_LENGTH] = {1, 2, 3, 4, 6};
+	uint8_t packetNonce[PACKET_NONCE_LENGTH] = {7, 8, 9};
+	uint8_t iv[AES_BLOCK_LENGTH];
+	makeIv(iv, packetNonce, sessionA);
+
+	cache.store(cipher, keyA, key, iv);
+	if (!cache.contains(keyA, sessionA) || cache.contains(keyB, sessionA) || cache.contains(keyA, sessionB)) {
+		cout << "wrong keying" << endl;
+		return false;
+	}
+	if (cache.take(keyB, sessionA) != NULL || cache.take(keyA, sessionB) != NULL) {
+		cout << "keystream handed out for another key or session" << endl;
+		return false;
+	}
+	if (cache.take(keyA, sessionA) == NULL || cache.take(keyA, sessionA) != NULL) {
+		cout << "keystream not handed out exactly once" << endl;
+		return false;
+	}
+
+	// more packets than entries: the first is replaced.
+	for (uint8_t i = 0; i < KEYSTREAM_CACHE_ENTRIES + 1; ++i) {
+		iv[0] = i;
+		cache.store(cipher, keyA, key, iv);
+	}
+	uint8_t taken = 0;
+	const keystream_cache_entry_t* entry;
+	while ((entry = cache.take(keyA, sessionA)) != NULL) {
+		if (entry->iv[0] == 0) {
+			cout << "first entry not replaced" << endl;
+			return false;
+		}
+		++taken;
+	}
+	if (taken != KEYSTREAM_CACHE_ENTRIES) {
+		cout << taken << " entries taken" << endl;
+		return false;
+	}
+
+	cache.store(cipher, keyB, key, iv);
+	cache.clear();
+	if (cache.take(keyB, sessionA) != NULL) {
+		cout << "keystream handed out after clear" << endl;
+		return false;
+	}
+	if (cache.getHitCount() != 1 + KEYSTREAM_CACHE_ENTRIES || cache.getMissCount() != 5) {
+		cout << "wrong statistics: " << cache.getHitCount() << " hits, " << cache.getMissCount() << " misses" << endl;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * AES backend that takes a keystream out of the cache every few blocks, like a notification that is sent from an
+ * interrupt while the keystream of the next packet is computed.
+ */
+class InterruptingAes : public AesBackend {
+public:
+	InterruptingAes(KeystreamCache& cache, uint16_t keyId, const uint8_t* sessionNonce) :
+			_cache(cache), _keyId(keyId), _sessionNonce(sessionNonce), _blockCount(0) {}
+
+	void setKey(const uint8_t* key) {
+		_aes.setKey(key);
+	}
+
+	void encryptBlock(const uint8_t* cleartext, uint8_t* ciphertext) {
+		_aes.encryptBlock(cleartext, ciphertext);
+		// not a multiple of the keystream length, so that every block gets interrupted now and then.
+		if (++_blockCount % (KEYSTREAM_CACHE_BLOCKS + 1) == 0) {
+			const keystream_cache_entry_t* entry = _cache.take(_keyId, _sessionNonce);
+			if (entry != NULL) {
+				taken.push_back(*entry);
+			}
+		}
+	}
+
+	vector<keystream_cache_entry_t> taken;
+
+private:
+	SoftwareAes _aes;
+	KeystreamCache& _cache;
+	uint16_t _keyId;
+	const uint8_t* _sessionNonce;
+	uint32_t _blockCount;
+};
+
+bool testInterrupted(PacketCipher& cipher) {
+	KeystreamCache cache;
+	uint8_t key[AES_KEY_LENGTH] = {4};
+	uint8_t sessionNonce[SESSION_NONCE_LENGTH] = {1, 2, 3, 4, 5};
+	uint8_t packetNonce[PACKET_NONCE_LENGTH] = {0};
+	uint8_t iv[AES_BLOCK_LENGTH];
+	makeIv(iv, packetNonce, sessionNonce);
+	InterruptingAes aes(cache, 1, sessionNonce);
+	PacketCipher cacheCipher(aes);
+
+	// the cache fills up, so that entries are replaced while others are taken.
+	for (int i = 0; i < NUM_PACKETS; ++i) {
+		iv[0] = i;
+		iv[1] = i >> 8;
+		cache.store(cacheCipher, 1, key, iv);
+	}
+	if (aes.taken.empty()) {
+		cout << "no keystream taken while storing" << endl;
+		return false;
+	}
+	cipher.setKey(key);
+	for (const keystream_cache_entry_t& entry : aes.taken) {
+		uint8_t expected[sizeof(entry.keystream)];
+		cipher.keystream(entry.iv, expected, sizeof(expected));
+		if (memcmp(entry.keystream, expected, sizeof(expected)) != 0) {
+			cout << "keystream taken before it was computed" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Time to encrypt a notification of given payload length, with or without a cached keystream, in ns.
+ */
+uint64_t encryptNs(PacketCipher& cipher, uint16_t payloadLength, bool cached) {
+	KeystreamCache cache;
+	uint8_t key[AES_KEY_LENGTH] = {3};
+	uint8_t sessionNonce[SESSION_NONCE_LENGTH] = {1, 2, 3, 4, 5};
+	uint8_t iv[AES_BLOCK_LENGTH];
+	makeIv(iv, sessionNonce, sessionNonce);
+	vector<uint8_t> payload(payloadLength, 0x5A);
+	uint16_t length = encryptedLength(payloadLength);
+	vector<uint8_t> output(length);
+	uint64_t totalNs = 0;
+	for (int i = 0; i < NUM_PACKETS; ++i) {
+		iv[0] = i;
+		const keystream_cache_entry_t* entry = NULL;
+		if (cached) {
+			// idle time, not measured.
+			cache.store(cipher, 1, key, iv);
+			entry = cache.take(1, sessionNonce);
+		}
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		cipher.setKey(key);
+		if (entry != NULL) {
+			cipher.encryptCtr(iv, sessionNonce, &payload[0], payloadLength, &output[0], length, entry->keystream,
+					sizeof(entry->keystream));
+		}
+		else {
+			cipher.encryptCtr(iv, sessionNonce, &payload[0], payloadLength, &output[0], length);
+		}
+		totalNs += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+	}
+	return totalNs / NUM_PACKETS;
+}
+
+int main() {
+	cout << "Test KeystreamCache implementation" << endl;
+	srand(1);
+
+	SoftwareAes aes(false);
+	PacketCipher cipher(aes);
+	bool success = testSameOutput(cipher);
+	success &= testKeying(cipher);
+	success &= testInterrupted(cipher);
+
+	// The state notifications, and a payload longer than the cached keystream.
+	const uint16_t payloadLengths[] = {12, 28, 60, 124};
+	for (uint16_t payloadLength : payloadLengths) {
+		cout << "  " << payloadLength << " B: " << encryptNs(cipher, payloadLength, true) << " ns with vs "
+				<< encryptNs(cipher, payloadLength, false) << " ns without cached keystream" << endl;
+	}
+	return success ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Switches appliances on and off in a synthetic trace, with inrush currents, a fluctuating load and noise, and feeds
+ * it through PowerCalculation and LoadEventDetector. Measures the detection latency in periods, the number of missed
+ * switches, and the number of false events.
+ *
+ * A recorded trace can be given as argument: then the detected events are printed.
+ */
+
+#include "PowerTrace.h"
+
+#include <processing/cs_LoadEventDetector.h>
+
+#include <iostream>
+
+using namespace std;
+
+#define NUM_SAMPLES      (CS_ADC_BUF_SIZE / 2)
+//! An event is matched to a switch when it comes within this many periods.
+#define MAX_LATENCY      60
+//! Switches are expected to be detected when the step is this much larger than the minimal step.
+#define DETECTABLE_MARGIN 1.5
+
+struct appliance_t {
+	const char* name;
+	trace_load_t load;
+	//! Current when starting, relative to the current, and the number of periods it takes to decay.
+	double inrush;
+	uint32_t inrushPeriods;
+	//! Random change of the current every period, relative to the current.
+	double fluctuation;
+};
+
+struct switch_t {
+	uint32_t period;
+	uint8_t appliance;
+	bool on;
+	//! Whether the step is large enough compared to the total current.
+	bool detectable;
+};
+
+appliance_t appliance(const char* name, double currentRms, double phaseDeg, double thirdHarmonic, double inrush,
+		uint32_t inrushPeriods, double fluctuation) {
+	appliance_t a;
+	a.name = name;
+	a.load.currentRms = currentRms;
+	a.load.phaseDeg = phaseDeg;
+	a.load.thirdHarmonic = thirdHarmonic;
+	a.inrush = inrush;
+	a.inrushPeriods = inrushPeriods;
+	a.fluctuation = fluctuation;
+	return a;
+}
+
+/**
+ * Synthesize a buffer with the appliances that are on.
+ */
+void sampleBuffer(vector<int16_t>& buf, const vector<appliance_t>& appliances, const vector<int32_t>& onSince, uint32_t period) {
+	trace_load_t voltage;
+	voltage.currentRms = 0;
+	voltage.noiseLsb = 2;
+	buf.clear();
+	synthesizeTrace(buf, voltage, period * NUM_SAMPLES, NUM_SAMPLES);
+	vector<int16_t> single;
+	for (size_t a = 0; a < appliances.size(); ++a) {
+		if (onSince[a] < 0) {
+			continue;
+		}
+		trace_load_t load = appliances[a].load;
+		uint32_t periodsOn = period - onSince[a];
+		if (periodsOn < appliances[a].inrushPeriods) {
+			load.currentRms *= 1 + (appliances[a].inrush - 1) * (appliances[a].inrushPeriods - periodsOn) / appliances[a].inrushPeriods;
+		}
+		load.currentRms *= 1 + appliances[a].fluctuation * (2.0 * rand() / RAND_MAX - 1);
+		single.clear();
+		synthesizeTrace(single, load, period * NUM_SAMPLES, NUM_SAMPLES);
+		for (uint32_t i = 1; i < CS_ADC_BUF_SIZE; i += 2) {
+			buf[i] += single[i] - TRACE_CURRENT_ZERO;
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	cout << "Test LoadEventDetector implementation" << endl;
+	srand(1);
+
+	PowerCalculation calculation;
+	calculation.init(traceCalculationConfig());
+	LoadEventDetector detector;
+
+	if (argc > 1) {
+		vector<int16_t> trace;
+		if (!readTrace(argv[1], trace)) {
+			cout << "Could not read " << argv[1] << endl;
+			return 1;
+		}
+		for (uint32_t i = 0; i < traceNumBuffers(trace); ++i) {
+			calculation.process(traceBuffer(trace, i));
+			if (detector.update(calculation.getResult().filteredCurrentRmsMedianMilliAmp)) {
+				const load_event_t& event = detector.getEvent();
+				cout << "  period " << i << ": " << (event.type == LOAD_EVENT_SWITCHED_ON ? "on" : "off") << ", delta "
+						<< event.deltaMilliAmp << " mA" << endl;
+			}
+		}
+		return 0;
+	}
+
+	vector<appliance_t> appliances;
+	appliances.push_back(appliance("lamp", 60.0 / 230, 0, 0, 1, 0, 0));
+	appliances.push_back(appliance("heater", 2000.0 / 230, 0, 0, 1, 0, 0.01));
+	appliances.push_back(appliance("fridge", 150.0 / 230, 40, 0, 5, 15, 0.02));
+	appliances.push_back(appliance("LED driver", 20.0 / 230, 10, 0.6, 4, 1, 0));
+	appliances.push_back(appliance("tv", 100.0 / 230, 10, 0.5, 1, 0, 0.05));
+
+	// Every appliance goes on and off a few times, in random order.
+	vector<switch_t> switches;
+	vector<int32_t> onSince(appliances.size(), -1);
+	uint32_t numPeriods = 0;
+	for (int i = 0; i < 60; ++i) {
+		numPeriods += 150 + rand() % 300;
+		switch_t s;
+		s.period = numPeriods;
+		s.appliance = rand() % appliances.size();
+		switches.push_back(s);
+	}
+	numPeriods += 300;
+	// Toggle, so that each switch changes the state of its appliance.
+	vector<bool> isOn(appliances.size(), false);
+	uint32_t numDetectable = 0;
+	for (switch_t& s : switches) {
+		double totalMilliAmp = 0;
+		for (size_t a = 0; a < appliances.size(); ++a) {
+			totalMilliAmp += isOn[a] ? appliances[a].load.currentRms * 1000 : 0;
+		}
+		double minStep = max((double)LOAD_EVENT_MIN_STEP_MILLI_AMP, totalMilliAmp * LOAD_EVENT_MIN_STEP_PERCENT / 100);
+		s.detectable = appliances[s.appliance].load.currentRms * 1000 > DETECTABLE_MARGIN * minStep;
+		numDetectable += s.detectable;
+		isOn[s.appliance] = !isOn[s.appliance];
+		s.on = isOn[s.appliance];
+	}
+
+	vector<int32_t> latency;
+	uint32_t numFalse = 0;
+	vector<bool> detected(switches.size(), false);
+	size_t nextSwitch = 0;
+	vector<int16_t> buf;
+	for (uint32_t period = 0; period < numPeriods; ++period) {
+		if (nextSwitch < switches.size() && switches[nextSwitch].period == period) {
+			onSince[switches[nextSwitch].appliance] = switches[nextSwitch].on ? period : -1;
+			++nextSwitch;
+		}
+		sampleBuffer(buf, appliances, onSince, period);
+		calculation.process(traceBuffer(buf, 0));
+		if (!detector.update(calculation.getResult().filteredCurrentRmsMedianMilliAmp)) {
+			continue;
+		}
+		// Match the event to the last switch before it.
+		const load_event_t& event = detector.getEvent();
+		bool matched = false;
+		if (nextSwitch > 0) {
+			size_t s = nextSwitch - 1;
+			bool on = event.type == LOAD_EVENT_SWITCHED_ON;
+			if (!detected[s] && switches[s].on == on && period - switches[s].period <= MAX_LATENCY) {
+				detected[s] = true;
+				latency.push_back(period - switches[s].period);
+				matched = true;
+			}
+		}
+		if (!matched) {
+			cout << "  false event at period " << period << ": delta " << event.deltaMilliAmp << " mA" << endl;
+			++numFalse;
+		}
+	}
+
+	uint32_t numMissed = 0;
+	for (size_t s = 0; s < switches.size(); ++s) {
+		if (!detected[s] && switches[s].detectable) {
+			cout << "  missed " << appliances[switches[s].appliance].name << (switches[s].on ? " on" : " off")
+					<< " at period " << switches[s].period << endl;
+			++numMissed;
+		}
+	}
+	int32_t maxLatency = 0;
+	double avgLatency = 0;
+	for (int32_t l : latency) {
+		maxLatency = max(maxLatency, l);
+		avgLatency += l;
+	}
+	avgLatency /= latency.size();
+	cout << "  " << switches.size() << " switches (" << numDetectable << " above the step size) in " << numPeriods
+			<< " periods: " << numMissed << " missed, "
+			<< numFalse << " false events, latency " << avgLatency << " periods on average, " << maxLatency << " max"
+			<< endl;
+
+	bool success = true;
+	if (numMissed > 0 || numFalse > 0) {
+		cout << "wrong events" << endl;
+		success = false;
+	}
+	// The median, the debounce, and the inrush of the fridge, with some periods of margin.
+	int32_t maxExpectedLatency = POWER_SAMPLING_RMS_WINDOW_SIZE / 2 + LOAD_EVENT_DEBOUNCE_PERIODS + appliances[2].inrushPeriods + 10;
+	if (maxLatency > maxExpectedLatency) {
+		cout << "latency too high" << endl;
+		success = false;
+	}
+	return success ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Checks the median and average of MedianWindow against sorting a copy of the last values, for several window sizes.
+ */
+
+#include <structs/buffer/cs_MedianWindow.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+#define NUM_VALUES 10000
+
+template <uint16_t capacity>
+bool compare(int32_t range) {
+	MedianWindow<int32_t, capacity> window;
+	deque<int32_t> last;
+	for (int i = 0; i < NUM_VALUES; ++i) {
+		// A small range gives many equal values.
+		int32_t value = (rand() % range) - range / 2;
+		window.push(value);
+		last.push_back(value);
+		if (last.size() > capacity) {
+			last.pop_front();
+		}
+		if (window.size() != last.size() || window.full() != (last.size() == capacity)) {
+			cout << "window " << capacity << ": wrong size at " << i << endl;
+			return false;
+		}
+		vector<int32_t> sorted(last.begin(), last.end());
+		sort(sorted.begin(), sorted.end());
+		int64_t sum = 0;
+		for (int32_t v : sorted) {
+			sum += v;
+		}
+		int32_t median = (sorted.size() % 2) ? sorted[sorted.size() / 2]
+				: ((int64_t)sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) / 2;
+		int32_t average = sum / (int64_t)sorted.size();
+		if (window.median() != median || window.average() != average) {
+			cout << "window " << capacity << ": wrong median or average at " << i << ": " << window.median() << " vs "
+					<< median << ", " << window.average() << " vs " << average << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int main() {
+	cout << "Test MedianWindow implementation" << endl;
+	srand(1);
+	bool success = true;
+	const int32_t ranges[] = {5, 100000};
+	for (int32_t range : ranges) {
+		success &= compare<1>(range);
+		success &= compare<2>(range);
+		success &= compare<7>(range);
+		success &= compare<9>(range);
+		success &= compare<10>(range);
+		success &= compare<25>(range);
+		success &= compare<64>(range);
+	}
+	return success ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Known answer tests of the AES backends (FIPS-197 and SP 800-38A), and of the packets of docs/PROTOCOL.md:
+ * - the encrypted session nonce: ECB of 0xCAFEBABE and the session nonce, with the guest key.
+ * - an encrypted packet: CTR with the packet nonce and session nonce as IV, and the validation key in front of the
+ *   payload.
+ * The expected ciphertexts were made with openssl.
+ *
+ * Also checks that decryption gives back the payload for all lengths, and fails with a wrong validation key.
+ *
+ * Benchmarks the throughput of encrypting and decrypting packets of characteristic sizes, with the portable and the
+ * AES-NI backend.
+ */
+
+#include <processing/cs_PacketCipher.h>
+#include <processing/cs_SoftwareAes.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define NUM_PACKETS 20000
+#define NUM_RUNS    3
+
+vector<uint8_t> fromHex(const string& hex) {
+	vector<uint8_t> bytes;
+	for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+		bytes.push_back((uint8_t)stoul(hex.substr(i, 2), NULL, 16));
+	}
+	return bytes;
+}
+
+string toHex(const uint8_t* bytes, size_t length) {
+	static const char digits[] = "0123456789abcdef";
+	string hex;
+	for (size_t i = 0; i < length; ++i) {
+		hex += digits[bytes[i] >> 4];
+		hex += digits[bytes[i] & 0xF];
+	}
+	return hex;
+}
+
+bool expectEqual(const char* name, const uint8_t* actual, const string& expectedHex) {
+	vector<uint8_t> expected = fromHex(expectedHex);
+	if (memcmp(actual, &expected[0], expected.size()) != 0) {
+		cout << name << ": " << toHex(actual, expected.size()) << " vs " << expectedHex << endl;
+		return false;
+	}
+	return true;
+}
+
+bool testBlocks(AesBackend& aes) {
+	bool success = true;
+	uint8_t out[AES_BLOCK_LENGTH];
+
+	// FIPS-197 appendix C.1.
+	aes.setKey(&fromHex("000102030405060708090a0b0c0d0e0f")[0]);
+	aes.encryptBlock(&fromHex("00112233445566778899aabbccddeeff")[0], out);
+	success &= expectEqual("FIPS-197 C.1", out, "69c4e0d86a7b0430d8cdb78070b4c55a");
+
+	// SP 800-38A F.1.1, ECB-AES128.encrypt.
+	aes.setKey(&fromHex("2b7e151628aed2a6abf7158809cf4f3c")[0]);
+	const char* cleartexts[] = {"6bc1bee22e409f96e93d7e117393172a", "ae2d8a571e03ac9c9eb76fac45af8e51",
+			"30c81c46a35ce411e5fbc1191a0a52ef", "f69f2445df4f9b17ad2b417be66c3710"};
+	const char* ciphertexts[] = {"3ad77bb40d7a3660a89ecaf32466ef97", "f5d3d58503b9699de785895a96fdbaaf",
+			"43b1cd7f598ece23881b00e3ed030688", "7b0c785e27e8ad3f8223207104725dd4"};
+	for (int i = 0; i < 4; ++i) {
+		aes.encryptBlock(&fromHex(cleartexts[i])[0], out);
+		success &= expectEqual("SP 800-38A F.1.1", out, ciphertexts[i]);
+	}
+
+	// In place.
+	vector<uint8_t> block = fromHex(cleartexts[0]);
+	aes.encryptBlock(&block[0], &block[0]);
+	success &= expectEqual("in place", &block[0], ciphertexts[0]);
+	return success;
+}
+
+//! The protocol examples: key "ABCDEFGHIJKLMNOP", packet nonce 01 02 03, session nonce 10 11 12 13 14.
+static const uint8_t protocolKey[] = {'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P'};
+static const uint8_t packetNonce[PACKET_NONCE_LENGTH] = {0x01, 0x02, 0x03};
+static const uint8_t sessionNonce[SESSION_NONCE_LENGTH] = {0x10, 0x11, 0x12, 0x13, 0x14};
+
+//! IV of an encrypted packet: packet nonce, session nonce, zero padded.
+void protocolIv(uint8_t* iv) {
+	memset(iv, 0, AES_BLOCK_LENGTH);
+	memcpy(iv, packetNonce, PACKET_NONCE_LENGTH);
+	memcpy(iv + PACKET_NONCE_LENGTH, sessionNonce, SESSION_NONCE_LENGTH);
+}
+
+//! Length of the encrypted payload: validation key and payload, padded to whole blocks.
+uint16_t encryptedLength(uint16_t payloadLength) {
+	return (payloadLength + VALIDATION_NONCE_LENGTH + AES_BLOCK_LENGTH - 1) / AES_BLOCK_LENGTH * AES_BLOCK_LENGTH;
+}
+
+bool testProtocol(AesBackend& aes) {
+	bool success = true;
+	PacketCipher cipher(aes);
+	cipher.setKey(protocolKey);
+
+	// Session nonce after ECB encryption: validation key 0xCAFEBABE (little endian), session nonce, zero padded.
+	uint8_t cleartext[AES_BLOCK_LENGTH] = {0xbe, 0xba, 0xfe, 0xca};
+	memcpy(cleartext + 4, sessionNonce, SESSION_NONCE_LENGTH);
+	uint8_t ciphertext[AES_BLOCK_LENGTH];
+	cipher.encryptEcb(cleartext, ciphertext);
+	success &= expectEqual("session nonce", ciphertext, "12ee3b4f5dc5d3530af7dc6dd4d32a77");
+
+	// Encrypted packet with a payload of the bytes 0 to 39, the session nonce as validation key.
+	uint8_t iv[AES_BLOCK_LENGTH];
+	protocolIv(iv);
+	uint8_t payload[40];
+	for (uint8_t i = 0; i < sizeof(payload); ++i) {
+		payload[i] = i;
+	}
+	uint8_t encrypted[48];
+	if (!cipher.encryptCtr(iv, sessionNonce, payload, sizeof(payload), encrypted, sizeof(encrypted))) {
+		cout << "encryption failed" << endl;
+		return false;
+	}
+	success &= expectEqual("encrypted packet", encrypted,
+			"6b821d0bd78b98d38413151ae04d831aca5146171df86e17480ce734bb8b49b4fa5f0989ea1688da184683e05f997303");
+
+	// Round trip of every payload length up to 4 blocks, into a target of the exact length.
+	uint8_t decrypted[64];
+	uint8_t buffer[64];
+	for (uint16_t length = 0; length <= 60; ++length) {
+		uint16_t encLength = encryptedLength(length);
+		memset(decrypted, 0xEE, sizeof(decrypted));
+		if (!cipher.encryptCtr(iv, sessionNonce, payload, min<uint16_t>(length, sizeof(payload)), buffer, encLength)
+				|| !cipher.decryptCtr(iv, sessionNonce, buffer, encLength, decrypted, length)) {
+			cout << "round trip of " << length << " bytes failed" << endl;
+			return false;
+		}
+		for (uint16_t i = 0; i < length; ++i) {
+			uint8_t expected = i < sizeof(payload) ? payload[i] : 0;
+			if (decrypted[i] != expected) {
+				cout << "round trip of " << length << " bytes differs at " << i << endl;
+				return false;
+			}
+		}
+		if (decrypted[length] != 0xEE) {
+			cout << "round trip of " << length << " bytes wrote beyond the target" << endl;
+			return false;
+		}
+	}
+
+	// Wrong validation key, wrong key, and invalid lengths.
+	uint8_t wrongNonce[VALIDATION_NONCE_LENGTH] = {0x10, 0x11, 0x12, 0x15};
+	if (cipher.decryptCtr(iv, wrongNonce, encrypted, sizeof(encrypted), decrypted, sizeof(payload))) {
+		cout << "decrypted with a wrong validation key" << endl;
+		success = false;
+	}
+	uint8_t wrongKey[AES_KEY_LENGTH] = {0};
+	cipher.setKey(wrongKey);
+	if (cipher.decryptCtr(iv, sessionNonce, encrypted, sizeof(encrypted), decrypted, sizeof(payload))) {
+		cout << "decrypted with a wrong key" << endl;
+		success = false;
+	}
+	cipher.setKey(protocolKey);
+	if (cipher.encryptCtr(iv, sessionNonce, payload, 10, buffer, 20)
+			|| cipher.encryptCtr(iv, sessionNonce, payload, 0, buffer, 0)
+			|| cipher.decryptCtr(iv, sessionNonce, encrypted, 40, decrypted, 12)
+			|| cipher.decryptCtr(iv, sessionNonce, encrypted, 16, decrypted, 13)) {
+		cout << "invalid length accepted" << endl;
+		success = false;
+	}
+	return success;
+}
+
+/**
+ * Encrypt and decrypt NUM_PACKETS packets of given payload length, returns the payload bytes per second.
+ */
+double benchmark(AesBackend& aes, uint16_t payloadLength) {
+	PacketCipher cipher(aes);
+	cipher.setKey(protocolKey);
+	uint8_t iv[AES_BLOCK_LENGTH];
+	protocolIv(iv);
+	uint16_t encLength = encryptedLength(payloadLength);
+	vector<uint8_t> payload(payloadLength, 0x5A);
+	vector<uint8_t> encrypted(encLength);
+	vector<uint8_t> decrypted(payloadLength);
+	uint64_t bestNs = UINT64_MAX;
+	for (int run = 0; run < NUM_RUNS; ++run) {
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int i = 0; i < NUM_PACKETS; ++i) {
+			iv[0] = i;
+			cipher.encryptCtr(iv, sessionNonce, &payload[0], payloadLength, &encrypted[0], encLength);
+			cipher.decryptCtr(iv, sessionNonce, &encrypted[0], encLength, &decrypted[0], payloadLength);
+		}
+		uint64_t ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+		bestNs = min(bestNs, ns);
+	}
+	return 2.0 * NUM_PACKETS * payloadLength / (bestNs / 1e9);
+}
+
+void benchmark(const char* name, AesBackend& aes) {
+	// A single block, the 20 bytes of a default MTU, and larger writes like schedule entries and mesh commands.
+	const uint16_t payloadLengths[] = {12, 20, 60, 124, 252};
+	cout << "  " << name << ":";
+	for (uint16_t payloadLength : payloadLengths) {
+		cout << " " << payloadLength << " B: " << (uint64_t)(benchmark(aes, payloadLength) / 1000) << " kB/s";
+	}
+	cout << endl;
+}
+
+int main() {
+	cout << "Test PacketCipher implementation" << endl;
+	bool success = true;
+
+	SoftwareAes portable(false);
+	success &= testBlocks(portable);
+	success &= testProtocol(portable);
+
+	SoftwareAes aesNi;
+	if (aesNi.usesAesNi()) {
+		success &= testBlocks(aesNi);
+		success &= testProtocol(aesNi);
+	}
+
+	benchmark("portable", portable);
+	if (aesNi.usesAesNi()) {
+		benchmark("AES-NI", aesNi);
+	}
+	return success ? 0 : 1;
+}
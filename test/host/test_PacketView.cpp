@@ -0,0 +1,169 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Checks decryption in place: a control packet, laid out as it is written to the characteristic, is decrypted where
+ * it is, and the PacketView points at the command inside that buffer. The result has to be the same as the decryption
+ * to another buffer.
+ *
+ * Checks that a packet with a wrong validation nonce, a length that is not a whole number of blocks, or a stream
+ * header with a length beyond the payload is refused.
+ */
+
+#include <processing/cs_PacketCipher.h>
+#include <processing/cs_SoftwareAes.h>
+#include <structs/cs_PacketView.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+#define NUM_PACKETS      1000
+#define MAX_DATA_LENGTH  200
+
+void randomBytes(uint8_t* buf, uint16_t length) {
+	for (uint16_t i = 0; i < length; ++i) {
+		buf[i] = rand();
+	}
+}
+
+uint16_t encryptedLength(uint16_t payloadLength) {
+	return (payloadLength + VALIDATION_NONCE_LENGTH + AES_BLOCK_LENGTH - 1) / AES_BLOCK_LENGTH * AES_BLOCK_LENGTH;
+}
+
+/**
+ * Encrypt a stream buffer packet of given type and data in the protocol layout: packet nonce, user level, encrypted
+ * blocks. The packet nonce is taken from the IV.
+ */
+vector<uint8_t> makePacket(PacketCipher& cipher, const uint8_t* iv, const uint8_t* validationNonce, uint8_t type,
+		const uint8_t* data, uint16_t dataLength) {
+	vector<uint8_t> payload(SB_HEADER_SIZE + dataLength);
+	stream_header_t header;
+	header.type = type;
+	header.opCode = WRITE_VALUE;
+	header.length = dataLength;
+	memcpy(&payload[0], &header, SB_HEADER_SIZE);
+	memcpy(&payload[SB_HEADER_SIZE], data, dataLength);
+
+	uint16_t length = encryptedLength(payload.size());
+	vector<uint8_t> packet(PACKET_NONCE_LENGTH + USER_LEVEL_LENGTH + length);
+	memcpy(&packet[0], iv, PACKET_NONCE_LENGTH);
+	packet[PACKET_NONCE_LENGTH] = 0;
+	cipher.encryptCtr(iv, validationNonce, &payload[0], payload.size(), &packet[PACKET_NONCE_LENGTH + USER_LEVEL_LENGTH],
+			length);
+	return packet;
+}
+
+bool testInPlace(PacketCipher& cipher) {
+	uint8_t iv[AES_BLOCK_LENGTH] = {0};
+	uint8_t data[MAX_DATA_LENGTH];
+	for (int i = 0; i < NUM_PACKETS; ++i) {
+		randomBytes(iv, PACKET_NONCE_LENGTH + SESSION_NONCE_LENGTH);
+		const uint8_t* validationNonce = iv + PACKET_NONCE_LENGTH;
+		uint16_t dataLength = rand() % (MAX_DATA_LENGTH + 1);
+		uint8_t type = rand();
+		randomBytes(data, dataLength);
+		vector<uint8_t> packet = makePacket(cipher, iv, validationNonce, type, data, dataLength);
+		uint8_t* encrypted = &packet[PACKET_NONCE_LENGTH + USER_LEVEL_LENGTH];
+		uint16_t length = packet.size() - PACKET_NONCE_LENGTH - USER_LEVEL_LENGTH;
+
+		// decrypted to another buffer, as before.
+		vector<uint8_t> copy(length - VALIDATION_NONCE_LENGTH);
+		if (!cipher.decryptCtr(iv, validationNonce, encrypted, length, &copy[0], copy.size())) {
+			cout << "decryption failed" << endl;
+			return false;
+		}
+
+		if (!cipher.decryptCtrInPlace(iv, validationNonce, encrypted, length)) {
+			cout << "decryption in place failed" << endl;
+			return false;
+		}
+		PacketView view;
+		view.assign(encrypted + VALIDATION_NONCE_LENGTH, length - VALIDATION_NONCE_LENGTH);
+		if (memcmp(view.payload(), &copy[0], copy.size()) != 0) {
+			cout << "decryption in place differs for " << dataLength << " bytes of data" << endl;
+			return false;
+		}
+		if (!view.isStream() || view.type() != type || view.opCode() != WRITE_VALUE || view.length() != dataLength
+				|| memcmp(view.data(), data, dataLength) != 0) {
+			cout << "wrong view for " << dataLength << " bytes of data" << endl;
+			return false;
+		}
+		if (view.data() < &packet[0] || view.data() + view.length() > &packet[0] + packet.size()) {
+			cout << "view points outside the packet" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool testRefused(PacketCipher& cipher) {
+	uint8_t iv[AES_BLOCK_LENGTH] = {1, 2, 3, 4, 5, 6, 7, 8};
+	const uint8_t* validationNonce = iv + PACKET_NONCE_LENGTH;
+	uint8_t data[20] = {9, 8, 7};
+	vector<uint8_t> packet = makePacket(cipher, iv, validationNonce, 1, data, sizeof(data));
+	uint8_t* encrypted = &packet[PACKET_NONCE_LENGTH + USER_LEVEL_LENGTH];
+	uint16_t length = packet.size() - PACKET_NONCE_LENGTH - USER_LEVEL_LENGTH;
+
+	uint8_t otherNonce[VALIDATION_NONCE_LENGTH] = {6, 5, 4, 3};
+	vector<uint8_t> wrong(packet);
+	if (cipher.decryptCtrInPlace(iv, otherNonce, &wrong[PACKET_NONCE_LENGTH + USER_LEVEL_LENGTH], length)) {
+		cout << "wrong validation nonce accepted" << endl;
+		return false;
+	}
+	if (cipher.decryptCtrInPlace(iv, validationNonce, encrypted, length - 1)
+			|| cipher.decryptCtrInPlace(iv, validationNonce, encrypted, 0)) {
+		cout << "invalid length accepted" << endl;
+		return false;
+	}
+
+	// a header that claims more data than the payload holds.
+	uint8_t payload[AES_BLOCK_LENGTH] = {0};
+	stream_header_t header = {1, WRITE_VALUE, AES_BLOCK_LENGTH - SB_HEADER_SIZE + 1};
+	memcpy(payload, &header, SB_HEADER_SIZE);
+	PacketView view;
+	if (view.isStream()) {
+		cout << "empty view is a stream" << endl;
+		return false;
+	}
+	view.assign(payload, sizeof(payload));
+	if (view.isStream()) {
+		cout << "header length beyond the payload accepted" << endl;
+		return false;
+	}
+	view.assign(payload, SB_HEADER_SIZE - 1);
+	if (view.isStream()) {
+		cout << "payload shorter than a header accepted" << endl;
+		return false;
+	}
+	header.length = AES_BLOCK_LENGTH - SB_HEADER_SIZE;
+	memcpy(payload, &header, SB_HEADER_SIZE);
+	view.assign(payload, sizeof(payload));
+	if (!view.isStream()) {
+		cout << "data up to the end of the payload refused" << endl;
+		return false;
+	}
+	return true;
+}
+
+int main() {
+	cout << "Test decryption in place and PacketView" << endl;
+	srand(1);
+
+	uint8_t key[AES_KEY_LENGTH];
+	randomBytes(key, AES_KEY_LENGTH);
+	SoftwareAes aes;
+	PacketCipher cipher(aes);
+	cipher.setKey(key);
+
+	bool success = testInPlace(cipher);
+	success &= testRefused(cipher);
+	return success ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Checks the period measured by PeriodTracker on synthetic 50 Hz, 60 Hz, below 50 Hz and drifting traces, and compares
+ * the jitter of Irms when integrating over the tracked period, and over the nominal 20 ms.
+ *
+ * Checks that the window covers the whole period, also for the longest periods, which don't fit in 20 ms.
+ */
+
+#include "PowerTrace.h"
+
+#include <processing/cs_PeriodTracker.h>
+
+#include <iostream>
+
+using namespace std;
+
+struct period_case_t {
+	double frequencyHz;
+	double frequencyDrift;
+	double noiseLsb;
+};
+
+struct rms_stats_t {
+	double mean;
+	double stddev;
+};
+
+//! Irms of every buffer, after the first second.
+rms_stats_t irmsStats(vector<int16_t>& trace, bool track) {
+	PowerCalculation calculation;
+	calculation.init(traceCalculationConfig());
+	PeriodTracker tracker;
+	tracker.init(CS_ADC_SAMPLE_INTERVAL_US);
+	uint32_t skip = 1000000 / (CS_ADC_BUF_SIZE / 2 * CS_ADC_SAMPLE_INTERVAL_US);
+	double sum = 0;
+	double squareSum = 0;
+	uint32_t count = 0;
+	for (uint32_t bufIndex = 0; bufIndex < traceNumBuffers(trace); ++bufIndex) {
+		power_t power = traceBuffer(trace, bufIndex);
+		tracker.update(power, calculation.getAvgZeroVoltage());
+		if (track) {
+			power.acPeriodUs = tracker.getWindowUs(power.bufSize / power.numChannels);
+		}
+		calculation.process(power);
+		if (bufIndex >= skip) {
+			double irms = calculation.getResult().currentRmsMilliAmp;
+			sum += irms;
+			squareSum += irms * irms;
+			++count;
+		}
+	}
+	rms_stats_t stats;
+	stats.mean = sum / count;
+	stats.stddev = sqrt(squareSum / count - stats.mean * stats.mean);
+	return stats;
+}
+
+int main() {
+	cout << "Test PeriodTracker implementation" << endl;
+	srand(1);
+	const period_case_t cases[] = {
+			{50, 0, 0},
+			{60, 0, 0},
+			{49.5, 0.1, 3},
+			{60.5, -0.1, 3},
+			{47, 0, 0},
+			{45.5, 0.1, 3},
+			{50, 0, 20},
+	};
+	const uint32_t seconds = 10;
+	const uint32_t numSamples = seconds * 1000000 / CS_ADC_SAMPLE_INTERVAL_US;
+	bool success = true;
+	for (const period_case_t& c : cases) {
+		trace_load_t load;
+		load.frequencyHz = c.frequencyHz;
+		load.frequencyDrift = c.frequencyDrift;
+		load.noiseLsb = c.noiseLsb;
+		vector<int16_t> trace;
+		synthesizeTrace(trace, load, 0, numSamples);
+
+		// Period error, once locked.
+		PeriodTracker tracker;
+		tracker.init(CS_ADC_SAMPLE_INTERVAL_US);
+		int32_t zeroVoltage = TRACE_VOLTAGE_ZERO * 1000;
+		double maxErrorUs = 0;
+		double maxWindowErrorUs = 0;
+		int32_t lockedAt = -1;
+		for (uint32_t bufIndex = 0; bufIndex < traceNumBuffers(trace); ++bufIndex) {
+			tracker.update(traceBuffer(trace, bufIndex), zeroVoltage);
+			if (!tracker.isLocked()) {
+				continue;
+			}
+			if (lockedAt < 0) {
+				lockedAt = bufIndex;
+			}
+			double t = (bufIndex + 1) * CS_ADC_BUF_SIZE / 2 * CS_ADC_SAMPLE_INTERVAL_US / 1000000.0;
+			double periodUs = 1000000 / (c.frequencyHz + c.frequencyDrift * t);
+			maxErrorUs = max(maxErrorUs, fabs(tracker.getPeriodUs() - periodUs));
+			double windowUs = tracker.getWindowUs(CS_ADC_BUF_SIZE / 2);
+			maxWindowErrorUs = max(maxWindowErrorUs, fabs(windowUs - periodUs));
+		}
+
+		rms_stats_t fixed = irmsStats(trace, false);
+		rms_stats_t tracked = irmsStats(trace, true);
+		cout << c.frequencyHz << " Hz, drift " << c.frequencyDrift << " Hz/s, noise " << c.noiseLsb << ": locked at buffer "
+				<< lockedAt << ", max period error " << maxErrorUs << " us, Irms fixed " << fixed.mean << " +- "
+				<< fixed.stddev << " mA, tracked " << tracked.mean << " +- " << tracked.stddev << " mA" << endl;
+		if (lockedAt < 0 || lockedAt > 10) {
+			cout << "  did not lock in time" << endl;
+			success = false;
+		}
+		if (maxErrorUs > 20) {
+			cout << "  period error too large" << endl;
+			success = false;
+		}
+		if (maxWindowErrorUs > CS_ADC_SAMPLE_INTERVAL_US) {
+			cout << "  window doesn't cover the period: off by " << maxWindowErrorUs << " us" << endl;
+			success = false;
+		}
+		if (fabs(tracked.mean - load.currentRms * 1000) > 10 || tracked.stddev > 10) {
+			cout << "  tracked Irms is off" << endl;
+			success = false;
+		}
+		if (c.frequencyHz != 50 && tracked.stddev >= fixed.stddev) {
+			cout << "  tracking doesn't reduce the jitter" << endl;
+			success = false;
+		}
+	}
+	return success ? 0 : 1;
+}
@@ -0,0 +1,273 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Accuracy report of the fixed point power kernel.
+ *
+ * For a range of synthetic loads and zero offsets, Irms, Vrms and power are calculated with:
+ * - the kernel (cs_PowerKernel.h),
+ * - the previous implementation: a 64 bit divide per sample, and float / double math at the end,
+ * - exact double math, truncated to an integer like the other two.
+ * The test fails when the kernel is more than 1 mA, 1 mV or 1 mW off from the exact result.
+ *
+ * On x86-64, the SSE2 and AVX2 sums are checked to be identical to the scalar sums, for random samples over the whole
+ * int16 range, and their speed is reported in periods per second.
+ */
+
+#include "PowerTrace.h"
+
+#include <processing/cs_PowerKernel.h>
+
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+struct rms_result_t {
+	int32_t currentRmsMA;
+	int32_t voltageRmsMilliVolt;
+	int32_t powerMilliWatt;
+};
+
+//! The loop of PowerCalculation::calculatePower() before the kernel was introduced.
+rms_result_t calculatePrevious(const int16_t* buf, uint16_t numSamples, int32_t zeroVoltage, int32_t zeroCurrent) {
+	float currentMultiplier = TRACE_CURRENT_MULTIPLIER;
+	float voltageMultiplier = TRACE_VOLTAGE_MULTIPLIER;
+	int64_t pSum = 0;
+	int64_t cSquareSum = 0;
+	int64_t vSquareSum = 0;
+	int64_t current;
+	int64_t voltage;
+	for (uint16_t i = 0; i < numSamples * 2; i += 2) {
+		current = (int64_t)buf[i+1]*1000 - zeroCurrent;
+		voltage = (int64_t)buf[i]*1000 - zeroVoltage;
+		cSquareSum += (current * current) / (1000*1000);
+		vSquareSum += (voltage * voltage) / (1000*1000);
+		pSum +=       (current * voltage) / (1000*1000);
+	}
+	rms_result_t result;
+	result.powerMilliWatt = pSum * currentMultiplier * voltageMultiplier * 1000 / numSamples;
+	result.currentRmsMA = sqrt((double)cSquareSum * currentMultiplier * currentMultiplier / numSamples) * 1000;
+	result.voltageRmsMilliVolt = sqrt((double)vSquareSum * voltageMultiplier * voltageMultiplier / numSamples) * 1000;
+	return result;
+}
+
+rms_result_t calculateExact(const int16_t* buf, uint16_t numSamples, int32_t zeroVoltage, int32_t zeroCurrent) {
+	double currentMultiplier = TRACE_CURRENT_MULTIPLIER;
+	double voltageMultiplier = TRACE_VOLTAGE_MULTIPLIER;
+	double pSum = 0;
+	double cSquareSum = 0;
+	double vSquareSum = 0;
+	for (uint16_t i = 0; i < numSamples * 2; i += 2) {
+		double current = buf[i+1] - zeroCurrent / 1000.0;
+		double voltage = buf[i] - zeroVoltage / 1000.0;
+		cSquareSum += current * current;
+		vSquareSum += voltage * voltage;
+		pSum += current * voltage;
+	}
+	rms_result_t result;
+	result.powerMilliWatt = pSum * currentMultiplier * voltageMultiplier * 1000 / numSamples;
+	result.currentRmsMA = sqrt(cSquareSum / numSamples) * currentMultiplier * 1000;
+	result.voltageRmsMilliVolt = sqrt(vSquareSum / numSamples) * voltageMultiplier * 1000;
+	return result;
+}
+
+rms_result_t calculateKernel(const int16_t* buf, uint16_t numSamples, int32_t zeroVoltage, int32_t zeroCurrent) {
+	static fixed_multiplier_t currentMultiplier = toFixedMultiplier(TRACE_CURRENT_MULTIPLIER);
+	static fixed_multiplier_t voltageMultiplier = toFixedMultiplier(TRACE_VOLTAGE_MULTIPLIER);
+	static fixed_multiplier_t powerMultiplier = toFixedMultiplier(TRACE_CURRENT_MULTIPLIER * TRACE_VOLTAGE_MULTIPLIER);
+	power_sums_t sums;
+	sumPower(buf, buf + 1, 2, numSamples, sums);
+	rms_result_t result;
+	result.powerMilliWatt = powerFromProductSum(centeredProductSum(sums, zeroVoltage, zeroCurrent), numSamples, powerMultiplier);
+	result.currentRmsMA = rmsFromSquareSum(centeredSquareSum(sums.sumCurrent, sums.sumCurrentSquare, zeroCurrent, numSamples), numSamples, currentMultiplier);
+	result.voltageRmsMilliVolt = rmsFromSquareSum(centeredSquareSum(sums.sumVoltage, sums.sumVoltageSquare, zeroVoltage, numSamples), numSamples, voltageMultiplier);
+	return result;
+}
+
+struct max_error_t {
+	int32_t current;
+	int32_t voltage;
+	int32_t power;
+	max_error_t() : current(0), voltage(0), power(0) {}
+	void update(const rms_result_t& a, const rms_result_t& b) {
+		current = max(current, abs(a.currentRmsMA - b.currentRmsMA));
+		voltage = max(voltage, abs(a.voltageRmsMilliVolt - b.voltageRmsMilliVolt));
+		power = max(power, abs(a.powerMilliWatt - b.powerMilliWatt));
+	}
+};
+
+ostream& operator<<(ostream& os, const max_error_t& error) {
+	return os << error.current << " mA, " << error.voltage << " mV, " << error.power << " mW";
+}
+
+bool operator==(const power_sums_t& a, const power_sums_t& b) {
+	return a.count == b.count && a.sumVoltage == b.sumVoltage && a.sumCurrent == b.sumCurrent
+			&& a.sumVoltageSquare == b.sumVoltageSquare && a.sumCurrentSquare == b.sumCurrentSquare
+			&& a.sumProduct == b.sumProduct;
+}
+
+#if POWER_KERNEL_SIMD == 1
+typedef void (*sum_power_t)(const int16_t* first, bool voltageFirst, uint16_t count, power_sums_t& sums);
+
+bool checkSimd(const char* name, sum_power_t sum) {
+	vector<int16_t> buf(2 * 1000);
+	for (int k = 0; k < 2000; ++k) {
+		for (size_t i = 0; i < buf.size(); ++i) {
+			buf[i] = rand() % 65536 - 32768;
+		}
+		// Include the extremes.
+		buf[rand() % buf.size()] = -32768;
+		buf[rand() % buf.size()] = 32767;
+		uint16_t count = rand() % (buf.size() / 2 + 1);
+		bool voltageFirst = rand() % 2;
+		power_sums_t scalar;
+		power_sums_t simd;
+		sumPowerScalar(&buf[voltageFirst ? 0 : 1], &buf[voltageFirst ? 1 : 0], 2, count, scalar);
+		sum(&buf[0], voltageFirst, count, simd);
+		if (!(scalar == simd)) {
+			cout << name << ": sums differ for " << count << " samples" << endl;
+			return false;
+		}
+
+		vector<int32_t> wide(buf.begin(), buf.begin() + count);
+		power_sums_t scalarCurrent;
+		power_sums_t simdCurrent;
+		sumCurrentScalar(&buf[0], count, scalarCurrent);
+		sumCurrent(&buf[0], count, simdCurrent);
+		if (scalarCurrent.sumCurrent != simdCurrent.sumCurrent || scalarCurrent.sumCurrentSquare != simdCurrent.sumCurrentSquare) {
+			cout << "sumCurrent: sums differ for " << count << " samples" << endl;
+			return false;
+		}
+		sumCurrent(wide.data(), count, simdCurrent);
+		if (scalarCurrent.sumCurrent != simdCurrent.sumCurrent || scalarCurrent.sumCurrentSquare != simdCurrent.sumCurrentSquare) {
+			cout << "sumCurrent: sums of 32 bit samples differ for " << count << " samples" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+void scalarSum(const int16_t* first, bool voltageFirst, uint16_t count, power_sums_t& sums) {
+	sumPowerScalar(&first[voltageFirst ? 0 : 1], &first[voltageFirst ? 1 : 0], 2, count, sums);
+}
+
+/**
+ * Returns the number of periods per second, the fastest of a few runs.
+ */
+double periodsPerSecond(const vector<int16_t>& trace, uint16_t numSamples, sum_power_t sum) {
+	uint32_t numPeriods = trace.size() / (2 * numSamples);
+	uint64_t bestNs = UINT64_MAX;
+	volatile int64_t sink = 0;
+	for (int run = 0; run < 5; ++run) {
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (uint32_t i = 0; i < numPeriods; ++i) {
+			power_sums_t sums;
+			sum(&trace[i * 2 * numSamples], true, numSamples, sums);
+			sink += sums.sumProduct;
+		}
+		chrono::steady_clock::time_point end = chrono::steady_clock::now();
+		bestNs = min(bestNs, (uint64_t)chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+	}
+	return numPeriods * 1e9 / bestNs;
+}
+#endif
+
+int main() {
+	cout << "Test PowerKernel implementation" << endl;
+	srand(1);
+	const uint16_t numSamples = CS_ADC_BUF_SIZE / 2;
+	const double currents[] = {0, 0.01, 0.1, 1, 5, 16};
+	const double phases[] = {0, 30, 90, 180};
+	const double noises[] = {0, 5};
+	// Zero offsets as they come out of the exponential moving average: not a multiple of 1000.
+	const int32_t zeroOffsets[] = {0, 123, -456, 999};
+	const uint32_t numOffsets = sizeof(zeroOffsets) / sizeof(zeroOffsets[0]);
+
+	vector<int16_t> trace;
+	vector<rms_result_t> previous;
+	vector<rms_result_t> kernel;
+	vector<int32_t> zeroVoltages;
+	vector<int32_t> zeroCurrents;
+	max_error_t kernelError;
+	max_error_t previousError;
+	max_error_t kernelPrevious;
+	uint32_t numExact = 0;
+	uint32_t numBuffers = 0;
+	for (double current : currents) {
+		for (double phase : phases) {
+			for (double noise : noises) {
+				trace_load_t load;
+				load.currentRms = current;
+				load.phaseDeg = phase;
+				load.noiseLsb = noise;
+				synthesizeTrace(trace, load, numBuffers * numSamples, numSamples);
+				for (int32_t offset : zeroOffsets) {
+					const int16_t* buf = &trace[numBuffers * CS_ADC_BUF_SIZE];
+					int32_t zeroVoltage = TRACE_VOLTAGE_ZERO * 1000 + offset;
+					int32_t zeroCurrent = TRACE_CURRENT_ZERO * 1000 - offset;
+					rms_result_t exact = calculateExact(buf, numSamples, zeroVoltage, zeroCurrent);
+					rms_result_t prev = calculatePrevious(buf, numSamples, zeroVoltage, zeroCurrent);
+					rms_result_t kern = calculateKernel(buf, numSamples, zeroVoltage, zeroCurrent);
+					kernelError.update(kern, exact);
+					previousError.update(prev, exact);
+					kernelPrevious.update(kern, prev);
+					if (kern.currentRmsMA == prev.currentRmsMA && kern.voltageRmsMilliVolt == prev.voltageRmsMilliVolt
+							&& kern.powerMilliWatt == prev.powerMilliWatt) {
+						++numExact;
+					}
+					zeroVoltages.push_back(zeroVoltage);
+					zeroCurrents.push_back(zeroCurrent);
+				}
+				++numBuffers;
+			}
+		}
+	}
+	uint32_t numResults = zeroVoltages.size();
+	cout << "results: " << numResults << ", identical to previous: " << numExact << endl;
+	cout << "max error kernel: " << kernelError << endl;
+	cout << "max error previous: " << previousError << endl;
+	cout << "max difference kernel - previous: " << kernelPrevious << endl;
+
+	// Speed, the fastest of a few runs.
+	previous.resize(numResults);
+	kernel.resize(numResults);
+	uint64_t previousNs = UINT64_MAX;
+	uint64_t kernelNs = UINT64_MAX;
+	for (int run = 0; run < 5; ++run) {
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (uint32_t i = 0; i < numResults; ++i) {
+			previous[i] = calculatePrevious(&trace[i / numOffsets * CS_ADC_BUF_SIZE], numSamples, zeroVoltages[i], zeroCurrents[i]);
+		}
+		chrono::steady_clock::time_point mid = chrono::steady_clock::now();
+		for (uint32_t i = 0; i < numResults; ++i) {
+			kernel[i] = calculateKernel(&trace[i / numOffsets * CS_ADC_BUF_SIZE], numSamples, zeroVoltages[i], zeroCurrents[i]);
+		}
+		chrono::steady_clock::time_point end = chrono::steady_clock::now();
+		previousNs = min(previousNs, (uint64_t)chrono::duration_cast<chrono::nanoseconds>(mid - start).count());
+		kernelNs = min(kernelNs, (uint64_t)chrono::duration_cast<chrono::nanoseconds>(end - mid).count());
+	}
+	cout << "previous " << previousNs / numResults << " ns/buffer, kernel " << kernelNs / numResults << " ns/buffer" << endl;
+
+	bool success = true;
+#if POWER_KERNEL_SIMD == 1
+	success &= checkSimd("SSE2", sumPowerSse2);
+	cout << "sums: scalar " << periodsPerSecond(trace, numSamples, scalarSum) << ", SSE2 "
+			<< periodsPerSecond(trace, numSamples, sumPowerSse2);
+	if (cpuSupportsAvx2()) {
+		success &= checkSimd("AVX2", sumPowerAvx2);
+		cout << ", AVX2 " << periodsPerSecond(trace, numSamples, sumPowerAvx2);
+	}
+	cout << " periods/s" << endl;
+#endif
+
+	if (kernelError.current > 1 || kernelError.voltage > 1 || kernelError.power > 1) {
+		cout << "kernel is not accurate enough" << endl;
+		success = false;
+	}
+	return success ? 0 : 1;
+}
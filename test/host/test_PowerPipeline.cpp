@@ -0,0 +1,178 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Checks that PowerCalculation gives the same Irms, Vrms and power as the float calculation it replaced.
+ *
+ * BaselineCalculation below is the calculation of the original PowerSampling: sort_median filter, voltage zero from the
+ * raw samples, current zero from the filtered samples, and a loop that scales every sample by 1000 and divides every
+ * square and product by 1000*1000, with float multipliers and a double sqrt. Both are fed the same trace with load
+ * changes and zero lines that start off. The new path only rounds differently, so for every buffer the zero lines must
+ * be identical, and Irms, filtered Irms, Vrms and power must agree within TOLERANCE: 1 mA, 1 mV and 1 mW.
+ */
+
+#include "PowerTrace.h"
+
+#include <iostream>
+
+#include <third/SortMedian.h>
+
+using namespace std;
+
+//! Tolerance of the results, in mA, mV and mW.
+#define TOLERANCE 1
+
+const uint16_t numSamples = CS_ADC_BUF_SIZE / 2;
+const uint16_t halfWindowSize = POWER_SAMPLING_CURVE_HALF_WINDOW_SIZE;
+const uint16_t windowSize = 2 * halfWindowSize + 1;
+const uint16_t blockCount = (numSamples + 2 * halfWindowSize + windowSize - 1) / windowSize;
+
+class BaselineCalculation {
+public:
+	BaselineCalculation(const power_calculation_config_t& config) :
+			_config(config),
+			_avgZeroVoltage(config.voltageZero * 1000),
+			_avgZeroCurrent(config.currentZero * 1000),
+			_filterParams(halfWindowSize, blockCount),
+			_inputSamples(blockCount * windowSize),
+			_outputSamples(blockCount * windowSize)
+	{
+	}
+
+	void process(const power_t& power) {
+		uint16_t numPeriodSamples = power.acPeriodUs / power.sampleIntervalUs;
+		filter(power);
+
+		// Voltage zero, from the raw samples.
+		int64_t sum = 0;
+		for (int i = power.voltageIndex; i < numPeriodSamples * power.numChannels; i += power.numChannels) {
+			sum += power.buf[i];
+		}
+		int32_t zeroVoltage = sum * 1000 / numPeriodSamples;
+		int64_t discount = _config.avgZeroVoltageDiscount;
+		_avgZeroVoltage = ((1000 - discount) * _avgZeroVoltage + discount * zeroVoltage) / 1000;
+
+		// Current zero, from the filtered samples.
+		sum = 0;
+		for (int i = 0; i < numPeriodSamples; ++i) {
+			sum += _outputSamples[i];
+		}
+		int32_t zeroCurrent = sum * 1000 / numPeriodSamples;
+		discount = _config.avgZeroCurrentDiscount;
+		_avgZeroCurrent = ((1000 - discount) * _avgZeroCurrent + discount * zeroCurrent) / 1000;
+
+		// Power, Irms and Vrms.
+		float currentMultiplier = _config.currentMultiplier;
+		float voltageMultiplier = _config.voltageMultiplier;
+		int64_t pSum = 0;
+		int64_t cSquareSum = 0;
+		int64_t vSquareSum = 0;
+		int64_t current;
+		int64_t voltage;
+		for (uint16_t i = 0; i < numPeriodSamples * power.numChannels; i += power.numChannels) {
+			current = (int64_t)power.buf[i+power.currentIndex]*1000 - _avgZeroCurrent;
+			voltage = (int64_t)power.buf[i+power.voltageIndex]*1000 - _avgZeroVoltage;
+			cSquareSum += (current * current) / (1000*1000);
+			vSquareSum += (voltage * voltage) / (1000*1000);
+			pSum +=       (current * voltage) / (1000*1000);
+		}
+		powerMilliWatt = pSum * currentMultiplier * voltageMultiplier * 1000 / numPeriodSamples - _config.powerZero;
+		currentRmsMA = sqrt((double)cSquareSum * currentMultiplier * currentMultiplier / numPeriodSamples) * 1000;
+		voltageRmsMilliVolt = sqrt((double)vSquareSum * voltageMultiplier * voltageMultiplier / numPeriodSamples) * 1000;
+
+		// Irms of the filtered samples.
+		cSquareSum = 0;
+		for (uint16_t i = 0; i < numPeriodSamples; ++i) {
+			current = (int64_t)_outputSamples[i]*1000 - _avgZeroCurrent;
+			cSquareSum += (current * current) / (1000*1000);
+		}
+		filteredCurrentRmsMA = sqrt((double)cSquareSum * currentMultiplier * currentMultiplier / numPeriodSamples) * 1000;
+	}
+
+	int32_t powerMilliWatt;
+	int32_t currentRmsMA;
+	int32_t voltageRmsMilliVolt;
+	int32_t filteredCurrentRmsMA;
+	int32_t _avgZeroVoltage;
+	int32_t _avgZeroCurrent;
+
+private:
+	power_calculation_config_t _config;
+	MedianFilter _filterParams;
+	PowerVector _inputSamples;
+	PowerVector _outputSamples;
+
+	void filter(const power_t& power) {
+		// Pad the input with the first and last sample, up to the end of the last block.
+		uint16_t j = 0;
+		for (; j < _filterParams.half; ++j) {
+			_inputSamples[j] = power.buf[power.currentIndex];
+		}
+		uint16_t i = power.currentIndex;
+		for (; i < power.bufSize; i += power.numChannels) {
+			_inputSamples[j++] = power.buf[i];
+		}
+		for (; j < _inputSamples.size(); ++j) {
+			_inputSamples[j] = power.buf[i - power.numChannels];
+		}
+		sort_median(_filterParams, _inputSamples, _outputSamples);
+	}
+};
+
+bool near(const char* name, uint32_t bufIndex, int64_t value, int64_t expected, int64_t tolerance) {
+	if (value - expected > tolerance || expected - value > tolerance) {
+		cout << "Buffer " << bufIndex << ": " << name << "=" << value << ", baseline " << expected << endl;
+		return false;
+	}
+	return true;
+}
+
+int main() {
+	cout << "Test PowerCalculation against the baseline float calculation" << endl;
+	srand(1);
+
+	// A second of each load.
+	const uint32_t samplesPerLoad = 1000000 / CS_ADC_SAMPLE_INTERVAL_US;
+	const double currents[] = {0, 0.05, 2, 16, 0.5};
+	const double phases[] = {0, 0, 30, -60, 90};
+	vector<int16_t> trace;
+	for (uint32_t i = 0; i < sizeof(currents) / sizeof(currents[0]); ++i) {
+		trace_load_t load;
+		load.currentRms = currents[i];
+		load.phaseDeg = phases[i];
+		load.noiseLsb = 4;
+		synthesizeTrace(trace, load, i * samplesPerLoad, samplesPerLoad);
+	}
+
+	power_calculation_config_t config = traceCalculationConfig();
+	// Start with zero lines that are off, so that they converge during the test.
+	config.voltageZero += 20;
+	config.currentZero -= 20;
+	PowerCalculation calculation;
+	calculation.init(config);
+	BaselineCalculation baseline(config);
+
+	uint32_t numBuffers = traceNumBuffers(trace);
+	for (uint32_t bufIndex = 0; bufIndex < numBuffers; ++bufIndex) {
+		power_t power = traceBuffer(trace, bufIndex);
+		calculation.process(power);
+		baseline.process(power);
+		const power_calculation_result_t& result = calculation.getResult();
+		if (!near("voltage zero", bufIndex, calculation.getAvgZeroVoltage(), baseline._avgZeroVoltage, 0)
+				|| !near("current zero", bufIndex, calculation.getAvgZeroCurrent(), baseline._avgZeroCurrent, 0)
+				|| !near("Irms", bufIndex, result.currentRmsMilliAmp, baseline.currentRmsMA, TOLERANCE)
+				|| !near("filtered Irms", bufIndex, result.filteredCurrentRmsMilliAmp, baseline.filteredCurrentRmsMA,
+						TOLERANCE)
+				|| !near("Vrms", bufIndex, result.voltageRmsMilliVolt, baseline.voltageRmsMilliVolt, TOLERANCE)
+				|| !near("power", bufIndex, result.powerMilliWatt, baseline.powerMilliWatt, TOLERANCE)) {
+			cout << "Results differ from the baseline" << endl;
+			return EXIT_FAILURE;
+		}
+	}
+	cout << "Results of " << numBuffers << " buffers match the baseline" << endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,75 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Feeds the timeline of SamplingTimeline.h through a pipeline that fully processes every period, and one that follows
+ * the SamplingScheduler.
+ *
+ * Checks that the soft fuse trips just as fast with the scheduler, that steady loads are mostly in monitor mode, that
+ * every period is processed while streaming, and that periods that are not fully processed leave the filtered Irms and
+ * its median as they were. The CPU occupancy is compared in bench_SamplingScheduler.
+ */
+
+#include "SamplingTimeline.h"
+
+#include <iostream>
+
+using namespace std;
+
+//! Periods of a steady load: the burst after a switch, and some seconds of monitoring.
+#define STEADY_PERIODS 1000
+//! Steady segments should spend at least this percentage of the periods in monitor mode.
+#define MIN_MONITOR_PERCENT 80
+
+int main() {
+	cout << "Test SamplingScheduler implementation" << endl;
+	srand(1);
+
+	pipeline_t full;
+	pipeline_t scheduled;
+	full.init(false);
+	scheduled.init(true);
+
+	bool success = true;
+	uint32_t numPeriods = 0;
+	for (const segment_t& s : timeline(STEADY_PERIODS)) {
+		uint32_t numBurst = runSegment(s, numPeriods, full, scheduled);
+		numPeriods += s.numPeriods;
+
+		uint32_t monitorPercent = 100 * (s.numPeriods - numBurst) / s.numPeriods;
+		cout << "  " << s.name << ": " << s.numPeriods << " periods, " << scheduled.numFull << " fully processed, "
+				<< monitorPercent << "% in monitor mode";
+		if (full.tripPeriod != NEVER || scheduled.tripPeriod != NEVER) {
+			cout << ", fuse trips at period " << scheduled.tripPeriod << " vs " << full.tripPeriod;
+		}
+		cout << endl;
+
+		// The burst after a switch lasts POWER_SAMPLING_BURST_MS, the rest of a steady segment should be monitored.
+		if (s.steady && monitorPercent < MIN_MONITOR_PERCENT) {
+			cout << "steady load not monitored" << endl;
+			success = false;
+		}
+		if (s.hold && scheduled.numFull != s.numPeriods) {
+			cout << "not every period processed while streaming" << endl;
+			success = false;
+		}
+		if (scheduled.filteredChanged) {
+			cout << "filtered Irms changed without filtering" << endl;
+			success = false;
+		}
+		if (s.overload && full.tripPeriod == NEVER) {
+			cout << "overload did not trip" << endl;
+			success = false;
+		}
+		if ((full.tripPeriod == NEVER) != (scheduled.tripPeriod == NEVER)
+				|| abs(full.tripPeriod - scheduled.tripPeriod) > 1) {
+			cout << "fuse latency differs" << endl;
+			success = false;
+		}
+	}
+	return success ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Checks that the sliding median filter and the statically allocated block median filter give the same output as
+ * sort_median, and compares their speed.
+ *
+ * Both filters get the current curve of one 50 Hz period (100 samples), for half window sizes 5 and 16.
+ * The output is compared for realistic and adversarial curves, the speed only for realistic curves.
+ */
+
+#include <processing/cs_BlockMedianFilter.h>
+#include <processing/cs_SlidingMedianFilter.h>
+#include <third/SortMedian.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+#define NUM_SAMPLES 100
+#define NUM_CURVES 1000
+#define NUM_RUNS 5
+
+enum curve_type_t {
+	CURVE_LOAD,        // Distorted sinusoid with a bit of noise.
+	CURVE_NO_LOAD,     // Only noise around zero.
+	CURVE_RANDOM,      // Full scale random values: worst case for the sliding filter.
+	CURVE_CONSTANT,
+	CURVE_TYPE_COUNT
+};
+
+//! Make an interleaved buffer with a current curve on index 1, and a voltage curve on index 0.
+void makeBuffer(vector<int16_t>& buf, curve_type_t type, int seed) {
+	buf.resize(2 * NUM_SAMPLES);
+	for (int i = 0; i < NUM_SAMPLES; ++i) {
+		double w = 2 * M_PI * i / NUM_SAMPLES;
+		double value = 0;
+		switch (type) {
+		case CURVE_LOAD:
+			value = 300 * sin(w + seed) + 60 * sin(3 * w) + (rand() % 7) - 3;
+			break;
+		case CURVE_NO_LOAD:
+			value = (rand() % 7) - 3;
+			break;
+		case CURVE_RANDOM:
+			value = (rand() % 4096) - 2048;
+			break;
+		default:
+			value = seed;
+		}
+		buf[2*i] = 1900 * sin(w + seed);
+		buf[2*i+1] = (int16_t)value;
+	}
+}
+
+//! Same steps as PowerCalculation::filter() with sort_median.
+void sortMedianFilter(MedianFilter& filterParams, const vector<int16_t>& buf, PowerVector& input, PowerVector& output) {
+	unsigned j = 0;
+	for (; j < filterParams.half; ++j) {
+		input[j] = buf[1];
+	}
+	for (unsigned i = 1; i < buf.size(); i += 2) {
+		input[j++] = buf[i];
+	}
+	for (; j < input.size(); ++j) {
+		input[j] = buf[buf.size() - 1];
+	}
+	sort_median(filterParams, input, output);
+}
+
+template <uint16_t halfWindowSize>
+bool compare() {
+	const unsigned windowSize = 2 * halfWindowSize + 1;
+	const unsigned blockCount = (NUM_SAMPLES + halfWindowSize * 2) / windowSize;
+	MedianFilter filterParams(halfWindowSize, blockCount);
+	PowerVector input(NUM_SAMPLES + halfWindowSize * 2);
+	PowerVector outputSort(NUM_SAMPLES);
+	PowerVector outputSliding(NUM_SAMPLES);
+	PowerVector outputBlock(NUM_SAMPLES);
+	SlidingMedianFilter<halfWindowSize> filter;
+	BlockMedianFilter<halfWindowSize, blockCount> blockFilter;
+
+	// Check if the output is identical.
+	vector<int16_t> buf;
+	for (int curve = 0; curve < NUM_CURVES; ++curve) {
+		curve_type_t type = (curve_type_t)(curve % CURVE_TYPE_COUNT);
+		makeBuffer(buf, type, curve);
+		sortMedianFilter(filterParams, buf, input, outputSort);
+		filter.filter(&buf[1], 2, NUM_SAMPLES, outputSliding.data());
+		blockFilter.filter(&buf[1], 2, NUM_SAMPLES, outputBlock.data());
+		for (int i = 0; i < NUM_SAMPLES; ++i) {
+			if (outputSort[i] != outputSliding[i] || outputSort[i] != outputBlock[i]) {
+				cout << "half window " << halfWindowSize << ": curve " << curve << " (type " << type << ") differs at "
+						<< i << ": " << outputSort[i] << " vs " << outputSliding[i] << " (sliding), " << outputBlock[i]
+						<< " (block)" << endl;
+				return false;
+			}
+		}
+	}
+
+	// Compare the speed on realistic curves: half with load, half without. Take the fastest of a few runs.
+	vector<vector<int16_t> > bufs(NUM_CURVES);
+	for (int curve = 0; curve < NUM_CURVES; ++curve) {
+		makeBuffer(bufs[curve], (curve % 2) ? CURVE_NO_LOAD : CURVE_LOAD, curve);
+	}
+	uint64_t sortNs = UINT64_MAX;
+	uint64_t slidingNs = UINT64_MAX;
+	uint64_t blockNs = UINT64_MAX;
+	for (int run = 0; run < NUM_RUNS; ++run) {
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int curve = 0; curve < NUM_CURVES; ++curve) {
+			sortMedianFilter(filterParams, bufs[curve], input, outputSort);
+		}
+		chrono::steady_clock::time_point mid = chrono::steady_clock::now();
+		for (int curve = 0; curve < NUM_CURVES; ++curve) {
+			filter.filter(&bufs[curve][1], 2, NUM_SAMPLES, outputSliding.data());
+		}
+		chrono::steady_clock::time_point end = chrono::steady_clock::now();
+		for (int curve = 0; curve < NUM_CURVES; ++curve) {
+			blockFilter.filter(&bufs[curve][1], 2, NUM_SAMPLES, outputBlock.data());
+		}
+		chrono::steady_clock::time_point endBlock = chrono::steady_clock::now();
+		sortNs = min(sortNs, (uint64_t)chrono::duration_cast<chrono::nanoseconds>(mid - start).count());
+		slidingNs = min(slidingNs, (uint64_t)chrono::duration_cast<chrono::nanoseconds>(end - mid).count());
+		blockNs = min(blockNs, (uint64_t)chrono::duration_cast<chrono::nanoseconds>(endBlock - end).count());
+	}
+	cout << "half window " << halfWindowSize << ": sort_median " << sortNs / NUM_CURVES << " ns/buffer, sliding "
+			<< slidingNs / NUM_CURVES << " ns/buffer, block " << blockNs / NUM_CURVES << " ns/buffer" << endl;
+	if (slidingNs >= sortNs) {
+		cout << "sliding median is not faster" << endl;
+		return false;
+	}
+	return true;
+}
+
+int main() {
+	cout << "Test SlidingMedianFilter implementation" << endl;
+	srand(1);
+	bool success = true;
+	success &= compare<5>();
+	success &= compare<16>();
+	return success ? 0 : 1;
+}
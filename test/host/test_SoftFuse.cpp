@@ -0,0 +1,286 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Runs inrush, short and overload scenarios through the SoftFuse, period by period, and checks after how many periods
+ * it trips. The latency of the previous soft fuse (median of the last 9 periods above the threshold, or 21 periods in
+ * a row above the dimmer threshold) is shown for comparison. The dimmer fuse has to trip at least as soon as the
+ * previous one, a mild overcurrent has to trip within the trip time of the curve, and a change of the load class
+ * during an overload must not change the curve.
+ */
+
+#include <processing/cs_SoftFuse.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+#define PERIOD_US  20000
+#define NEVER      -1
+
+struct fuse_phase_t {
+	uint32_t numPeriods;
+	int32_t currentMilliAmp;
+	soft_fuse_load_class_t loadClass;
+};
+
+struct fuse_scenario_t {
+	const char* name;
+	bool pwm;
+	vector<fuse_phase_t> phases;
+	//! Period (counted from 1) at which the fuse should trip, or NEVER.
+	int32_t expectedTripPeriod;
+};
+
+void initFuse(SoftFuse& fuse, bool pwm) {
+	if (!pwm) {
+		fuse.init(CURRENT_USAGE_THRESHOLD);
+		return;
+	}
+	// Same as PowerSampling.
+	fuse.init(CURRENT_USAGE_THRESHOLD_PWM);
+	for (uint8_t loadClass = 0; loadClass < SOFT_FUSE_NUM_LOAD_CLASSES; ++loadClass) {
+		soft_fuse_curve_t curve;
+		curve.tripMs = SOFT_FUSE_TRIP_MS_PWM;
+		curve.shortPercent = SOFT_FUSE_SHORT_PERCENT;
+		curve.shortPeriods = loadClass == SOFT_FUSE_LOAD_ELECTRONIC ? SOFT_FUSE_SHORT_PERIODS + 1 : SOFT_FUSE_SHORT_PERIODS;
+		curve.maxPeriods = SOFT_FUSE_MAX_PERIODS_PWM;
+		fuse.setCurve((soft_fuse_load_class_t)loadClass, curve);
+	}
+}
+
+/**
+ * Returns the period at which the fuse trips, or NEVER.
+ */
+int32_t run(const fuse_scenario_t& scenario) {
+	SoftFuse fuse;
+	initFuse(fuse, scenario.pwm);
+	// Like PowerSampling: the load class is known from the previous period, before that there was no load.
+	soft_fuse_load_class_t loadClass = SOFT_FUSE_LOAD_RESISTIVE;
+	int32_t period = 0;
+	for (const fuse_phase_t& phase : scenario.phases) {
+		for (uint32_t i = 0; i < phase.numPeriods; ++i) {
+			++period;
+			if (fuse.update(phase.currentMilliAmp, PERIOD_US, loadClass)) {
+				return period;
+			}
+			loadClass = phase.loadClass;
+		}
+	}
+	return NEVER;
+}
+
+/**
+ * The previous soft fuse: the median of the last 9 filtered Irms values above the threshold, or 21 unfiltered Irms
+ * values in a row above the dimmer threshold.
+ */
+int32_t runPrevious(const fuse_scenario_t& scenario) {
+	// Full of periods without load.
+	vector<int32_t> history(9, 0);
+	uint32_t consecutive = 0;
+	int32_t period = 0;
+	for (const fuse_phase_t& phase : scenario.phases) {
+		for (uint32_t i = 0; i < phase.numPeriods; ++i) {
+			++period;
+			if (scenario.pwm) {
+				consecutive = phase.currentMilliAmp > CURRENT_USAGE_THRESHOLD_PWM ? consecutive + 1 : 0;
+				if (consecutive > 20) {
+					return period;
+				}
+				continue;
+			}
+			history.push_back(phase.currentMilliAmp);
+			history.erase(history.begin());
+			vector<int32_t> sorted = history;
+			sort(sorted.begin(), sorted.end());
+			if (sorted[sorted.size() / 2] > CURRENT_USAGE_THRESHOLD) {
+				return period;
+			}
+		}
+	}
+	return NEVER;
+}
+
+fuse_phase_t phase(uint32_t numPeriods, int32_t currentMilliAmp, soft_fuse_load_class_t loadClass) {
+	fuse_phase_t p = {numPeriods, currentMilliAmp, loadClass};
+	return p;
+}
+
+int main() {
+	cout << "Test SoftFuse implementation" << endl;
+	bool success = true;
+	vector<fuse_scenario_t> scenarios;
+	fuse_scenario_t s;
+
+	s.name = "nominal load";
+	s.pwm = false;
+	s.phases.assign(1, phase(30000, 10000, SOFT_FUSE_LOAD_RESISTIVE));
+	s.expectedTripPeriod = NEVER;
+	scenarios.push_back(s);
+
+	// Trips at the trip time of the curve: 500 ms.
+	s.name = "overload 2x";
+	s.phases.assign(1, phase(1000, 32000, SOFT_FUSE_LOAD_RESISTIVE));
+	s.expectedTripPeriod = 25;
+	scenarios.push_back(s);
+
+	// The I²t takes 3 * 16² * 0.5 / (17.6² - 16²) = 7.1 s at 10%, and 23.6 s at 3%, the cap of periods above the
+	// threshold trips at the trip time of the curve: 500 ms.
+	s.name = "overload 10%";
+	s.phases.assign(1, phase(5000, 17600, SOFT_FUSE_LOAD_RESISTIVE));
+	s.expectedTripPeriod = SOFT_FUSE_TRIP_MS_RESISTIVE * 1000 / PERIOD_US;
+	scenarios.push_back(s);
+
+	s.name = "overload 3%";
+	s.phases.assign(1, phase(5000, 16500, SOFT_FUSE_LOAD_RESISTIVE));
+	s.expectedTripPeriod = SOFT_FUSE_TRIP_MS_RESISTIVE * 1000 / PERIOD_US;
+	scenarios.push_back(s);
+
+	s.name = "short";
+	s.phases.assign(1, phase(100, 100000, SOFT_FUSE_LOAD_RESISTIVE));
+	s.expectedTripPeriod = SOFT_FUSE_SHORT_PERIODS;
+	scenarios.push_back(s);
+
+	// Each burst heats 3 * 16² * 0.3, each pause cools 16² * 0.3: trips at the end of the 2nd burst.
+	s.name = "repeated overload";
+	s.phases.clear();
+	for (int i = 0; i < 5; ++i) {
+		s.phases.push_back(phase(15, 32000, SOFT_FUSE_LOAD_RESISTIVE));
+		s.phases.push_back(phase(15, 0, SOFT_FUSE_LOAD_RESISTIVE));
+	}
+	s.expectedTripPeriod = 45;
+	scenarios.push_back(s);
+
+	s.name = "motor inrush";
+	s.phases.clear();
+	s.phases.push_back(phase(15, 40000, SOFT_FUSE_LOAD_MOTOR));
+	s.phases.push_back(phase(30000, 8000, SOFT_FUSE_LOAD_MOTOR));
+	s.expectedTripPeriod = NEVER;
+	scenarios.push_back(s);
+
+	// 3 * 16² * 4 / (40² - 16²) = 2.29 s.
+	s.name = "motor stalled";
+	s.phases.assign(1, phase(1000, 40000, SOFT_FUSE_LOAD_MOTOR));
+	s.expectedTripPeriod = 115;
+	scenarios.push_back(s);
+
+	// The I²t takes 57 s, the cap of periods above the threshold trips at 4 s.
+	s.name = "motor overload 10%";
+	s.phases.assign(1, phase(5000, 17600, SOFT_FUSE_LOAD_MOTOR));
+	s.expectedTripPeriod = SOFT_FUSE_TRIP_MS_MOTOR * 1000 / PERIOD_US;
+	scenarios.push_back(s);
+
+	// The class that comes in later is stale: the resistive curve stays in use, and trips at 500 ms.
+	s.name = "overload, then motor class";
+	s.pwm = false;
+	s.phases.clear();
+	s.phases.push_back(phase(SOFT_FUSE_CLASS_LATCH_PERIODS + 1, 32000, SOFT_FUSE_LOAD_RESISTIVE));
+	s.phases.push_back(phase(1000, 32000, SOFT_FUSE_LOAD_MOTOR));
+	s.expectedTripPeriod = 25;
+	scenarios.push_back(s);
+
+	// Once cooled down, the class follows the load again.
+	s.name = "motor after overload";
+	s.phases.clear();
+	s.phases.push_back(phase(10, 24000, SOFT_FUSE_LOAD_RESISTIVE));
+	s.phases.push_back(phase(50, 0, SOFT_FUSE_LOAD_MOTOR));
+	s.phases.push_back(phase(15, 40000, SOFT_FUSE_LOAD_MOTOR));
+	s.phases.push_back(phase(1000, 8000, SOFT_FUSE_LOAD_MOTOR));
+	s.expectedTripPeriod = NEVER;
+	scenarios.push_back(s);
+
+	s.name = "motor short";
+	s.phases.clear();
+	s.phases.push_back(phase(50, 8000, SOFT_FUSE_LOAD_MOTOR));
+	s.phases.push_back(phase(100, 200000, SOFT_FUSE_LOAD_MOTOR));
+	s.expectedTripPeriod = 50 + SOFT_FUSE_SHORT_PERIODS;
+	scenarios.push_back(s);
+
+	s.name = "LED driver inrush";
+	s.phases.clear();
+	s.phases.push_back(phase(1, 60000, SOFT_FUSE_LOAD_ELECTRONIC));
+	s.phases.push_back(phase(30000, 2000, SOFT_FUSE_LOAD_ELECTRONIC));
+	s.expectedTripPeriod = NEVER;
+	scenarios.push_back(s);
+
+	s.name = "LED drivers switched on together";
+	s.phases.clear();
+	s.phases.push_back(phase(50, 2000, SOFT_FUSE_LOAD_ELECTRONIC));
+	s.phases.push_back(phase(2, 60000, SOFT_FUSE_LOAD_ELECTRONIC));
+	s.phases.push_back(phase(30000, 12000, SOFT_FUSE_LOAD_ELECTRONIC));
+	s.expectedTripPeriod = NEVER;
+	scenarios.push_back(s);
+
+	s.name = "LED driver overload 10%";
+	s.phases.clear();
+	s.phases.push_back(phase(1, 60000, SOFT_FUSE_LOAD_ELECTRONIC));
+	s.phases.push_back(phase(5000, 17600, SOFT_FUSE_LOAD_ELECTRONIC));
+	s.expectedTripPeriod = SOFT_FUSE_TRIP_MS_ELECTRONIC * 1000 / PERIOD_US;
+	scenarios.push_back(s);
+
+	s.name = "dimmer nominal";
+	s.pwm = true;
+	s.phases.assign(1, phase(30000, 900, SOFT_FUSE_LOAD_RESISTIVE));
+	s.expectedTripPeriod = NEVER;
+	scenarios.push_back(s);
+
+	// 3 * 1² * 0.4 / (1.5² - 1²) = 0.96 s, but the cap of periods above the threshold trips sooner.
+	s.name = "dimmer overload";
+	s.phases.assign(1, phase(1000, 1500, SOFT_FUSE_LOAD_RESISTIVE));
+	s.expectedTripPeriod = SOFT_FUSE_MAX_PERIODS_PWM;
+	scenarios.push_back(s);
+
+	// The I²t takes 11.7 s at 5% and 59 s at 1%, the cap of periods above the threshold trips sooner.
+	s.name = "dimmer overload 5%";
+	s.phases.assign(1, phase(1000, 1050, SOFT_FUSE_LOAD_RESISTIVE));
+	s.expectedTripPeriod = SOFT_FUSE_MAX_PERIODS_PWM;
+	scenarios.push_back(s);
+
+	s.name = "dimmer overload 1%";
+	s.phases.assign(1, phase(1000, 1010, SOFT_FUSE_LOAD_MOTOR));
+	s.expectedTripPeriod = SOFT_FUSE_MAX_PERIODS_PWM;
+	scenarios.push_back(s);
+
+	s.name = "dimmer overload with dips";
+	s.phases.clear();
+	for (int i = 0; i < 5; ++i) {
+		s.phases.push_back(phase(SOFT_FUSE_MAX_PERIODS_PWM - 1, 1050, SOFT_FUSE_LOAD_RESISTIVE));
+		s.phases.push_back(phase(1, 900, SOFT_FUSE_LOAD_RESISTIVE));
+	}
+	s.expectedTripPeriod = NEVER;
+	scenarios.push_back(s);
+
+	// Already trips on the I²t in the first period.
+	s.name = "dimmer short";
+	s.phases.assign(1, phase(100, 10000, SOFT_FUSE_LOAD_RESISTIVE));
+	s.expectedTripPeriod = 1;
+	scenarios.push_back(s);
+
+	for (const fuse_scenario_t& scenario : scenarios) {
+		int32_t tripPeriod = run(scenario);
+		int32_t previousTripPeriod = runPrevious(scenario);
+		cout << "  " << scenario.name << ": trips at period " << tripPeriod << ", expected " << scenario.expectedTripPeriod
+				<< ", previous fuse " << previousTripPeriod << endl;
+		if (scenario.expectedTripPeriod == NEVER ? tripPeriod != NEVER : abs(tripPeriod - scenario.expectedTripPeriod) > 1) {
+			cout << scenario.name << ": wrong trip period" << endl;
+			success = false;
+		}
+		if (scenario.pwm && previousTripPeriod != NEVER && (tripPeriod == NEVER || tripPeriod > previousTripPeriod)) {
+			cout << scenario.name << ": the dimmer trips later than before" << endl;
+			success = false;
+		}
+	}
+
+	if (SoftFuse::classify(400, 100) != SOFT_FUSE_LOAD_MOTOR || SoftFuse::classify(50, 900) != SOFT_FUSE_LOAD_ELECTRONIC
+			|| SoftFuse::classify(-100, 50) != SOFT_FUSE_LOAD_RESISTIVE) {
+		cout << "wrong load class" << endl;
+		success = false;
+	}
+	return success ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Checks the SpscQueue single threaded: order, wrap around, overruns and the high water mark.
+ *
+ * The queue is stressed with a producer and a consumer thread in bench_SpscQueue.
+ */
+
+#include <structs/buffer/cs_SpscQueue.h>
+
+#include <iostream>
+
+using namespace std;
+
+#define CAPACITY   4
+
+struct item_t {
+	uint32_t seq;
+	uint32_t check[3];
+};
+
+typedef SpscQueue<item_t, CAPACITY> Queue;
+
+item_t makeItem(uint32_t seq) {
+	item_t item;
+	item.seq = seq;
+	item.check[0] = seq * 2654435761u;
+	item.check[1] = ~seq;
+	item.check[2] = seq ^ 0x5A5A5A5A;
+	return item;
+}
+
+bool isValid(const item_t& item) {
+	return item.check[0] == item.seq * 2654435761u && item.check[1] == ~item.seq && item.check[2] == (item.seq ^ 0x5A5A5A5A);
+}
+
+bool testSingleThread() {
+	Queue queue;
+	item_t item;
+	if (!queue.empty() || queue.pop(item)) {
+		cout << "new queue not empty" << endl;
+		return false;
+	}
+	uint32_t seq = 0;
+	uint32_t expected = 0;
+	// Fill it up and empty it a few times, so that the indices wrap around.
+	for (int round = 0; round < 10; ++round) {
+		for (int i = 0; i < CAPACITY; ++i) {
+			if (!queue.push(makeItem(seq++))) {
+				cout << "push failed with " << queue.size() << " items" << endl;
+				return false;
+			}
+		}
+		if (queue.size() != CAPACITY || queue.push(makeItem(seq))) {
+			cout << "full queue accepted an item" << endl;
+			return false;
+		}
+		for (int i = 0; i < CAPACITY; ++i) {
+			if (!queue.pop(item) || item.seq != expected++ || !isValid(item)) {
+				cout << "wrong item popped" << endl;
+				return false;
+			}
+		}
+		if (!queue.empty()) {
+			cout << "emptied queue not empty" << endl;
+			return false;
+		}
+	}
+	if (queue.getPushCount() != seq || queue.getOverrunCount() != 10 || queue.getHighWater() != CAPACITY) {
+		cout << "wrong statistics: " << queue.getPushCount() << " pushed, " << queue.getOverrunCount() << " overruns, "
+				<< queue.getHighWater() << " high water" << endl;
+		return false;
+	}
+	queue.reset();
+	if (queue.getPushCount() != 0 || queue.getOverrunCount() != 0 || queue.getHighWater() != 0) {
+		cout << "statistics not reset" << endl;
+		return false;
+	}
+	return true;
+}
+
+int main() {
+	cout << "Test SpscQueue implementation" << endl;
+	bool success = testSingleThread();
+	return success ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+/*
+ * Author: Crownstone Team
+ * Copyright: Crownstone B.V. (https://crownstone.rocks)
+ * Date: Oct 17, 2026
+ * License: LGPLv3+, Apache License, or MIT, your choice
+ */
+
+/**
+ * Round trips synthetic buffers (noise, harmonics, steps, clipping, random extremes) through the WaveformEncoder and
+ * WaveformDecoder, checks that missed chunks are detected, and shows the compression ratio compared to raw 16 bit
+ * samples and to plain int8 deltas (with a 3 byte escape). Recorded traces can be given as arguments.
+ */
+
+#include "PowerTrace.h"
+
+#include <processing/cs_WaveformCodec.h>
+
+#include <iostream>
+
+using namespace std;
+
+#define NUM_SAMPLES (CS_ADC_BUF_SIZE / 2)
+
+struct codec_stats_t {
+	uint64_t rawBytes;
+	uint64_t deltaBytes;
+	uint64_t encodedBytes;
+	codec_stats_t() : rawBytes(0), deltaBytes(0), encodedBytes(0) {}
+};
+
+/**
+ * Size of a channel as int8 deltas, where deltas that don't fit take an escape byte and the full sample.
+ */
+uint32_t deltaSize(const int16_t* samples, uint16_t stride, uint16_t count) {
+	uint32_t size = sizeof(int16_t);
+	for (uint16_t i = 1; i < count; ++i) {
+		int32_t delta = samples[i * stride] - samples[(i - 1) * stride];
+		size += (delta > -128 && delta < 128) ? 1 : 1 + sizeof(int16_t);
+	}
+	return size;
+}
+
+/**
+ * Encode and decode a buffer, and compare the result.
+ */
+bool roundTrip(const char* name, vector<int16_t>& trace, uint32_t bufIndex, codec_stats_t& stats) {
+	WaveformEncoder encoder;
+	WaveformDecoder decoder;
+	power_t power = traceBuffer(trace, bufIndex);
+	vector<uint8_t> chunk(WaveformEncoder::maxEncodedSize(NUM_SAMPLES));
+	uint16_t size = encoder.encode(power, bufIndex, 1234, &chunk[0], chunk.size());
+	if (size == 0) {
+		cout << name << ": encoding failed" << endl;
+		return false;
+	}
+
+	power_waveform_header_t header;
+	int16_t voltage[NUM_SAMPLES];
+	int16_t current[NUM_SAMPLES];
+	if (!decoder.decode(&chunk[0], size, header, voltage, current, NUM_SAMPLES)) {
+		cout << name << ": decoding failed" << endl;
+		return false;
+	}
+	if (header.numSamples != NUM_SAMPLES || header.timestamp != 1234 || header.sampleIntervalUs != power.sampleIntervalUs) {
+		cout << name << ": wrong header" << endl;
+		return false;
+	}
+	for (uint16_t i = 0; i < NUM_SAMPLES; ++i) {
+		if (voltage[i] != power.buf[i * 2] || current[i] != power.buf[i * 2 + 1]) {
+			cout << name << ": wrong sample at " << i << endl;
+			return false;
+		}
+	}
+
+	// A truncated chunk must be rejected.
+	if (decoder.decode(&chunk[0], size - 1, header, voltage, current, NUM_SAMPLES)) {
+		cout << name << ": truncated chunk accepted" << endl;
+		return false;
+	}
+
+	stats.rawBytes += NUM_SAMPLES * 2 * sizeof(int16_t);
+	stats.deltaBytes += deltaSize(power.buf, 2, NUM_SAMPLES) + deltaSize(power.buf + 1, 2, NUM_SAMPLES);
+	stats.encodedBytes += size;
+	return true;
+}
+
+bool roundTripTrace(const char* name, vector<int16_t>& trace, codec_stats_t& total) {
+	codec_stats_t stats;
+	bool success = true;
+	for (uint32_t i = 0; i < traceNumBuffers(trace); ++i) {
+		success &= roundTrip(name, trace, i, stats);
+	}
+	if (stats.encodedBytes) {
+		cout << "  " << name << ": " << stats.encodedBytes / traceNumBuffers(trace) << " bytes per buffer, ratio "
+				<< (double)stats.rawBytes / stats.encodedBytes << " vs raw, " << (double)stats.deltaBytes / stats.encodedBytes
+				<< " vs int8 deltas" << endl;
+	}
+	total.rawBytes += stats.rawBytes;
+	total.deltaBytes += stats.deltaBytes;
+	total.encodedBytes += stats.encodedBytes;
+	return success;
+}
+
+bool roundTripLoad(const char* name, const trace_load_t& load, codec_stats_t& total) {
+	vector<int16_t> trace;
+	synthesizeTrace(trace, load, 0, 20 * NUM_SAMPLES);
+	return roundTripTrace(name, trace, total);
+}
+
+/**
+ * A single sample per channel has no residuals.
+ */
+bool singleSample() {
+	int16_t samples[2] = {-32768, 32767};
+	uint8_t out[8];
+	uint16_t size = WaveformEncoder::encodeChannel(samples, 1, 1, out, sizeof(out));
+	int16_t decoded[1];
+	if (size != 3 || WaveformDecoder::decodeChannel(out, size, 1, decoded) != size || decoded[0] != -32768) {
+		cout << "single sample: wrong result" << endl;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Skip buffers, and check that the decoder counts them.
+ */
+bool missedChunks() {
+	vector<int16_t> trace;
+	trace_load_t load;
+	synthesizeTrace(trace, load, 0, NUM_SAMPLES);
+	power_t power = traceBuffer(trace, 0);
+	WaveformEncoder encoder;
+	WaveformDecoder decoder;
+	vector<uint8_t> chunk(WaveformEncoder::maxEncodedSize(NUM_SAMPLES));
+	power_waveform_header_t header;
+	int16_t voltage[NUM_SAMPLES];
+	int16_t current[NUM_SAMPLES];
+	uint32_t numDropped = 0;
+	// Long enough for the sequence number to wrap.
+	for (uint32_t i = 0; i < 70000; ++i) {
+		uint16_t size = encoder.encode(power, i, i, &chunk[0], chunk.size());
+		if (i % 7 == 3 || (i >= 100 && i < 110)) {
+			++numDropped;
+			continue;
+		}
+		if (!decoder.decode(&chunk[0], size, header, voltage, current, NUM_SAMPLES)) {
+			cout << "missed chunks: decoding failed" << endl;
+			return false;
+		}
+	}
+	if (decoder.getNumMissed() != numDropped) {
+		cout << "missed chunks: counted " << decoder.getNumMissed() << " instead of " << numDropped << endl;
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	cout << "Test WaveformCodec implementation" << endl;
+	srand(1);
+	bool success = true;
+	codec_stats_t total;
+
+	trace_load_t load;
+	success &= roundTripLoad("no load", load, total);
+
+	load.currentRms = 5;
+	load.noiseLsb = 3;
+	success &= roundTripLoad("resistive, noise", load, total);
+
+	load.currentRms = 1;
+	load.phaseDeg = 30;
+	load.thirdHarmonic = 0.5;
+	load.fifthHarmonic = 0.3;
+	load.noiseLsb = 10;
+	success &= roundTripLoad("harmonics, much noise", load, total);
+
+	// Current steps, like a dimmer cutting the sine.
+	vector<int16_t> trace;
+	trace_load_t dimmer;
+	dimmer.currentRms = 8;
+	synthesizeTrace(trace, dimmer, 0, 20 * NUM_SAMPLES);
+	for (size_t i = 1; i < trace.size(); i += 2) {
+		if ((i / 2) % 40 < 15) {
+			trace[i] = TRACE_CURRENT_ZERO;
+		}
+	}
+	success &= roundTripTrace("dimmer steps", trace, total);
+
+	// Clipped at the limits of the ADC.
+	trace.clear();
+	trace_load_t clipped;
+	clipped.currentRms = 40;
+	synthesizeTrace(trace, clipped, 0, 20 * NUM_SAMPLES);
+	for (size_t i = 1; i < trace.size(); i += 2) {
+		trace[i] = max(-2048, min(2047, (int)trace[i]));
+	}
+	success &= roundTripTrace("clipped", trace, total);
+
+	// Worst case: random int16 extremes.
+	trace.clear();
+	for (uint32_t i = 0; i < 20 * CS_ADC_BUF_SIZE; ++i) {
+		trace.push_back(rand() % 2 ? -32768 + rand() % 4 : 32767 - rand() % 4);
+	}
+	codec_stats_t randomStats;
+	success &= roundTripTrace("random extremes", trace, randomStats);
+	if (randomStats.encodedBytes > 20 * WaveformEncoder::maxEncodedSize(NUM_SAMPLES)) {
+		cout << "random extremes: larger than the max size" << endl;
+		success = false;
+	}
+
+	for (int i = 1; i < argc; ++i) {
+		trace.clear();
+		if (!readTrace(argv[i], trace)) {
+			cout << "Could not read " << argv[i] << endl;
+			return 1;
+		}
+		success &= roundTripTrace(argv[i], trace, total);
+	}
+
+	success &= singleSample();
+	success &= missedChunks();
+
+	cout << "  total ratio " << (double)total.rawBytes / total.encodedBytes << " vs raw, "
+			<< (double)total.deltaBytes / total.encodedBytes << " vs int8 deltas" << endl;
+	if (total.encodedBytes * 2 > total.rawBytes) {
+		cout << "compression ratio too low" << endl;
+		success = false;
+	}
+	return success ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+#!/usr/bin/env python
+#
+# Author: Crownstone Team
+# Copyright: Crownstone B.V. (https://crownstone.rocks)
+# Date: Oct 17, 2026
+# License: LGPLv3+, Apache License, or MIT, your choice
+#
+# RAM accounting of the firmware.
+#
+# Reports the statically allocated RAM (.data and .bss) per object file and the largest symbols, from the map file of
+# the linker, and the buffers that are allocated on the heap at boot (see cs_main_crownstone.cpp).
+#
+# Also reports the buffers that a write to the control or mesh control characteristic occupies while it's handled: the
+# encrypted packet in the encryption buffer, and the payload that is decrypted from it into the master buffer, where
+# the command is read from (see PacketView).
+#
+# Usage: ram_report.py [-m build/crownstone.map] [-c conf/cmake/CMakeBuild.config] [-n 20]
+
+from __future__ import print_function
+
+import argparse
+import os
+import re
+import sys
+
+# BLE_GATTS_VAR_ATTR_LEN_MAX of the softdevice, the size of the encryption buffer.
+ENCRYPTION_BUFFER_SIZE = 512
+
+# Packet nonce, user level and validation nonce, see EncryptionHandler.
+PACKET_NONCE_LENGTH = 3
+USER_LEVEL_LENGTH = 1
+VALIDATION_NONCE_LENGTH = 4
+AES_BLOCK_LENGTH = 16
+STREAM_HEADER_SIZE = 4
+
+RAM_SECTIONS = ('.data', '.bss', 'COMMON')
+
+repo = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+
+
+def read_config(paths):
+	"""Read the KEY=value lines of the cmake build configs, later files override earlier ones."""
+	config = {}
+	for path in paths:
+		if not os.path.isfile(path):
+			continue
+		with open(path) as f:
+			for line in f:
+				line = line.split('#', 1)[0].strip()
+				if '=' in line:
+					key, value = line.split('=', 1)
+					config[key.strip()] = value.strip()
+	return config
+
+
+def parse_map(path):
+	"""Return a list of (section, symbol, size, object) of the RAM sections in a GNU ld map file."""
+	entries = []
+	entry_re = re.compile(r'^\s*(\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$')
+	in_map = False
+	pending = None
+	with open(path) as f:
+		for line in f:
+			if line.startswith('Linker script and memory map'):
+				in_map = True
+				continue
+			if not in_map:
+				continue
+			stripped = line.strip()
+			# long section names are wrapped: the address, size and object are on the next line.
+			if pending is None and stripped.startswith(RAM_SECTIONS) and len(stripped.split()) == 1:
+				pending = stripped
+				continue
+			match = entry_re.match(line)
+			name = pending
+			pending = None
+			if match is None:
+				continue
+			if name is None:
+				name = match.group(1)
+			if name is None or not name.startswith(RAM_SECTIONS):
+				continue
+			size = int(match.group(3), 16)
+			if size == 0:
+				continue
+			section = name.split('.')[1] if name.startswith('.') else 'bss'
+			symbol = name[len(section) + 2:] if name.startswith('.') else name
+			obj = os.path.basename(match.group(4).strip())
+			entries.append((section, symbol or name, size, obj))
+	return entries
+
+
+def report_static(entries, top):
+	per_object = {}
+	for section, symbol, size, obj in entries:
+		data, bss = per_object.get(obj, (0, 0))
+		if section == 'data':
+			data += size
+		else:
+			bss += size
+		per_object[obj] = (data, bss)
+
+	print('Static RAM per object (bytes):')
+	print('  %8s %8s %8s  %s' % ('.data', '.bss', 'total', 'object'))
+	total_data = total_bss = 0
+	for obj, (data, bss) in sorted(per_object.items(), key=lambda item: -sum(item[1]))[:top]:
+		print('  %8d %8d %8d  %s' % (data, bss, data + bss, obj))
+	for data, bss in per_object.values():
+		total_data += data
+		total_bss += bss
+	print('  %8d %8d %8d  total' % (total_data, total_bss, total_data + total_bss))
+	print()
+
+	print('Largest symbols (bytes):')
+	for section, symbol, size, obj in sorted(entries, key=lambda entry: -entry[2])[:top]:
+		print('  %8d  %-5s %s (%s)' % (size, section, symbol, obj))
+	print()
+
+
+def encrypted_length(payload_length):
+	blocks = (payload_length + VALIDATION_NONCE_LENGTH + AES_BLOCK_LENGTH - 1) // AES_BLOCK_LENGTH
+	return PACKET_NONCE_LENGTH + USER_LEVEL_LENGTH + blocks * AES_BLOCK_LENGTH
+
+
+def report_buffers(master_buffer_size):
+	print('Heap buffers allocated at boot (bytes):')
+	print('  %8d  MasterBuffer (MASTER_BUFFER_SIZE)' % master_buffer_size)
+	print('  %8d  EncryptionBuffer (BLE_GATTS_VAR_ATTR_LEN_MAX)' % ENCRYPTION_BUFFER_SIZE)
+	print('  %8d  total' % (master_buffer_size + ENCRYPTION_BUFFER_SIZE))
+	print()
+
+	# The largest command is limited by the master buffer, since that's where the reply and the reads go.
+	print('Buffers occupied while a control or mesh control write is handled (bytes):')
+	print('  %8s %8s %8s %8s' % ('command', 'packet', 'payload', 'total'))
+	for data_length in (1, 16, 64, 128, master_buffer_size - STREAM_HEADER_SIZE):
+		payload_length = STREAM_HEADER_SIZE + data_length
+		packet_length = encrypted_length(payload_length)
+		if packet_length > ENCRYPTION_BUFFER_SIZE:
+			continue
+		# the encrypted packet in the encryption buffer, and the decrypted payload, with padding, in the master buffer.
+		copy_length = packet_length - PACKET_NONCE_LENGTH - USER_LEVEL_LENGTH - VALIDATION_NONCE_LENGTH
+		print('  %8d %8d %8d %8d' % (payload_length, packet_length, copy_length, packet_length + copy_length))
+	print()
+	print('The payload is decrypted straight into the master buffer, and the command is handled from there, so there is')
+	print('no copy besides the decryption. The master buffer is locked while the command is handled.')
+
+
+def main():
+	parser = argparse.ArgumentParser(description='RAM accounting of the firmware.')
+	parser.add_argument('-m', '--map', help='map file of the linker, for the static RAM')
+	parser.add_argument('-c', '--config', help='build config, on top of conf/cmake/CMakeBuild.config.default')
+	parser.add_argument('-n', '--top', type=int, default=20, help='number of objects and symbols to show')
+	args = parser.parse_args()
+
+	configs = [os.path.join(repo, 'conf', 'cmake', 'CMakeBuild.config.default')]
+	if args.config:
+		configs.append(args.config)
+	config = read_config(configs)
+	master_buffer_size = int(config.get('MASTER_BUFFER_SIZE', 0))
+	if master_buffer_size == 0:
+		print('MASTER_BUFFER_SIZE not found in %s' % ', '.join(configs), file=sys.stderr)
+		return 1
+
+	if args.map:
+		entries = parse_map(args.map)
+		if not entries:
+			print('No .data or .bss sections found in %s' % args.map, file=sys.stderr)
+			return 1
+		report_static(entries, args.top)
+
+	report_buffers(master_buffer_size)
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit(main())